@@ -9,7 +9,8 @@
 BASEDIR := $(dir $(lastword $(MAKEFILE_LIST)))
 indigo_ofdpa_driver_BASEDIR := $(BASEDIR)indigo_ofdpa_driver
 ofdpa_l2play_BASEDIR := $(BASEDIR)ofdpa_l2play
+ofdpa_sim_BASEDIR := $(BASEDIR)ofdpa_sim
 ofdpa_tools_BASEDIR := $(BASEDIR)ofdpa_tools
 
 
-ALL_MODULES := $(ALL_MODULES) indigo_ofdpa_driver ofdpa_l2play ofdpa_tools
+ALL_MODULES := $(ALL_MODULES) indigo_ofdpa_driver ofdpa_l2play ofdpa_sim ofdpa_tools
@@ -0,0 +1,83 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_flow_expiry.h
+*
+* @purpose      Agent-side idle and hard timeout tracking of flows
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_FLOW_EXPIRY_H__
+#define __IND_OFDPA_FLOW_EXPIRY_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+#include <indigo/fi.h>
+
+/* Resolution of the timer wheel */
+#define IND_OFDPA_FLOW_EXPIRY_TICK_MS     100
+
+/* Timers worked off, and flows read by the counter sweep, per tick */
+#define IND_OFDPA_FLOW_EXPIRY_BATCH       256
+
+/*
+ * While expiry is enabled, flows are installed in OF-DPA without timeouts
+ * and their idle_time and hard_time are tracked here instead. Counters are
+ * read by a sweep that walks a flow table while idle timers of the table
+ * wait on it. An idle timer that runs out restarts from the last read that
+ * saw the flow's packets move; if that is longer ago than the idle time,
+ * the timer waits for the sweep, which expires the flow if its packets
+ * still have not moved. Expired flows are deleted from OF-DPA and reported
+ * to the core in one batch per tick. Enabling or disabling only affects
+ * flows added afterwards.
+ */
+void ind_ofdpa_flow_expiry_enable_set(int enable);
+int ind_ofdpa_flow_expiry_enable_get(void);
+
+/*
+ * Start the tick timer. Flows may be tracked before this is called, they
+ * expire once it runs. Must be called from the thread that runs the
+ * socket manager, as must everything else in this file.
+ */
+indigo_error_t ind_ofdpa_flow_expiry_init(uint32_t tick_ms);
+void ind_ofdpa_flow_expiry_finish(void);
+
+/* Start tracking a flow installed in table_id; a no-op if both timeouts
+   are 0 */
+indigo_error_t ind_ofdpa_flow_expiry_add(uint32_t table_id, uint64_t cookie,
+                                         uint16_t idle_time, uint16_t hard_time);
+
+/* Stop tracking a flow that was deleted by other means */
+void ind_ofdpa_flow_expiry_cancel(uint64_t cookie);
+
+/* Queue a flow-removed report, by Indigo flow id, for a flow already gone
+   from OF-DPA */
+void ind_ofdpa_flow_expiry_notify(uint64_t cookie, indigo_fi_flow_removed_t reason);
+
+/* Tracked flows, wheel occupancy and expiry counters */
+void ind_ofdpa_flow_expiry_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_FLOW_EXPIRY_H__ */
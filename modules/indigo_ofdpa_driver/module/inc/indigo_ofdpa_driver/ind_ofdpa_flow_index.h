@@ -0,0 +1,97 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_flow_index.h
+*
+* @purpose      Secondary indexes over the flows programmed in OF-DPA
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_FLOW_INDEX_H__
+#define __IND_OFDPA_FLOW_INDEX_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Fields of a query; a flow matches if it has every one given */
+#define IND_OFDPA_FLOW_QUERY_TABLE   0x1
+#define IND_OFDPA_FLOW_QUERY_GROUP   0x2
+#define IND_OFDPA_FLOW_QUERY_PORT    0x4
+
+typedef struct
+{
+  uint32_t fields;
+  uint8_t  table_id;
+  uint32_t group_id;
+  uint32_t port;
+} ind_ofdpa_flow_query_t;
+
+/* A flow as indexed */
+typedef struct
+{
+  uint64_t cookie;          /* OF-DPA cookie */
+  uint8_t  table_id;
+  uint32_t group_id;        /* 0 if none */
+  uint32_t port;            /* output port, 0 if none */
+} ind_ofdpa_flow_index_entry_t;
+
+/*
+ * Index a flow by its OF-DPA cookie, table, output group and output
+ * port, or update the index of a flow already in it. The flow code
+ * calls this wherever it programs or changes a flow and
+ * ind_ofdpa_flow_index_remove() wherever a flow leaves OF-DPA, so the
+ * index holds the flows the driver has programmed or restored.
+ */
+indigo_error_t ind_ofdpa_flow_index_set(const ind_ofdpa_flow_index_entry_t *entry);
+void ind_ofdpa_flow_index_remove(uint64_t cookie);
+
+/*
+ * Copy up to max flows matching query to entries, grouped by table, and
+ * return how many were copied. Only the chain of the most selective
+ * field given is walked: output group, then output port, then table.
+ */
+uint32_t ind_ofdpa_flow_index_collect(const ind_ofdpa_flow_query_t *query,
+                                      ind_ofdpa_flow_index_entry_t *entries, uint32_t max);
+
+/* Number of flows matching query, as for collect */
+uint32_t ind_ofdpa_flow_index_count(const ind_ofdpa_flow_query_t *query);
+
+/* Account the batched delete of count flows of a table, failed of which
+   OF-DPA refused, taking elapsed_ns */
+void ind_ofdpa_flow_index_delete_account(uint8_t table_id, uint32_t count, uint32_t failed,
+                                         uint64_t elapsed_ns);
+
+void ind_ofdpa_flow_index_finish(void);
+
+/* Delete the flows matching query from OF-DPA, up to max_flows, issuing
+   the deletes a table at a time. Returns the number deleted. Implemented
+   by the flow code. */
+uint32_t ind_ofdpa_flows_delete(const ind_ofdpa_flow_query_t *query, uint32_t max_flows);
+
+/* Index occupancy and per-table batched delete counters */
+void ind_ofdpa_flow_index_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_FLOW_INDEX_H__ */
@@ -0,0 +1,133 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_groups.h
+*
+* @purpose      OF-DPA group table driver interfaces
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_GROUPS_H__
+#define __IND_OFDPA_GROUPS_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Default period of the group statistics sampler */
+#define IND_OFDPA_GROUP_STATS_MS_DEFAULT      1000
+
+/* Upper bound on the physical bucket table of a resilient select group */
+#define IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS   1024
+
+/*
+ * Resilient hashing emulation for OpenFlow select groups mapped to OF-DPA
+ * ECMP groups. When enabled, the N buckets given by the controller are
+ * spread over a fixed table of num_slots physical buckets. A membership
+ * change rewrites only the slots owned by members that were removed, or
+ * the few slots handed over to members that were added, so flows hashed
+ * to any other slot keep their next hop.
+ *
+ * num_slots of 0 disables the mode. The setting applies to groups
+ * created afterwards.
+ */
+indigo_error_t ind_ofdpa_group_resilient_set(uint32_t num_slots);
+
+/* Slot remap counters of resilient groups, compared against the remap a
+ * plain modulo-N hash would have caused for the same updates */
+void ind_ofdpa_group_resilient_stats_show(aim_pvs_t *pvs);
+
+/*
+ * Group references. The driver tracks which groups point at each group
+ * through bucket referenceGroupIds, and how many flows point at it through
+ * a group action. References to group IDs the driver has not installed,
+ * and group ID 0 from flows, are ignored.
+ */
+void ind_ofdpa_group_flow_ref(uint32_t group_id);
+void ind_ofdpa_group_flow_unref(uint32_t group_id);
+
+/* Non-zero if any flow or other group references the group */
+int ind_ofdpa_group_in_use(uint32_t group_id);
+
+/*
+ * Deletes of groups still referenced by flows or other groups are rejected
+ * without calling OF-DPA. With cascade enabled, the flows pointing at the
+ * group are deleted first; references from other groups still cause a
+ * reject.
+ */
+void ind_ofdpa_group_delete_cascade_set(int enable);
+
+/* Length of the longest reference chain below the group; 0 for groups that
+ * reference nothing, such as L2 interface groups */
+uint32_t ind_ofdpa_group_level(uint32_t group_id);
+
+/* Sort group IDs so every group follows the groups it references, or
+ * precedes them if delete_order is set */
+indigo_error_t ind_ofdpa_group_sort(uint32_t *ids, uint32_t count, int delete_order);
+
+/* Print the tree of groups and flow counts that depend on a group */
+void ind_ofdpa_group_dependents_show(aim_pvs_t *pvs, uint32_t group_id);
+
+/* Create, modify, delete and failure counts and average service time per
+   OF-DPA group type */
+void ind_ofdpa_group_type_stats_show(aim_pvs_t *pvs);
+
+/*
+ * Group statistics sampler. Every interval_ms it refreshes the cached
+ * OF-DPA stats of a batch of groups, and the transmit rates of all ports.
+ * Group stats requests are answered from the cache once a group has been
+ * sampled. An interval of 0 stops the sampler, and each request then calls
+ * OF-DPA. Must be called from the thread that runs the socket manager.
+ */
+indigo_error_t ind_ofdpa_group_stats_init(uint32_t interval_ms);
+void ind_ofdpa_group_stats_finish(void);
+void ind_ofdpa_group_stats_show(aim_pvs_t *pvs);
+
+/* Per-member egress rates of ECMP groups and the max/mean ratio. OF-DPA
+   has no bucket counters, so each member is measured by the transmit rate
+   of the port its next hop resolves to. */
+void ind_ofdpa_group_ecmp_imbalance_show(aim_pvs_t *pvs);
+
+/*
+ * Warm restart, driven by ind_ofdpa_warm. Restore tracks every group in
+ * OF-DPA as restored and adds the number whose shadow record was missing
+ * or no longer fit to drift; a group add with a restored id claims it.
+ * End deletes the groups still unclaimed. Both return a group count.
+ */
+uint32_t ind_ofdpa_group_warm_restore(uint32_t *drift);
+uint32_t ind_ofdpa_group_warm_pending(void);
+uint32_t ind_ofdpa_group_warm_end(void);
+
+/*
+ * Controller resync, driven by ind_ofdpa_warm. Mark flags every group
+ * Indigo has as unconfirmed; a successful modify confirms it. End deletes
+ * the groups still unconfirmed that no flow or group uses any more. Mark
+ * and end return a group count.
+ */
+uint32_t ind_ofdpa_group_resync_mark(void);
+uint32_t ind_ofdpa_group_resync_pending(void);
+uint32_t ind_ofdpa_group_resync_end(void);
+
+#endif /* __IND_OFDPA_GROUPS_H__ */
@@ -0,0 +1,60 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_io.h
+*
+* @purpose      OF-DPA event and packet socket I/O thread
+*
+* @component    OF-DPA
+*
+* @comments     The I/O thread reads the OF-DPA client event and packet
+*               sockets and hands the results to the main loop through
+*               single-producer/single-consumer rings and an eventfd.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_IO_H__
+#define __IND_OFDPA_IO_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Packet ring depth, must be a power of two */
+#define IND_OFDPA_IO_PKT_RING_SIZE    256
+
+/* Packets delivered per main loop callback before yielding to other sockets */
+#define IND_OFDPA_IO_DRAIN_BUDGET     64
+
+typedef enum
+{
+  IND_OFDPA_IO_BACKEND_POLL = 0,
+  IND_OFDPA_IO_BACKEND_EPOLL,       /* edge-triggered event and packet fds */
+} ind_ofdpa_io_backend_t;
+
+/* Start the I/O thread. The OF-DPA client event and packet sockets must
+ * already be bound and must not be registered with the socket manager. */
+indigo_error_t ind_ofdpa_io_start(ind_ofdpa_io_backend_t backend);
+void ind_ofdpa_io_stop(void);
+
+void ind_ofdpa_io_stats_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_IO_H__ */
@@ -0,0 +1,66 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_loop_stats.h
+*
+* @purpose      Service time accounting and stall detection for the
+*               socket manager main loop
+*
+* @component    OF-DPA
+*
+* @comments     Callbacks registered through these functions are run via
+*               a timing trampoline. Sockets registered directly with the
+*               socket manager (controller connections) are not covered.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_LOOP_STATS_H__
+#define __IND_OFDPA_LOOP_STATS_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <SocketManager/socketmanager.h>
+
+#define IND_OFDPA_LOOP_MAX_CALLBACKS      16
+#define IND_OFDPA_LOOP_HIST_BUCKETS       24
+#define IND_OFDPA_LOOP_HEARTBEAT_MS       100
+#define IND_OFDPA_LOOP_STALL_MS_DEFAULT   2000
+
+/* Register a socket callback; name is used in reports and must be static */
+indigo_error_t ind_ofdpa_loop_socket_register(int fd, ind_soc_socket_ready_callback_f callback,
+                                              void *cookie, const char *name);
+indigo_error_t ind_ofdpa_loop_socket_unregister(int fd);
+
+/* Register a repeating timer callback; name is used in reports and must be static */
+indigo_error_t ind_ofdpa_loop_timer_register(ind_soc_timer_callback_f callback, void *cookie,
+                                             int repeat_time_ms, const char *name);
+indigo_error_t ind_ofdpa_loop_timer_unregister(ind_soc_timer_callback_f callback, void *cookie);
+
+/* Start the heartbeat timer and, if stall_ms is non-zero, the watchdog
+ * thread. stall_ms must then be above IND_OFDPA_LOOP_HEARTBEAT_MS. Must be
+ * called from the thread that runs the socket manager. */
+indigo_error_t ind_ofdpa_loop_stats_init(uint32_t stall_ms);
+void ind_ofdpa_loop_stats_finish(void);
+
+void ind_ofdpa_loop_stats_show(aim_pvs_t *pvs);
+void ind_ofdpa_loop_stats_clear(void);
+
+#endif /* __IND_OFDPA_LOOP_STATS_H__ */
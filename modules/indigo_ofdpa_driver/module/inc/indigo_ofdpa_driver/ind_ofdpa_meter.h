@@ -0,0 +1,59 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_meter.h
+*
+* @purpose      OF-DPA meter table driver interfaces
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_METER_H__
+#define __IND_OFDPA_METER_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Default period of the meter statistics poller */
+#define IND_OFDPA_METER_STATS_MS_DEFAULT   1000
+
+/*
+ * Start the meter statistics poller. Every interval_ms it refreshes the
+ * cached OF-DPA stats of all installed meters; an interval of 0 stops it
+ * and stats lookups then call OF-DPA. Must be called from the thread that
+ * runs the socket manager.
+ */
+indigo_error_t ind_ofdpa_meter_stats_init(uint32_t interval_ms);
+void ind_ofdpa_meter_stats_finish(void);
+
+/* Flow reference count and duration of an installed meter, from the
+   poller cache when it is running */
+indigo_error_t ind_ofdpa_meter_stats_get(uint32_t meter_id, uint32_t *ref_count,
+                                         uint32_t *duration_sec);
+
+/* List installed meters with their bands and cached stats */
+void ind_ofdpa_meter_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_METER_H__ */
@@ -0,0 +1,195 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_rpc_stats.h
+*
+* @purpose      Per-API call counters and latency histograms for the
+*               libofdpa client calls made by the driver
+*
+* @component    OF-DPA
+*
+* @comments     Include after ofdpa_api.h. Every API in the list below
+*               is redefined as a macro that times the real call and
+*               records the result, so driver code calls the API as usual.
+*               The same macro feeds the call trace of ind_ofdpa_trace.h,
+*               so arguments must not have side effects.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_RPC_STATS_H__
+#define __IND_OFDPA_RPC_STATS_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <AIM/aim.h>
+#include <ofdpa_api.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_trace.h>
+
+/* Latency buckets are powers of two in nanoseconds; bucket n counts calls
+ * that took [2^(n-1), 2^n) ns and the last bucket holds everything slower. */
+#define IND_OFDPA_RPC_HIST_BUCKETS  32
+
+/* Error counters are indexed by -OFDPA_ERROR_t; slot 0 collects any code
+ * outside the range. */
+#define IND_OFDPA_RPC_ERR_SLOTS     64
+
+#define IND_OFDPA_RPC_API_LIST(_X)   \
+  _X(FlowAdd)                        \
+  _X(FlowModify)                     \
+  _X(FlowByCookieGet)                \
+  _X(FlowByCookieDelete)             \
+  _X(FlowTableInfoGet)               \
+  _X(FlowEventNextGet)               \
+  _X(FlowNextGet)                    \
+  _X(GroupAdd)                       \
+  _X(GroupDelete)                    \
+  _X(GroupTypeGet)                   \
+  _X(GroupMplsSubTypeGet)            \
+  _X(GroupStatsGet)                  \
+  _X(GroupNextGet)                   \
+  _X(GroupBucketEntryAdd)            \
+  _X(GroupBucketEntryModify)         \
+  _X(GroupBucketEntryDelete)         \
+  _X(GroupBucketEntryFirstGet)       \
+  _X(GroupBucketEntryNextGet)        \
+  _X(GroupBucketsDeleteAll)          \
+  _X(MeterAdd)                       \
+  _X(MeterDelete)                    \
+  _X(MeterStatsGet)                  \
+  _X(PktSend)                        \
+  _X(PktReceive)                     \
+  _X(MaxPktSizeGet)                  \
+  _X(PortNextGet)                    \
+  _X(PortMacGet)                     \
+  _X(PortNameGet)                    \
+  _X(PortStateGet)                   \
+  _X(PortConfigGet)                  \
+  _X(PortConfigSet)                  \
+  _X(PortCurrSpeedGet)               \
+  _X(PortMaxSpeedGet)                \
+  _X(PortFeatureGet)                 \
+  _X(PortAdvertiseFeatureSet)        \
+  _X(PortStatsGet)                   \
+  _X(PortEventNextGet)               \
+  _X(NumQueuesGet)                   \
+  _X(QueueStatsGet)                  \
+  _X(QueueRateGet)
+
+#define IND_OFDPA_RPC_ENUM_ENTRY(_name) IND_OFDPA_RPC_##_name,
+
+typedef enum
+{
+  IND_OFDPA_RPC_API_LIST(IND_OFDPA_RPC_ENUM_ENTRY)
+  IND_OFDPA_RPC_COUNT
+} ind_ofdpa_rpc_id_t;
+
+static inline uint64_t ind_ofdpa_rpc_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+void ind_ofdpa_rpc_record(ind_ofdpa_rpc_id_t id, OFDPA_ERROR_t rv, uint64_t elapsed_ns);
+
+/* Dump aggregated counters of all threads since the last clear */
+void ind_ofdpa_rpc_stats_show(aim_pvs_t *pvs);
+
+/* Restart all counters from zero; safe while other threads are calling */
+void ind_ofdpa_rpc_stats_clear(void);
+
+const char *ind_ofdpa_rpc_error_name(OFDPA_ERROR_t rv);
+
+/* Record every wrapped call to a trace file, see ind_ofdpa_trace.h */
+int ind_ofdpa_rpc_trace_start(const char *path);
+void ind_ofdpa_rpc_trace_stop(void);
+void ind_ofdpa_rpc_trace_show(aim_pvs_t *pvs);
+
+#define IND_OFDPA_RPC(_id, _call, ...)                                    \
+  ({                                                                      \
+    uint64_t _rpc_start = ind_ofdpa_rpc_now_ns();                         \
+    uint64_t _rpc_elapsed;                                                \
+    ind_ofdpa_trace_buf_t *_rpc_trace =                                   \
+      ind_ofdpa_trace_begin(IND_OFDPA_RPC_##_id, _rpc_start);             \
+    if (_rpc_trace != NULL)                                               \
+    {                                                                     \
+      IND_OFDPA_TRACE_IN_##_id(_rpc_trace, __VA_ARGS__);                  \
+      ind_ofdpa_trace_in_done(_rpc_trace);                                \
+    }                                                                     \
+    OFDPA_ERROR_t _rpc_rv = (_call);                                      \
+    _rpc_elapsed = ind_ofdpa_rpc_now_ns() - _rpc_start;                   \
+    ind_ofdpa_rpc_record(IND_OFDPA_RPC_##_id, _rpc_rv, _rpc_elapsed);     \
+    if (_rpc_trace != NULL)                                               \
+    {                                                                     \
+      if (_rpc_rv == OFDPA_E_NONE)                                        \
+      {                                                                   \
+        IND_OFDPA_TRACE_OUT_##_id(_rpc_trace, __VA_ARGS__);               \
+      }                                                                   \
+      ind_ofdpa_trace_end(_rpc_trace, _rpc_rv, _rpc_elapsed);             \
+    }                                                                     \
+    _rpc_rv;                                                              \
+  })
+
+#ifndef IND_OFDPA_RPC_STATS_NO_WRAP
+#define ofdpaFlowAdd(...)                 IND_OFDPA_RPC(FlowAdd, ofdpaFlowAdd(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowModify(...)              IND_OFDPA_RPC(FlowModify, ofdpaFlowModify(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowByCookieGet(...)         IND_OFDPA_RPC(FlowByCookieGet, ofdpaFlowByCookieGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowByCookieDelete(...)      IND_OFDPA_RPC(FlowByCookieDelete, ofdpaFlowByCookieDelete(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowTableInfoGet(...)        IND_OFDPA_RPC(FlowTableInfoGet, ofdpaFlowTableInfoGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowEventNextGet(...)        IND_OFDPA_RPC(FlowEventNextGet, ofdpaFlowEventNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaFlowNextGet(...)             IND_OFDPA_RPC(FlowNextGet, ofdpaFlowNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupAdd(...)                IND_OFDPA_RPC(GroupAdd, ofdpaGroupAdd(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupDelete(...)             IND_OFDPA_RPC(GroupDelete, ofdpaGroupDelete(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupTypeGet(...)            IND_OFDPA_RPC(GroupTypeGet, ofdpaGroupTypeGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupMplsSubTypeGet(...)     IND_OFDPA_RPC(GroupMplsSubTypeGet, ofdpaGroupMplsSubTypeGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupStatsGet(...)           IND_OFDPA_RPC(GroupStatsGet, ofdpaGroupStatsGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupNextGet(...)            IND_OFDPA_RPC(GroupNextGet, ofdpaGroupNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketEntryAdd(...)     IND_OFDPA_RPC(GroupBucketEntryAdd, ofdpaGroupBucketEntryAdd(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketEntryModify(...)  IND_OFDPA_RPC(GroupBucketEntryModify, ofdpaGroupBucketEntryModify(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketEntryDelete(...)  IND_OFDPA_RPC(GroupBucketEntryDelete, ofdpaGroupBucketEntryDelete(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketEntryFirstGet(...) IND_OFDPA_RPC(GroupBucketEntryFirstGet, ofdpaGroupBucketEntryFirstGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketEntryNextGet(...) IND_OFDPA_RPC(GroupBucketEntryNextGet, ofdpaGroupBucketEntryNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaGroupBucketsDeleteAll(...)   IND_OFDPA_RPC(GroupBucketsDeleteAll, ofdpaGroupBucketsDeleteAll(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaMeterAdd(...)                IND_OFDPA_RPC(MeterAdd, ofdpaMeterAdd(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaMeterDelete(...)             IND_OFDPA_RPC(MeterDelete, ofdpaMeterDelete(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaMeterStatsGet(...)           IND_OFDPA_RPC(MeterStatsGet, ofdpaMeterStatsGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPktSend(...)                 IND_OFDPA_RPC(PktSend, ofdpaPktSend(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPktReceive(...)              IND_OFDPA_RPC(PktReceive, ofdpaPktReceive(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaMaxPktSizeGet(...)           IND_OFDPA_RPC(MaxPktSizeGet, ofdpaMaxPktSizeGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortNextGet(...)             IND_OFDPA_RPC(PortNextGet, ofdpaPortNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortMacGet(...)              IND_OFDPA_RPC(PortMacGet, ofdpaPortMacGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortNameGet(...)             IND_OFDPA_RPC(PortNameGet, ofdpaPortNameGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortStateGet(...)            IND_OFDPA_RPC(PortStateGet, ofdpaPortStateGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortConfigGet(...)           IND_OFDPA_RPC(PortConfigGet, ofdpaPortConfigGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortConfigSet(...)           IND_OFDPA_RPC(PortConfigSet, ofdpaPortConfigSet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortCurrSpeedGet(...)        IND_OFDPA_RPC(PortCurrSpeedGet, ofdpaPortCurrSpeedGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortMaxSpeedGet(...)         IND_OFDPA_RPC(PortMaxSpeedGet, ofdpaPortMaxSpeedGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortFeatureGet(...)          IND_OFDPA_RPC(PortFeatureGet, ofdpaPortFeatureGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortAdvertiseFeatureSet(...) IND_OFDPA_RPC(PortAdvertiseFeatureSet, ofdpaPortAdvertiseFeatureSet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortStatsGet(...)            IND_OFDPA_RPC(PortStatsGet, ofdpaPortStatsGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaPortEventNextGet(...)        IND_OFDPA_RPC(PortEventNextGet, ofdpaPortEventNextGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaNumQueuesGet(...)            IND_OFDPA_RPC(NumQueuesGet, ofdpaNumQueuesGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaQueueStatsGet(...)           IND_OFDPA_RPC(QueueStatsGet, ofdpaQueueStatsGet(__VA_ARGS__), __VA_ARGS__)
+#define ofdpaQueueRateGet(...)            IND_OFDPA_RPC(QueueRateGet, ofdpaQueueRateGet(__VA_ARGS__), __VA_ARGS__)
+#endif /* IND_OFDPA_RPC_STATS_NO_WRAP */
+
+#endif /* __IND_OFDPA_RPC_STATS_H__ */
@@ -0,0 +1,99 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_shadow.h
+*
+* @purpose      Memory-mapped shadow of the flows and groups programmed
+*               in OF-DPA
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_SHADOW_H__
+#define __IND_OFDPA_SHADOW_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Records a new shadow file is sized for; it doubles as needed */
+#define IND_OFDPA_SHADOW_MIN_RECORDS   4096
+
+typedef enum
+{
+  IND_OFDPA_SHADOW_FLOW  = 1,   /* key: OF-DPA cookie, data: ofdpaFlowEntry_t as programmed */
+  IND_OFDPA_SHADOW_GROUP = 2,   /* key: group id, data: ind_ofdpa_group_shadow_t */
+} ind_ofdpa_shadow_type_t;
+
+/* Per-record state kept in memory only; zero when a record is created or
+   loaded */
+typedef struct
+{
+  uint64_t tag;
+  uint32_t flags;
+} ind_ofdpa_shadow_meta_t;
+
+/*
+ * Open the shadow, loading the records of path if it exists. Each record
+ * is written to a free slot and published by a final store of its type,
+ * after which the slot it replaces is freed, so a crash at any point
+ * leaves either the old or the new record. Records that fail their check
+ * on load are dropped. With a NULL path the shadow lives in anonymous
+ * memory and starts empty.
+ *
+ * Until this is called every other call is a no-op.
+ */
+indigo_error_t ind_ofdpa_shadow_open(const char *path);
+void ind_ofdpa_shadow_close(void);
+int ind_ofdpa_shadow_is_open(void);
+
+/* Create or replace a record, keeping its meta */
+indigo_error_t ind_ofdpa_shadow_put(ind_ofdpa_shadow_type_t type, uint64_t key,
+                                    const void *data, uint32_t len);
+void ind_ofdpa_shadow_delete(ind_ofdpa_shadow_type_t type, uint64_t key);
+
+/*
+ * Copy up to len bytes of the data of a record to data, which may be NULL
+ * to only test for the record. Returns 0 if there is none. A put writes a
+ * new slot and may grow and move the mapping, so callers work on copies
+ * rather than pointers into the shadow.
+ */
+int ind_ofdpa_shadow_get(ind_ofdpa_shadow_type_t type, uint64_t key, void *data, uint32_t len);
+
+/* Meta of a record, NULL if there is none. Valid until the next put or
+   delete. */
+ind_ofdpa_shadow_meta_t *ind_ofdpa_shadow_meta(ind_ofdpa_shadow_type_t type, uint64_t key);
+
+/* Visit the records of a type. The callback may delete the record it is
+   given but must not put; data and meta are only valid during the call. */
+typedef void (*ind_ofdpa_shadow_walk_f)(uint64_t key, const void *data,
+                                        ind_ofdpa_shadow_meta_t *meta, void *cookie);
+void ind_ofdpa_shadow_walk(ind_ofdpa_shadow_type_t type, ind_ofdpa_shadow_walk_f fn, void *cookie);
+
+uint32_t ind_ofdpa_shadow_count(ind_ofdpa_shadow_type_t type);
+
+/* File, occupancy and load counters */
+void ind_ofdpa_shadow_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_SHADOW_H__ */
@@ -0,0 +1,72 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_telemetry.h
+*
+* @purpose      Local streaming counter export for the OF-DPA agent
+*
+* @component    OF-DPA
+*
+* @comments     Snapshots are written as NDJSON, one object per line,
+*               to every client connected to a Unix stream socket.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_TELEMETRY_H__
+#define __IND_OFDPA_TELEMETRY_H__
+
+#include <stdint.h>
+#include <indigo/error.h>
+
+#define IND_OFDPA_TELEMETRY_SOCKET_DEFAULT  "/var/run/ofagent/telemetry.sock"
+#define IND_OFDPA_TELEMETRY_MAX_CLIENTS     8
+
+/* Default snapshot period for each family, 0 disables the family */
+#define IND_OFDPA_TELEMETRY_PORT_MS_DEFAULT   1000
+#define IND_OFDPA_TELEMETRY_QUEUE_MS_DEFAULT  5000
+#define IND_OFDPA_TELEMETRY_TABLE_MS_DEFAULT  10000
+#define IND_OFDPA_TELEMETRY_GROUP_MS_DEFAULT  10000
+
+typedef enum
+{
+  IND_OFDPA_TELEMETRY_FAMILY_PORT = 0,
+  IND_OFDPA_TELEMETRY_FAMILY_QUEUE,
+  IND_OFDPA_TELEMETRY_FAMILY_TABLE,
+  IND_OFDPA_TELEMETRY_FAMILY_GROUP,
+  IND_OFDPA_TELEMETRY_FAMILY_COUNT
+} ind_ofdpa_telemetry_family_t;
+
+/* Map a family name ("port", "queue", "table", "group") to its id */
+indigo_error_t ind_ofdpa_telemetry_family_parse(const char *name,
+                                                ind_ofdpa_telemetry_family_t *family);
+
+/* Set the snapshot period of a family. May be called before or after
+ * ind_ofdpa_telemetry_init(); a period of 0 stops the family. */
+indigo_error_t ind_ofdpa_telemetry_interval_set(ind_ofdpa_telemetry_family_t family,
+                                                uint32_t interval_ms);
+
+/* Open the export socket and start the per-family timers. Must be called
+ * after the socket manager has been initialized. */
+indigo_error_t ind_ofdpa_telemetry_init(const char *socket_path);
+
+void ind_ofdpa_telemetry_finish(void);
+
+#endif /* __IND_OFDPA_TELEMETRY_H__ */
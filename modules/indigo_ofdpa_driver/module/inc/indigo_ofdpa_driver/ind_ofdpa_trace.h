@@ -0,0 +1,271 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_trace.h
+*
+* @purpose      Binary trace of the libofdpa calls made by the driver,
+*               for replay against a switch or libofdpa_sim
+*
+* @component    OF-DPA
+*
+* @comments     The file layout below is shared with the replay tool
+*               (ofdpa_tools client_trace_replay), which only needs
+*               ofdpa_api.h. Recording hooks into the IND_OFDPA_RPC()
+*               wrapper of ind_ofdpa_rpc_stats.h, so every wrapped call
+*               is traced.
+*
+*               A trace is a file header, the names of the traced APIs
+*               (NUL terminated, indexed by the api field of a record),
+*               then one record per call. A record holds the inputs of
+*               the call and, for calls returning events or packets,
+*               their outputs:
+*
+*                 - entries passed by pointer (flows, groups, buckets,
+*                   meters) are copied whole
+*                 - scalar arguments are stored as uint32_t, cookies as
+*                   uint64_t, in argument order
+*                 - ofdpaPktSend: flags, outPortNum, inPortNum, data
+*                 - ofdpaPktReceive output: reason, tableId, inPortNum,
+*                   data
+*                 - ofdpaFlowEventNextGet, ofdpaPortEventNextGet output:
+*                   the event
+*
+*               Integers are in host byte order; the header records the
+*               sizes of the OF-DPA entry types so a trace is only
+*               replayed by a build with the same layout.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_TRACE_H__
+#define __IND_OFDPA_TRACE_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <ofdpa_api.h>
+
+#define IND_OFDPA_TRACE_MAGIC     0x4f445452    /* "ODTR" */
+#define IND_OFDPA_TRACE_VERSION   1
+
+/* Inputs and outputs beyond this are cut; the record is flagged */
+#define IND_OFDPA_TRACE_DATA_MAX  (16 * 1024)
+
+#define IND_OFDPA_TRACE_F_TRUNCATED  0x1
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t num_apis;            /* API names following the header */
+  uint64_t start_sec;           /* wall clock at start of recording */
+  uint16_t flow_entry_size;     /* sizeof(ofdpaFlowEntry_t) */
+  uint16_t group_entry_size;    /* sizeof(ofdpaGroupEntry_t) */
+  uint16_t bucket_entry_size;   /* sizeof(ofdpaGroupBucketEntry_t) */
+  uint16_t meter_entry_size;    /* sizeof(ofdpaMeterEntry_t) */
+  uint16_t flow_event_size;     /* sizeof(ofdpaFlowEvent_t) */
+  uint16_t port_event_size;     /* sizeof(ofdpaPortEvent_t) */
+  uint32_t reserved;
+} ind_ofdpa_trace_file_hdr_t;
+
+typedef struct
+{
+  uint64_t ts_ns;               /* call start, since start of recording */
+  uint32_t dur_ns;              /* call duration, saturated */
+  uint16_t api;
+  int16_t  rv;
+  uint16_t in_len;
+  uint16_t out_len;
+  uint16_t thread;              /* recording thread, numbered from 1 */
+  uint16_t flags;
+} ind_ofdpa_trace_rec_t;
+
+/*
+ * Recorder
+ */
+
+/* A call being recorded; one per thread */
+typedef struct
+{
+  ind_ofdpa_trace_rec_t rec;
+  uint32_t              len;
+  uint8_t               data[IND_OFDPA_TRACE_DATA_MAX];
+} ind_ofdpa_trace_buf_t;
+
+typedef struct
+{
+  int      active;
+  char     path[256];
+  uint64_t records;
+  uint64_t bytes;
+  uint64_t truncated;
+  uint64_t write_errors;
+} ind_ofdpa_trace_status_t;
+
+extern int ind_ofdpa_trace_enabled;
+
+/* Start recording to path, replacing the file; names are the API names
+   indexed by the api argument of ind_ofdpa_trace_begin() */
+int ind_ofdpa_trace_start(const char *path, const char * const *names, uint16_t num_names);
+
+/* Stop recording and close the file */
+void ind_ofdpa_trace_stop(void);
+
+/* Counters of the current or last recording */
+void ind_ofdpa_trace_status_get(ind_ofdpa_trace_status_t *status);
+
+ind_ofdpa_trace_buf_t *ind_ofdpa_trace_buf_get(uint16_t api, uint64_t start_ns);
+
+/* Write the record; out_len is what was put since in_done */
+void ind_ofdpa_trace_end(ind_ofdpa_trace_buf_t *t, OFDPA_ERROR_t rv, uint64_t elapsed_ns);
+
+/* Returns the buffer to record the call into, NULL when not recording */
+static inline ind_ofdpa_trace_buf_t *ind_ofdpa_trace_begin(uint16_t api, uint64_t start_ns)
+{
+  if (!__atomic_load_n(&ind_ofdpa_trace_enabled, __ATOMIC_RELAXED))
+  {
+    return NULL;
+  }
+  return ind_ofdpa_trace_buf_get(api, start_ns);
+}
+
+static inline void ind_ofdpa_trace_put(ind_ofdpa_trace_buf_t *t, const void *data, uint32_t len)
+{
+  if (len > IND_OFDPA_TRACE_DATA_MAX - t->len)
+  {
+    len = IND_OFDPA_TRACE_DATA_MAX - t->len;
+    t->rec.flags |= IND_OFDPA_TRACE_F_TRUNCATED;
+  }
+  memcpy(&t->data[t->len], data, len);
+  t->len += len;
+}
+
+static inline void ind_ofdpa_trace_in_done(ind_ofdpa_trace_buf_t *t)
+{
+  t->rec.in_len = t->len;
+}
+
+#define IND_OFDPA_TRACE_U32(_t, _v) \
+  do { uint32_t _tv = (uint32_t)(_v); ind_ofdpa_trace_put((_t), &_tv, sizeof(_tv)); } while (0)
+#define IND_OFDPA_TRACE_U64(_t, _v) \
+  do { uint64_t _tv = (uint64_t)(_v); ind_ofdpa_trace_put((_t), &_tv, sizeof(_tv)); } while (0)
+#define IND_OFDPA_TRACE_PTR(_t, _p) \
+  ind_ofdpa_trace_put((_t), (_p), sizeof(*(_p)))
+#define IND_OFDPA_TRACE_BUFF(_t, _b) \
+  ind_ofdpa_trace_put((_t), (_b)->pstart, (_b)->size)
+
+/* Per-API capture of inputs (_IN_) before the call and of outputs (_OUT_)
+   after a successful call, named after the IND_OFDPA_RPC_API_LIST entry
+   and taking the arguments of the call */
+#define IND_OFDPA_TRACE_NONE(...)                                   do { } while (0)
+
+#define IND_OFDPA_TRACE_IN_FlowAdd(_t, _flow)                       IND_OFDPA_TRACE_PTR(_t, _flow)
+#define IND_OFDPA_TRACE_IN_FlowModify(_t, _flow)                    IND_OFDPA_TRACE_PTR(_t, _flow)
+#define IND_OFDPA_TRACE_IN_FlowByCookieGet(_t, _cookie, ...)        IND_OFDPA_TRACE_U64(_t, _cookie)
+#define IND_OFDPA_TRACE_IN_FlowByCookieDelete(_t, _cookie)          IND_OFDPA_TRACE_U64(_t, _cookie)
+#define IND_OFDPA_TRACE_IN_FlowTableInfoGet(_t, _table, _info)      IND_OFDPA_TRACE_U32(_t, _table)
+#define IND_OFDPA_TRACE_IN_FlowEventNextGet                         IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_IN_FlowNextGet(_t, _flow, _next)            IND_OFDPA_TRACE_PTR(_t, _flow)
+#define IND_OFDPA_TRACE_IN_GroupAdd(_t, _group)                     IND_OFDPA_TRACE_PTR(_t, _group)
+#define IND_OFDPA_TRACE_IN_GroupDelete(_t, _id)                     IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupTypeGet(_t, _id, _type)             IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupMplsSubTypeGet(_t, _id, _type)      IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupStatsGet(_t, _id, _stats)           IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupNextGet(_t, _id, _next)             IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupBucketEntryAdd(_t, _bucket)         IND_OFDPA_TRACE_PTR(_t, _bucket)
+#define IND_OFDPA_TRACE_IN_GroupBucketEntryModify(_t, _bucket)      IND_OFDPA_TRACE_PTR(_t, _bucket)
+#define IND_OFDPA_TRACE_IN_GroupBucketEntryDelete(_t, _id, _index) \
+  do { IND_OFDPA_TRACE_U32(_t, _id); IND_OFDPA_TRACE_U32(_t, _index); } while (0)
+#define IND_OFDPA_TRACE_IN_GroupBucketEntryFirstGet(_t, _id, _b)    IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_GroupBucketEntryNextGet(_t, _id, _index, _b) \
+  do { IND_OFDPA_TRACE_U32(_t, _id); IND_OFDPA_TRACE_U32(_t, _index); } while (0)
+#define IND_OFDPA_TRACE_IN_GroupBucketsDeleteAll(_t, _id)           IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_MeterAdd(_t, _meter)                     IND_OFDPA_TRACE_PTR(_t, _meter)
+#define IND_OFDPA_TRACE_IN_MeterDelete(_t, _id)                     IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_MeterStatsGet(_t, _id, _stats)           IND_OFDPA_TRACE_U32(_t, _id)
+#define IND_OFDPA_TRACE_IN_PktSend(_t, _pkt, _flags, _out, _in)                 \
+  do { IND_OFDPA_TRACE_U32(_t, _flags); IND_OFDPA_TRACE_U32(_t, _out);          \
+       IND_OFDPA_TRACE_U32(_t, _in); IND_OFDPA_TRACE_BUFF(_t, _pkt); } while (0)
+#define IND_OFDPA_TRACE_IN_PktReceive                               IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_IN_MaxPktSizeGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_IN_PortNextGet(_t, _port, ...)              IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortMacGet(_t, _port, ...)               IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortNameGet(_t, _port, ...)              IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortStateGet(_t, _port, ...)             IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortConfigGet(_t, _port, ...)            IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortConfigSet(_t, _port, _config) \
+  do { IND_OFDPA_TRACE_U32(_t, _port); IND_OFDPA_TRACE_U32(_t, _config); } while (0)
+#define IND_OFDPA_TRACE_IN_PortCurrSpeedGet(_t, _port, ...)         IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortMaxSpeedGet(_t, _port, ...)          IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortFeatureGet(_t, _port, ...)           IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortAdvertiseFeatureSet(_t, _port, _adv) \
+  do { IND_OFDPA_TRACE_U32(_t, _port); IND_OFDPA_TRACE_U32(_t, _adv); } while (0)
+#define IND_OFDPA_TRACE_IN_PortStatsGet(_t, _port, ...)             IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_PortEventNextGet                         IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_IN_NumQueuesGet(_t, _port, ...)             IND_OFDPA_TRACE_U32(_t, _port)
+#define IND_OFDPA_TRACE_IN_QueueStatsGet(_t, _port, _queue, ...) \
+  do { IND_OFDPA_TRACE_U32(_t, _port); IND_OFDPA_TRACE_U32(_t, _queue); } while (0)
+#define IND_OFDPA_TRACE_IN_QueueRateGet(_t, _port, _queue, ...) \
+  do { IND_OFDPA_TRACE_U32(_t, _port); IND_OFDPA_TRACE_U32(_t, _queue); } while (0)
+
+#define IND_OFDPA_TRACE_OUT_FlowEventNextGet(_t, _event)            IND_OFDPA_TRACE_PTR(_t, _event)
+#define IND_OFDPA_TRACE_OUT_PortEventNextGet(_t, _event)            IND_OFDPA_TRACE_PTR(_t, _event)
+#define IND_OFDPA_TRACE_OUT_PktReceive(_t, _timeout, _pkt)                              \
+  do { IND_OFDPA_TRACE_U32(_t, (_pkt)->reason); IND_OFDPA_TRACE_U32(_t, (_pkt)->tableId); \
+       IND_OFDPA_TRACE_U32(_t, (_pkt)->inPortNum);                                      \
+       IND_OFDPA_TRACE_BUFF(_t, &(_pkt)->pktData); } while (0)
+#define IND_OFDPA_TRACE_OUT_FlowAdd                                 IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_FlowModify                              IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_FlowByCookieGet                         IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_FlowByCookieDelete                      IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_FlowTableInfoGet                        IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_FlowNextGet                             IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupAdd                                IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupDelete                             IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupTypeGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupMplsSubTypeGet                     IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupStatsGet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupNextGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketEntryAdd                     IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketEntryModify                  IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketEntryDelete                  IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketEntryFirstGet                IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketEntryNextGet                 IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_GroupBucketsDeleteAll                   IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_MeterAdd                                IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_MeterDelete                             IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_MeterStatsGet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PktSend                                 IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_MaxPktSizeGet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortNextGet                             IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortMacGet                              IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortNameGet                             IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortStateGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortConfigGet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortConfigSet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortCurrSpeedGet                        IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortMaxSpeedGet                         IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortFeatureGet                          IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortAdvertiseFeatureSet                 IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_PortStatsGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_NumQueuesGet                            IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_QueueStatsGet                           IND_OFDPA_TRACE_NONE
+#define IND_OFDPA_TRACE_OUT_QueueRateGet                            IND_OFDPA_TRACE_NONE
+
+#endif /* __IND_OFDPA_TRACE_H__ */
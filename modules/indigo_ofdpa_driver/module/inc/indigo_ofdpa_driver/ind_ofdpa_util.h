@@ -29,9 +29,11 @@
 * @end
 *
 **********************************************************************/
+#include <AIM/aim.h>
 #include <indigo/error.h>
 #include <loci/of_match.h>
 #include <loci/loci.h>
+#include <indigo/of_state_manager.h>
 #include <ofdpa_api.h>
 #include <linux/if_ether.h>
 
@@ -316,11 +318,55 @@ typedef unsigned long long ind_ofdpa_fields_t;
 
 
 extern ind_ofdpa_fields_t ind_ofdpa_match_fields_bitmask;
+extern indTableNameList_t tableNameList[];
+extern const uint32_t tableNameListSize;
 indigo_error_t indigoConvertOfdpaRv(OFDPA_ERROR_t result);
 
 void ind_ofdpa_port_event_receive(void);
 void ind_ofdpa_flow_event_receive(void);
+uint32_t ind_ofdpa_flows_by_group_delete(uint32_t group_id, uint32_t max_flows);
+indigo_error_t ind_ofdpa_flows_by_meter_move(uint32_t from, uint32_t to, uint32_t *moved);
+OFDPA_ERROR_t ind_ofdpa_flow_expire(ofdpaFlowEntry_t *flow, uint64_t *flow_id);
+uint32_t ind_ofdpa_flow_warm_restore(uint32_t *drift);
+uint32_t ind_ofdpa_flow_warm_pending(void);
+uint32_t ind_ofdpa_flow_warm_end(void);
+uint32_t ind_ofdpa_flow_resync_mark(void);
+uint32_t ind_ofdpa_flow_resync_pending(void);
+uint32_t ind_ofdpa_flow_resync_end(void);
+void ind_ofdpa_flow_op_stats_show(aim_pvs_t *pvs);
+
+/*
+ * The flow translation and table operations, for the benchmark in the
+ * utest. match_get expects flow->tableId to be set and
+ * ind_ofdpa_match_fields_bitmask to be cleared, as flow_create does.
+ */
+typedef struct
+{
+  indigo_error_t (*match_get)(const of_match_t *match, ofdpaFlowEntry_t *flow);
+  indigo_error_t (*instructions_get)(of_flow_modify_t *flow_mod, ofdpaFlowEntry_t *flow);
+  const indigo_core_table_ops_t *table_ops;
+} ind_ofdpa_flow_bench_ops_t;
+
+const ind_ofdpa_flow_bench_ops_t *ind_ofdpa_flow_bench_ops_get(void);
+
+/*
+ * The group bucket translation and group table operations, for the tests
+ * and benchmarks in the utest. buckets_translate validates a bucket list
+ * as a group add would, without programming it; on success the caller
+ * frees *entries. table_priv_get returns the table_priv Indigo passes to
+ * the table operations for a group ID.
+ */
+typedef struct
+{
+  indigo_error_t (*buckets_translate)(uint32_t group_id, of_list_bucket_t *buckets,
+                                      ofdpaGroupBucketEntry_t **entries, uint32_t *count);
+  const indigo_core_group_table_ops_t *table_ops;
+  void *(*table_priv_get)(uint32_t group_id);
+} ind_ofdpa_group_bench_ops_t;
+
+const ind_ofdpa_group_bench_ops_t *ind_ofdpa_group_bench_ops_get(void);
 void ind_ofdpa_pkt_receive(void);
+void ind_ofdpa_pkt_deliver(ofdpaPacket_t *rxPkt);
 
 void ind_ofdpa_fwd_init(void);
 void ind_ofdpa_group_init(void);
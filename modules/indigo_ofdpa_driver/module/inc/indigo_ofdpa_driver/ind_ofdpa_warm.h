@@ -0,0 +1,104 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_warm.h
+*
+* @purpose      Warm restart of the agent over a programmed switch
+*
+* @component    OF-DPA
+*
+* @comments     none
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __IND_OFDPA_WARM_H__
+#define __IND_OFDPA_WARM_H__
+
+#include <stdint.h>
+#include <AIM/aim.h>
+#include <indigo/error.h>
+
+/* Time the controller has to re-add the restored entries */
+#define IND_OFDPA_WARM_WINDOW_MS   120000
+
+typedef enum
+{
+  IND_OFDPA_WARM_FLOW  = 0,
+  IND_OFDPA_WARM_GROUP = 1,
+  IND_OFDPA_WARM_KINDS
+} ind_ofdpa_warm_kind_t;
+
+/*
+ * Open the shadow file and take over the groups and flows left in OF-DPA
+ * by the previous run, without changing them. OF-DPA is walked once per
+ * table and is authoritative: its entries are restored, and shadow
+ * records with no entry behind them are dropped.
+ *
+ * Indigo's tables can only be filled by the controller, so restored
+ * entries stay driver-side and are not in Indigo's tables, flow stats or
+ * table counts until claimed. A restored entry is claimed when the
+ * controller adds an entry with the same key: a group with the same id,
+ * or a flow with the same table, priority and match. A claim that matches what is programmed costs no
+ * OF-DPA call; one that differs is applied as an in-place modify.
+ * Entries still unclaimed when window_ms runs out, or at
+ * ind_ofdpa_warm_end(), are deleted. The window also ends as soon as
+ * every restored entry is claimed, and the time from init to that point
+ * is reported as restart-to-ready.
+ *
+ * Must be called after the forwarding and group tables are registered
+ * and before any controller connects, from the thread that runs the
+ * socket manager, as must everything else in this file.
+ */
+indigo_error_t ind_ofdpa_warm_init(const char *path, uint32_t window_ms);
+
+/*
+ * Resync with a newly connected controller. With no window open, mark
+ * every flow and group Indigo has as unconfirmed and open a window of
+ * window_ms. A flow or group modify confirms the entry; Indigo turns a
+ * re-sent flow add into a modify. When the window ends, flows still
+ * unconfirmed are deleted and reported to Indigo as deleted, then
+ * unconfirmed groups no flow or group uses any more are deleted from
+ * OF-DPA. Indigo has no way to be told about a group, so it keeps such a
+ * group until the controller deletes it, and modifies of it fail. The
+ * window ends early once everything is confirmed.
+ *
+ * With a window already open, extend it to end no sooner than window_ms
+ * from now, keeping what is confirmed. A window_ms of 0 does nothing.
+ * Controller deletes are always applied at once.
+ */
+void ind_ofdpa_warm_resync(uint32_t window_ms);
+
+/* Stop the window timer and close the shadow, leaving OF-DPA as it is */
+void ind_ofdpa_warm_finish(void);
+
+/* End the warm restart or resync window now */
+void ind_ofdpa_warm_end(void);
+
+int ind_ofdpa_warm_active(void);
+
+/* Called by the flow and group code for each claim and confirmation */
+void ind_ofdpa_warm_claimed(ind_ofdpa_warm_kind_t kind, int modified);
+void ind_ofdpa_warm_confirmed(ind_ofdpa_warm_kind_t kind);
+
+/* Restore counts, claims, resync confirmations and restart-to-ready time */
+void ind_ofdpa_warm_show(aim_pvs_t *pvs);
+
+#endif /* __IND_OFDPA_WARM_H__ */
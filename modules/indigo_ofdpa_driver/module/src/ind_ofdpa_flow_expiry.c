@@ -0,0 +1,969 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_flow_expiry.c
+*
+* @purpose      Agent-side idle and hard timeout tracking of flows
+*
+* @component    OF-DPA
+*
+* @comments     Timers live in a hierarchical wheel: a root level of
+*               256 one-tick slots and three levels of 64 slots, each
+*               slot covering 64 slots of the level below. A timer is
+*               linked into the slot of its expiry tick, so insert and
+*               cancel are O(1), and is moved down a level when the
+*               level below wraps. Timers that run out go to a pending
+*               list that is worked off a bounded batch per tick. Idle
+*               timers whose flow has not been seen to move wait on a
+*               per-table check list for a counter sweep, which walks
+*               the table a bounded batch of flows per tick and settles
+*               every waiting timer of the table in one pass.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <indigo/forwarding.h>
+#include <OFStateManager/ofstatemanager.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_expiry.h>
+
+#define IND_OFDPA_WHEEL_ROOT_BITS     8
+#define IND_OFDPA_WHEEL_ROOT_SIZE     (1 << IND_OFDPA_WHEEL_ROOT_BITS)
+#define IND_OFDPA_WHEEL_ROOT_MASK     (IND_OFDPA_WHEEL_ROOT_SIZE - 1)
+#define IND_OFDPA_WHEEL_LEVEL_BITS    6
+#define IND_OFDPA_WHEEL_LEVEL_SIZE    (1 << IND_OFDPA_WHEEL_LEVEL_BITS)
+#define IND_OFDPA_WHEEL_LEVEL_MASK    (IND_OFDPA_WHEEL_LEVEL_SIZE - 1)
+#define IND_OFDPA_WHEEL_LEVELS        3
+
+/* Longest timer the wheel holds; later ones are parked in the last slot
+   and go back in when they come out early */
+#define IND_OFDPA_WHEEL_SPAN \
+  (1u << (IND_OFDPA_WHEEL_ROOT_BITS + (IND_OFDPA_WHEEL_LEVELS * IND_OFDPA_WHEEL_LEVEL_BITS)))
+
+#define IND_OFDPA_FLOW_TIMER_CHUNK    4096
+#define IND_OFDPA_FLOW_TIMER_HASH_MIN 4096
+
+/* Wait before retrying a flow whose counters or delete failed */
+#define IND_OFDPA_FLOW_EXPIRY_RETRY_MS 1000
+
+/* OpenFlow table IDs, and so OF-DPA's, fit in 8 bits */
+#define IND_OFDPA_FLOW_EXPIRY_TABLES   256
+
+#define IND_OFDPA_FLOW_TIMER_F_HARD     0x1
+#define IND_OFDPA_FLOW_TIMER_F_PENDING  0x2
+#define IND_OFDPA_FLOW_TIMER_F_CHECK    0x4   /* waits for the counter sweep */
+
+typedef struct ind_ofdpa_flow_link_s
+{
+  struct ind_ofdpa_flow_link_s *next;
+  struct ind_ofdpa_flow_link_s *prev;
+} ind_ofdpa_flow_link_t;
+
+typedef struct ind_ofdpa_flow_timer_s
+{
+  ind_ofdpa_flow_link_t          link;          /* wheel slot, pending or check list */
+  struct ind_ofdpa_flow_timer_s *hash_next;     /* also the pool free list */
+  uint64_t                       cookie;
+  uint64_t                       packets;       /* counter at the last read */
+  uint32_t                       seen;          /* tick of the last read that saw packets */
+  uint32_t                       expires;       /* tick the timer runs out */
+  uint32_t                       hard_expires;  /* valid with F_HARD */
+  uint32_t                       idle_ticks;    /* 0 if no idle timeout */
+  uint32_t                       check_pass;    /* sweep pass when F_CHECK was set */
+  uint16_t                       flags;
+  uint8_t                        table_id;
+} ind_ofdpa_flow_timer_t;
+
+typedef struct ind_ofdpa_flow_timer_chunk_s
+{
+  struct ind_ofdpa_flow_timer_chunk_s *next;
+  ind_ofdpa_flow_timer_t               timers[IND_OFDPA_FLOW_TIMER_CHUNK];
+} ind_ofdpa_flow_timer_chunk_t;
+
+typedef struct
+{
+  uint64_t                 cookie;
+  indigo_fi_flow_removed_t reason;
+} ind_ofdpa_flow_removed_t;
+
+typedef struct
+{
+  uint64_t added;
+  uint64_t cancelled;
+  uint64_t reads;           /* counter reads, by the sweep or for a hard timeout */
+  uint64_t restarted;       /* idle timers restarted on counter movement */
+  uint64_t checks;          /* idle timers handed to the counter sweep */
+  uint64_t sweeps;          /* table walks of the counter sweep */
+  uint64_t expired_idle;
+  uint64_t expired_hard;
+  uint64_t vanished;        /* flows found gone from OF-DPA */
+  uint64_t errors;
+  uint64_t reported;
+  uint64_t report_batches;
+  uint32_t max_report_batch;
+  uint32_t max_pending;
+  uint64_t ticks;
+  uint64_t max_tick_ns;
+} ind_ofdpa_flow_expiry_stats_t;
+
+static int expiry_enabled;
+static uint32_t expiry_tick_ms = IND_OFDPA_FLOW_EXPIRY_TICK_MS;
+static int expiry_timer_running;
+static ind_ofdpa_flow_expiry_stats_t expiry_stats;
+
+static int wheel_ready;
+static uint32_t wheel_tick;         /* next tick to run */
+static ind_ofdpa_flow_link_t wheel_root[IND_OFDPA_WHEEL_ROOT_SIZE];
+static ind_ofdpa_flow_link_t wheel_level[IND_OFDPA_WHEEL_LEVELS][IND_OFDPA_WHEEL_LEVEL_SIZE];
+static ind_ofdpa_flow_link_t pending_list;
+static uint32_t pending_count;
+
+static ind_ofdpa_flow_link_t check_list[IND_OFDPA_FLOW_EXPIRY_TABLES];
+static uint32_t check_count[IND_OFDPA_FLOW_EXPIRY_TABLES];
+static uint32_t check_total;
+static int sweep_table = -1;        /* table being walked, -1 if none */
+static uint32_t sweep_pass;         /* table walks started */
+static ofdpaFlowEntry_t sweep_flow; /* last flow the walk read */
+
+static ind_ofdpa_flow_timer_t **timer_hash;
+static uint32_t timer_hash_size;
+static uint32_t timer_count;
+static ind_ofdpa_flow_timer_t *timer_free_list;
+static ind_ofdpa_flow_timer_chunk_t *timer_chunks;
+
+static ind_ofdpa_flow_removed_t *removed_queue;
+static uint32_t removed_count;
+static uint32_t removed_size;
+
+static void ind_ofdpa_flow_link_init(ind_ofdpa_flow_link_t *head)
+{
+  head->next = head;
+  head->prev = head;
+}
+
+static int ind_ofdpa_flow_link_empty(ind_ofdpa_flow_link_t *head)
+{
+  return head->next == head;
+}
+
+static void ind_ofdpa_flow_link_append(ind_ofdpa_flow_link_t *head, ind_ofdpa_flow_link_t *link)
+{
+  link->prev = head->prev;
+  link->next = head;
+  head->prev->next = link;
+  head->prev = link;
+}
+
+static void ind_ofdpa_flow_link_remove(ind_ofdpa_flow_link_t *link)
+{
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = link;
+  link->prev = link;
+}
+
+static uint32_t ind_ofdpa_flow_expiry_now(void)
+{
+  return (uint32_t)(ind_ofdpa_rpc_now_ns() / 1000000ULL / expiry_tick_ms);
+}
+
+static uint32_t ind_ofdpa_flow_expiry_ticks(uint32_t ms)
+{
+  return (ms + expiry_tick_ms - 1) / expiry_tick_ms;
+}
+
+/* Tick comparison that survives wrap of the 32 bit tick counter */
+static int ind_ofdpa_flow_tick_reached(uint32_t tick, uint32_t now)
+{
+  return (int32_t)(now - tick) >= 0;
+}
+
+static void ind_ofdpa_flow_wheel_setup(void)
+{
+  int i;
+  int j;
+
+  if (wheel_ready)
+  {
+    return;
+  }
+
+  for (i = 0; i < IND_OFDPA_WHEEL_ROOT_SIZE; i++)
+  {
+    ind_ofdpa_flow_link_init(&wheel_root[i]);
+  }
+  for (i = 0; i < IND_OFDPA_WHEEL_LEVELS; i++)
+  {
+    for (j = 0; j < IND_OFDPA_WHEEL_LEVEL_SIZE; j++)
+    {
+      ind_ofdpa_flow_link_init(&wheel_level[i][j]);
+    }
+  }
+  ind_ofdpa_flow_link_init(&pending_list);
+  for (i = 0; i < IND_OFDPA_FLOW_EXPIRY_TABLES; i++)
+  {
+    ind_ofdpa_flow_link_init(&check_list[i]);
+  }
+  wheel_tick = ind_ofdpa_flow_expiry_now();
+  wheel_ready = 1;
+}
+
+static void ind_ofdpa_flow_wheel_insert(ind_ofdpa_flow_timer_t *timer)
+{
+  uint32_t expires = timer->expires;
+  uint32_t delta = expires - wheel_tick;
+  ind_ofdpa_flow_link_t *slot;
+  int level;
+
+  if ((int32_t)delta < 0)
+  {
+    /* Already due, runs with the next tick */
+    slot = &wheel_root[wheel_tick & IND_OFDPA_WHEEL_ROOT_MASK];
+  }
+  else if (delta < IND_OFDPA_WHEEL_ROOT_SIZE)
+  {
+    slot = &wheel_root[expires & IND_OFDPA_WHEEL_ROOT_MASK];
+  }
+  else
+  {
+    if (delta >= IND_OFDPA_WHEEL_SPAN)
+    {
+      expires = wheel_tick + IND_OFDPA_WHEEL_SPAN - 1;
+    }
+    for (level = 0; level < IND_OFDPA_WHEEL_LEVELS - 1; level++)
+    {
+      if (delta < (1u << (IND_OFDPA_WHEEL_ROOT_BITS + ((level + 1) * IND_OFDPA_WHEEL_LEVEL_BITS))))
+      {
+        break;
+      }
+    }
+    slot = &wheel_level[level][(expires >> (IND_OFDPA_WHEEL_ROOT_BITS + (level * IND_OFDPA_WHEEL_LEVEL_BITS))) &
+                               IND_OFDPA_WHEEL_LEVEL_MASK];
+  }
+
+  ind_ofdpa_flow_link_append(slot, &timer->link);
+}
+
+/* Move the timers of an upper level slot down to where they now belong */
+static void ind_ofdpa_flow_wheel_cascade(ind_ofdpa_flow_link_t *slot)
+{
+  ind_ofdpa_flow_link_t list;
+  ind_ofdpa_flow_link_t *link;
+
+  if (ind_ofdpa_flow_link_empty(slot))
+  {
+    return;
+  }
+
+  list.next = slot->next;
+  list.prev = slot->prev;
+  list.next->prev = &list;
+  list.prev->next = &list;
+  ind_ofdpa_flow_link_init(slot);
+
+  while (!ind_ofdpa_flow_link_empty(&list))
+  {
+    link = list.next;
+    ind_ofdpa_flow_link_remove(link);
+    ind_ofdpa_flow_wheel_insert((ind_ofdpa_flow_timer_t *)link);
+  }
+}
+
+/* Run every tick up to now, moving the timers that run out to the pending list */
+static void ind_ofdpa_flow_wheel_run(uint32_t now)
+{
+  ind_ofdpa_flow_link_t *slot;
+  ind_ofdpa_flow_timer_t *timer;
+  uint32_t index;
+  int level;
+
+  while (ind_ofdpa_flow_tick_reached(wheel_tick, now))
+  {
+    if ((wheel_tick & IND_OFDPA_WHEEL_ROOT_MASK) == 0)
+    {
+      for (level = 0; level < IND_OFDPA_WHEEL_LEVELS; level++)
+      {
+        index = (wheel_tick >> (IND_OFDPA_WHEEL_ROOT_BITS + (level * IND_OFDPA_WHEEL_LEVEL_BITS))) &
+                IND_OFDPA_WHEEL_LEVEL_MASK;
+        ind_ofdpa_flow_wheel_cascade(&wheel_level[level][index]);
+        if (index != 0)
+        {
+          break;
+        }
+      }
+    }
+
+    slot = &wheel_root[wheel_tick & IND_OFDPA_WHEEL_ROOT_MASK];
+    while (!ind_ofdpa_flow_link_empty(slot))
+    {
+      timer = (ind_ofdpa_flow_timer_t *)slot->next;
+      ind_ofdpa_flow_link_remove(&timer->link);
+      ind_ofdpa_flow_link_append(&pending_list, &timer->link);
+      timer->flags |= IND_OFDPA_FLOW_TIMER_F_PENDING;
+      pending_count++;
+    }
+
+    wheel_tick++;
+  }
+
+  if (pending_count > expiry_stats.max_pending)
+  {
+    expiry_stats.max_pending = pending_count;
+  }
+}
+
+static uint32_t ind_ofdpa_flow_timer_hash(uint64_t cookie)
+{
+  return (uint32_t)((cookie * 0x9e3779b97f4a7c15ULL) >> 32) & (timer_hash_size - 1);
+}
+
+static void ind_ofdpa_flow_timer_hash_grow(void)
+{
+  ind_ofdpa_flow_timer_t **old_hash = timer_hash;
+  ind_ofdpa_flow_timer_t **new_hash;
+  ind_ofdpa_flow_timer_t *timer;
+  uint32_t old_size = timer_hash_size;
+  uint32_t new_size = (old_size == 0) ? IND_OFDPA_FLOW_TIMER_HASH_MIN : (old_size * 2);
+  uint32_t bucket;
+  uint32_t i;
+
+  new_hash = calloc(new_size, sizeof(*new_hash));
+  if (new_hash == NULL)
+  {
+    /* Keep the current table with longer chains */
+    return;
+  }
+
+  timer_hash = new_hash;
+  timer_hash_size = new_size;
+  for (i = 0; i < old_size; i++)
+  {
+    while ((timer = old_hash[i]) != NULL)
+    {
+      old_hash[i] = timer->hash_next;
+      bucket = ind_ofdpa_flow_timer_hash(timer->cookie);
+      timer->hash_next = timer_hash[bucket];
+      timer_hash[bucket] = timer;
+    }
+  }
+  free(old_hash);
+}
+
+static ind_ofdpa_flow_timer_t **ind_ofdpa_flow_timer_find(uint64_t cookie)
+{
+  ind_ofdpa_flow_timer_t **prev;
+
+  if (timer_hash_size == 0)
+  {
+    return NULL;
+  }
+
+  for (prev = &timer_hash[ind_ofdpa_flow_timer_hash(cookie)]; *prev != NULL; prev = &(*prev)->hash_next)
+  {
+    if ((*prev)->cookie == cookie)
+    {
+      return prev;
+    }
+  }
+  return NULL;
+}
+
+static ind_ofdpa_flow_timer_t *ind_ofdpa_flow_timer_alloc(void)
+{
+  ind_ofdpa_flow_timer_chunk_t *chunk;
+  ind_ofdpa_flow_timer_t *timer;
+  int i;
+
+  if (timer_free_list == NULL)
+  {
+    chunk = malloc(sizeof(*chunk));
+    if (chunk == NULL)
+    {
+      return NULL;
+    }
+    chunk->next = timer_chunks;
+    timer_chunks = chunk;
+    for (i = IND_OFDPA_FLOW_TIMER_CHUNK - 1; i >= 0; i--)
+    {
+      chunk->timers[i].hash_next = timer_free_list;
+      timer_free_list = &chunk->timers[i];
+    }
+  }
+
+  timer = timer_free_list;
+  timer_free_list = timer->hash_next;
+  memset(timer, 0, sizeof(*timer));
+  return timer;
+}
+
+/* Take a timer off the wheel, pending list or check list */
+static void ind_ofdpa_flow_timer_unlink(ind_ofdpa_flow_timer_t *timer)
+{
+  if (timer->flags & IND_OFDPA_FLOW_TIMER_F_PENDING)
+  {
+    pending_count--;
+  }
+  if (timer->flags & IND_OFDPA_FLOW_TIMER_F_CHECK)
+  {
+    check_count[timer->table_id]--;
+    check_total--;
+  }
+  timer->flags &= ~(IND_OFDPA_FLOW_TIMER_F_PENDING | IND_OFDPA_FLOW_TIMER_F_CHECK);
+  ind_ofdpa_flow_link_remove(&timer->link);
+}
+
+/* Unhash, unlink and free a timer; prev is its hash chain link */
+static void ind_ofdpa_flow_timer_free(ind_ofdpa_flow_timer_t **prev)
+{
+  ind_ofdpa_flow_timer_t *timer = *prev;
+
+  *prev = timer->hash_next;
+  timer_count--;
+  ind_ofdpa_flow_timer_unlink(timer);
+
+  timer->hash_next = timer_free_list;
+  timer_free_list = timer;
+}
+
+static void ind_ofdpa_flow_timer_restart(ind_ofdpa_flow_timer_t *timer, uint32_t expires)
+{
+  ind_ofdpa_flow_timer_unlink(timer);
+
+  if ((timer->flags & IND_OFDPA_FLOW_TIMER_F_HARD) &&
+      ind_ofdpa_flow_tick_reached(timer->hard_expires, expires))
+  {
+    expires = timer->hard_expires;
+  }
+  timer->expires = expires;
+  ind_ofdpa_flow_wheel_insert(timer);
+}
+
+/* Leave an idle timer that ran out to the counter sweep of its table */
+static void ind_ofdpa_flow_timer_check(ind_ofdpa_flow_timer_t *timer)
+{
+  ind_ofdpa_flow_timer_unlink(timer);
+  timer->flags |= IND_OFDPA_FLOW_TIMER_F_CHECK;
+  timer->check_pass = sweep_pass;
+  ind_ofdpa_flow_link_append(&check_list[timer->table_id], &timer->link);
+  check_count[timer->table_id]++;
+  check_total++;
+  expiry_stats.checks++;
+}
+
+static void ind_ofdpa_flow_removed_report(uint64_t cookie, indigo_fi_flow_removed_t reason)
+{
+  ind_core_flow_expiry_handler(cookie, reason);
+  expiry_stats.reported++;
+}
+
+static void ind_ofdpa_flow_removed_flush(void)
+{
+  uint32_t i;
+
+  if (removed_count == 0)
+  {
+    return;
+  }
+
+  for (i = 0; i < removed_count; i++)
+  {
+    ind_ofdpa_flow_removed_report(removed_queue[i].cookie, removed_queue[i].reason);
+  }
+
+  expiry_stats.report_batches++;
+  if (removed_count > expiry_stats.max_report_batch)
+  {
+    expiry_stats.max_report_batch = removed_count;
+  }
+  removed_count = 0;
+}
+
+void ind_ofdpa_flow_expiry_notify(uint64_t cookie, indigo_fi_flow_removed_t reason)
+{
+  ind_ofdpa_flow_removed_t *queue;
+  uint32_t size;
+
+  if (!expiry_timer_running)
+  {
+    ind_ofdpa_flow_removed_report(cookie, reason);
+    return;
+  }
+
+  if (removed_count == removed_size)
+  {
+    size = (removed_size == 0) ? IND_OFDPA_FLOW_EXPIRY_BATCH : (removed_size * 2);
+    queue = realloc(removed_queue, size * sizeof(*queue));
+    if (queue == NULL)
+    {
+      ind_ofdpa_flow_removed_report(cookie, reason);
+      return;
+    }
+    removed_queue = queue;
+    removed_size = size;
+  }
+
+  removed_queue[removed_count].cookie = cookie;
+  removed_queue[removed_count].reason = reason;
+  removed_count++;
+}
+
+/*
+ * Work off up to a batch of timers that ran out. A hard timeout removes
+ * the flow. An idle timer restarts from the last read that saw the flow's
+ * packets move; if no read has since its idle time, the timer waits for
+ * the counter sweep.
+ */
+static void ind_ofdpa_flow_expiry_pending(uint32_t now)
+{
+  ind_ofdpa_flow_timer_t *timer;
+  ofdpaFlowEntry_t flow;
+  ofdpaFlowEntryStats_t flowStats;
+  uint64_t flow_id;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t budget = IND_OFDPA_FLOW_EXPIRY_BATCH;
+  uint32_t retry = ind_ofdpa_flow_expiry_ticks(IND_OFDPA_FLOW_EXPIRY_RETRY_MS);
+
+  if (pending_count == 0)
+  {
+    return;
+  }
+
+  while ((budget != 0) && !ind_ofdpa_flow_link_empty(&pending_list))
+  {
+    timer = (ind_ofdpa_flow_timer_t *)pending_list.next;
+
+    /* Parked beyond the span of the wheel */
+    if (!ind_ofdpa_flow_tick_reached(timer->expires, now))
+    {
+      ind_ofdpa_flow_timer_restart(timer, timer->expires);
+      continue;
+    }
+
+    if (!(timer->flags & IND_OFDPA_FLOW_TIMER_F_HARD) ||
+        !ind_ofdpa_flow_tick_reached(timer->hard_expires, now))
+    {
+      if (!ind_ofdpa_flow_tick_reached(timer->seen + timer->idle_ticks, now))
+      {
+        expiry_stats.restarted++;
+        ind_ofdpa_flow_timer_restart(timer, timer->seen + timer->idle_ticks);
+      }
+      else
+      {
+        ind_ofdpa_flow_timer_check(timer);
+      }
+      continue;
+    }
+
+    budget--;
+    memset(&flow, 0, sizeof(flow));
+    ofdpa_rv = ofdpaFlowByCookieGet(timer->cookie, &flow, &flowStats);
+    expiry_stats.reads++;
+    if (ofdpa_rv == OFDPA_E_NOT_FOUND)
+    {
+      expiry_stats.vanished++;
+      ind_ofdpa_flow_timer_free(ind_ofdpa_flow_timer_find(timer->cookie));
+      continue;
+    }
+    if (ofdpa_rv == OFDPA_E_NONE)
+    {
+      ofdpa_rv = ind_ofdpa_flow_expire(&flow, &flow_id);
+    }
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to expire flow 0x%llx. (ofdpa_rv = %d)",
+                (unsigned long long)timer->cookie, ofdpa_rv);
+      expiry_stats.errors++;
+      ind_ofdpa_flow_timer_restart(timer, now + retry);
+      continue;
+    }
+
+    LOG_TRACE("Flow 0x%llx expired on hard timeout", (unsigned long long)timer->cookie);
+    expiry_stats.expired_hard++;
+    ind_ofdpa_flow_expiry_notify(flow_id, INDIGO_FLOW_REMOVED_HARD_TIMEOUT);
+    ind_ofdpa_flow_timer_free(ind_ofdpa_flow_timer_find(timer->cookie));
+  }
+}
+
+/* Start a walk of the next table after table with timers waiting on it */
+static void ind_ofdpa_flow_sweep_start(int table)
+{
+  int i;
+
+  sweep_table = -1;
+  for (i = 1; i <= IND_OFDPA_FLOW_EXPIRY_TABLES; i++)
+  {
+    if (check_count[(table + i) & (IND_OFDPA_FLOW_EXPIRY_TABLES - 1)] != 0)
+    {
+      sweep_table = (table + i) & (IND_OFDPA_FLOW_EXPIRY_TABLES - 1);
+      break;
+    }
+  }
+  if (sweep_table < 0)
+  {
+    return;
+  }
+
+  sweep_pass++;
+  expiry_stats.sweeps++;
+  memset(&sweep_flow, 0, sizeof(sweep_flow));
+  sweep_flow.tableId = sweep_table;
+}
+
+/* The walk read the whole table; a timer that waited since before it
+   started and was not settled has no flow left in OF-DPA */
+static void ind_ofdpa_flow_sweep_end(void)
+{
+  ind_ofdpa_flow_link_t *list = &check_list[sweep_table];
+  ind_ofdpa_flow_link_t *link;
+  ind_ofdpa_flow_link_t *next;
+  ind_ofdpa_flow_timer_t *timer;
+
+  for (link = list->next; link != list; link = next)
+  {
+    next = link->next;
+    timer = (ind_ofdpa_flow_timer_t *)link;
+    if (timer->check_pass != sweep_pass)
+    {
+      expiry_stats.vanished++;
+      ind_ofdpa_flow_timer_free(ind_ofdpa_flow_timer_find(timer->cookie));
+    }
+  }
+
+  ind_ofdpa_flow_sweep_start(sweep_table);
+}
+
+/*
+ * Read the counters of up to a batch of flows, walking the tables with
+ * idle timers waiting on them. Every tracked flow read whose packets
+ * moved is marked seen; a waiting timer whose flow moved restarts, one
+ * whose flow did not is removed.
+ */
+static void ind_ofdpa_flow_expiry_sweep(uint32_t now)
+{
+  ind_ofdpa_flow_timer_t **prev;
+  ind_ofdpa_flow_timer_t *timer;
+  ofdpaFlowEntry_t flow;
+  ofdpaFlowEntryStats_t flowStats;
+  uint64_t flow_id;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t budget = IND_OFDPA_FLOW_EXPIRY_BATCH;
+  uint32_t retry = ind_ofdpa_flow_expiry_ticks(IND_OFDPA_FLOW_EXPIRY_RETRY_MS);
+  int hard;
+
+  if (sweep_table < 0)
+  {
+    if (check_total == 0)
+    {
+      return;
+    }
+    ind_ofdpa_flow_sweep_start(-1);
+  }
+
+  while ((budget != 0) && (sweep_table >= 0))
+  {
+    budget--;
+    ofdpa_rv = ofdpaFlowNextGet(&sweep_flow, &flow);
+    if (ofdpa_rv == OFDPA_E_NOT_FOUND)
+    {
+      ind_ofdpa_flow_sweep_end();
+      continue;
+    }
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to walk flow table %d for expiry. (ofdpa_rv = %d)",
+                sweep_table, ofdpa_rv);
+      expiry_stats.errors++;
+      break;
+    }
+    sweep_flow = flow;
+
+    prev = ind_ofdpa_flow_timer_find(flow.cookie);
+    if ((prev == NULL) || ((*prev)->idle_ticks == 0))
+    {
+      continue;
+    }
+    timer = *prev;
+
+    memset(&flowStats, 0, sizeof(flowStats));
+    ofdpa_rv = ofdpaFlowStatsGet(&flow, &flowStats);
+    expiry_stats.reads++;
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to read flow 0x%llx for expiry. (ofdpa_rv = %d)",
+                (unsigned long long)timer->cookie, ofdpa_rv);
+      expiry_stats.errors++;
+      /* Wait for the next walk */
+      timer->check_pass = sweep_pass;
+      continue;
+    }
+
+    if (flowStats.receivedPackets != timer->packets)
+    {
+      timer->packets = flowStats.receivedPackets;
+      timer->seen = now;
+      if (timer->flags & IND_OFDPA_FLOW_TIMER_F_CHECK)
+      {
+        expiry_stats.restarted++;
+        ind_ofdpa_flow_timer_restart(timer, now + timer->idle_ticks);
+      }
+      continue;
+    }
+    if (!(timer->flags & IND_OFDPA_FLOW_TIMER_F_CHECK))
+    {
+      continue;
+    }
+
+    hard = (timer->flags & IND_OFDPA_FLOW_TIMER_F_HARD) &&
+           ind_ofdpa_flow_tick_reached(timer->hard_expires, now);
+    ofdpa_rv = ind_ofdpa_flow_expire(&flow, &flow_id);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to delete expired flow 0x%llx. (ofdpa_rv = %d)",
+                (unsigned long long)timer->cookie, ofdpa_rv);
+      expiry_stats.errors++;
+      ind_ofdpa_flow_timer_restart(timer, now + retry);
+      continue;
+    }
+
+    LOG_TRACE("Flow 0x%llx expired on %s timeout", (unsigned long long)timer->cookie,
+              hard ? "hard" : "idle");
+    if (hard)
+    {
+      expiry_stats.expired_hard++;
+    }
+    else
+    {
+      expiry_stats.expired_idle++;
+    }
+    ind_ofdpa_flow_expiry_notify(flow_id, hard ? INDIGO_FLOW_REMOVED_HARD_TIMEOUT :
+                                                 INDIGO_FLOW_REMOVED_IDLE_TIMEOUT);
+    ind_ofdpa_flow_timer_free(prev);
+  }
+}
+
+static void ind_ofdpa_flow_expiry_timer(void *cookie)
+{
+  uint64_t start_ns = ind_ofdpa_rpc_now_ns();
+  uint64_t elapsed_ns;
+  uint32_t now = (uint32_t)(start_ns / 1000000ULL / expiry_tick_ms);
+
+  if (wheel_ready)
+  {
+    ind_ofdpa_flow_wheel_run(now);
+    ind_ofdpa_flow_expiry_pending(now);
+    ind_ofdpa_flow_expiry_sweep(now);
+  }
+  ind_ofdpa_flow_removed_flush();
+
+  expiry_stats.ticks++;
+  elapsed_ns = ind_ofdpa_rpc_now_ns() - start_ns;
+  if (elapsed_ns > expiry_stats.max_tick_ns)
+  {
+    expiry_stats.max_tick_ns = elapsed_ns;
+  }
+}
+
+void ind_ofdpa_flow_expiry_enable_set(int enable)
+{
+  expiry_enabled = (enable != 0);
+  LOG_VERBOSE("Agent flow expiry %s", expiry_enabled ? "enabled" : "disabled");
+}
+
+int ind_ofdpa_flow_expiry_enable_get(void)
+{
+  return expiry_enabled;
+}
+
+indigo_error_t ind_ofdpa_flow_expiry_init(uint32_t tick_ms)
+{
+  indigo_error_t err;
+
+  ind_ofdpa_flow_expiry_finish();
+
+  if (tick_ms == 0)
+  {
+    return INDIGO_ERROR_PARAM;
+  }
+
+  /* Tracked timers are in ticks of the old length */
+  if ((tick_ms != expiry_tick_ms) && (timer_count != 0))
+  {
+    LOG_ERROR("Cannot change the flow expiry tick with %u flows tracked.", timer_count);
+    return INDIGO_ERROR_PARAM;
+  }
+  expiry_tick_ms = tick_ms;
+
+  err = ind_ofdpa_loop_timer_register(ind_ofdpa_flow_expiry_timer, NULL, tick_ms,
+                                      "flow expiry");
+  if (err < 0)
+  {
+    LOG_ERROR("Failed to register flow expiry timer.");
+    return err;
+  }
+
+  expiry_timer_running = 1;
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_flow_expiry_finish(void)
+{
+  if (expiry_timer_running)
+  {
+    ind_ofdpa_loop_timer_unregister(ind_ofdpa_flow_expiry_timer, NULL);
+    expiry_timer_running = 0;
+    ind_ofdpa_flow_removed_flush();
+  }
+}
+
+indigo_error_t ind_ofdpa_flow_expiry_add(uint32_t table_id, uint64_t cookie,
+                                         uint16_t idle_time, uint16_t hard_time)
+{
+  ind_ofdpa_flow_timer_t **prev;
+  ind_ofdpa_flow_timer_t *timer;
+  uint32_t now;
+  uint32_t bucket;
+
+  if ((idle_time == 0) && (hard_time == 0))
+  {
+    return INDIGO_ERROR_NONE;
+  }
+  if (table_id >= IND_OFDPA_FLOW_EXPIRY_TABLES)
+  {
+    return INDIGO_ERROR_PARAM;
+  }
+
+  ind_ofdpa_flow_wheel_setup();
+
+  /* A re-added cookie starts over */
+  prev = ind_ofdpa_flow_timer_find(cookie);
+  if (prev != NULL)
+  {
+    ind_ofdpa_flow_timer_free(prev);
+  }
+
+  if (timer_count >= timer_hash_size)
+  {
+    ind_ofdpa_flow_timer_hash_grow();
+    if (timer_hash_size == 0)
+    {
+      return INDIGO_ERROR_RESOURCE;
+    }
+  }
+
+  timer = ind_ofdpa_flow_timer_alloc();
+  if (timer == NULL)
+  {
+    LOG_ERROR("No memory to track timeouts of flow 0x%llx", (unsigned long long)cookie);
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  now = ind_ofdpa_flow_expiry_now();
+  timer->cookie = cookie;
+  timer->table_id = table_id;
+  timer->seen = now;
+  ind_ofdpa_flow_link_init(&timer->link);
+  timer->idle_ticks = ind_ofdpa_flow_expiry_ticks((uint32_t)idle_time * 1000);
+  if (hard_time != 0)
+  {
+    timer->flags |= IND_OFDPA_FLOW_TIMER_F_HARD;
+    timer->hard_expires = now + ind_ofdpa_flow_expiry_ticks((uint32_t)hard_time * 1000);
+  }
+
+  bucket = ind_ofdpa_flow_timer_hash(cookie);
+  timer->hash_next = timer_hash[bucket];
+  timer_hash[bucket] = timer;
+  timer_count++;
+
+  ind_ofdpa_flow_timer_restart(timer, (idle_time != 0) ? (now + timer->idle_ticks) : timer->hard_expires);
+  expiry_stats.added++;
+
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_flow_expiry_cancel(uint64_t cookie)
+{
+  ind_ofdpa_flow_timer_t **prev;
+
+  prev = ind_ofdpa_flow_timer_find(cookie);
+  if (prev != NULL)
+  {
+    ind_ofdpa_flow_timer_free(prev);
+    expiry_stats.cancelled++;
+  }
+}
+
+void ind_ofdpa_flow_expiry_show(aim_pvs_t *pvs)
+{
+  uint32_t root_used = 0;
+  uint32_t level_used[IND_OFDPA_WHEEL_LEVELS];
+  int i;
+  int j;
+
+  memset(level_used, 0, sizeof(level_used));
+  if (wheel_ready)
+  {
+    for (i = 0; i < IND_OFDPA_WHEEL_ROOT_SIZE; i++)
+    {
+      root_used += !ind_ofdpa_flow_link_empty(&wheel_root[i]);
+    }
+    for (i = 0; i < IND_OFDPA_WHEEL_LEVELS; i++)
+    {
+      for (j = 0; j < IND_OFDPA_WHEEL_LEVEL_SIZE; j++)
+      {
+        level_used[i] += !ind_ofdpa_flow_link_empty(&wheel_level[i][j]);
+      }
+    }
+  }
+
+  aim_printf(pvs, "agent expiry %s, tick %u ms, timer %s\n",
+             expiry_enabled ? "enabled" : "disabled", expiry_tick_ms,
+             expiry_timer_running ? "running" : "stopped");
+  aim_printf(pvs, "flows tracked %u  pending %u (max %u)  hash buckets %u\n",
+             timer_count, pending_count, expiry_stats.max_pending, timer_hash_size);
+  aim_printf(pvs, "waiting for sweep %u  sweeping table %d\n", check_total, sweep_table);
+  aim_printf(pvs, "slots in use: root %u/%u  levels %u/%u/%u of %u\n",
+             root_used, IND_OFDPA_WHEEL_ROOT_SIZE,
+             level_used[0], level_used[1], level_used[2], IND_OFDPA_WHEEL_LEVEL_SIZE);
+  aim_printf(pvs, "added %llu  cancelled %llu  reads %llu  restarted %llu\n",
+             (unsigned long long)expiry_stats.added,
+             (unsigned long long)expiry_stats.cancelled,
+             (unsigned long long)expiry_stats.reads,
+             (unsigned long long)expiry_stats.restarted);
+  aim_printf(pvs, "sent to sweep %llu  table walks %llu\n",
+             (unsigned long long)expiry_stats.checks,
+             (unsigned long long)expiry_stats.sweeps);
+  aim_printf(pvs, "expired idle %llu  hard %llu  vanished %llu  errors %llu\n",
+             (unsigned long long)expiry_stats.expired_idle,
+             (unsigned long long)expiry_stats.expired_hard,
+             (unsigned long long)expiry_stats.vanished,
+             (unsigned long long)expiry_stats.errors);
+  aim_printf(pvs, "reported %llu in %llu batches (max %u)\n",
+             (unsigned long long)expiry_stats.reported,
+             (unsigned long long)expiry_stats.report_batches,
+             expiry_stats.max_report_batch);
+  aim_printf(pvs, "ticks %llu  max tick %.1f us\n",
+             (unsigned long long)expiry_stats.ticks,
+             expiry_stats.max_tick_ns / 1000.0);
+}
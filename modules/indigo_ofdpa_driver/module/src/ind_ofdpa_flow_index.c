@@ -0,0 +1,432 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_flow_index.c
+*
+* @purpose      Secondary indexes over the flows programmed in OF-DPA
+*
+* @component    OF-DPA
+*
+* @comments     Each flow has one node, found by cookie through a hash
+*               that doubles as it fills, and linked on a chain per
+*               table and, if it has them, on a chain of a fixed hash
+*               by output group and one by output port. The chains are
+*               doubly linked so a flow leaves them in constant time.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_index.h>
+
+#define IND_OFDPA_FLOW_INDEX_TABLES        256
+#define IND_OFDPA_FLOW_INDEX_BUCKETS_LOG2  12
+#define IND_OFDPA_FLOW_INDEX_BUCKETS       (1 << IND_OFDPA_FLOW_INDEX_BUCKETS_LOG2)
+
+typedef enum
+{
+  IND_OFDPA_FLOW_LINK_TABLE = 0,
+  IND_OFDPA_FLOW_LINK_GROUP = 1,
+  IND_OFDPA_FLOW_LINK_PORT  = 2,
+  IND_OFDPA_FLOW_LINKS
+} ind_ofdpa_flow_link_t;
+
+typedef struct ind_ofdpa_flow_index_node_s
+{
+  struct ind_ofdpa_flow_index_node_s  *cookie_next;
+  struct ind_ofdpa_flow_index_node_s  *next[IND_OFDPA_FLOW_LINKS];
+  struct ind_ofdpa_flow_index_node_s **pprev[IND_OFDPA_FLOW_LINKS];   /* NULL if not linked */
+  ind_ofdpa_flow_index_entry_t         entry;
+} ind_ofdpa_flow_index_node_t;
+
+static ind_ofdpa_flow_index_node_t **cookie_hash;
+static uint32_t cookie_hash_size;
+static uint32_t flow_count;
+
+static ind_ofdpa_flow_index_node_t *table_chains[IND_OFDPA_FLOW_INDEX_TABLES];
+static ind_ofdpa_flow_index_node_t *group_chains[IND_OFDPA_FLOW_INDEX_BUCKETS];
+static ind_ofdpa_flow_index_node_t *port_chains[IND_OFDPA_FLOW_INDEX_BUCKETS];
+static uint32_t table_count[IND_OFDPA_FLOW_INDEX_TABLES];
+static uint32_t group_linked;
+static uint32_t port_linked;
+
+static struct
+{
+  uint64_t batches;
+  uint64_t deleted;
+  uint64_t failed;
+  uint64_t total_ns;
+  uint64_t max_ns;
+} table_delete_stats[IND_OFDPA_FLOW_INDEX_TABLES];
+
+static uint32_t ind_ofdpa_flow_index_cookie_hash(uint64_t cookie)
+{
+  return (uint32_t)(cookie ^ (cookie >> 32)) * 2654435761u;
+}
+
+static uint32_t ind_ofdpa_flow_index_bucket(uint32_t key)
+{
+  return (key * 2654435761u) >> (32 - IND_OFDPA_FLOW_INDEX_BUCKETS_LOG2);
+}
+
+static void ind_ofdpa_flow_index_link(ind_ofdpa_flow_index_node_t *node, ind_ofdpa_flow_link_t link,
+                                      ind_ofdpa_flow_index_node_t **head)
+{
+  node->next[link] = *head;
+  if (*head != NULL)
+  {
+    (*head)->pprev[link] = &node->next[link];
+  }
+  *head = node;
+  node->pprev[link] = head;
+}
+
+static void ind_ofdpa_flow_index_unlink(ind_ofdpa_flow_index_node_t *node, ind_ofdpa_flow_link_t link)
+{
+  if (node->pprev[link] == NULL)
+  {
+    return;
+  }
+  *node->pprev[link] = node->next[link];
+  if (node->next[link] != NULL)
+  {
+    node->next[link]->pprev[link] = node->pprev[link];
+  }
+  node->next[link] = NULL;
+  node->pprev[link] = NULL;
+}
+
+static void ind_ofdpa_flow_index_chains_leave(ind_ofdpa_flow_index_node_t *node)
+{
+  ind_ofdpa_flow_index_unlink(node, IND_OFDPA_FLOW_LINK_TABLE);
+  table_count[node->entry.table_id]--;
+  if (node->pprev[IND_OFDPA_FLOW_LINK_GROUP] != NULL)
+  {
+    ind_ofdpa_flow_index_unlink(node, IND_OFDPA_FLOW_LINK_GROUP);
+    group_linked--;
+  }
+  if (node->pprev[IND_OFDPA_FLOW_LINK_PORT] != NULL)
+  {
+    ind_ofdpa_flow_index_unlink(node, IND_OFDPA_FLOW_LINK_PORT);
+    port_linked--;
+  }
+}
+
+static void ind_ofdpa_flow_index_chains_join(ind_ofdpa_flow_index_node_t *node)
+{
+  ind_ofdpa_flow_index_link(node, IND_OFDPA_FLOW_LINK_TABLE, &table_chains[node->entry.table_id]);
+  table_count[node->entry.table_id]++;
+  if (node->entry.group_id != 0)
+  {
+    ind_ofdpa_flow_index_link(node, IND_OFDPA_FLOW_LINK_GROUP,
+                              &group_chains[ind_ofdpa_flow_index_bucket(node->entry.group_id)]);
+    group_linked++;
+  }
+  if (node->entry.port != 0)
+  {
+    ind_ofdpa_flow_index_link(node, IND_OFDPA_FLOW_LINK_PORT,
+                              &port_chains[ind_ofdpa_flow_index_bucket(node->entry.port)]);
+    port_linked++;
+  }
+}
+
+static ind_ofdpa_flow_index_node_t *ind_ofdpa_flow_index_find(uint64_t cookie)
+{
+  ind_ofdpa_flow_index_node_t *node;
+
+  if (cookie_hash_size == 0)
+  {
+    return NULL;
+  }
+  node = cookie_hash[ind_ofdpa_flow_index_cookie_hash(cookie) & (cookie_hash_size - 1)];
+  while ((node != NULL) && (node->entry.cookie != cookie))
+  {
+    node = node->cookie_next;
+  }
+  return node;
+}
+
+static void ind_ofdpa_flow_index_grow(void)
+{
+  ind_ofdpa_flow_index_node_t **grown;
+  ind_ofdpa_flow_index_node_t *node;
+  uint32_t size;
+  uint32_t bucket;
+  uint32_t i;
+
+  size = (cookie_hash_size == 0) ? 1024 : (cookie_hash_size * 2);
+  grown = calloc(size, sizeof(*grown));
+  if (grown == NULL)
+  {
+    return;
+  }
+  for (i = 0; i < cookie_hash_size; i++)
+  {
+    while ((node = cookie_hash[i]) != NULL)
+    {
+      cookie_hash[i] = node->cookie_next;
+      bucket = ind_ofdpa_flow_index_cookie_hash(node->entry.cookie) & (size - 1);
+      node->cookie_next = grown[bucket];
+      grown[bucket] = node;
+    }
+  }
+  free(cookie_hash);
+  cookie_hash = grown;
+  cookie_hash_size = size;
+}
+
+indigo_error_t ind_ofdpa_flow_index_set(const ind_ofdpa_flow_index_entry_t *entry)
+{
+  ind_ofdpa_flow_index_node_t *node;
+  uint32_t bucket;
+
+  node = ind_ofdpa_flow_index_find(entry->cookie);
+  if (node != NULL)
+  {
+    ind_ofdpa_flow_index_chains_leave(node);
+    node->entry = *entry;
+    ind_ofdpa_flow_index_chains_join(node);
+    return INDIGO_ERROR_NONE;
+  }
+
+  if (flow_count >= cookie_hash_size)
+  {
+    ind_ofdpa_flow_index_grow();
+  }
+  node = calloc(1, sizeof(*node));
+  if ((node == NULL) || (cookie_hash_size == 0))
+  {
+    LOG_ERROR("Failed to index flow 0x%llx", (unsigned long long)entry->cookie);
+    free(node);
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  node->entry = *entry;
+  bucket = ind_ofdpa_flow_index_cookie_hash(entry->cookie) & (cookie_hash_size - 1);
+  node->cookie_next = cookie_hash[bucket];
+  cookie_hash[bucket] = node;
+  flow_count++;
+  ind_ofdpa_flow_index_chains_join(node);
+
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_flow_index_remove(uint64_t cookie)
+{
+  ind_ofdpa_flow_index_node_t **prev;
+  ind_ofdpa_flow_index_node_t *node;
+
+  if (cookie_hash_size == 0)
+  {
+    return;
+  }
+  prev = &cookie_hash[ind_ofdpa_flow_index_cookie_hash(cookie) & (cookie_hash_size - 1)];
+  for (; (node = *prev) != NULL; prev = &node->cookie_next)
+  {
+    if (node->entry.cookie == cookie)
+    {
+      *prev = node->cookie_next;
+      flow_count--;
+      ind_ofdpa_flow_index_chains_leave(node);
+      free(node);
+      return;
+    }
+  }
+}
+
+static int ind_ofdpa_flow_index_match(const ind_ofdpa_flow_index_entry_t *entry,
+                                      const ind_ofdpa_flow_query_t *query)
+{
+  return ((!(query->fields & IND_OFDPA_FLOW_QUERY_TABLE) || (entry->table_id == query->table_id)) &&
+          (!(query->fields & IND_OFDPA_FLOW_QUERY_GROUP) || (entry->group_id == query->group_id)) &&
+          (!(query->fields & IND_OFDPA_FLOW_QUERY_PORT)  || (entry->port == query->port)));
+}
+
+/* Visit the flows matching query until fn returns non-zero */
+static void ind_ofdpa_flow_index_walk(const ind_ofdpa_flow_query_t *query,
+                                      int (*fn)(const ind_ofdpa_flow_index_entry_t *entry, void *cookie),
+                                      void *cookie)
+{
+  ind_ofdpa_flow_index_node_t *node;
+  ind_ofdpa_flow_link_t link;
+  uint32_t i;
+
+  if (query->fields & IND_OFDPA_FLOW_QUERY_GROUP)
+  {
+    link = IND_OFDPA_FLOW_LINK_GROUP;
+    node = group_chains[ind_ofdpa_flow_index_bucket(query->group_id)];
+  }
+  else if (query->fields & IND_OFDPA_FLOW_QUERY_PORT)
+  {
+    link = IND_OFDPA_FLOW_LINK_PORT;
+    node = port_chains[ind_ofdpa_flow_index_bucket(query->port)];
+  }
+  else if (query->fields & IND_OFDPA_FLOW_QUERY_TABLE)
+  {
+    link = IND_OFDPA_FLOW_LINK_TABLE;
+    node = table_chains[query->table_id];
+  }
+  else
+  {
+    for (i = 0; i < cookie_hash_size; i++)
+    {
+      for (node = cookie_hash[i]; node != NULL; node = node->cookie_next)
+      {
+        if (fn(&node->entry, cookie))
+        {
+          return;
+        }
+      }
+    }
+    return;
+  }
+
+  for (; node != NULL; node = node->next[link])
+  {
+    if (ind_ofdpa_flow_index_match(&node->entry, query) && fn(&node->entry, cookie))
+    {
+      return;
+    }
+  }
+}
+
+typedef struct
+{
+  ind_ofdpa_flow_index_entry_t *entries;
+  uint32_t                      max;
+  uint32_t                      count;
+} ind_ofdpa_flow_index_collect_t;
+
+static int ind_ofdpa_flow_index_collect_one(const ind_ofdpa_flow_index_entry_t *entry, void *cookie)
+{
+  ind_ofdpa_flow_index_collect_t *collect = cookie;
+
+  if (collect->entries != NULL)
+  {
+    collect->entries[collect->count] = *entry;
+  }
+  collect->count++;
+  return (collect->count >= collect->max);
+}
+
+static int ind_ofdpa_flow_index_table_cmp(const void *a, const void *b)
+{
+  return (int)((const ind_ofdpa_flow_index_entry_t *)a)->table_id -
+         (int)((const ind_ofdpa_flow_index_entry_t *)b)->table_id;
+}
+
+uint32_t ind_ofdpa_flow_index_collect(const ind_ofdpa_flow_query_t *query,
+                                      ind_ofdpa_flow_index_entry_t *entries, uint32_t max)
+{
+  ind_ofdpa_flow_index_collect_t collect = { entries, max, 0 };
+
+  if (max == 0)
+  {
+    return 0;
+  }
+  ind_ofdpa_flow_index_walk(query, ind_ofdpa_flow_index_collect_one, &collect);
+  if (!(query->fields & IND_OFDPA_FLOW_QUERY_TABLE))
+  {
+    qsort(entries, collect.count, sizeof(*entries), ind_ofdpa_flow_index_table_cmp);
+  }
+
+  return collect.count;
+}
+
+uint32_t ind_ofdpa_flow_index_count(const ind_ofdpa_flow_query_t *query)
+{
+  ind_ofdpa_flow_index_collect_t collect = { NULL, 0xFFFFFFFF, 0 };
+
+  if (query->fields == IND_OFDPA_FLOW_QUERY_TABLE)
+  {
+    return table_count[query->table_id];
+  }
+  ind_ofdpa_flow_index_walk(query, ind_ofdpa_flow_index_collect_one, &collect);
+
+  return collect.count;
+}
+
+void ind_ofdpa_flow_index_delete_account(uint8_t table_id, uint32_t count, uint32_t failed,
+                                         uint64_t elapsed_ns)
+{
+  table_delete_stats[table_id].batches++;
+  table_delete_stats[table_id].deleted += count - failed;
+  table_delete_stats[table_id].failed += failed;
+  table_delete_stats[table_id].total_ns += elapsed_ns;
+  if (elapsed_ns > table_delete_stats[table_id].max_ns)
+  {
+    table_delete_stats[table_id].max_ns = elapsed_ns;
+  }
+}
+
+void ind_ofdpa_flow_index_finish(void)
+{
+  ind_ofdpa_flow_index_node_t *node;
+  uint32_t i;
+
+  for (i = 0; i < cookie_hash_size; i++)
+  {
+    while ((node = cookie_hash[i]) != NULL)
+    {
+      cookie_hash[i] = node->cookie_next;
+      free(node);
+    }
+  }
+  free(cookie_hash);
+  cookie_hash = NULL;
+  cookie_hash_size = 0;
+  flow_count = 0;
+  group_linked = 0;
+  port_linked = 0;
+  memset(table_chains, 0, sizeof(table_chains));
+  memset(group_chains, 0, sizeof(group_chains));
+  memset(port_chains, 0, sizeof(port_chains));
+  memset(table_count, 0, sizeof(table_count));
+}
+
+void ind_ofdpa_flow_index_show(aim_pvs_t *pvs)
+{
+  uint32_t i;
+
+  aim_printf(pvs, "flows %u (hash buckets %u)  with output group %u  with output port %u\n",
+             flow_count, cookie_hash_size, group_linked, port_linked);
+  aim_printf(pvs, "%-5s %8s %9s %9s %7s %11s %11s\n",
+             "table", "flows", "batches", "deleted", "failed", "avg us/flow", "max batch us");
+  for (i = 0; i < IND_OFDPA_FLOW_INDEX_TABLES; i++)
+  {
+    if ((table_count[i] == 0) && (table_delete_stats[i].batches == 0))
+    {
+      continue;
+    }
+    aim_printf(pvs, "%-5u %8u %9llu %9llu %7llu %11.1f %11.1f\n",
+               i, table_count[i],
+               (unsigned long long)table_delete_stats[i].batches,
+               (unsigned long long)table_delete_stats[i].deleted,
+               (unsigned long long)table_delete_stats[i].failed,
+               ((table_delete_stats[i].deleted + table_delete_stats[i].failed) == 0) ? 0.0 :
+               (table_delete_stats[i].total_ns / 1000.0 /
+                (table_delete_stats[i].deleted + table_delete_stats[i].failed)),
+               table_delete_stats[i].max_ns / 1000.0);
+  }
+}
@@ -34,6 +34,12 @@
 #include <indigo/memory.h>
 #include <indigo/forwarding.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_expiry.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_index.h>
 #include <indigo/of_state_manager.h>
 #include <indigo/fi.h>
 #include <OFStateManager/ofstatemanager.h>
@@ -42,6 +48,7 @@
 #include <linux/tcp.h>
 #include <linux/udp.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <pthread.h>
 #include <errno.h>
 
@@ -85,6 +92,8 @@ indTableNameList_t tableNameList[] =
 
 #define TABLE_NAME_LIST_SIZE (sizeof(tableNameList)/sizeof(tableNameList[0]))
 
+const uint32_t tableNameListSize = TABLE_NAME_LIST_SIZE;
+
 static indigo_error_t ind_ofdpa_match_fields_prerequisite_validate(const of_match_t *match, OFDPA_FLOW_TABLE_ID_t tableId)
 {
   indigo_error_t err = INDIGO_ERROR_NONE;
@@ -2466,7 +2475,13 @@ ind_ofdpa_instructions_get(of_flow_modify_t *flow_mod, ofdpaFlowEntry_t *flow)
         break;
       case OF_INSTRUCTION_METER:
         of_instruction_meter_meter_id_get(&inst, &meter_id);
-        LOG_ERROR("Unsupported instruction: meter_id.");
+        if (flow->tableId != OFDPA_FLOW_TABLE_ID_ACL_POLICY)
+        {
+          LOG_ERROR("Unsupported instruction %s for flow table %d.", of_object_id_str[inst.object_id], flow->tableId);
+          return INDIGO_ERROR_COMPAT;
+        }
+        flow->flowData.policyAclFlowEntry.meterIdAction = 1;
+        flow->flowData.policyAclFlowEntry.meterId = meter_id;
         break;
       default:
         LOG_ERROR("Invalid instruction.");
@@ -2547,6 +2562,508 @@ indigo_error_t indigo_fwd_forwarding_features_get(of_features_reply_t *features_
   return INDIGO_ERROR_NONE;
 }
 
+/* Group a flow points at through a group action, or 0 if none */
+static uint32_t ind_ofdpa_flow_group_get(const ofdpaFlowEntry_t *flow)
+{
+  switch (flow->tableId)
+  {
+    case OFDPA_FLOW_TABLE_ID_MPLS_L2_PORT:
+      return flow->flowData.mplsL2PortFlowEntry.groupId;
+
+    case OFDPA_FLOW_TABLE_ID_MPLS_0:
+    case OFDPA_FLOW_TABLE_ID_MPLS_1:
+    case OFDPA_FLOW_TABLE_ID_MPLS_2:
+      return flow->flowData.mplsFlowEntry.groupID;
+
+    case OFDPA_FLOW_TABLE_ID_UNICAST_ROUTING:
+      return flow->flowData.unicastRoutingFlowEntry.groupID;
+
+    case OFDPA_FLOW_TABLE_ID_MULTICAST_ROUTING:
+      return flow->flowData.multicastRoutingFlowEntry.groupID;
+
+    case OFDPA_FLOW_TABLE_ID_BRIDGING:
+      return flow->flowData.bridgingFlowEntry.groupID;
+
+    case OFDPA_FLOW_TABLE_ID_ACL_POLICY:
+      return flow->flowData.policyAclFlowEntry.groupID;
+
+    default:
+      return 0;
+  }
+}
+
+static uint32_t ind_ofdpa_flow_port_get(const ofdpaFlowEntry_t *flow)
+{
+  switch (flow->tableId)
+  {
+    case OFDPA_FLOW_TABLE_ID_MAINTENANCE_POINT:
+      return flow->flowData.mpFlowEntry.outputPort;
+
+    case OFDPA_FLOW_TABLE_ID_TERMINATION_MAC:
+      return flow->flowData.terminationMacFlowEntry.outputPort;
+
+    case OFDPA_FLOW_TABLE_ID_MPLS_MAINTENANCE_POINT:
+      return flow->flowData.mplsMpFlowEntry.outputPort;
+
+    case OFDPA_FLOW_TABLE_ID_BRIDGING:
+      return flow->flowData.bridgingFlowEntry.outputPort;
+
+    case OFDPA_FLOW_TABLE_ID_ACL_POLICY:
+      return flow->flowData.policyAclFlowEntry.outputPort;
+
+    case OFDPA_FLOW_TABLE_ID_EGRESS_MAINTENANCE_POINT:
+      return flow->flowData.egressMpFlowEntry.outputPort;
+
+    default:
+      return 0;
+  }
+}
+
+/* Index a flow programmed in OF-DPA by table, output group and port */
+static void ind_ofdpa_flow_index_update(const ofdpaFlowEntry_t *hwFlow)
+{
+  ind_ofdpa_flow_index_entry_t entry;
+
+  entry.cookie = hwFlow->cookie;
+  entry.table_id = (uint8_t)hwFlow->tableId;
+  entry.group_id = ind_ofdpa_flow_group_get(hwFlow);
+  entry.port = ind_ofdpa_flow_port_get(hwFlow);
+  (void)ind_ofdpa_flow_index_set(&entry);
+}
+
+/* Per-table location of the table's entry in flowData and of its match
+   fields, which with the priority form the key of a flow */
+typedef struct
+{
+  OFDPA_FLOW_TABLE_ID_t tableId;
+  uint32_t              entry_offset;
+  uint32_t              entry_size;
+  uint32_t              match_offset;
+  uint32_t              match_size;
+} ind_ofdpa_flow_layout_t;
+
+#define IND_OFDPA_FLOW_LAYOUT(_id, _entry)                                        \
+  { OFDPA_FLOW_TABLE_ID_##_id,                                                    \
+    offsetof(ofdpaFlowEntry_t, flowData._entry),                                  \
+    sizeof(((ofdpaFlowEntry_t *)0)->flowData._entry),                             \
+    offsetof(ofdpaFlowEntry_t, flowData._entry.match_criteria),                   \
+    sizeof(((ofdpaFlowEntry_t *)0)->flowData._entry.match_criteria) }
+
+static const ind_ofdpa_flow_layout_t flow_layouts[] =
+{
+  IND_OFDPA_FLOW_LAYOUT(INGRESS_PORT,              ingressPortFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(PORT_DSCP_TRUST,           dscpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(PORT_PCP_TRUST,            pcpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(TUNNEL_DSCP_TRUST,         dscpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(TUNNEL_PCP_TRUST,          pcpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(VLAN,                      vlanFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(VLAN_1,                    vlan1FlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MAINTENANCE_POINT,         mpFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_L2_PORT,              mplsL2PortFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_DSCP_TRUST,           dscpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_PCP_TRUST,            pcpTrustFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(TERMINATION_MAC,           terminationMacFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_0,                    mplsFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_1,                    mplsFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_2,                    mplsFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_MAINTENANCE_POINT,    mplsMpFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(UNICAST_ROUTING,           unicastRoutingFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MULTICAST_ROUTING,         multicastRoutingFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(BRIDGING,                  bridgingFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(ACL_POLICY,                policyAclFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(EGRESS_VLAN,               egressVlanFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(EGRESS_VLAN_1,             egressVlan1FlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(EGRESS_MAINTENANCE_POINT,  egressMpFlowEntry),
+  IND_OFDPA_FLOW_LAYOUT(MPLS_QOS,                  mplsQosFlowEntry),
+};
+
+static const ind_ofdpa_flow_layout_t *ind_ofdpa_flow_layout_get(OFDPA_FLOW_TABLE_ID_t tableId)
+{
+  uint32_t i;
+
+  for (i = 0; i < sizeof(flow_layouts)/sizeof(flow_layouts[0]); i++)
+  {
+    if (flow_layouts[i].tableId == tableId)
+    {
+      return &flow_layouts[i];
+    }
+  }
+  return NULL;
+}
+
+/* Non-zero if two entries of the same table program the same flow,
+   cookies aside */
+static int ind_ofdpa_flow_same(const ind_ofdpa_flow_layout_t *layout,
+                               const ofdpaFlowEntry_t *a, const ofdpaFlowEntry_t *b)
+{
+  return ((a->tableId == b->tableId) &&
+          (a->priority == b->priority) &&
+          (a->idle_time == b->idle_time) &&
+          (a->hard_time == b->hard_time) &&
+          (memcmp((const uint8_t *)a + layout->entry_offset,
+                  (const uint8_t *)b + layout->entry_offset, layout->entry_size) == 0));
+}
+
+static uint32_t ind_ofdpa_flow_key_hash(const ind_ofdpa_flow_layout_t *layout,
+                                        const ofdpaFlowEntry_t *flow)
+{
+  const uint8_t *p = (const uint8_t *)flow + layout->match_offset;
+  const uint8_t *end = p + layout->match_size;
+  uint32_t h = 2166136261u;
+
+  h = (h ^ flow->tableId) * 16777619u;
+  h = (h ^ flow->priority) * 16777619u;
+  while (p < end)
+  {
+    h = (h ^ *p++) * 16777619u;
+  }
+  return h;
+}
+
+static int ind_ofdpa_flow_key_equal(const ind_ofdpa_flow_layout_t *layout,
+                                    const ofdpaFlowEntry_t *a, const ofdpaFlowEntry_t *b)
+{
+  return ((a->tableId == b->tableId) &&
+          (a->priority == b->priority) &&
+          (memcmp((const uint8_t *)a + layout->match_offset,
+                  (const uint8_t *)b + layout->match_offset, layout->match_size) == 0));
+}
+
+/* The entry as given to OF-DPA. With agent expiry its timeouts are
+   tracked here and OF-DPA gets the flow without them. Returns non-zero
+   if the agent tracks the timeouts. */
+static int ind_ofdpa_flow_hw_entry(const ofdpaFlowEntry_t *flow, ofdpaFlowEntry_t *hwFlow)
+{
+  *hwFlow = *flow;
+  if (!ind_ofdpa_flow_expiry_enable_get() ||
+      ((flow->idle_time == 0) && (flow->hard_time == 0)))
+  {
+    return 0;
+  }
+  hwFlow->idle_time = 0;
+  hwFlow->hard_time = 0;
+  return 1;
+}
+
+/*
+ * Flow shadow. While the shadow is open every flow programmed in OF-DPA
+ * has a record keyed by its OF-DPA cookie holding the entry as
+ * programmed. The cookie is the Indigo flow id, unless a restored flow
+ * still used that cookie when the flow was added; the record's tag then
+ * holds the flow id. Restored flows no controller has claimed carry
+ * F_RESTORED and are indexed by key. Flows programmed before a controller
+ * resync started carry F_UNCONFIRMED until the controller adds or
+ * modifies them again.
+ */
+#define IND_OFDPA_FLOW_SHADOW_F_RESTORED     0x1
+#define IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED  0x2
+
+/* Cookies handed out in place of flow ids that are in use */
+#define IND_OFDPA_FLOW_COOKIE_REMAP_BASE  0x8000000000000000ULL
+
+typedef struct ind_ofdpa_flow_restored_s
+{
+  struct ind_ofdpa_flow_restored_s *next;
+  uint64_t                          cookie;
+  uint32_t                          hash;
+} ind_ofdpa_flow_restored_t;
+
+static uint64_t flow_cookie_next = IND_OFDPA_FLOW_COOKIE_REMAP_BASE;
+static ind_ofdpa_flow_restored_t **flow_restored_hash;
+static uint32_t flow_restored_hash_size;
+static uint32_t flow_restored_count;
+static uint32_t flow_unconfirmed_count;
+
+static uint64_t ind_ofdpa_flow_cookie_alloc(indigo_cookie_t flow_id)
+{
+  if (!ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, flow_id, NULL, 0))
+  {
+    return flow_id;
+  }
+  while (ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, flow_cookie_next, NULL, 0))
+  {
+    flow_cookie_next++;
+  }
+  return flow_cookie_next++;
+}
+
+static void ind_ofdpa_flow_shadow_set(const ofdpaFlowEntry_t *hwFlow, indigo_cookie_t flow_id)
+{
+  ind_ofdpa_shadow_meta_t *meta;
+
+  ind_ofdpa_flow_index_update(hwFlow);
+  if (ind_ofdpa_shadow_put(IND_OFDPA_SHADOW_FLOW, hwFlow->cookie, hwFlow, sizeof(*hwFlow)) != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Failed to shadow flow 0x%llx", (unsigned long long)hwFlow->cookie);
+    return;
+  }
+  meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, hwFlow->cookie);
+  if (meta != NULL)
+  {
+    if (meta->flags & IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED)
+    {
+      flow_unconfirmed_count--;
+    }
+    meta->tag = (flow_id != hwFlow->cookie) ? flow_id : 0;
+    meta->flags = 0;
+  }
+}
+
+/* Record a changed entry of a shadowed flow */
+static void ind_ofdpa_flow_shadow_update(const ofdpaFlowEntry_t *hwFlow)
+{
+  ind_ofdpa_flow_index_update(hwFlow);
+  if (ind_ofdpa_shadow_put(IND_OFDPA_SHADOW_FLOW, hwFlow->cookie, hwFlow, sizeof(*hwFlow)) != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Failed to shadow flow 0x%llx", (unsigned long long)hwFlow->cookie);
+  }
+}
+
+/* Forget the shadow and index of a flow gone from OF-DPA */
+static void ind_ofdpa_flow_shadow_drop(uint64_t cookie)
+{
+  ind_ofdpa_shadow_meta_t *meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, cookie);
+
+  if ((meta != NULL) && (meta->flags & IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED))
+  {
+    flow_unconfirmed_count--;
+  }
+  ind_ofdpa_shadow_delete(IND_OFDPA_SHADOW_FLOW, cookie);
+  ind_ofdpa_flow_index_remove(cookie);
+}
+
+/* Clear the resync mark of a flow the controller modified */
+static void ind_ofdpa_flow_confirm(uint64_t cookie)
+{
+  ind_ofdpa_shadow_meta_t *meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, cookie);
+
+  if ((meta != NULL) && (meta->flags & IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED))
+  {
+    meta->flags &= ~IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED;
+    flow_unconfirmed_count--;
+    ind_ofdpa_warm_confirmed(IND_OFDPA_WARM_FLOW);
+  }
+}
+
+static void ind_ofdpa_flow_restored_insert(ind_ofdpa_flow_restored_t *restored)
+{
+  ind_ofdpa_flow_restored_t **grown;
+  ind_ofdpa_flow_restored_t *node;
+  uint32_t size;
+  uint32_t i;
+
+  if (flow_restored_count >= flow_restored_hash_size)
+  {
+    size = (flow_restored_hash_size == 0) ? 1024 : (flow_restored_hash_size * 2);
+    grown = calloc(size, sizeof(*grown));
+    if (grown != NULL)
+    {
+      for (i = 0; i < flow_restored_hash_size; i++)
+      {
+        while ((node = flow_restored_hash[i]) != NULL)
+        {
+          flow_restored_hash[i] = node->next;
+          node->next = grown[node->hash & (size - 1)];
+          grown[node->hash & (size - 1)] = node;
+        }
+      }
+      free(flow_restored_hash);
+      flow_restored_hash = grown;
+      flow_restored_hash_size = size;
+    }
+  }
+
+  if (flow_restored_hash_size == 0)
+  {
+    LOG_ERROR("Failed to index restored flow 0x%llx", (unsigned long long)restored->cookie);
+    free(restored);
+    return;
+  }
+
+  restored->next = flow_restored_hash[restored->hash & (flow_restored_hash_size - 1)];
+  flow_restored_hash[restored->hash & (flow_restored_hash_size - 1)] = restored;
+  flow_restored_count++;
+}
+
+/* Unindex and return the unclaimed restored flow with the key of flow */
+static ind_ofdpa_flow_restored_t *ind_ofdpa_flow_restored_take(const ofdpaFlowEntry_t *flow)
+{
+  const ind_ofdpa_flow_layout_t *layout;
+  ind_ofdpa_flow_restored_t **prev;
+  ind_ofdpa_flow_restored_t *restored;
+  ofdpaFlowEntry_t current;
+  uint32_t hash;
+
+  if ((flow_restored_count == 0) || ((layout = ind_ofdpa_flow_layout_get(flow->tableId)) == NULL))
+  {
+    return NULL;
+  }
+
+  hash = ind_ofdpa_flow_key_hash(layout, flow);
+  for (prev = &flow_restored_hash[hash & (flow_restored_hash_size - 1)]; *prev != NULL; prev = &(*prev)->next)
+  {
+    restored = *prev;
+    if ((restored->hash == hash) &&
+        ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, restored->cookie, &current, sizeof(current)) &&
+        ind_ofdpa_flow_key_equal(layout, &current, flow))
+    {
+      *prev = restored->next;
+      flow_restored_count--;
+      return restored;
+    }
+  }
+  return NULL;
+}
+
+/* Drop the shadow of a flow gone from OF-DPA. Returns 0 for a restored
+   flow no controller claimed, which Indigo does not know, otherwise sets
+   the flow's Indigo flow id. */
+static int ind_ofdpa_flow_forget(uint64_t cookie, indigo_cookie_t *flow_id)
+{
+  const ind_ofdpa_flow_layout_t *layout;
+  ind_ofdpa_flow_restored_t **prev;
+  ind_ofdpa_flow_restored_t *restored;
+  ind_ofdpa_shadow_meta_t *meta;
+  ofdpaFlowEntry_t current;
+  int claimed = 1;
+
+  *flow_id = cookie;
+  meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, cookie);
+  if (meta == NULL)
+  {
+    ind_ofdpa_flow_index_remove(cookie);
+    return claimed;
+  }
+
+  if (meta->flags & IND_OFDPA_FLOW_SHADOW_F_RESTORED)
+  {
+    claimed = 0;
+    (void)ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, cookie, &current, sizeof(current));
+    layout = ind_ofdpa_flow_layout_get(current.tableId);
+    if ((layout != NULL) && (flow_restored_hash_size != 0))
+    {
+      prev = &flow_restored_hash[ind_ofdpa_flow_key_hash(layout, &current) & (flow_restored_hash_size - 1)];
+      for (; *prev != NULL; prev = &(*prev)->next)
+      {
+        if ((*prev)->cookie == cookie)
+        {
+          restored = *prev;
+          *prev = restored->next;
+          flow_restored_count--;
+          free(restored);
+          break;
+        }
+      }
+    }
+  }
+  else if (meta->tag != 0)
+  {
+    *flow_id = meta->tag;
+  }
+
+  ind_ofdpa_flow_shadow_drop(cookie);
+  return claimed;
+}
+
+/* Add a flow to OF-DPA, on behalf of Indigo flow flow_id */
+static OFDPA_ERROR_t ind_ofdpa_flow_install(ofdpaFlowEntry_t *flow, indigo_cookie_t flow_id)
+{
+  ofdpaFlowEntry_t hwFlow;
+  OFDPA_ERROR_t ofdpa_rv;
+  int tracked;
+
+  tracked = ind_ofdpa_flow_hw_entry(flow, &hwFlow);
+  ofdpa_rv = ofdpaFlowAdd(&hwFlow);
+  if (ofdpa_rv == OFDPA_E_NONE)
+  {
+    if (tracked)
+    {
+      (void)ind_ofdpa_flow_expiry_add(flow->tableId, flow->cookie, flow->idle_time,
+                                      flow->hard_time);
+    }
+    ind_ofdpa_flow_shadow_set(&hwFlow, flow_id);
+  }
+  return ofdpa_rv;
+}
+
+/* Hand a restored flow, already given its new content, over to Indigo
+   flow flow_id */
+static void ind_ofdpa_flow_claim_finish(const ofdpaFlowEntry_t *flow, indigo_cookie_t flow_id,
+                                        ind_ofdpa_flow_restored_t *restored, int modified)
+{
+  ofdpaFlowEntry_t hwFlow;
+
+  if (ind_ofdpa_flow_hw_entry(flow, &hwFlow))
+  {
+    (void)ind_ofdpa_flow_expiry_add(flow->tableId, flow->cookie, flow->idle_time,
+                                    flow->hard_time);
+  }
+  ind_ofdpa_flow_shadow_set(&hwFlow, flow_id);
+  free(restored);
+
+  LOG_TRACE("Flow 0x%llx claimed restored flow 0x%llx%s", (unsigned long long)flow_id,
+            (unsigned long long)flow->cookie, modified ? " with changes" : "");
+  ind_ofdpa_warm_claimed(IND_OFDPA_WARM_FLOW, modified);
+}
+
+/* Take over a restored flow with the key of a flow being added, changing
+   it in place if it differs */
+static indigo_error_t ind_ofdpa_flow_claim(ofdpaFlowEntry_t *flow, indigo_cookie_t flow_id,
+                                           ind_ofdpa_flow_restored_t *restored, void **entry_priv)
+{
+  ofdpaFlowEntry_t old;
+  ofdpaFlowEntry_t hwFlow;
+  OFDPA_ERROR_t ofdpa_rv;
+  int same;
+
+  (void)ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, restored->cookie, &old, sizeof(old));
+  flow->cookie = restored->cookie;
+  (void)ind_ofdpa_flow_hw_entry(flow, &hwFlow);
+  same = ind_ofdpa_flow_same(ind_ofdpa_flow_layout_get(flow->tableId), &hwFlow, &old);
+
+  if (!same)
+  {
+    ofdpa_rv = ofdpaFlowModify(&hwFlow);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to modify restored flow 0x%llx. (ofdpa_rv = %d)",
+                (unsigned long long)flow->cookie, ofdpa_rv);
+      ind_ofdpa_flow_restored_insert(restored);
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
+    ind_ofdpa_group_flow_ref(ind_ofdpa_flow_group_get(flow));
+    ind_ofdpa_group_flow_unref(ind_ofdpa_flow_group_get(&old));
+  }
+
+  ind_ofdpa_flow_claim_finish(flow, flow_id, restored, !same);
+  *entry_priv = INDIGO_COOKIE_TO_POINTER(flow->cookie);
+
+  return INDIGO_ERROR_NONE;
+}
+
+static struct
+{
+  uint64_t creates;
+  uint64_t modifies;
+  uint64_t modifies_unchanged;    /* acked without calling OF-DPA */
+  uint64_t modifies_shadowed;     /* current entry read from the shadow */
+  uint64_t deletes;
+} flow_op_stats;
+
+void ind_ofdpa_flow_op_stats_show(aim_pvs_t *pvs)
+{
+  aim_printf(pvs, "creates %llu  modifies %llu  deletes %llu\n",
+             (unsigned long long)flow_op_stats.creates,
+             (unsigned long long)flow_op_stats.modifies,
+             (unsigned long long)flow_op_stats.deletes);
+  aim_printf(pvs, "modifies unchanged %llu (%.1f%%), OF-DPA calls saved\n",
+             (unsigned long long)flow_op_stats.modifies_unchanged,
+             (flow_op_stats.modifies == 0) ? 0.0 :
+             (100.0 * flow_op_stats.modifies_unchanged / flow_op_stats.modifies));
+  aim_printf(pvs, "modifies read from the shadow %llu, OF-DPA reads saved\n",
+             (unsigned long long)flow_op_stats.modifies_shadowed);
+}
+
 static indigo_error_t
 flow_create(void *table_priv,
                 indigo_cxn_id_t cxn_id,
@@ -2562,6 +3079,7 @@ flow_create(void *table_priv,
   uint16_t idle_timeout, hard_timeout; 
   uint8_t table_id;
   of_match_t of_match;
+  ind_ofdpa_flow_restored_t *restored;
 
   LOG_TRACE("Flow create called");
 
@@ -2614,8 +3132,17 @@ flow_create(void *table_priv,
     return err; 
   }
 
+  /* During a warm restart the flow may already be programmed */
+  restored = ind_ofdpa_flow_restored_take(&flow);
+  if (restored != NULL)
+  {
+    return ind_ofdpa_flow_claim(&flow, flow_id, restored, entry_priv);
+  }
+  flow.cookie = ind_ofdpa_flow_cookie_alloc(flow_id);
+
   /* Submit the changes to ofdpa */
-  ofdpa_rv = ofdpaFlowAdd(&flow);
+  flow_op_stats.creates++;
+  ofdpa_rv = ind_ofdpa_flow_install(&flow, flow_id);
   if (ofdpa_rv != OFDPA_E_NONE)
   {
     LOG_ERROR("Failed to add flow. (ofdpa_rv = %d)", ofdpa_rv);
@@ -2623,9 +3150,10 @@ flow_create(void *table_priv,
   else
   {
     LOG_TRACE("Flow added successfully. (ofdpa_rv = %d)", ofdpa_rv);
+    ind_ofdpa_group_flow_ref(ind_ofdpa_flow_group_get(&flow));
   }
   
-  *entry_priv = INDIGO_COOKIE_TO_POINTER(flow_id);
+  *entry_priv = INDIGO_COOKIE_TO_POINTER(flow.cookie);
 
   return (indigoConvertOfdpaRv(ofdpa_rv));
 }
@@ -2641,6 +3169,9 @@ flow_modify(void *table_priv,
   ofdpaFlowEntryStats_t flowStats;
   OFDPA_ERROR_t ofdpa_rv = OFDPA_E_NONE;  
   of_match_t of_match;
+  uint32_t old_group_id;
+  ofdpaFlowEntry_t old_flow;
+  const ind_ofdpa_flow_layout_t *layout;
   indigo_cookie_t flow_id = INDIGO_POINTER_TO_COOKIE(entry_priv);
 
   LOG_TRACE("Flow modify called");      
@@ -2654,36 +3185,58 @@ flow_modify(void *table_priv,
   memset(&flow, 0, sizeof(flow));
   memset(&flowStats, 0, sizeof(flowStats));
 
-  /* Get the flow entries and flow stats from the indigo cookie */
-  ofdpa_rv = ofdpaFlowByCookieGet(flow_id, &flow, &flowStats);
-  if (ofdpa_rv != OFDPA_E_NONE)
+  if (ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, flow_id, &flow, sizeof(flow)))
   {
-    if (ofdpa_rv == OFDPA_E_NOT_FOUND)
-    {
-      LOG_ERROR("Request to modify non-existent flow. (ofdpa_rv = %d)", ofdpa_rv);
-    }
-    else
+    /* The entry as programmed, without asking OF-DPA */
+    flow_op_stats.modifies_shadowed++;
+  }
+  else
+  {
+    /* Get the flow entries and flow stats from the indigo cookie */
+    ofdpa_rv = ofdpaFlowByCookieGet(flow_id, &flow, &flowStats);
+    if (ofdpa_rv != OFDPA_E_NONE)
     {
-      LOG_ERROR("Invalid flow. (ofdpa_rv = %d)", ofdpa_rv);
+      if (ofdpa_rv == OFDPA_E_NOT_FOUND)
+      {
+        LOG_ERROR("Request to modify non-existent flow. (ofdpa_rv = %d)", ofdpa_rv);
+      }
+      else
+      {
+        LOG_ERROR("Invalid flow. (ofdpa_rv = %d)", ofdpa_rv);
+      }
+      return (indigoConvertOfdpaRv(ofdpa_rv));   
     }
-    return (indigoConvertOfdpaRv(ofdpa_rv));   
   }
 
-  memset(&of_match, 0, sizeof(of_match));
-  if (of_flow_add_match_get(flow_modify, &of_match) < 0)
-  {
-    LOG_ERROR("Error getting openflow match criteria.");
-    return INDIGO_ERROR_UNKNOWN;
-  }
-  
+  old_flow = flow;
+  old_group_id = ind_ofdpa_flow_group_get(&flow);
+
   memset(&flow.flowData, 0, sizeof(flow.flowData));
 
-  /* Get the match fields and masks from LOCI match structure */
-  err = ind_ofdpa_match_fields_masks_get(&of_match, &flow);
-  if (err != INDIGO_ERROR_NONE)
+  /* A modify cannot change the match: keep the one programmed, which for
+     a non-strict modify is not the one in the message */
+  layout = ind_ofdpa_flow_layout_get(flow.tableId);
+  if (layout != NULL)
   {
-    LOG_ERROR("Error getting match fields and masks. (err = %d)", err);
-    return err;
+    memcpy((uint8_t *)&flow + layout->match_offset,
+           (const uint8_t *)&old_flow + layout->match_offset, layout->match_size);
+  }
+  else
+  {
+    memset(&of_match, 0, sizeof(of_match));
+    if (of_flow_add_match_get(flow_modify, &of_match) < 0)
+    {
+      LOG_ERROR("Error getting openflow match criteria.");
+      return INDIGO_ERROR_UNKNOWN;
+    }
+
+    /* Get the match fields and masks from LOCI match structure */
+    err = ind_ofdpa_match_fields_masks_get(&of_match, &flow);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      LOG_ERROR("Error getting match fields and masks. (err = %d)", err);
+      return err;
+    }
   }
 
   /* Get the modified instructions set from the LOCI flow add object */
@@ -2694,6 +3247,16 @@ flow_modify(void *table_priv,
     return err;
   } 
 
+  /* Indigo turns a re-sent add of an installed flow into a modify */
+  flow_op_stats.modifies++;
+  if ((layout != NULL) && ind_ofdpa_flow_same(layout, &old_flow, &flow))
+  {
+    LOG_TRACE("Flow 0x%llx unchanged, not modified", (unsigned long long)flow_id);
+    flow_op_stats.modifies_unchanged++;
+    ind_ofdpa_flow_confirm(flow_id);
+    return INDIGO_ERROR_NONE;
+  }
+
   /* Submit the changes to ofdpa */
   ofdpa_rv = ofdpaFlowModify(&flow);
   if (ofdpa_rv!= OFDPA_E_NONE)
@@ -2703,6 +3266,10 @@ flow_modify(void *table_priv,
   else
   {
     LOG_TRACE("Flow modified successfully. (ofdpa_rv = %d)", ofdpa_rv);
+    ind_ofdpa_flow_shadow_update(&flow);
+    ind_ofdpa_group_flow_ref(ind_ofdpa_flow_group_get(&flow));
+    ind_ofdpa_group_flow_unref(old_group_id);
+    ind_ofdpa_flow_confirm(flow_id);
   }
 
   return (indigoConvertOfdpaRv(ofdpa_rv));
@@ -2724,7 +3291,7 @@ flow_delete(void *table_priv,
 
   memset(&flow, 0, sizeof(flow));
   memset(&flowStats, 0, sizeof(flowStats));
-        
+
   ofdpa_rv = ofdpaFlowByCookieGet(flow_id, &flow, &flowStats);
   if (ofdpa_rv != OFDPA_E_NONE)
   {
@@ -2750,6 +3317,7 @@ flow_delete(void *table_priv,
 #endif // ROBS_HACK
 
   /* Delete the flow entry */
+  flow_op_stats.deletes++;
   ofdpa_rv = ofdpaFlowByCookieDelete(flow_id);
   if (ofdpa_rv != OFDPA_E_NONE)
   {
@@ -2758,6 +3326,9 @@ flow_delete(void *table_priv,
   else
   {
     LOG_TRACE("Flow deleted successfully. (ofdpa_rv = %d)", ofdpa_rv);
+    ind_ofdpa_flow_expiry_cancel(flow_id);
+    ind_ofdpa_flow_shadow_drop(flow_id);
+    ind_ofdpa_group_flow_unref(ind_ofdpa_flow_group_get(&flow));
   }
 
   return (indigoConvertOfdpaRv(ofdpa_rv));;
@@ -2892,19 +3463,36 @@ indigo_error_t indigo_fwd_experimenter(of_experimenter_t *experimenter,
 
 indigo_error_t indigo_fwd_expiration_enable_set(int is_enabled)
 {
-  LOG_ERROR("indigo_fwd_expiration_enable_set() unsupported.");
-  return INDIGO_ERROR_NOT_SUPPORTED;
+  ind_ofdpa_flow_expiry_enable_set(is_enabled);
+  return INDIGO_ERROR_NONE;
 }
 
 indigo_error_t indigo_fwd_expiration_enable_get(int *is_enabled)
 {
-  LOG_ERROR("indigo_fwd_expiration_enable_get() unsupported.");
-  return INDIGO_ERROR_NOT_SUPPORTED;
+  *is_enabled = ind_ofdpa_flow_expiry_enable_get();
+  return INDIGO_ERROR_NONE;
+}
+
+/* Delete a flow the agent expired and release its group */
+OFDPA_ERROR_t ind_ofdpa_flow_expire(ofdpaFlowEntry_t *flow, uint64_t *flow_id)
+{
+  OFDPA_ERROR_t ofdpa_rv;
+  indigo_cookie_t owner;
+
+  ofdpa_rv = ofdpaFlowByCookieDelete(flow->cookie);
+  if (ofdpa_rv == OFDPA_E_NONE)
+  {
+    ind_ofdpa_group_flow_unref(ind_ofdpa_flow_group_get(flow));
+    (void)ind_ofdpa_flow_forget(flow->cookie, &owner);
+    *flow_id = owner;
+  }
+  return ofdpa_rv;
 }
 
 void ind_ofdpa_flow_event_receive(void)
 {
   ofdpaFlowEvent_t flowEventData;
+  indigo_cookie_t flow_id;
 
   LOG_TRACE("Reading Flow Events");
 
@@ -2913,26 +3501,367 @@ void ind_ofdpa_flow_event_receive(void)
 
   while (ofdpaFlowEventNextGet(&flowEventData) == OFDPA_E_NONE)
   {
+    /* The flow is already gone from OF-DPA */
+    ind_ofdpa_flow_expiry_cancel(flowEventData.flowMatch.cookie);
+    ind_ofdpa_group_flow_unref(ind_ofdpa_flow_group_get(&flowEventData.flowMatch));
+    if (!ind_ofdpa_flow_forget(flowEventData.flowMatch.cookie, &flow_id))
+    {
+      LOG_TRACE("Restored flow 0x%llx timed out before it was claimed.",
+                (unsigned long long)flowEventData.flowMatch.cookie);
+      continue;
+    }
+
     if (flowEventData.eventMask & OFDPA_FLOW_EVENT_HARD_TIMEOUT)
     {
       LOG_TRACE("Received flow event on hard timeout.");
-#ifdef ROBS_HACK
-      ind_core_flow_expiry_handler(flowEventData.flowMatch.cookie,
-                                   INDIGO_FLOW_REMOVED_HARD_TIMEOUT);
-#endif
+      ind_ofdpa_flow_expiry_notify(flow_id, INDIGO_FLOW_REMOVED_HARD_TIMEOUT);
     }
     else
     {
       LOG_TRACE("Received flow event on idle timeout.");
-#ifdef ROBS_HACK
-      ind_core_flow_expiry_handler(flowEventData.flowMatch.cookie,
-                                   INDIGO_FLOW_REMOVED_IDLE_TIMEOUT);
-#endif
+      ind_ofdpa_flow_expiry_notify(flow_id, INDIGO_FLOW_REMOVED_IDLE_TIMEOUT);
     }
   }
   return;
 }
 
+/* Delete the flows matching query, up to max_flows, a table at a time.
+   Returns the number deleted. */
+uint32_t ind_ofdpa_flows_delete(const ind_ofdpa_flow_query_t *query, uint32_t max_flows)
+{
+  ind_ofdpa_flow_index_entry_t *entries;
+  OFDPA_ERROR_t ofdpa_rv;
+  indigo_cookie_t flow_id;
+  uint64_t start;
+  uint32_t count;
+  uint32_t deleted = 0;
+  uint32_t failed;
+  uint32_t first;
+  uint32_t i;
+
+  /* Resolve the exact set first; deleting changes the index */
+  count = ind_ofdpa_flow_index_count(query);
+  if (count > max_flows)
+  {
+    count = max_flows;
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+  entries = malloc(count * sizeof(*entries));
+  if (entries == NULL)
+  {
+    LOG_ERROR("Failed to allocate %u flows to delete", count);
+    return 0;
+  }
+  count = ind_ofdpa_flow_index_collect(query, entries, count);
+
+  for (first = 0; first < count; first = i)
+  {
+    start = ind_ofdpa_rpc_now_ns();
+    failed = 0;
+    for (i = first; (i < count) && (entries[i].table_id == entries[first].table_id); i++)
+    {
+      ofdpa_rv = ofdpaFlowByCookieDelete(entries[i].cookie);
+      if (ofdpa_rv != OFDPA_E_NONE)
+      {
+        LOG_ERROR("Failed to delete flow 0x%llx. (ofdpa_rv = %d)",
+                  (unsigned long long)entries[i].cookie, ofdpa_rv);
+        failed++;
+        continue;
+      }
+
+      LOG_TRACE("Deleted flow 0x%llx", (unsigned long long)entries[i].cookie);
+      ind_ofdpa_flow_expiry_cancel(entries[i].cookie);
+      ind_ofdpa_group_flow_unref(entries[i].group_id);
+      deleted++;
+      if (!ind_ofdpa_flow_forget(entries[i].cookie, &flow_id))
+      {
+        continue;
+      }
+      ind_ofdpa_flow_expiry_notify(flow_id, INDIGO_FLOW_REMOVED_DELETE);
+    }
+    ind_ofdpa_flow_index_delete_account(entries[first].table_id, i - first, failed,
+                                        ind_ofdpa_rpc_now_ns() - start);
+  }
+
+  free(entries);
+  return deleted;
+}
+
+uint32_t ind_ofdpa_flows_by_group_delete(uint32_t group_id, uint32_t max_flows)
+{
+  ind_ofdpa_flow_query_t query;
+
+  memset(&query, 0, sizeof(query));
+  query.fields = IND_OFDPA_FLOW_QUERY_GROUP;
+  query.group_id = group_id;
+
+  return ind_ofdpa_flows_delete(&query, max_flows);
+}
+
+/* Re-point the ACL policy flows metered by from to meter to, counting them
+   in *moved. Stops at the first flow OF-DPA refuses; the caller moves the
+   flows back. */
+indigo_error_t ind_ofdpa_flows_by_meter_move(uint32_t from, uint32_t to, uint32_t *moved)
+{
+  ofdpaFlowEntry_t flow;
+  ofdpaFlowEntry_t nextFlow;
+  OFDPA_ERROR_t ofdpa_rv;
+
+  memset(&flow, 0, sizeof(flow));
+  flow.tableId = OFDPA_FLOW_TABLE_ID_ACL_POLICY;
+
+  while (ofdpaFlowNextGet(&flow, &nextFlow) == OFDPA_E_NONE)
+  {
+    flow = nextFlow;
+    if (!flow.flowData.policyAclFlowEntry.meterIdAction ||
+        (flow.flowData.policyAclFlowEntry.meterId != from))
+    {
+      continue;
+    }
+
+    flow.flowData.policyAclFlowEntry.meterId = to;
+    ofdpa_rv = ofdpaFlowModify(&flow);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to move flow 0x%llx from meter %u to %u, rv = %d",
+                (unsigned long long)flow.cookie, from, to, ofdpa_rv);
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
+    if (ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, flow.cookie, NULL, 0))
+    {
+      ind_ofdpa_flow_shadow_update(&flow);
+    }
+    (*moved)++;
+  }
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Drop shadow records of flows OF-DPA no longer has */
+static void ind_ofdpa_flow_stale_drop(uint64_t key, const void *data,
+                                      ind_ofdpa_shadow_meta_t *meta, void *cookie)
+{
+  if (!(meta->flags & IND_OFDPA_FLOW_SHADOW_F_RESTORED))
+  {
+    ind_ofdpa_shadow_delete(IND_OFDPA_SHADOW_FLOW, key);
+    (*(uint32_t *)cookie)++;
+  }
+}
+
+/* Take over the flows in OF-DPA as restored, unclaimed flows. Groups must
+   be restored first so the flows can reference them. Returns the number of
+   flows restored and adds the number that differed from the shadow to
+   drift. */
+uint32_t ind_ofdpa_flow_warm_restore(uint32_t *drift)
+{
+  ofdpaFlowEntry_t current;
+  ofdpaFlowEntry_t flow;
+  ofdpaFlowEntry_t nextFlow;
+  ind_ofdpa_shadow_meta_t *meta;
+  ind_ofdpa_flow_restored_t *restored;
+  uint32_t count = 0;
+  uint32_t i;
+
+  for (i = 0; i < sizeof(flow_layouts)/sizeof(flow_layouts[0]); i++)
+  {
+    memset(&flow, 0, sizeof(flow));
+    flow.tableId = flow_layouts[i].tableId;
+
+    while (ofdpaFlowNextGet(&flow, &nextFlow) == OFDPA_E_NONE)
+    {
+      flow = nextFlow;
+
+      /* OF-DPA is authoritative */
+      if (!ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, flow.cookie, &current, sizeof(current)) ||
+          !ind_ofdpa_flow_same(&flow_layouts[i], &current, &flow))
+      {
+        (*drift)++;
+        if (ind_ofdpa_shadow_put(IND_OFDPA_SHADOW_FLOW, flow.cookie, &flow, sizeof(flow)) != INDIGO_ERROR_NONE)
+        {
+          LOG_ERROR("Failed to shadow restored flow 0x%llx", (unsigned long long)flow.cookie);
+          continue;
+        }
+      }
+
+      restored = malloc(sizeof(*restored));
+      if (restored == NULL)
+      {
+        LOG_ERROR("Failed to allocate restored flow 0x%llx", (unsigned long long)flow.cookie);
+        continue;
+      }
+      meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, flow.cookie);
+      meta->tag = 0;
+      meta->flags = IND_OFDPA_FLOW_SHADOW_F_RESTORED;
+      restored->cookie = flow.cookie;
+      restored->hash = ind_ofdpa_flow_key_hash(&flow_layouts[i], &flow);
+      ind_ofdpa_flow_restored_insert(restored);
+      ind_ofdpa_flow_index_update(&flow);
+      ind_ofdpa_group_flow_ref(ind_ofdpa_flow_group_get(&flow));
+      count++;
+    }
+  }
+
+  ind_ofdpa_shadow_walk(IND_OFDPA_SHADOW_FLOW, ind_ofdpa_flow_stale_drop, drift);
+
+  return count;
+}
+
+uint32_t ind_ofdpa_flow_warm_pending(void)
+{
+  return flow_restored_count;
+}
+
+/* Delete the restored flows no controller claimed. Returns the number
+   deleted. */
+uint32_t ind_ofdpa_flow_warm_end(void)
+{
+  ind_ofdpa_flow_restored_t *restored;
+  ofdpaFlowEntry_t current;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t removed = 0;
+  uint32_t i;
+
+  for (i = 0; i < flow_restored_hash_size; i++)
+  {
+    while ((restored = flow_restored_hash[i]) != NULL)
+    {
+      flow_restored_hash[i] = restored->next;
+
+      ofdpa_rv = ofdpaFlowByCookieDelete(restored->cookie);
+      if ((ofdpa_rv == OFDPA_E_NONE) || (ofdpa_rv == OFDPA_E_NOT_FOUND))
+      {
+        if ((ofdpa_rv == OFDPA_E_NONE) &&
+            ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, restored->cookie, &current, sizeof(current)))
+        {
+          ind_ofdpa_group_flow_unref(ind_ofdpa_flow_group_get(&current));
+        }
+        ind_ofdpa_flow_shadow_drop(restored->cookie);
+        removed++;
+      }
+      else
+      {
+        LOG_ERROR("Failed to delete unclaimed flow 0x%llx. (ofdpa_rv = %d)",
+                  (unsigned long long)restored->cookie, ofdpa_rv);
+      }
+      free(restored);
+    }
+  }
+
+  free(flow_restored_hash);
+  flow_restored_hash = NULL;
+  flow_restored_hash_size = 0;
+  flow_restored_count = 0;
+
+  return removed;
+}
+
+static void ind_ofdpa_flow_resync_mark_one(uint64_t key, const void *data,
+                                           ind_ofdpa_shadow_meta_t *meta, void *cookie)
+{
+  if (!(meta->flags & (IND_OFDPA_FLOW_SHADOW_F_RESTORED | IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED)))
+  {
+    meta->flags |= IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED;
+    flow_unconfirmed_count++;
+  }
+}
+
+/* Mark every flow Indigo has as unconfirmed. Returns the number marked. */
+uint32_t ind_ofdpa_flow_resync_mark(void)
+{
+  uint32_t before = flow_unconfirmed_count;
+
+  ind_ofdpa_shadow_walk(IND_OFDPA_SHADOW_FLOW, ind_ofdpa_flow_resync_mark_one, NULL);
+
+  return flow_unconfirmed_count - before;
+}
+
+uint32_t ind_ofdpa_flow_resync_pending(void)
+{
+  return flow_unconfirmed_count;
+}
+
+typedef struct
+{
+  uint64_t *cookies;
+  uint32_t  count;
+  uint32_t  max;
+} ind_ofdpa_flow_sweep_t;
+
+static void ind_ofdpa_flow_unconfirmed_collect(uint64_t key, const void *data,
+                                               ind_ofdpa_shadow_meta_t *meta, void *cookie)
+{
+  ind_ofdpa_flow_sweep_t *sweep = cookie;
+
+  if ((meta->flags & IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED) && (sweep->count < sweep->max))
+  {
+    sweep->cookies[sweep->count++] = key;
+  }
+}
+
+/* Delete the flows the controller did not add or modify since the resync
+   started, and report each to Indigo as deleted. Returns the number
+   deleted. */
+uint32_t ind_ofdpa_flow_resync_end(void)
+{
+  ind_ofdpa_flow_sweep_t sweep;
+  ind_ofdpa_shadow_meta_t *meta;
+  ofdpaFlowEntry_t current;
+  indigo_cookie_t flow_id;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t group_id;
+  uint32_t removed = 0;
+  uint32_t i;
+
+  if (flow_unconfirmed_count == 0)
+  {
+    return 0;
+  }
+
+  sweep.count = 0;
+  sweep.max = flow_unconfirmed_count;
+  sweep.cookies = malloc(sweep.max * sizeof(*sweep.cookies));
+  if (sweep.cookies == NULL)
+  {
+    LOG_ERROR("Failed to allocate %u unconfirmed flows", sweep.max);
+    return 0;
+  }
+  ind_ofdpa_shadow_walk(IND_OFDPA_SHADOW_FLOW, ind_ofdpa_flow_unconfirmed_collect, &sweep);
+
+  for (i = 0; i < sweep.count; i++)
+  {
+    memset(&current, 0, sizeof(current));
+    (void)ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_FLOW, sweep.cookies[i], &current, sizeof(current));
+    group_id = ind_ofdpa_flow_group_get(&current);
+
+    ofdpa_rv = ofdpaFlowByCookieDelete(sweep.cookies[i]);
+    if ((ofdpa_rv != OFDPA_E_NONE) && (ofdpa_rv != OFDPA_E_NOT_FOUND))
+    {
+      /* Leave it to the controller */
+      LOG_ERROR("Failed to delete unconfirmed flow 0x%llx. (ofdpa_rv = %d)",
+                (unsigned long long)sweep.cookies[i], ofdpa_rv);
+      meta = ind_ofdpa_shadow_meta(IND_OFDPA_SHADOW_FLOW, sweep.cookies[i]);
+      meta->flags &= ~IND_OFDPA_FLOW_SHADOW_F_UNCONFIRMED;
+      flow_unconfirmed_count--;
+      continue;
+    }
+
+    ind_ofdpa_flow_expiry_cancel(sweep.cookies[i]);
+    if (ofdpa_rv == OFDPA_E_NONE)
+    {
+      ind_ofdpa_group_flow_unref(group_id);
+    }
+    (void)ind_ofdpa_flow_forget(sweep.cookies[i], &flow_id);
+    ind_ofdpa_flow_expiry_notify(flow_id, INDIGO_FLOW_REMOVED_DELETE);
+    removed++;
+  }
+  free(sweep.cookies);
+
+  return removed;
+}
+
 static void ind_ofdpa_key_to_match(uint32_t portNum, of_match_t *match)
 {
   memset(match, 0, sizeof(*match));
@@ -2984,13 +3913,41 @@ ind_ofdpa_fwd_pkt_in(of_port_no_t in_port,
   return indigo_core_packet_in(of_packet_in);
 }
 
-void ind_ofdpa_pkt_receive(void)
+void ind_ofdpa_pkt_deliver(ofdpaPacket_t *rxPkt)
 {
   indigo_error_t rc;
   uint32_t i;
+  of_match_t match;
+
+  LOG_TRACE("Client received packet");
+  LOG_TRACE("Reason:  %d", rxPkt->reason);
+  LOG_TRACE("Table ID:  %d", rxPkt->tableId);
+  LOG_TRACE("Ingress port:  %u", rxPkt->inPortNum);
+  LOG_TRACE("Size:  %u\r\n", rxPkt->pktData.size);
+  for (i = 0; i < rxPkt->pktData.size; i++)
+  {
+    if (i && ((i % 16) == 0))
+      LOG_TRACE("\r\n");
+    LOG_TRACE("%02x ", (unsigned int) *(rxPkt->pktData.pstart + i));
+  }
+  LOG_TRACE("\r\n");
+
+  ind_ofdpa_key_to_match(rxPkt->inPortNum, &match);
+
+  rc = ind_ofdpa_fwd_pkt_in(rxPkt->inPortNum, rxPkt->pktData.pstart, 
+                       (rxPkt->pktData.size - 4), rxPkt->reason, 
+                       &match, rxPkt->tableId);
+
+  if (rc != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Could not send Packet-in message, rc = 0x%x", rc);
+  }
+}
+
+void ind_ofdpa_pkt_receive(void)
+{
   uint32_t maxPktSize;
   ofdpaPacket_t rxPkt;
-  of_match_t match;
   struct timeval timeout;
 
   /* Determine how large receive buffer must be */
@@ -3014,29 +3971,7 @@ void ind_ofdpa_pkt_receive(void)
 
   while (ofdpaPktReceive(&timeout, &rxPkt) == OFDPA_E_NONE)
   {
-    LOG_TRACE("Client received packet");
-    LOG_TRACE("Reason:  %d", rxPkt.reason);
-    LOG_TRACE("Table ID:  %d", rxPkt.tableId);
-    LOG_TRACE("Ingress port:  %u", rxPkt.inPortNum);
-    LOG_TRACE("Size:  %u\r\n", rxPkt.pktData.size);
-    for (i = 0; i < rxPkt.pktData.size; i++)
-    {
-      if (i && ((i % 16) == 0))
-        LOG_TRACE("\r\n");
-      LOG_TRACE("%02x ", (unsigned int) *(rxPkt.pktData.pstart + i));
-    }
-    LOG_TRACE("\r\n");
-
-    ind_ofdpa_key_to_match(rxPkt.inPortNum, &match);
-
-    rc = ind_ofdpa_fwd_pkt_in(rxPkt.inPortNum, rxPkt.pktData.pstart, 
-                         (rxPkt.pktData.size - 4), rxPkt.reason, 
-                         &match, rxPkt.tableId);
-
-    if (rc != INDIGO_ERROR_NONE)
-    {
-      LOG_ERROR("Could not send Packet-in message, rc = 0x%x", rc);
-    }
+    ind_ofdpa_pkt_deliver(&rxPkt);
   }
   free(rxPkt.pktData.pstart);
   return;
@@ -3075,6 +4010,18 @@ static const indigo_core_table_ops_t table_ops = {
     .table_stats_get = table_stats_get,
 };
 
+static const ind_ofdpa_flow_bench_ops_t flow_bench_ops = {
+    .match_get = ind_ofdpa_match_fields_masks_get,
+    .instructions_get = ind_ofdpa_instructions_get,
+    .table_ops = &table_ops,
+};
+
+const ind_ofdpa_flow_bench_ops_t *
+ind_ofdpa_flow_bench_ops_get(void)
+{
+    return &flow_bench_ops;
+}
+
 void
 ind_ofdpa_fwd_init(void)
 {
@@ -30,10 +30,17 @@
 *
 **********************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
 #include <indigo/forwarding.h>
 #include <indigo/of_state_manager.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_util.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
 
 static indigo_error_t
 ind_ofdpa_translate_group_actions(of_list_action_t *actions, 
@@ -262,479 +269,2630 @@ ind_ofdpa_translate_group_actions(of_list_action_t *actions,
     return INDIGO_ERROR_NONE;
 }
 
+/* OF-DPA group ID fields. The type sits in bits 31:28 and the layout of
+   the remaining bits depends on it; see the OF-DPA group naming rules. */
+typedef struct
+{
+  uint32_t type;
+  uint32_t sub_type;            /* MPLS label, MPLS forwarding and overlay groups */
+  uint32_t vlan_id;
+  uint32_t port;
+  uint32_t tunnel_id;           /* overlay groups */
+  uint32_t index;
+} ind_ofdpa_group_id_t;
+
+/* Decode all group ID fields locally, instead of one ofdpaGroupTypeGet()
+   and ofdpaGroupMplsSubTypeGet() call per bucket */
+static void
+ind_ofdpa_group_id_decode(uint32_t group_id, ind_ofdpa_group_id_t *gid)
+{
+  memset(gid, 0, sizeof(*gid));
+  gid->type = (group_id >> 28) & 0xF;
+
+  switch (gid->type)
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+      gid->vlan_id = (group_id >> 16) & 0xFFF;
+      gid->port = group_id & 0xFFFF;
+      break;
+
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+      gid->port = group_id & 0xFFFF;
+      break;
+
+    case OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST:
+      gid->vlan_id = (group_id >> 16) & 0xFFF;
+      gid->index = group_id & 0xFFFF;
+      break;
+
+    case OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY:
+      gid->tunnel_id = (group_id >> 12) & 0xFFFF;
+      gid->sub_type = (group_id >> 10) & 0x3;
+      gid->index = group_id & 0x3FF;
+      break;
+
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL:
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING:
+      gid->sub_type = (group_id >> 24) & 0xF;
+      gid->index = group_id & 0xFFFFFF;
+      break;
+
+    default:
+      gid->index = group_id & 0xFFFFFFF;
+      break;
+  }
+}
+
+static void
+ind_ofdpa_group_l2_interface_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                      uint64_t group_action_bitmap,
+                                      uint64_t group_action_sf_bitmap,
+                                      of_port_no_t watch_port,
+                                      ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l2Interface.outputPort = group_bucket->outputPort;
+  group_bucket_entry->bucketData.l2Interface.popVlanTag = group_bucket->popVlanTag;
+
+  if (group_action_sf_bitmap & IND_OFDPA_VLAN_PCP)
+  {
+    group_bucket_entry->bucketData.l2Interface.vlanPcpAction = 1;
+    group_bucket_entry->bucketData.l2Interface.vlanPcp = group_bucket->vlanPcp;
+  }
+  if (group_action_sf_bitmap & IND_OFDPA_VLAN_DEI)
+  {
+    group_bucket_entry->bucketData.l2Interface.vlanCfiAction = 1;
+    group_bucket_entry->bucketData.l2Interface.vlanCfi = group_bucket->vlanCfi;
+  }
+  if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.l2Interface.priorityRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.l2Interface.priorityRemarkTableIndex = group_bucket->priorityRemarkTableIndex;
+  }
+
+  if (group_action_sf_bitmap & IND_OFDPA_IP_DSCP)
+  {
+    group_bucket_entry->bucketData.l2Interface.dscpAction = 1;
+    group_bucket_entry->bucketData.l2Interface.dscp = group_bucket->dscp;
+  }
+  if (group_action_bitmap & IND_OFDPA_DSCP_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.l2Interface.dscpRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.l2Interface.dscpRemarkTableIndex = group_bucket->dscpRemarkTableIndex;
+  }
+}
+
+static void
+ind_ofdpa_group_l2_unfiltered_interface_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                                 uint64_t group_action_bitmap,
+                                                 uint64_t group_action_sf_bitmap,
+                                                 of_port_no_t watch_port,
+                                                 ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l2UnfilteredInterface.outputPort = group_bucket->outputPort;
+
+
+  if (group_action_sf_bitmap & IND_OFDPA_VLAN_PCP)
+  {
+    group_bucket_entry->bucketData.l2UnfilteredInterface.vlanPcpAction = 1;
+    group_bucket_entry->bucketData.l2UnfilteredInterface.vlanPcp = group_bucket->vlanPcp;
+  }
+  if (group_action_sf_bitmap & IND_OFDPA_VLAN_DEI)
+  {
+    group_bucket_entry->bucketData.l2UnfilteredInterface.vlanCfiAction = 1;
+    group_bucket_entry->bucketData.l2UnfilteredInterface.vlanCfi = group_bucket->vlanCfi;
+  }
+  if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.l2UnfilteredInterface.priorityRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.l2UnfilteredInterface.priorityRemarkTableIndex = group_bucket->priorityRemarkTableIndex;
+  }
+
+  if (group_action_sf_bitmap & IND_OFDPA_IP_DSCP)
+  {
+    group_bucket_entry->bucketData.l2UnfilteredInterface.dscpAction = 1;
+    group_bucket_entry->bucketData.l2UnfilteredInterface.dscp = group_bucket->dscp;
+  }
+  if (group_action_bitmap & IND_OFDPA_DSCP_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.l2UnfilteredInterface.dscpRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.l2UnfilteredInterface.dscpRemarkTableIndex = group_bucket->dscpRemarkTableIndex;
+  }
+}
+
+static void
+ind_ofdpa_group_l2_rewrite_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                    uint64_t group_action_bitmap,
+                                    uint64_t group_action_sf_bitmap,
+                                    of_port_no_t watch_port,
+                                    ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l2Rewrite.vlanId = group_bucket->vlanId;
+
+  memcpy(&group_bucket_entry->bucketData.l2Rewrite.srcMac,
+         &group_bucket->srcMac, sizeof(group_bucket_entry->bucketData.l2Rewrite.srcMac));
+
+  memcpy(&group_bucket_entry->bucketData.l2Rewrite.dstMac,
+         &group_bucket->dstMac, sizeof(group_bucket_entry->bucketData.l2Rewrite.dstMac));
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+static void
+ind_ofdpa_group_l3_unicast_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                    uint64_t group_action_bitmap,
+                                    uint64_t group_action_sf_bitmap,
+                                    of_port_no_t watch_port,
+                                    ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l3Unicast.vlanId = group_bucket->vlanId;
+
+  memcpy(&group_bucket_entry->bucketData.l3Unicast.srcMac,
+         &group_bucket->srcMac, sizeof(group_bucket_entry->bucketData.l3Unicast.srcMac));
+
+  memcpy(&group_bucket_entry->bucketData.l3Unicast.dstMac,
+         &group_bucket->dstMac, sizeof(group_bucket_entry->bucketData.l3Unicast.dstMac));
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+static void
+ind_ofdpa_group_l3_interface_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                      uint64_t group_action_bitmap,
+                                      uint64_t group_action_sf_bitmap,
+                                      of_port_no_t watch_port,
+                                      ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l3Interface.vlanId = group_bucket->vlanId;
+
+  memcpy(&group_bucket_entry->bucketData.l3Interface.srcMac,
+         &group_bucket->srcMac, sizeof(group_bucket_entry->bucketData.l3Interface.srcMac));
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+/* Buckets that only chain to another group: replication, ECMP and the
+   MPLS flood, multicast, protection and ECMP subtypes */
+static void
+ind_ofdpa_group_ref_group_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                   uint64_t group_action_bitmap,
+                                   uint64_t group_action_sf_bitmap,
+                                   of_port_no_t watch_port,
+                                   ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+static void
+ind_ofdpa_group_l2_overlay_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                    uint64_t group_action_bitmap,
+                                    uint64_t group_action_sf_bitmap,
+                                    of_port_no_t watch_port,
+                                    ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.l2Overlay.outputPort = group_bucket->outputPort;
+}
+
+static void
+ind_ofdpa_group_mpls_interface_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                        uint64_t group_action_bitmap,
+                                        uint64_t group_action_sf_bitmap,
+                                        of_port_no_t watch_port,
+                                        ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  memcpy(&group_bucket_entry->bucketData.mplsInterface.srcMac,
+         &group_bucket->srcMac, sizeof(group_bucket_entry->bucketData.mplsInterface.srcMac));
+  memcpy(&group_bucket_entry->bucketData.mplsInterface.dstMac,
+         &group_bucket->dstMac, sizeof(group_bucket_entry->bucketData.mplsInterface.dstMac));
+  group_bucket_entry->bucketData.mplsInterface.vlanId = group_bucket->vlanId;
+
+  if (group_action_bitmap & IND_OFDPA_OAM_LM_TX_COUNT)
+  {
+    group_bucket_entry->bucketData.mplsInterface.oamLmTxCountAction = 1;
+    group_bucket_entry->bucketData.mplsInterface.lmepId = group_bucket->lmepId;
+  }
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+static void
+ind_ofdpa_group_mpls_label_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                    uint64_t group_action_bitmap,
+                                    uint64_t group_action_sf_bitmap,
+                                    of_port_no_t watch_port,
+                                    ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->bucketData.mplsLabel.pushL2Hdr = group_bucket->pushL2Hdr;
+
+  if (group_action_bitmap & IND_OFDPA_PUSH_VLAN)
+  {
+    group_bucket_entry->bucketData.mplsLabel.pushVlan = 1;
+    group_bucket_entry->bucketData.mplsLabel.newTpid = group_bucket->newTpid;
+  }
+
+  if (group_action_bitmap & IND_OFDPA_PUSH_MPLS)
+  {
+    group_bucket_entry->bucketData.mplsLabel.pushMplsHdr = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsEtherType = group_bucket->mplsEtherType;
+  }
+
+  group_bucket_entry->bucketData.mplsLabel.pushCW = group_bucket->pushCW;
+
+  group_bucket_entry->bucketData.mplsLabel.mplsLabel = group_bucket->mplsLabel;
+
+  group_bucket_entry->bucketData.mplsLabel.mplsBOS = group_bucket->mplsBOS;
+
+  group_bucket_entry->bucketData.mplsLabel.mplsCopyEXPOutwards = group_bucket->mplsCopyEXPOutwards;
+  if (group_action_sf_bitmap & IND_OFDPA_MPLS_TC)
+  {
+    group_bucket_entry->bucketData.mplsLabel.mplsEXPAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsEXP = group_bucket->mplsEXP;
+  }
+  if (group_action_bitmap & IND_OFDPA_MPLS_TC_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.mplsLabel.mplsEXPRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsEXPRemarkTableIndex = group_bucket->mplsEXPRemarkTableIndex;
+  }
+
+  group_bucket_entry->bucketData.mplsLabel.mplsCopyTTLOutwards = group_bucket->mplsCopyTTLOutwards;
+  if (group_action_bitmap & IND_OFDPA_SET_MPLS_TTL)
+  {
+    group_bucket_entry->bucketData.mplsLabel.mplsTTLAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsTTL = group_bucket->mplsTTL;
+  }
+  if (group_action_sf_bitmap & IND_OFDPA_MPLS_TTL)
+  {
+    group_bucket_entry->bucketData.mplsLabel.mplsTTLAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsTTL = group_bucket->mplsTTL;
+  }
+
+  if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
+  {
+    group_bucket_entry->bucketData.mplsLabel.mplsPriorityRemarkTableIndexAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.mplsPriorityRemarkTableIndex = group_bucket->priorityRemarkTableIndex;
+  }
+
+  if (group_action_bitmap & IND_OFDPA_OAM_LM_TX_COUNT)
+  {
+    group_bucket_entry->bucketData.mplsLabel.oamLmTxCountAction = 1;
+    group_bucket_entry->bucketData.mplsLabel.lmepId = group_bucket->lmepId;
+  }
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+static void
+ind_ofdpa_group_mpls_fast_failover_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                            uint64_t group_action_bitmap,
+                                            uint64_t group_action_sf_bitmap,
+                                            of_port_no_t watch_port,
+                                            ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+  group_bucket_entry->bucketData.mplsFastFailOver.watchPort = watch_port;
+}
+
+static void
+ind_ofdpa_group_mpls_l2_tag_populate(const ind_ofdpa_group_bucket_t *group_bucket,
+                                     uint64_t group_action_bitmap,
+                                     uint64_t group_action_sf_bitmap,
+                                     of_port_no_t watch_port,
+                                     ofdpaGroupBucketEntry_t *group_bucket_entry)
+{
+  if (group_action_bitmap & IND_OFDPA_POP_VLAN)
+  {
+    group_bucket_entry->bucketData.mplsL2Tag.popVlan = 1;
+  }
+  if (group_action_bitmap & IND_OFDPA_PUSH_VLAN)
+  {
+    group_bucket_entry->bucketData.mplsL2Tag.pushVlan = 1;
+    group_bucket_entry->bucketData.mplsL2Tag.newTpid = group_bucket->newTpid;
+  }
+  group_bucket_entry->bucketData.mplsL2Tag.vlanId = group_bucket->vlanId;
+
+  group_bucket_entry->referenceGroupId = group_bucket->referenceGroupId;
+}
+
+typedef void (*ind_ofdpa_group_populate_f)(const ind_ofdpa_group_bucket_t *group_bucket,
+                                           uint64_t group_action_bitmap,
+                                           uint64_t group_action_sf_bitmap,
+                                           of_port_no_t watch_port,
+                                           ofdpaGroupBucketEntry_t *group_bucket_entry);
+
+/* One OF-DPA bucket format. A bucket may use only the actions in
+   action_bitmap and the set-fields in sf_bitmap; populate then fills the
+   format's bucket data. */
+typedef struct
+{
+  uint64_t                   action_bitmap;
+  uint64_t                   sf_bitmap;
+  ind_ofdpa_group_populate_f populate;
+} ind_ofdpa_group_format_t;
+
+/* Set-fields are not restricted for formats that take none of their own */
+#define IND_OFDPA_GROUP_ANY_SF_BITMAP   (~0ULL)
+
+#define IND_OFDPA_GROUP_FORMAT(_action_bitmap, _sf_bitmap, _name) \
+  { _action_bitmap, _sf_bitmap, ind_ofdpa_group_##_name##_populate }
+
+/* Formats of the group types without subtypes, indexed by group type */
+static const ind_ofdpa_group_format_t group_type_formats[16] =
+{
+  [OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE]            = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L2INTF_BITMAP, IND_OFDPA_L2INTF_SF_BITMAP, l2_interface),
+  [OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE]              = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L2REWRITE_BITMAP, IND_OFDPA_L2REWRITE_SF_BITMAP, l2_rewrite),
+  [OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST]              = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L3UNICAST_BITMAP, IND_OFDPA_L3UNICAST_SF_BITMAP, l3_unicast),
+  [OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST]            = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD]                = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE]            = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L3INTERFACE_BITMAP, IND_OFDPA_L3INTERFACE_SF_BITMAP, l3_interface),
+  [OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST]            = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_GROUP_ENTRY_TYPE_L3_ECMP]                 = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY]              = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L2OVERLAY_BITMAP, IND_OFDPA_GROUP_ANY_SF_BITMAP, l2_overlay),
+  [OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE] = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_L2_UNFILTERED_INTF_BITMAP, IND_OFDPA_L2_UNFILTERED_INTF_SF_BITMAP, l2_unfiltered_interface),
+};
+
+/* MPLS label group formats, indexed by MPLS subtype */
+static const ind_ofdpa_group_format_t group_mpls_label_formats[16] =
+{
+  [OFDPA_MPLS_INTERFACE]     = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSINTERFACE_BITMAP, IND_OFDPA_GROUP_ANY_SF_BITMAP, mpls_interface),
+  [OFDPA_MPLS_L2_VPN_LABEL]  = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSLABEL_BITMAP, IND_OFDPA_MPLSLABEL_SF_BITMAP, mpls_label),
+  [OFDPA_MPLS_L3_VPN_LABEL]  = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSLABEL_BITMAP, IND_OFDPA_MPLSLABEL_SF_BITMAP, mpls_label),
+  [OFDPA_MPLS_TUNNEL_LABEL1] = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSLABEL_BITMAP, IND_OFDPA_MPLSLABEL_SF_BITMAP, mpls_label),
+  [OFDPA_MPLS_TUNNEL_LABEL2] = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSLABEL_BITMAP, IND_OFDPA_MPLSLABEL_SF_BITMAP, mpls_label),
+  [OFDPA_MPLS_SWAP_LABEL]    = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSLABEL_BITMAP, IND_OFDPA_MPLSLABEL_SF_BITMAP, mpls_label),
+};
+
+/* MPLS forwarding group formats, indexed by MPLS subtype */
+static const ind_ofdpa_group_format_t group_mpls_forwarding_formats[16] =
+{
+  [OFDPA_MPLS_FAST_FAILOVER]               = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSFF_BITMAP, IND_OFDPA_GROUP_ANY_SF_BITMAP, mpls_fast_failover),
+  [OFDPA_MPLS_L2_TAG]                      = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_MPLSL2TAG_BITMAP, IND_OFDPA_MPLSL2TAG_SF_BITMAP, mpls_l2_tag),
+  [OFDPA_MPLS_L2_FLOOD]                    = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_L2_MULTICAST]                = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_L2_LOCAL_FLOOD]              = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_L2_LOCAL_MULTICAST]          = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_L2_FLOOD_SPLIT_HORIZON]      = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_L2_MULTICAST_SPLIT_HORIZON]  = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_1_1_HEAD_END_PROTECT]        = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+  [OFDPA_MPLS_ECMP]                        = IND_OFDPA_GROUP_FORMAT(IND_OFDPA_REFGROUP, IND_OFDPA_GROUP_ANY_SF_BITMAP, ref_group),
+};
+
+/* One entry per OF-DPA group type, indexed by the type field of the
+   group ID. Also registered as the table_priv of the Indigo group tables
+   covering that type. */
+typedef struct
+{
+  const char                     *name;
+  const ind_ofdpa_group_format_t *sub_formats;  /* by subtype, NULL if the type has none */
+  struct
+  {
+    uint64_t creates;
+    uint64_t modifies;
+    uint64_t deletes;
+    uint64_t failures;
+    uint64_t buckets;           /* buckets translated by create and modify */
+    uint64_t time_ns;           /* total time in create, modify and delete */
+  } stats;
+} ind_ofdpa_group_type_t;
+
+static ind_ofdpa_group_type_t group_types[16] =
+{
+  [OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE]            = { "l2_interface" },
+  [OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE]              = { "l2_rewrite" },
+  [OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST]              = { "l3_unicast" },
+  [OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST]            = { "l2_multicast" },
+  [OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD]                = { "l2_flood" },
+  [OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE]            = { "l3_interface" },
+  [OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST]            = { "l3_multicast" },
+  [OFDPA_GROUP_ENTRY_TYPE_L3_ECMP]                 = { "l3_ecmp" },
+  [OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY]              = { "l2_overlay" },
+  [OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL]              = { "mpls_label",      group_mpls_label_formats },
+  [OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING]         = { "mpls_forwarding", group_mpls_forwarding_formats },
+  [OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE] = { "l2_unfiltered_interface" },
+};
+
+void
+ind_ofdpa_group_type_stats_show(aim_pvs_t *pvs)
+{
+  ind_ofdpa_group_type_t *desc;
+  uint64_t ops;
+  int i;
+
+  aim_printf(pvs, "%-24s %10s %10s %10s %10s %12s %10s\n",
+             "type", "creates", "modifies", "deletes", "failures", "buckets", "avg_us");
+
+  for (i = 0; i < 16; i++)
+  {
+    desc = &group_types[i];
+    ops = desc->stats.creates + desc->stats.modifies + desc->stats.deletes;
+    if ((desc->name == NULL) || (ops + desc->stats.failures == 0))
+    {
+      continue;
+    }
+
+    aim_printf(pvs, "%-24s %10llu %10llu %10llu %10llu %12llu %10.1f\n",
+               desc->name,
+               (unsigned long long)desc->stats.creates,
+               (unsigned long long)desc->stats.modifies,
+               (unsigned long long)desc->stats.deletes,
+               (unsigned long long)desc->stats.failures,
+               (unsigned long long)desc->stats.buckets,
+               (ops == 0) ? 0.0 : (desc->stats.time_ns / 1000.0 / ops));
+  }
+}
+
+/* Bucket format of a group, from its type and, for subtyped types, its
+   subtype */
 static indigo_error_t
-ind_ofdpa_translate_group_buckets(uint32_t group_id, 
-                                  of_list_bucket_t *of_buckets,
-                                  uint16_t command)
+ind_ofdpa_group_format_get(const ind_ofdpa_group_id_t *gid,
+                           const ind_ofdpa_group_format_t **format)
+{
+  const ind_ofdpa_group_type_t *desc = &group_types[gid->type];
+
+  if (desc->name == NULL)
+  {
+    LOG_ERROR("Invalid GROUP_TYPE %d", gid->type);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  if (desc->sub_formats == NULL)
+  {
+    *format = &group_type_formats[gid->type];
+    return INDIGO_ERROR_NONE;
+  }
+
+  *format = &desc->sub_formats[gid->sub_type];
+  if ((*format)->populate == NULL)
+  {
+    LOG_ERROR("unsupported MPLS_SUBTYPE %d for GROUP_TYPE %d", gid->sub_type, gid->type);
+    return INDIGO_ERROR_COMPAT;
+  }
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Translate one OpenFlow bucket into an OF-DPA bucket entry of the given
+   format. Nothing is programmed here, so every bucket can be validated
+   before the group is touched. */
+static indigo_error_t
+ind_ofdpa_translate_group_bucket(uint32_t group_id,
+                                 const ind_ofdpa_group_format_t *format,
+                                 uint32_t bucket_index,
+                                 of_bucket_t *of_bucket,
+                                 ofdpaGroupBucketEntry_t *group_bucket_entry)
 {
   indigo_error_t err;
-  uint16_t bucket_index = 0;
   of_list_action_t of_actions;
-  of_bucket_t of_bucket;
   ind_ofdpa_group_bucket_t group_bucket;
-  int rv;
-  uint32_t group_type, sub_group_type;
   uint64_t group_action_bitmap = 0;
   uint64_t group_action_sf_bitmap = 0;
-  ofdpaGroupEntry_t group_entry;
-  ofdpaGroupBucketEntry_t group_bucket_entry;
-  OFDPA_ERROR_t ofdpa_rv = OFDPA_E_FAIL;
-  int group_added = 0;
   of_port_no_t watch_port;
 
-  OF_LIST_BUCKET_ITER(of_buckets, &of_bucket, rv) 
+  of_bucket_watch_port_get(of_bucket, &watch_port);
+
+  of_bucket_actions_bind(of_bucket, &of_actions);
+
+  memset(&group_bucket, 0, sizeof(group_bucket));
+
+  err = ind_ofdpa_translate_group_actions(
+      &of_actions, &group_bucket, &group_action_bitmap, &group_action_sf_bitmap);
+  if (err < 0) 
+  {
+    LOG_ERROR("Error in translating group actions");
+    return err;
+  }
+
+  if (((group_action_bitmap & ~format->action_bitmap) != 0) ||
+      ((group_action_sf_bitmap & ~format->sf_bitmap) != 0))
+  {
+    LOG_ERROR("Incompatible fields for Group Type");
+    return INDIGO_ERROR_COMPAT;
+  }
+
+  memset(group_bucket_entry, 0, sizeof(*group_bucket_entry));
+  group_bucket_entry->groupId = group_id;
+  group_bucket_entry->bucketIndex = bucket_index;
+
+  format->populate(&group_bucket, group_action_bitmap, group_action_sf_bitmap,
+                   watch_port, group_bucket_entry);
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Translate and validate the complete bucket list. On success the caller
+   owns *entries and must free it. */
+static indigo_error_t
+ind_ofdpa_translate_group_buckets(uint32_t group_id,
+                                  const ind_ofdpa_group_id_t *gid,
+                                  of_list_bucket_t *of_buckets,
+                                  ofdpaGroupBucketEntry_t **entries,
+                                  uint32_t *count)
+{
+  indigo_error_t err;
+  of_bucket_t of_bucket;
+  ofdpaGroupBucketEntry_t *list;
+  const ind_ofdpa_group_format_t *format;
+  uint32_t num_buckets = 0;
+  uint32_t i = 0;
+  int rv;
+
+  *entries = NULL;
+  *count = 0;
+
+  err = ind_ofdpa_group_format_get(gid, &format);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  OF_LIST_BUCKET_ITER(of_buckets, &of_bucket, rv)
   {
-    of_bucket_watch_port_get(&of_bucket,&watch_port);
-    
-    of_bucket_actions_bind(&of_bucket, &of_actions);
+    num_buckets++;
+  }
+
+  if (num_buckets == 0)
+  {
+    LOG_ERROR("No buckets given for Group 0x%x", group_id);
+    return INDIGO_ERROR_PARAM;
+  }
 
-    memset(&group_bucket, 0, sizeof(group_bucket));
+  list = calloc(num_buckets, sizeof(*list));
+  if (list == NULL)
+  {
+    LOG_ERROR("Failed to allocate %u Group buckets", num_buckets);
+    return INDIGO_ERROR_RESOURCE;
+  }
 
-    err = ind_ofdpa_translate_group_actions(
-        &of_actions, &group_bucket, &group_action_bitmap, &group_action_sf_bitmap);
-    if (err < 0) 
+  OF_LIST_BUCKET_ITER(of_buckets, &of_bucket, rv)
+  {
+    err = ind_ofdpa_translate_group_bucket(group_id, format, i, &of_bucket, &list[i]);
+    if (err != INDIGO_ERROR_NONE)
     {
-      LOG_ERROR("Error in translating group actions");
-      if (group_added == 1) 
-      {
-        /* Delete the added group */
-        (void)ofdpaGroupDelete(group_id);
-      }
+      free(list);
       return err;
     }
+    i++;
+  }
+
+  *entries = list;
+  *count = num_buckets;
+  group_types[gid->type].stats.buckets += num_buckets;
 
-    ofdpaGroupTypeGet(group_id, &group_type);
+  return INDIGO_ERROR_NONE;
+}
 
-    memset(&group_bucket_entry, 0, sizeof(group_bucket_entry));
-    group_bucket_entry.groupId = group_id;
-    group_bucket_entry.bucketIndex = bucket_index;
+/* Read back the buckets currently programmed for a group, in index order */
+static indigo_error_t
+ind_ofdpa_group_buckets_read(uint32_t group_id,
+                             ofdpaGroupBucketEntry_t **entries,
+                             uint32_t *count)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  ofdpaGroupBucketEntry_t *list = NULL;
+  ofdpaGroupBucketEntry_t *grown;
+  uint32_t num_buckets = 0;
+  uint32_t size = 0;
+  OFDPA_ERROR_t ofdpa_rv;
 
-    err = INDIGO_ERROR_NONE;
+  memset(&bucket, 0, sizeof(bucket));
+  ofdpa_rv = ofdpaGroupBucketEntryFirstGet(group_id, &bucket);
 
-    switch (group_type)
+  while (ofdpa_rv == OFDPA_E_NONE)
+  {
+    if (num_buckets == size)
     {
-      case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
-        if((group_action_bitmap | IND_OFDPA_L2INTF_BITMAP) != IND_OFDPA_L2INTF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        if((group_action_sf_bitmap | IND_OFDPA_L2INTF_SF_BITMAP) != IND_OFDPA_L2INTF_SF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        group_bucket_entry.bucketData.l2Interface.outputPort = group_bucket.outputPort;
-        group_bucket_entry.bucketData.l2Interface.popVlanTag = group_bucket.popVlanTag;
+      size = (size == 0) ? 8 : (size * 2);
+      grown = realloc(list, size * sizeof(*list));
+      if (grown == NULL)
+      {
+        LOG_ERROR("Failed to allocate %u Group buckets", size);
+        free(list);
+        return INDIGO_ERROR_RESOURCE;
+      }
+      list = grown;
+    }
+    list[num_buckets++] = bucket;
 
-        if (group_action_sf_bitmap & IND_OFDPA_VLAN_PCP)
-        {
-          group_bucket_entry.bucketData.l2Interface.vlanPcpAction = 1;
-          group_bucket_entry.bucketData.l2Interface.vlanPcp = group_bucket.vlanPcp;
-        }
-        if (group_action_sf_bitmap & IND_OFDPA_VLAN_DEI)
-        {
-          group_bucket_entry.bucketData.l2Interface.vlanCfiAction = 1;
-          group_bucket_entry.bucketData.l2Interface.vlanCfi = group_bucket.vlanCfi;
-        }
-        if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
-        {
-          group_bucket_entry.bucketData.l2Interface.priorityRemarkTableIndexAction = 1;
-          group_bucket_entry.bucketData.l2Interface.priorityRemarkTableIndex = group_bucket.priorityRemarkTableIndex;
-        }
+    ofdpa_rv = ofdpaGroupBucketEntryNextGet(group_id, bucket.bucketIndex, &bucket);
+  }
 
-        if (group_action_sf_bitmap & IND_OFDPA_IP_DSCP)
-        {
-          group_bucket_entry.bucketData.l2Interface.dscpAction = 1;
-          group_bucket_entry.bucketData.l2Interface.dscp = group_bucket.dscp;
-        }
-        if (group_action_bitmap & IND_OFDPA_DSCP_REMARK_TABLE_INDEX)
-        {
-          group_bucket_entry.bucketData.l2Interface.dscpRemarkTableIndexAction = 1;
-          group_bucket_entry.bucketData.l2Interface.dscpRemarkTableIndex = group_bucket.dscpRemarkTableIndex;
-        }
-        
-        break;
+  *entries = list;
+  *count = num_buckets;
 
-      case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
-        if((group_action_bitmap | IND_OFDPA_L2_UNFILTERED_INTF_BITMAP) != IND_OFDPA_L2_UNFILTERED_INTF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        if((group_action_sf_bitmap | IND_OFDPA_L2_UNFILTERED_INTF_SF_BITMAP) != IND_OFDPA_L2_UNFILTERED_INTF_SF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        group_bucket_entry.bucketData.l2UnfilteredInterface.outputPort = group_bucket.outputPort;
+  return INDIGO_ERROR_NONE;
+}
 
-        
-        if (group_action_sf_bitmap & IND_OFDPA_VLAN_PCP)
-        {
-          group_bucket_entry.bucketData.l2UnfilteredInterface.vlanPcpAction = 1;
-          group_bucket_entry.bucketData.l2UnfilteredInterface.vlanPcp = group_bucket.vlanPcp;
-        }
-        if (group_action_sf_bitmap & IND_OFDPA_VLAN_DEI)
-        {
-          group_bucket_entry.bucketData.l2UnfilteredInterface.vlanCfiAction = 1;
-          group_bucket_entry.bucketData.l2UnfilteredInterface.vlanCfi = group_bucket.vlanCfi;
-        }
-        if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
-        {
-          group_bucket_entry.bucketData.l2UnfilteredInterface.priorityRemarkTableIndexAction = 1;
-          group_bucket_entry.bucketData.l2UnfilteredInterface.priorityRemarkTableIndex = group_bucket.priorityRemarkTableIndex;
-        }
+/* Placeholder index for new buckets that have not been given one yet */
+#define IND_OFDPA_GROUP_BUCKET_INDEX_NONE   0xFFFFFFFF
 
-        if (group_action_sf_bitmap & IND_OFDPA_IP_DSCP)
-        {
-          group_bucket_entry.bucketData.l2UnfilteredInterface.dscpAction = 1;
-          group_bucket_entry.bucketData.l2UnfilteredInterface.dscp = group_bucket.dscp;
-        }
-        if (group_action_bitmap & IND_OFDPA_DSCP_REMARK_TABLE_INDEX)
-        {
-          group_bucket_entry.bucketData.l2UnfilteredInterface.dscpRemarkTableIndexAction = 1;
-          group_bucket_entry.bucketData.l2UnfilteredInterface.dscpRemarkTableIndex = group_bucket.dscpRemarkTableIndex;
-        }
+static int
+ind_ofdpa_group_bucket_equal(ofdpaGroupBucketEntry_t *a, ofdpaGroupBucketEntry_t *b)
+{
+  return ((a->referenceGroupId == b->referenceGroupId) &&
+          (memcmp(&a->bucketData, &b->bucketData, sizeof(a->bucketData)) == 0));
+}
+
+/* Zero if the bucket chains to a group OF-DPA does not have. Such a bucket
+   can never be added, so a modify must not delete the bucket it replaces
+   first. */
+static int
+ind_ofdpa_group_bucket_ref_present(const ofdpaGroupBucketEntry_t *bucket)
+{
+  ofdpaGroupEntryStats_t stats;
+
+  return ((bucket->referenceGroupId == 0) ||
+          (ofdpaGroupStatsGet(bucket->referenceGroupId, &stats) == OFDPA_E_NONE));
+}
+
+/* Find the lowest bucket index, starting at start, not used by the current
+   buckets nor by the new bucket set */
+static uint32_t
+ind_ofdpa_group_bucket_index_alloc(uint32_t start,
+                                   ofdpaGroupBucketEntry_t *old_buckets, uint32_t num_old,
+                                   ofdpaGroupBucketEntry_t *new_buckets, uint32_t num_new)
+{
+  uint32_t index = start;
+  uint32_t i;
+  int in_use;
+
+  do
+  {
+    in_use = 0;
+    for (i = 0; (i < num_old) && !in_use; i++)
+    {
+      in_use = (old_buckets[i].bucketIndex == index);
+    }
+    for (i = 0; (i < num_new) && !in_use; i++)
+    {
+      in_use = (new_buckets[i].bucketIndex == index);
+    }
+    if (in_use)
+    {
+      index++;
+    }
+  } while (in_use);
+
+  return index;
+}
+
+/* Hash buckets of the group registry, must be a power of two */
+#define IND_OFDPA_GROUP_HASH_SIZE   4096
+
+/* Longest group chain followed when walking references */
+#define IND_OFDPA_GROUP_MAX_DEPTH   16
+
+/* A group whose buckets point at another group */
+typedef struct
+{
+  uint32_t id;
+  uint32_t count;               /* buckets of that group pointing here */
+} ind_ofdpa_group_referrer_t;
+
+/* Driver state for an installed group; used as the Indigo entry_priv */
+typedef struct ind_ofdpa_group_s
+{
+  struct ind_ofdpa_group_s *hash_next;
+  uint32_t                 id;
+  ind_ofdpa_group_id_t     gid;
+  uint32_t                 num_buckets;
+  ofdpaGroupBucketEntry_t *buckets;     /* as last programmed, with their OF-DPA bucket indices */
+  uint32_t                 num_slots;   /* resilient table size, 0 if not resilient */
+  uint32_t                 num_members;
+  ofdpaGroupBucketEntry_t *members;     /* buckets as given by the controller, resilient groups only */
+  uint32_t                 flow_refs;   /* flows whose actions point here */
+  uint32_t                 stats_ref_count;     /* last OF-DPA stats sample */
+  uint32_t                 stats_duration;
+  uint64_t                 stats_sampled_ns;    /* 0 if never sampled */
+  uint32_t                 num_referrers;
+  uint32_t                 max_referrers;
+  ind_ofdpa_group_referrer_t *referrers;
+  int                      restored;    /* found in OF-DPA on warm restart, not yet claimed */
+  int                      unconfirmed; /* installed before a resync started, not modified since */
+  int                      swept;       /* deleted from OF-DPA at the end of a resync */
+} ind_ofdpa_group_t;
+
+/* Shadow record of a group; its buckets are read back from OF-DPA */
+typedef struct
+{
+  uint32_t num_slots;
+} ind_ofdpa_group_shadow_t;
+
+/* Groups whose buckets are an unordered set, so a bucket may move to any
+   index. Fast failover and protection groups depend on bucket order. */
+static int
+ind_ofdpa_group_buckets_unordered(const ind_ofdpa_group_id_t *gid)
+{
+  switch (gid->type)
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_ECMP:
+      return 1;
+
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING:
+      switch (gid->sub_type)
+      {
+        case OFDPA_MPLS_L2_FLOOD:
+        case OFDPA_MPLS_L2_MULTICAST:
+        case OFDPA_MPLS_L2_LOCAL_FLOOD:
+        case OFDPA_MPLS_L2_LOCAL_MULTICAST:
+        case OFDPA_MPLS_L2_FLOOD_SPLIT_HORIZON:
+        case OFDPA_MPLS_L2_MULTICAST_SPLIT_HORIZON:
+        case OFDPA_MPLS_ECMP:
+          return 1;
+        default:
+          return 0;
+      }
+
+    default:
+      return 0;
+  }
+}
+
+static int
+ind_ofdpa_group_is_ecmp(const ind_ofdpa_group_id_t *gid)
+{
+  return ((gid->type == OFDPA_GROUP_ENTRY_TYPE_L3_ECMP) ||
+          ((gid->type == OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING) &&
+           (gid->sub_type == OFDPA_MPLS_ECMP)));
+}
+
+/* Groups whose buckets carry a referenceGroupId */
+static int
+ind_ofdpa_group_type_has_refs(uint32_t group_type)
+{
+  switch (group_type)
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY:
+      return 0;
+    default:
+      return 1;
+  }
+}
+
+static ind_ofdpa_group_t *group_hash[IND_OFDPA_GROUP_HASH_SIZE];
+static uint32_t group_restored_count;
+static uint32_t group_unconfirmed_count;
+
+static uint32_t
+ind_ofdpa_group_hash(uint32_t group_id)
+{
+  return (group_id ^ (group_id >> 12) ^ (group_id >> 24)) & (IND_OFDPA_GROUP_HASH_SIZE - 1);
+}
+
+static ind_ofdpa_group_t *
+ind_ofdpa_group_find(uint32_t group_id)
+{
+  ind_ofdpa_group_t *group;
+
+  for (group = group_hash[ind_ofdpa_group_hash(group_id)]; group != NULL; group = group->hash_next)
+  {
+    if (group->id == group_id)
+    {
+      return group;
+    }
+  }
+  return NULL;
+}
+
+static void
+ind_ofdpa_group_shadow_set(ind_ofdpa_group_t *group)
+{
+  ind_ofdpa_group_shadow_t shadow;
+
+  shadow.num_slots = group->num_slots;
+  if (ind_ofdpa_shadow_put(IND_OFDPA_SHADOW_GROUP, group->id, &shadow, sizeof(shadow)) != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Failed to shadow Group 0x%x", group->id);
+  }
+}
+
+static void
+ind_ofdpa_group_insert(ind_ofdpa_group_t *group)
+{
+  uint32_t hash = ind_ofdpa_group_hash(group->id);
+
+  group->hash_next = group_hash[hash];
+  group_hash[hash] = group;
+  ind_ofdpa_group_shadow_set(group);
+}
+
+static void
+ind_ofdpa_group_remove(ind_ofdpa_group_t *group)
+{
+  ind_ofdpa_group_t **link = &group_hash[ind_ofdpa_group_hash(group->id)];
+
+  ind_ofdpa_shadow_delete(IND_OFDPA_SHADOW_GROUP, group->id);
+  while (*link != NULL)
+  {
+    if (*link == group)
+    {
+      *link = group->hash_next;
+      return;
+    }
+    link = &(*link)->hash_next;
+  }
+}
+
+static void
+ind_ofdpa_group_referrer_add(ind_ofdpa_group_t *target, uint32_t referrer_id)
+{
+  ind_ofdpa_group_referrer_t *grown;
+  uint32_t i;
+
+  for (i = 0; i < target->num_referrers; i++)
+  {
+    if (target->referrers[i].id == referrer_id)
+    {
+      target->referrers[i].count++;
+      return;
+    }
+  }
+
+  if (target->num_referrers == target->max_referrers)
+  {
+    uint32_t max = (target->max_referrers == 0) ? 4 : (target->max_referrers * 2);
+
+    grown = realloc(target->referrers, max * sizeof(*grown));
+    if (grown == NULL)
+    {
+      LOG_ERROR("Failed to track reference from Group 0x%x to Group 0x%x", referrer_id, target->id);
+      return;
+    }
+    target->referrers = grown;
+    target->max_referrers = max;
+  }
+
+  target->referrers[target->num_referrers].id = referrer_id;
+  target->referrers[target->num_referrers].count = 1;
+  target->num_referrers++;
+}
+
+static void
+ind_ofdpa_group_referrer_remove(ind_ofdpa_group_t *target, uint32_t referrer_id)
+{
+  uint32_t i;
+
+  for (i = 0; i < target->num_referrers; i++)
+  {
+    if (target->referrers[i].id == referrer_id)
+    {
+      if (--target->referrers[i].count == 0)
+      {
+        target->referrers[i] = target->referrers[--target->num_referrers];
+      }
+      return;
+    }
+  }
+}
+
+/* Add or drop the references held by a set of buckets of group */
+static void
+ind_ofdpa_group_refs_update(ind_ofdpa_group_t *group,
+                            ofdpaGroupBucketEntry_t *buckets,
+                            uint32_t num_buckets,
+                            int add)
+{
+  ind_ofdpa_group_t *target;
+  uint32_t i;
+
+  if (!ind_ofdpa_group_type_has_refs(group->gid.type))
+  {
+    return;
+  }
+
+  for (i = 0; i < num_buckets; i++)
+  {
+    target = ind_ofdpa_group_find(buckets[i].referenceGroupId);
+    if ((target == NULL) || (target == group))
+    {
+      continue;
+    }
+    if (add)
+    {
+      ind_ofdpa_group_referrer_add(target, group->id);
+    }
+    else
+    {
+      ind_ofdpa_group_referrer_remove(target, group->id);
+    }
+  }
+}
+
+/* Install a new bucket shadow for group, moving its references over */
+static void
+ind_ofdpa_group_buckets_replace(ind_ofdpa_group_t *group,
+                                ofdpaGroupBucketEntry_t *buckets,
+                                uint32_t num_buckets)
+{
+  ind_ofdpa_group_refs_update(group, buckets, num_buckets, 1);
+  ind_ofdpa_group_refs_update(group, group->buckets, group->num_buckets, 0);
+
+  free(group->buckets);
+  group->buckets = buckets;
+  group->num_buckets = num_buckets;
+}
+
+static uint32_t
+ind_ofdpa_group_level_get(ind_ofdpa_group_t *group, uint32_t depth)
+{
+  ind_ofdpa_group_t *target;
+  uint32_t level = 0;
+  uint32_t i;
+
+  if ((depth >= IND_OFDPA_GROUP_MAX_DEPTH) || !ind_ofdpa_group_type_has_refs(group->gid.type))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < group->num_buckets; i++)
+  {
+    target = ind_ofdpa_group_find(group->buckets[i].referenceGroupId);
+    if ((target != NULL) && (target != group))
+    {
+      uint32_t target_level = ind_ofdpa_group_level_get(target, depth + 1) + 1;
+
+      if (target_level > level)
+      {
+        level = target_level;
+      }
+    }
+  }
+
+  return level;
+}
+
+void
+ind_ofdpa_group_flow_ref(uint32_t group_id)
+{
+  ind_ofdpa_group_t *group;
+
+  if ((group_id != 0) && ((group = ind_ofdpa_group_find(group_id)) != NULL))
+  {
+    group->flow_refs++;
+  }
+}
+
+void
+ind_ofdpa_group_flow_unref(uint32_t group_id)
+{
+  ind_ofdpa_group_t *group;
+
+  if ((group_id != 0) && ((group = ind_ofdpa_group_find(group_id)) != NULL) &&
+      (group->flow_refs > 0))
+  {
+    group->flow_refs--;
+  }
+}
+
+int
+ind_ofdpa_group_in_use(uint32_t group_id)
+{
+  ind_ofdpa_group_t *group = ind_ofdpa_group_find(group_id);
+
+  return ((group != NULL) && ((group->flow_refs != 0) || (group->num_referrers != 0)));
+}
+
+/* Delete the flows of an in-use group instead of rejecting the delete */
+static int group_delete_cascade = 0;
+
+void
+ind_ofdpa_group_delete_cascade_set(int enable)
+{
+  group_delete_cascade = enable;
+}
+
+uint32_t
+ind_ofdpa_group_level(uint32_t group_id)
+{
+  ind_ofdpa_group_t *group = ind_ofdpa_group_find(group_id);
+
+  return (group == NULL) ? 0 : ind_ofdpa_group_level_get(group, 0);
+}
+
+typedef struct
+{
+  uint32_t id;
+  uint32_t level;
+} ind_ofdpa_group_sort_key_t;
+
+static int
+ind_ofdpa_group_sort_cmp(const void *a, const void *b)
+{
+  const ind_ofdpa_group_sort_key_t *ka = a;
+  const ind_ofdpa_group_sort_key_t *kb = b;
+
+  if (ka->level != kb->level)
+  {
+    return (ka->level < kb->level) ? -1 : 1;
+  }
+  return (ka->id < kb->id) ? -1 : (ka->id > kb->id);
+}
+
+indigo_error_t
+ind_ofdpa_group_sort(uint32_t *ids, uint32_t count, int delete_order)
+{
+  ind_ofdpa_group_sort_key_t *keys;
+  uint32_t i;
+
+  keys = calloc(count + 1, sizeof(*keys));
+  if (keys == NULL)
+  {
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    keys[i].id = ids[i];
+    keys[i].level = ind_ofdpa_group_level(ids[i]);
+  }
+
+  qsort(keys, count, sizeof(*keys), ind_ofdpa_group_sort_cmp);
+
+  for (i = 0; i < count; i++)
+  {
+    ids[i] = keys[delete_order ? (count - 1 - i) : i].id;
+  }
+
+  free(keys);
+
+  return INDIGO_ERROR_NONE;
+}
+
+static void
+ind_ofdpa_group_dependents_print(aim_pvs_t *pvs, ind_ofdpa_group_t *group,
+                                 uint32_t buckets, uint32_t depth)
+{
+  ind_ofdpa_group_t *referrer;
+  uint32_t i;
+
+  aim_printf(pvs, "%*s0x%08x", (int)(depth * 2), "", group->id);
+  if (depth > 0)
+  {
+    aim_printf(pvs, " (%u bucket%s)", buckets, (buckets == 1) ? "" : "s");
+  }
+  aim_printf(pvs, " flows %u\n", group->flow_refs);
+
+  if (depth >= IND_OFDPA_GROUP_MAX_DEPTH)
+  {
+    return;
+  }
+
+  for (i = 0; i < group->num_referrers; i++)
+  {
+    referrer = ind_ofdpa_group_find(group->referrers[i].id);
+    if (referrer != NULL)
+    {
+      ind_ofdpa_group_dependents_print(pvs, referrer, group->referrers[i].count, depth + 1);
+    }
+  }
+}
+
+void
+ind_ofdpa_group_dependents_show(aim_pvs_t *pvs, uint32_t group_id)
+{
+  ind_ofdpa_group_t *group = ind_ofdpa_group_find(group_id);
+
+  if (group == NULL)
+  {
+    aim_printf(pvs, "Group 0x%08x not found\n", group_id);
+    return;
+  }
+
+  aim_printf(pvs, "Group 0x%08x level %u, referenced by %u groups and %u flows\n",
+             group_id, ind_ofdpa_group_level_get(group, 0),
+             group->num_referrers, group->flow_refs);
+  ind_ofdpa_group_dependents_print(pvs, group, 0, 0);
+}
+
+/* Physical bucket table size for new resilient select groups, 0 if disabled */
+static uint32_t resilient_num_slots = 0;
+
+static struct
+{
+  uint64_t updates;
+  uint64_t slots;               /* slots covered by all updates */
+  uint64_t remapped;            /* slots that changed member */
+  uint64_t modulo_remapped;     /* slots a modulo-N hash would have moved */
+} resilient_stats;
+
+/*
+ * Spread the members over num_slots physical buckets. A slot of the
+ * group's current table keeps its member as long as that member is still
+ * present and holds no more than its fair share; the remaining slots are
+ * handed out round robin to members below their share.
+ */
+static indigo_error_t
+ind_ofdpa_group_resilient_expand(ind_ofdpa_group_t *group,
+                                 uint32_t num_slots,
+                                 ofdpaGroupBucketEntry_t *members,
+                                 uint32_t num_members,
+                                 ofdpaGroupBucketEntry_t **slots_out)
+{
+  ofdpaGroupBucketEntry_t *slots;
+  int32_t *owner;
+  uint32_t *share;
+  uint32_t *held;
+  uint32_t k, m;
+  uint32_t cursor = 0;
+
+  slots = calloc(num_slots, sizeof(*slots));
+  owner = calloc(num_slots, sizeof(*owner));
+  share = calloc(num_members, sizeof(*share));
+  held = calloc(num_members, sizeof(*held));
+  if ((slots == NULL) || (owner == NULL) || (share == NULL) || (held == NULL))
+  {
+    LOG_ERROR("Failed to allocate %u resilient slots", num_slots);
+    free(slots);
+    free(owner);
+    free(share);
+    free(held);
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  for (m = 0; m < num_members; m++)
+  {
+    share[m] = (num_slots / num_members) + ((m < (num_slots % num_members)) ? 1 : 0);
+  }
+
+  for (k = 0; k < num_slots; k++)
+  {
+    owner[k] = -1;
+    if ((group == NULL) || (k >= group->num_buckets))
+    {
+      continue;
+    }
+    for (m = 0; m < num_members; m++)
+    {
+      if ((held[m] < share[m]) &&
+          ind_ofdpa_group_bucket_equal(&group->buckets[k], &members[m]))
+      {
+        owner[k] = m;
+        held[m]++;
+        break;
+      }
+    }
+  }
+
+  for (k = 0; k < num_slots; k++)
+  {
+    if (owner[k] < 0)
+    {
+      /* Some member is below its share as long as a slot is unowned */
+      while (held[cursor] >= share[cursor])
+      {
+        cursor = (cursor + 1) % num_members;
+      }
+      owner[k] = cursor;
+      held[cursor]++;
+      cursor = (cursor + 1) % num_members;
+    }
+    slots[k] = members[owner[k]];
+    slots[k].bucketIndex = k;
+  }
+
+  free(owner);
+  free(share);
+  free(held);
+
+  *slots_out = slots;
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Count the slots a resilient table update remaps, and the slots a
+   modulo-N hash over the same table would have remapped */
+static void
+ind_ofdpa_group_resilient_remap_count(ind_ofdpa_group_t *group,
+                                      ofdpaGroupBucketEntry_t *slots,
+                                      ofdpaGroupBucketEntry_t *members,
+                                      uint32_t num_members,
+                                      uint32_t *remapped,
+                                      uint32_t *modulo_remapped)
+{
+  uint32_t k;
+
+  *remapped = 0;
+  *modulo_remapped = 0;
+
+  for (k = 0; k < group->num_slots; k++)
+  {
+    if ((k >= group->num_buckets) ||
+        !ind_ofdpa_group_bucket_equal(&group->buckets[k], &slots[k]))
+    {
+      (*remapped)++;
+    }
+    /* A restored table has no member list to compare against */
+    if ((group->num_members != 0) &&
+        !ind_ofdpa_group_bucket_equal(&group->members[k % group->num_members],
+                                      &members[k % num_members]))
+    {
+      (*modulo_remapped)++;
+    }
+  }
+}
+
+indigo_error_t
+ind_ofdpa_group_resilient_set(uint32_t num_slots)
+{
+  if (num_slots > IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS)
+  {
+    LOG_ERROR("Resilient table size %u exceeds %u", num_slots, IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  resilient_num_slots = num_slots;
+
+  return INDIGO_ERROR_NONE;
+}
+
+void
+ind_ofdpa_group_resilient_stats_show(aim_pvs_t *pvs)
+{
+  uint64_t slots = resilient_stats.slots;
+
+  if (resilient_num_slots == 0)
+  {
+    aim_printf(pvs, "Resilient hashing disabled for new groups\n");
+  }
+  else
+  {
+    aim_printf(pvs, "Resilient hashing with %u slots per new select group\n", resilient_num_slots);
+  }
+
+  aim_printf(pvs, "Membership updates     %llu\n", (unsigned long long)resilient_stats.updates);
+  aim_printf(pvs, "Slots remapped         %llu of %llu (%.2f%%)\n",
+             (unsigned long long)resilient_stats.remapped, (unsigned long long)slots,
+             (slots == 0) ? 0.0 : (100.0 * resilient_stats.remapped / slots));
+  aim_printf(pvs, "Modulo-N would remap   %llu of %llu (%.2f%%)\n",
+             (unsigned long long)resilient_stats.modulo_remapped, (unsigned long long)slots,
+             (slots == 0) ? 0.0 : (100.0 * resilient_stats.modulo_remapped / slots));
+}
+
+/* Program a new group; on success the group takes ownership of entries */
+static indigo_error_t
+ind_ofdpa_group_add(ind_ofdpa_group_t *group,
+                    ofdpaGroupBucketEntry_t *entries,
+                    uint32_t count)
+{
+  ofdpaGroupEntry_t group_entry;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t i;
+
+  memset(&group_entry, 0, sizeof(group_entry));
+  group_entry.groupId = group->id;
+
+  ofdpa_rv = ofdpaGroupAdd(&group_entry);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Error in adding Group, rv = %d",ofdpa_rv);
+    return indigoConvertOfdpaRv(ofdpa_rv);
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    ofdpa_rv = ofdpaGroupBucketEntryAdd(&entries[i]);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Error in adding Group bucket, rv = %d",ofdpa_rv);
+      /* Delete the added group */
+      (void)ofdpaGroupDelete(group->id);
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
+  }
+
+  group->num_buckets = count;
+  group->buckets = entries;
+
+  return INDIGO_ERROR_NONE;
+}
+
+typedef enum
+{
+  IND_OFDPA_BUCKET_UNDO_DELETE = 0,     /* bucket was added */
+  IND_OFDPA_BUCKET_UNDO_MODIFY,         /* bucket was modified, entry holds the old contents */
+  IND_OFDPA_BUCKET_UNDO_ADD,            /* bucket was deleted, entry holds the old contents */
+} ind_ofdpa_bucket_undo_op_t;
+
+typedef struct
+{
+  ind_ofdpa_bucket_undo_op_t op;
+  ofdpaGroupBucketEntry_t    entry;
+} ind_ofdpa_bucket_undo_t;
+
+static void
+ind_ofdpa_group_buckets_rollback(uint32_t group_id,
+                                 ind_ofdpa_bucket_undo_t *undo,
+                                 uint32_t num_undo)
+{
+  OFDPA_ERROR_t ofdpa_rv;
+
+  LOG_ERROR("Restoring previous buckets of Group 0x%x", group_id);
+
+  while (num_undo > 0)
+  {
+    num_undo--;
+    switch (undo[num_undo].op)
+    {
+      case IND_OFDPA_BUCKET_UNDO_DELETE:
+        ofdpa_rv = ofdpaGroupBucketEntryDelete(group_id, undo[num_undo].entry.bucketIndex);
+        break;
+      case IND_OFDPA_BUCKET_UNDO_MODIFY:
+        ofdpa_rv = ofdpaGroupBucketEntryModify(&undo[num_undo].entry);
+        break;
+      case IND_OFDPA_BUCKET_UNDO_ADD:
+      default:
+        ofdpa_rv = ofdpaGroupBucketEntryAdd(&undo[num_undo].entry);
+        break;
+    }
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to restore bucket %u of Group 0x%x, rv = %d",
+                undo[num_undo].entry.bucketIndex, group_id, ofdpa_rv);
+    }
+  }
+}
+
+/*
+ * Replace the buckets of an existing group without a window in which the
+ * group has no buckets, issuing RPCs only for buckets that change.
+ *
+ * The current buckets come from the group's shadow copy. For unordered
+ * groups (ECMP, flood, multicast) every new bucket identical to a current
+ * one keeps that bucket's index; resilient groups are matched by slot. The remaining new buckets take over the
+ * remaining current buckets in order and are modified in place; where
+ * OF-DPA refuses the modify, the new bucket is added under a free index
+ * before the old one is deleted. Groups whose bucket order matters (fast
+ * failover, protection) cannot take a bucket under another index, so
+ * there the old bucket is deleted and the new one added under its index;
+ * the group's other buckets forward meanwhile. Surplus buckets are deleted only after
+ * all new buckets are in place. Any failure undoes the steps already
+ * taken, so the group keeps its previous bucket set.
+ *
+ * On success the group takes ownership of entries.
+ */
+static indigo_error_t
+ind_ofdpa_group_modify(ind_ofdpa_group_t *group,
+                       ofdpaGroupBucketEntry_t *entries,
+                       uint32_t count)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *old_buckets = group->buckets;
+  uint32_t num_old = group->num_buckets;
+  int32_t *old_pair = NULL;             /* current bucket taken over by each new bucket */
+  uint8_t *old_used = NULL;
+  uint8_t *old_stale = NULL;
+  ind_ofdpa_bucket_undo_t *undo = NULL;
+  uint32_t num_undo = 0;
+  uint32_t free_index = 0;
+  uint32_t next_old = 0;
+  uint32_t i, j;
+  int ordered;
+  int in_place;
+  OFDPA_ERROR_t ofdpa_rv = OFDPA_E_NONE;
+
+  /* Each bucket needs at most two steps (add and delete) to undo */
+  undo = calloc(2 * (count + num_old), sizeof(*undo));
+  old_pair = calloc(count, sizeof(*old_pair));
+  old_used = calloc(num_old + 1, sizeof(*old_used));
+  old_stale = calloc(num_old + 1, sizeof(*old_stale));
+  if ((undo == NULL) || (old_pair == NULL) || (old_used == NULL) || (old_stale == NULL))
+  {
+    LOG_ERROR("Failed to allocate Group 0x%x modify state", group->id);
+    err = INDIGO_ERROR_RESOURCE;
+    goto done;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    old_pair[i] = -1;
+  }
+
+  /* A spare bucket added under a free index would sort after its
+     neighbours, e.g. ahead of the primary in a fast failover group */
+  ordered = ((group->num_slots == 0) && (num_old > 1) &&
+             !ind_ofdpa_group_buckets_unordered(&group->gid));
+
+  if ((group->num_slots == 0) &&
+      ind_ofdpa_group_buckets_unordered(&group->gid))
+  {
+    for (i = 0; i < count; i++)
+    {
+      for (j = 0; j < num_old; j++)
+      {
+        if (!old_used[j] && ind_ofdpa_group_bucket_equal(&old_buckets[j], &entries[i]))
+        {
+          old_pair[i] = j;
+          old_used[j] = 1;
+          break;
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    if (old_pair[i] < 0)
+    {
+      while ((next_old < num_old) && old_used[next_old])
+      {
+        next_old++;
+      }
+      if (next_old < num_old)
+      {
+        old_pair[i] = next_old;
+        old_used[next_old] = 1;
+      }
+    }
+    entries[i].bucketIndex = (old_pair[i] < 0) ?
+      IND_OFDPA_GROUP_BUCKET_INDEX_NONE : old_buckets[old_pair[i]].bucketIndex;
+  }
+
+  /* Make: bring every new bucket into place while the old ones still forward */
+  for (i = 0; i < count; i++)
+  {
+    ofdpaGroupBucketEntry_t *old_bucket = NULL;
+
+    in_place = 0;
+    if (old_pair[i] >= 0)
+    {
+      old_bucket = &old_buckets[old_pair[i]];
+
+      if (ind_ofdpa_group_bucket_equal(old_bucket, &entries[i]))
+      {
+        continue;
+      }
+
+      ofdpa_rv = ofdpaGroupBucketEntryModify(&entries[i]);
+      if (ofdpa_rv == OFDPA_E_NONE)
+      {
+        undo[num_undo].op = IND_OFDPA_BUCKET_UNDO_MODIFY;
+        undo[num_undo].entry = *old_bucket;
+        num_undo++;
+        continue;
+      }
+      LOG_VERBOSE("Group 0x%x bucket %u modify failed, rv = %d; replacing it",
+                  group->id, entries[i].bucketIndex, ofdpa_rv);
+
+      /* Stand the new bucket up under a free index, where order allows;
+         the old one goes below */
+      old_stale[old_pair[i]] = 1;
+      in_place = ordered;
+    }
+
+    if (!in_place)
+    {
+      free_index = ind_ofdpa_group_bucket_index_alloc(free_index, old_buckets, num_old, entries, count);
+      entries[i].bucketIndex = free_index;
+
+      ofdpa_rv = ofdpaGroupBucketEntryAdd(&entries[i]);
+      if ((ofdpa_rv != OFDPA_E_NONE) && (old_bucket != NULL) &&
+          ind_ofdpa_group_bucket_ref_present(&entries[i]))
+      {
+        /* No room for a spare bucket, e.g. an indirect group */
+        LOG_VERBOSE("Group 0x%x bucket %u cannot be replaced hitlessly, rv = %d",
+                    group->id, old_bucket->bucketIndex, ofdpa_rv);
+        in_place = 1;
+      }
+    }
+    if (in_place)
+    {
+      /* Replace this one bucket under its own index */
+      ofdpa_rv = ofdpaGroupBucketEntryDelete(group->id, old_bucket->bucketIndex);
+      if (ofdpa_rv == OFDPA_E_NONE)
+      {
+        old_stale[old_pair[i]] = 0;
+        undo[num_undo].op = IND_OFDPA_BUCKET_UNDO_ADD;
+        undo[num_undo].entry = *old_bucket;
+        num_undo++;
+
+        entries[i].bucketIndex = old_bucket->bucketIndex;
+        ofdpa_rv = ofdpaGroupBucketEntryAdd(&entries[i]);
+      }
+    }
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Error in adding Group bucket, rv = %d",ofdpa_rv);
+      goto rollback;
+    }
+
+    undo[num_undo].op = IND_OFDPA_BUCKET_UNDO_DELETE;
+    undo[num_undo].entry = entries[i];
+    num_undo++;
+  }
+
+  /* Break: remove replaced and surplus buckets, highest index first */
+  for (j = num_old; j > 0; j--)
+  {
+    if (old_used[j - 1] && !old_stale[j - 1])
+    {
+      continue;
+    }
+
+    ofdpa_rv = ofdpaGroupBucketEntryDelete(group->id, old_buckets[j - 1].bucketIndex);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Error in deleting Group bucket, rv = %d",ofdpa_rv);
+      goto rollback;
+    }
+
+    undo[num_undo].op = IND_OFDPA_BUCKET_UNDO_ADD;
+    undo[num_undo].entry = old_buckets[j - 1];
+    num_undo++;
+  }
+
+  LOG_TRACE("Group 0x%x modified with %u bucket operations", group->id, num_undo);
+
+  ind_ofdpa_group_buckets_replace(group, entries, count);
+
+  err = INDIGO_ERROR_NONE;
+  goto done;
+
+rollback:
+  ind_ofdpa_group_buckets_rollback(group->id, undo, num_undo);
+  err = indigoConvertOfdpaRv(ofdpa_rv);
+
+  /* The restore may itself have failed; resync the shadow with OF-DPA */
+  if (ind_ofdpa_group_buckets_read(group->id, &old_buckets, &num_old) == INDIGO_ERROR_NONE)
+  {
+    ind_ofdpa_group_buckets_replace(group, old_buckets, num_old);
+  }
+
+done:
+  free(undo);
+  free(old_pair);
+  free(old_used);
+  free(old_stale);
+
+  return err;
+}
+
+static int
+ind_ofdpa_group_type_supported(uint8_t group_type)
+{
+  return ((group_type == OF_GROUP_TYPE_INDIRECT) ||
+          (group_type == OF_GROUP_TYPE_SELECT) ||
+          (group_type == OF_GROUP_TYPE_FF) ||
+          (group_type == OF_GROUP_TYPE_ALL));
+}
+
+/* Program a group from translated buckets and start tracking it. On
+   success the group takes ownership of entries. */
+static indigo_error_t
+ind_ofdpa_group_install(ind_ofdpa_group_t *group, uint8_t group_type,
+                        ofdpaGroupBucketEntry_t *entries, uint32_t count)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *slots;
+
+  if ((group_type == OF_GROUP_TYPE_SELECT) && (resilient_num_slots != 0) &&
+      ind_ofdpa_group_is_ecmp(&group->gid))
+  {
+    err = ind_ofdpa_group_resilient_expand(NULL, resilient_num_slots, entries, count, &slots);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      return err;
+    }
+
+    err = ind_ofdpa_group_add(group, slots, resilient_num_slots);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      free(slots);
+      return err;
+    }
+
+    group->num_slots = resilient_num_slots;
+    group->num_members = count;
+    group->members = entries;
+  }
+  else
+  {
+    err = ind_ofdpa_group_add(group, entries, count);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      return err;
+    }
+  }
+
+  ind_ofdpa_group_insert(group);
+  ind_ofdpa_group_refs_update(group, group->buckets, group->num_buckets, 1);
+
+  return INDIGO_ERROR_NONE;
+}
+
+static indigo_error_t
+ind_ofdpa_group_create(const ind_ofdpa_group_id_t *gid, uint32_t group_id,
+                       uint8_t group_type, of_list_bucket_t *buckets,
+                       void **entry_priv)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *entries;
+  uint32_t count;
+  ind_ofdpa_group_t *group;
+
+  if (!ind_ofdpa_group_type_supported(group_type))
+  {
+    return INDIGO_ERROR_NOT_SUPPORTED;
+  }
+
+  err = ind_ofdpa_translate_group_buckets(group_id, gid, buckets, &entries, &count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  group = calloc(1, sizeof(*group));
+  if (group == NULL)
+  {
+    LOG_ERROR("Failed to allocate Group 0x%x", group_id);
+    free(entries);
+    return INDIGO_ERROR_RESOURCE;
+  }
+  group->id = group_id;
+  group->gid = *gid;
+
+  err = ind_ofdpa_group_install(group, group_type, entries, count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    free(entries);
+    free(group);
+    return err;
+  }
+
+  *entry_priv = group;
+
+  return err;
+}
+
+/* Replace the buckets of a group with translated buckets. On success the
+   group takes ownership of entries. */
+static indigo_error_t
+ind_ofdpa_group_buckets_set(ind_ofdpa_group_t *group,
+                            ofdpaGroupBucketEntry_t *entries,
+                            uint32_t count)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *slots;
+  uint32_t remapped, modulo_remapped;
+
+  if (group->num_slots != 0)
+  {
+    err = ind_ofdpa_group_resilient_expand(group, group->num_slots, entries, count, &slots);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      return err;
+    }
+
+    ind_ofdpa_group_resilient_remap_count(group, slots, entries, count,
+                                          &remapped, &modulo_remapped);
+
+    err = ind_ofdpa_group_modify(group, slots, group->num_slots);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      free(slots);
+      return err;
+    }
+
+    resilient_stats.updates++;
+    resilient_stats.slots += group->num_slots;
+    resilient_stats.remapped += remapped;
+    resilient_stats.modulo_remapped += modulo_remapped;
+
+    free(group->members);
+    group->members = entries;
+    group->num_members = count;
+
+    return err;
+  }
+
+  return ind_ofdpa_group_modify(group, entries, count);
+}
+
+/* Clear the resync mark of a group the controller modified */
+static void
+ind_ofdpa_group_confirm(ind_ofdpa_group_t *group)
+{
+  if (group->unconfirmed)
+  {
+    group->unconfirmed = 0;
+    group_unconfirmed_count--;
+    ind_ofdpa_warm_confirmed(IND_OFDPA_WARM_GROUP);
+  }
+}
+
+static indigo_error_t
+ind_ofdpa_group_update(ind_ofdpa_group_t *group, of_list_bucket_t *buckets)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *entries;
+  uint32_t count;
+
+  if (group->swept)
+  {
+    LOG_ERROR("Group 0x%x was deleted at the end of a resync", group->id);
+    return INDIGO_ERROR_NOT_FOUND;
+  }
+
+  /* Validate the whole new bucket set before touching the group */
+  err = ind_ofdpa_translate_group_buckets(group->id, &group->gid, buckets, &entries, &count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  err = ind_ofdpa_group_buckets_set(group, entries, count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    free(entries);
+    return err;
+  }
+  ind_ofdpa_group_confirm(group);
+
+  return err;
+}
+
+/* Remove a group from OF-DPA and stop tracking it, keeping its memory and
+   bucket shadow for the caller to free */
+static indigo_error_t
+ind_ofdpa_group_uninstall(ind_ofdpa_group_t *group, int cascade)
+{
+  OFDPA_ERROR_t ofdpa_rv;
+
+  if (group->num_referrers != 0)
+  {
+    LOG_ERROR("Group 0x%x is referenced by %u groups, delete rejected",
+              group->id, group->num_referrers);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  if ((group->flow_refs != 0) && cascade)
+  {
+    LOG_VERBOSE("Deleting %u flows of Group 0x%x", group->flow_refs, group->id);
+    (void)ind_ofdpa_flows_by_group_delete(group->id, group->flow_refs);
+  }
+
+  if (group->flow_refs != 0)
+  {
+    LOG_ERROR("Group 0x%x is referenced by %u flows, delete rejected",
+              group->id, group->flow_refs);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  ofdpa_rv = ofdpaGroupDelete(group->id);
+
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Group Delete failed, rv = %d",ofdpa_rv);
+  }
+  else
+  {
+    ind_ofdpa_group_refs_update(group, group->buckets, group->num_buckets, 0);
+    ind_ofdpa_group_remove(group);
+    if (group->unconfirmed)
+    {
+      group->unconfirmed = 0;
+      group_unconfirmed_count--;
+    }
+  }
+  
+  return indigoConvertOfdpaRv(ofdpa_rv);
+}
+
+static void
+ind_ofdpa_group_free(ind_ofdpa_group_t *group)
+{
+  free(group->referrers);
+  free(group->members);
+  free(group->buckets);
+  free(group);
+}
+
+static indigo_error_t
+ind_ofdpa_group_delete(ind_ofdpa_group_t *group)
+{
+  indigo_error_t err;
+
+  /* Already gone from OF-DPA, Indigo is letting go of it now */
+  if (group->swept)
+  {
+    ind_ofdpa_group_free(group);
+    return INDIGO_ERROR_NONE;
+  }
+
+  err = ind_ofdpa_group_uninstall(group, group_delete_cascade);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    ind_ofdpa_group_free(group);
+  }
+
+  return err;
+}
+
+/* Non-zero if two bucket sets program the same group. Order only matters
+   where OF-DPA depends on it. */
+static int
+ind_ofdpa_group_buckets_same(ind_ofdpa_group_t *group,
+                             ofdpaGroupBucketEntry_t *a, uint32_t num_a,
+                             ofdpaGroupBucketEntry_t *b, uint32_t num_b)
+{
+  uint8_t *used;
+  uint32_t i, j;
+  int same = 1;
+
+  if (num_a != num_b)
+  {
+    return 0;
+  }
+
+  if ((group->num_slots != 0) || !ind_ofdpa_group_buckets_unordered(&group->gid))
+  {
+    for (i = 0; (i < num_a) && same; i++)
+    {
+      same = ind_ofdpa_group_bucket_equal(&a[i], &b[i]);
+    }
+    return same;
+  }
+
+  used = calloc(num_b + 1, sizeof(*used));
+  if (used == NULL)
+  {
+    return 0;
+  }
+  for (i = 0; (i < num_a) && same; i++)
+  {
+    for (j = 0; j < num_b; j++)
+    {
+      if (!used[j] && ind_ofdpa_group_bucket_equal(&a[i], &b[j]))
+      {
+        used[j] = 1;
+        break;
+      }
+    }
+    same = (j < num_b);
+  }
+  free(used);
+
+  return same;
+}
+
+/*
+ * A claim reprograms a restored group with the buckets the controller
+ * adds it with, in the resilient mode a new group of its type would get.
+ * Buckets the previous run already programmed the same way are kept, so
+ * an unchanged group costs no OF-DPA call.
+ */
+static indigo_error_t
+ind_ofdpa_group_claim(ind_ofdpa_group_t *group, uint8_t group_type,
+                      of_list_bucket_t *buckets, void **entry_priv)
+{
+  indigo_error_t err;
+  ofdpaGroupBucketEntry_t *entries;
+  ofdpaGroupBucketEntry_t *old_entries;
+  uint32_t count;
+  uint32_t num_old;
+  uint32_t old_slots;
+  int modified;
+
+  if (!ind_ofdpa_group_type_supported(group_type))
+  {
+    return INDIGO_ERROR_NOT_SUPPORTED;
+  }
+
+  err = ind_ofdpa_translate_group_buckets(group->id, &group->gid, buckets, &entries, &count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  /* Keep the programmed slots to tell whether the claim changed them */
+  num_old = group->num_buckets;
+  old_slots = group->num_slots;
+  old_entries = malloc((num_old + 1) * sizeof(*old_entries));
+  if (old_entries == NULL)
+  {
+    free(entries);
+    return INDIGO_ERROR_RESOURCE;
+  }
+  memcpy(old_entries, group->buckets, num_old * sizeof(*old_entries));
+
+  group->num_slots = 0;
+  if ((group_type == OF_GROUP_TYPE_SELECT) && (resilient_num_slots != 0) &&
+      ind_ofdpa_group_is_ecmp(&group->gid))
+  {
+    group->num_slots = resilient_num_slots;
+  }
+
+  err = ind_ofdpa_group_buckets_set(group, entries, count);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    group->num_slots = old_slots;
+    free(old_entries);
+    free(entries);
+    return err;
+  }
+
+  modified = !ind_ofdpa_group_buckets_same(group, old_entries, num_old,
+                                           group->buckets, group->num_buckets);
+  free(old_entries);
+
+  group->restored = 0;
+  group_restored_count--;
+  ind_ofdpa_group_shadow_set(group);
+  LOG_TRACE("Claimed restored Group 0x%x%s", group->id, modified ? " with changes" : "");
+  ind_ofdpa_warm_claimed(IND_OFDPA_WARM_GROUP, modified);
+
+  *entry_priv = group;
+
+  return err;
+}
+
+/* Track a group found in OF-DPA as restored. Its resilient table size
+   comes from the shadow, if that still fits the programmed buckets. */
+static indigo_error_t
+ind_ofdpa_group_restore(uint32_t group_id, uint32_t *drift)
+{
+  ind_ofdpa_group_shadow_t shadow;
+  ind_ofdpa_group_t *group;
+  indigo_error_t err;
+
+  group = calloc(1, sizeof(*group));
+  if (group == NULL)
+  {
+    LOG_ERROR("Failed to allocate Group 0x%x", group_id);
+    return INDIGO_ERROR_RESOURCE;
+  }
+  group->id = group_id;
+  ind_ofdpa_group_id_decode(group_id, &group->gid);
+
+  err = ind_ofdpa_group_buckets_read(group_id, &group->buckets, &group->num_buckets);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    free(group);
+    return err;
+  }
+
+  if (!ind_ofdpa_shadow_get(IND_OFDPA_SHADOW_GROUP, group_id, &shadow, sizeof(shadow)) ||
+      ((shadow.num_slots != 0) && (shadow.num_slots != group->num_buckets)))
+  {
+    (*drift)++;
+  }
+  else
+  {
+    group->num_slots = shadow.num_slots;
+  }
+
+  group->restored = 1;
+  group_restored_count++;
+  ind_ofdpa_group_insert(group);
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Drop shadow records of groups OF-DPA no longer has */
+static void
+ind_ofdpa_group_stale_drop(uint64_t key, const void *data,
+                           ind_ofdpa_shadow_meta_t *meta, void *cookie)
+{
+  if (ind_ofdpa_group_find((uint32_t)key) == NULL)
+  {
+    ind_ofdpa_shadow_delete(IND_OFDPA_SHADOW_GROUP, key);
+    (*(uint32_t *)cookie)++;
+  }
+}
+
+uint32_t
+ind_ofdpa_group_warm_restore(uint32_t *drift)
+{
+  ofdpaGroupEntryStats_t groupStats;
+  ofdpaGroupEntry_t groupEntry;
+  ind_ofdpa_group_t *group;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t count = 0;
+  uint32_t i;
+
+  memset(&groupEntry, 0, sizeof(groupEntry));
+
+  /* Group id 0 is a valid entry, so try it before walking */
+  ofdpa_rv = ofdpaGroupStatsGet(groupEntry.groupId, &groupStats);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    ofdpa_rv = ofdpaGroupNextGet(groupEntry.groupId, &groupEntry);
+  }
+
+  while (ofdpa_rv == OFDPA_E_NONE)
+  {
+    if ((ind_ofdpa_group_find(groupEntry.groupId) == NULL) &&
+        (ind_ofdpa_group_restore(groupEntry.groupId, drift) == INDIGO_ERROR_NONE))
+    {
+      count++;
+    }
+    ofdpa_rv = ofdpaGroupNextGet(groupEntry.groupId, &groupEntry);
+  }
+
+  /* References, once every group they may point at is known */
+  for (i = 0; i < IND_OFDPA_GROUP_HASH_SIZE; i++)
+  {
+    for (group = group_hash[i]; group != NULL; group = group->hash_next)
+    {
+      if (group->restored)
+      {
+        ind_ofdpa_group_refs_update(group, group->buckets, group->num_buckets, 1);
+      }
+    }
+  }
+
+  ind_ofdpa_shadow_walk(IND_OFDPA_SHADOW_GROUP, ind_ofdpa_group_stale_drop, drift);
+
+  return count;
+}
+
+uint32_t
+ind_ofdpa_group_warm_pending(void)
+{
+  return group_restored_count;
+}
+
+/* Delete the restored groups no controller claimed, referring groups
+   first. Returns the number deleted. */
+uint32_t
+ind_ofdpa_group_warm_end(void)
+{
+  ind_ofdpa_group_t *group;
+  uint32_t *ids;
+  uint32_t count = 0;
+  uint32_t removed = 0;
+  uint32_t i;
+
+  if (group_restored_count == 0)
+  {
+    return 0;
+  }
+
+  ids = calloc(group_restored_count, sizeof(*ids));
+  if (ids == NULL)
+  {
+    LOG_ERROR("Failed to allocate %u unclaimed Group ids", group_restored_count);
+    return 0;
+  }
+  for (i = 0; i < IND_OFDPA_GROUP_HASH_SIZE; i++)
+  {
+    for (group = group_hash[i]; group != NULL; group = group->hash_next)
+    {
+      if (group->restored && (count < group_restored_count))
+      {
+        ids[count++] = group->id;
+      }
+    }
+  }
+
+  (void)ind_ofdpa_group_sort(ids, count, 1);
+
+  for (i = 0; i < count; i++)
+  {
+    group = ind_ofdpa_group_find(ids[i]);
+    if (ind_ofdpa_group_uninstall(group, 0) != INDIGO_ERROR_NONE)
+    {
+      LOG_ERROR("Failed to delete unclaimed Group 0x%x", ids[i]);
+      continue;
+    }
+    ind_ofdpa_group_free(group);
+    group_restored_count--;
+    removed++;
+  }
+  free(ids);
+
+  return removed;
+}
+
+uint32_t
+ind_ofdpa_group_resync_mark(void)
+{
+  ind_ofdpa_group_t *group;
+  uint32_t marked = 0;
+  uint32_t i;
+
+  for (i = 0; i < IND_OFDPA_GROUP_HASH_SIZE; i++)
+  {
+    for (group = group_hash[i]; group != NULL; group = group->hash_next)
+    {
+      if (!group->restored && !group->unconfirmed)
+      {
+        group->unconfirmed = 1;
+        marked++;
+      }
+    }
+  }
+  group_unconfirmed_count += marked;
+
+  return marked;
+}
+
+uint32_t
+ind_ofdpa_group_resync_pending(void)
+{
+  return group_unconfirmed_count;
+}
+
+/* Delete the unconfirmed groups nothing references any more, referring
+   groups first. Indigo has no message to drop a group, so each stays
+   swept until Indigo deletes it. Returns the number deleted. */
+uint32_t
+ind_ofdpa_group_resync_end(void)
+{
+  ind_ofdpa_group_t *group;
+  uint32_t *ids;
+  uint32_t count = 0;
+  uint32_t removed = 0;
+  uint32_t kept = 0;
+  uint32_t i;
+
+  if (group_unconfirmed_count == 0)
+  {
+    return 0;
+  }
+
+  ids = calloc(group_unconfirmed_count, sizeof(*ids));
+  if (ids == NULL)
+  {
+    LOG_ERROR("Failed to allocate %u unconfirmed Group ids", group_unconfirmed_count);
+    return 0;
+  }
+  for (i = 0; i < IND_OFDPA_GROUP_HASH_SIZE; i++)
+  {
+    for (group = group_hash[i]; group != NULL; group = group->hash_next)
+    {
+      if (group->unconfirmed && (count < group_unconfirmed_count))
+      {
+        ids[count++] = group->id;
+      }
+    }
+  }
+
+  (void)ind_ofdpa_group_sort(ids, count, 1);
+
+  for (i = 0; i < count; i++)
+  {
+    group = ind_ofdpa_group_find(ids[i]);
+    group->unconfirmed = 0;
+    group_unconfirmed_count--;
+
+    /* A confirmed flow or group still uses it */
+    if ((group->num_referrers != 0) || (group->flow_refs != 0))
+    {
+      kept++;
+      continue;
+    }
+    if (ind_ofdpa_group_uninstall(group, 0) != INDIGO_ERROR_NONE)
+    {
+      LOG_ERROR("Failed to delete unconfirmed Group 0x%x", ids[i]);
+      continue;
+    }
+    group->swept = 1;
+    removed++;
+  }
+  free(ids);
+
+  if (kept != 0)
+  {
+    LOG_VERBOSE("Kept %u unconfirmed groups still in use", kept);
+  }
+
+  return removed;
+}
+
+/* Groups sampled per sampler tick, in hash bucket order */
+#define IND_OFDPA_GROUP_STATS_BATCH       256
+
+/* Egress ports tracked for ECMP member rates */
+#define IND_OFDPA_GROUP_STATS_MAX_PORTS   512
+
+typedef struct
+{
+  uint32_t port;
+  uint64_t tx_packets;
+  uint64_t tx_bytes;
+  uint64_t sampled_ns;
+  uint64_t pps;
+  uint64_t bps;
+} ind_ofdpa_group_port_rate_t;
+
+static uint32_t group_stats_interval_ms;
+static uint32_t group_stats_cursor;
+static ind_ofdpa_group_port_rate_t group_port_rates[IND_OFDPA_GROUP_STATS_MAX_PORTS];
+static uint32_t group_num_port_rates;
+
+static struct
+{
+  uint64_t sweeps;              /* complete passes over the registry */
+  uint64_t samples;             /* ofdpaGroupStatsGet() calls by the sampler */
+  uint64_t cache_hits;          /* stats requests answered from the cache */
+  uint64_t cache_misses;        /* stats requests that called OF-DPA */
+} group_stats;
+
+static OFDPA_ERROR_t
+ind_ofdpa_group_stats_sample(ind_ofdpa_group_t *group, uint64_t now_ns)
+{
+  ofdpaGroupEntryStats_t groupStats;
+  OFDPA_ERROR_t ofdpa_rv;
+
+  memset(&groupStats, 0, sizeof(groupStats));
+  ofdpa_rv = ofdpaGroupStatsGet(group->id, &groupStats);
+  if (ofdpa_rv == OFDPA_E_NONE)
+  {
+    group->stats_ref_count = groupStats.refCount;
+    group->stats_duration = groupStats.duration;
+    group->stats_sampled_ns = now_ns;
+  }
+
+  return ofdpa_rv;
+}
+
+static ind_ofdpa_group_port_rate_t *
+ind_ofdpa_group_port_rate_find(uint32_t port)
+{
+  uint32_t i;
+
+  for (i = 0; i < group_num_port_rates; i++)
+  {
+    if (group_port_rates[i].port == port)
+    {
+      return &group_port_rates[i];
+    }
+  }
+  return NULL;
+}
 
-        break;
+/* Egress packet and bit rates of every port since the previous tick */
+static void
+ind_ofdpa_group_port_rates_sample(uint64_t now_ns)
+{
+  ofdpaPortStats_t portStats;
+  ind_ofdpa_group_port_rate_t *rate;
+  double elapsed_s;
+  uint32_t port = 0;
 
-      case OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE:
-        if((group_action_bitmap | IND_OFDPA_L2REWRITE_BITMAP) != IND_OFDPA_L2REWRITE_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        if((group_action_sf_bitmap | IND_OFDPA_L2REWRITE_SF_BITMAP) != IND_OFDPA_L2REWRITE_SF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
+  while (ofdpaPortNextGet(port, &port) == OFDPA_E_NONE)
+  {
+    rate = ind_ofdpa_group_port_rate_find(port);
+    if (rate == NULL)
+    {
+      if (group_num_port_rates >= IND_OFDPA_GROUP_STATS_MAX_PORTS)
+      {
+        continue;
+      }
+      rate = &group_port_rates[group_num_port_rates++];
+      memset(rate, 0, sizeof(*rate));
+      rate->port = port;
+    }
 
-        group_bucket_entry.bucketData.l2Rewrite.vlanId = group_bucket.vlanId;
+    memset(&portStats, 0, sizeof(portStats));
+    if (ofdpaPortStatsGet(port, &portStats) != OFDPA_E_NONE)
+    {
+      continue;
+    }
 
-        memcpy(&group_bucket_entry.bucketData.l2Rewrite.srcMac,
-               &group_bucket.srcMac, sizeof(group_bucket_entry.bucketData.l2Rewrite.srcMac));
+    /* A counter that went backwards was cleared; just take a new base */
+    if ((rate->sampled_ns != 0) && (now_ns > rate->sampled_ns) &&
+        (portStats.tx_packets >= rate->tx_packets) &&
+        (portStats.tx_bytes >= rate->tx_bytes))
+    {
+      elapsed_s = (now_ns - rate->sampled_ns) / 1e9;
+      rate->pps = (portStats.tx_packets - rate->tx_packets) / elapsed_s;
+      rate->bps = (portStats.tx_bytes - rate->tx_bytes) * 8.0 / elapsed_s;
+    }
 
-        memcpy(&group_bucket_entry.bucketData.l2Rewrite.dstMac,
-               &group_bucket.dstMac, sizeof(group_bucket_entry.bucketData.l2Rewrite.dstMac));
+    rate->tx_packets = portStats.tx_packets;
+    rate->tx_bytes = portStats.tx_bytes;
+    rate->sampled_ns = now_ns;
+  }
+}
 
-        group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
+static void
+ind_ofdpa_group_stats_timer(void *cookie)
+{
+  ind_ofdpa_group_t *group;
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
+  uint32_t sampled = 0;
+  uint32_t scanned = 0;
+
+  /* Whole hash chains are sampled, so a tick may exceed the batch by the
+     length of one chain */
+  while ((sampled < IND_OFDPA_GROUP_STATS_BATCH) && (scanned < IND_OFDPA_GROUP_HASH_SIZE))
+  {
+    for (group = group_hash[group_stats_cursor]; group != NULL; group = group->hash_next)
+    {
+      (void)ind_ofdpa_group_stats_sample(group, now_ns);
+      sampled++;
+    }
+    scanned++;
+    group_stats_cursor = (group_stats_cursor + 1) % IND_OFDPA_GROUP_HASH_SIZE;
+    if (group_stats_cursor == 0)
+    {
+      group_stats.sweeps++;
+    }
+  }
+  group_stats.samples += sampled;
 
-        break;
+  ind_ofdpa_group_port_rates_sample(now_ns);
+}
 
-      case OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST:
-        if((group_action_bitmap | IND_OFDPA_L3UNICAST_BITMAP) != IND_OFDPA_L3UNICAST_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        if((group_action_sf_bitmap | IND_OFDPA_L3UNICAST_SF_BITMAP) != IND_OFDPA_L3UNICAST_SF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
+indigo_error_t
+ind_ofdpa_group_stats_init(uint32_t interval_ms)
+{
+  indigo_error_t err;
 
-        group_bucket_entry.bucketData.l3Unicast.vlanId = group_bucket.vlanId;
+  ind_ofdpa_group_stats_finish();
 
-        memcpy(&group_bucket_entry.bucketData.l3Unicast.srcMac,
-               &group_bucket.srcMac, sizeof(group_bucket_entry.bucketData.l3Unicast.srcMac));
+  if (interval_ms == 0)
+  {
+    return INDIGO_ERROR_NONE;
+  }
 
-        memcpy(&group_bucket_entry.bucketData.l3Unicast.dstMac,
-               &group_bucket.dstMac, sizeof(group_bucket_entry.bucketData.l3Unicast.dstMac));
+  err = ind_ofdpa_loop_timer_register(ind_ofdpa_group_stats_timer, NULL, interval_ms,
+                                      "group stats");
+  if (err < 0)
+  {
+    LOG_ERROR("Failed to register group stats timer.");
+    return err;
+  }
 
-        group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
+  group_stats_interval_ms = interval_ms;
+  return INDIGO_ERROR_NONE;
+}
 
-        break;
+void
+ind_ofdpa_group_stats_finish(void)
+{
+  if (group_stats_interval_ms != 0)
+  {
+    ind_ofdpa_loop_timer_unregister(ind_ofdpa_group_stats_timer, NULL);
+    group_stats_interval_ms = 0;
+  }
+}
 
-      case OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE:
-        if((group_action_bitmap | IND_OFDPA_L3INTERFACE_BITMAP) != IND_OFDPA_L3INTERFACE_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
-        if((group_action_sf_bitmap | IND_OFDPA_L3INTERFACE_SF_BITMAP) != IND_OFDPA_L3INTERFACE_SF_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
+void
+ind_ofdpa_group_stats_show(aim_pvs_t *pvs)
+{
+  if (group_stats_interval_ms == 0)
+  {
+    aim_printf(pvs, "Group stats sampler disabled\n");
+  }
+  else
+  {
+    aim_printf(pvs, "Group stats sampler every %u ms, %u groups per tick\n",
+               group_stats_interval_ms, IND_OFDPA_GROUP_STATS_BATCH);
+  }
 
-        group_bucket_entry.bucketData.l3Interface.vlanId = group_bucket.vlanId;
+  aim_printf(pvs, "Registry sweeps         %llu\n", (unsigned long long)group_stats.sweeps);
+  aim_printf(pvs, "Sampler RPCs            %llu\n", (unsigned long long)group_stats.samples);
+  aim_printf(pvs, "Requests from cache     %llu\n", (unsigned long long)group_stats.cache_hits);
+  aim_printf(pvs, "Requests sent to OF-DPA %llu\n", (unsigned long long)group_stats.cache_misses);
+  aim_printf(pvs, "Ports tracked           %u\n", group_num_port_rates);
+}
 
-        memcpy(&group_bucket_entry.bucketData.l3Interface.srcMac,
-               &group_bucket.srcMac, sizeof(group_bucket_entry.bucketData.l3Interface.srcMac));
+/* Egress port of a group, following every bucket of each referenced
+   group down to an L2 interface group. A group whose buckets lead to
+   more than one port has no single egress port. */
+static int
+ind_ofdpa_group_egress_port_get(uint32_t group_id, uint32_t *port, uint32_t depth)
+{
+  ind_ofdpa_group_t *group;
+  uint32_t bucket_port;
+  uint32_t i;
 
-        group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
+  group = ind_ofdpa_group_find(group_id);
+  if ((group == NULL) || (depth >= IND_OFDPA_GROUP_MAX_DEPTH))
+  {
+    return 0;
+  }
 
-        break;
+  switch (group->gid.type)
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+      *port = group->gid.port;
+      return 1;
 
-      case OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST:
-      case OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD:
-      case OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST:
-      case OFDPA_GROUP_ENTRY_TYPE_L3_ECMP:
-        if((group_action_bitmap | IND_OFDPA_REFGROUP) != IND_OFDPA_REFGROUP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
+    case OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY:
+      return 0;
 
-        group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-        break;
+    default:
+      break;
+  }
 
-      case OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY:
-        if((group_action_bitmap | IND_OFDPA_L2OVERLAY_BITMAP) != IND_OFDPA_L2OVERLAY_BITMAP)
-        {
-          err = INDIGO_ERROR_COMPAT;
-          break;
-        }
+  if (group->num_buckets == 0)
+  {
+    return 0;
+  }
 
-        group_bucket_entry.bucketData.l2Overlay.outputPort = group_bucket.outputPort;
-        break;
+  for (i = 0; i < group->num_buckets; i++)
+  {
+    if (!ind_ofdpa_group_egress_port_get(group->buckets[i].referenceGroupId, &bucket_port, depth + 1) ||
+        ((i != 0) && (bucket_port != *port)))
+    {
+      return 0;
+    }
+    *port = bucket_port;
+  }
 
-      case OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL:
-        ofdpaGroupMplsSubTypeGet(group_id, &sub_group_type);
-        switch (sub_group_type)
-        {
-          case OFDPA_MPLS_INTERFACE:
-            if((group_action_bitmap | IND_OFDPA_MPLSINTERFACE_BITMAP) != IND_OFDPA_MPLSINTERFACE_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            
-            memcpy(&group_bucket_entry.bucketData.mplsInterface.srcMac,
-                   &group_bucket.srcMac, sizeof(group_bucket_entry.bucketData.mplsInterface.srcMac));
-            memcpy(&group_bucket_entry.bucketData.mplsInterface.dstMac,
-                   &group_bucket.dstMac, sizeof(group_bucket_entry.bucketData.mplsInterface.dstMac));
-            group_bucket_entry.bucketData.mplsInterface.vlanId = group_bucket.vlanId;
-
-            if (group_action_bitmap & IND_OFDPA_OAM_LM_TX_COUNT)
-            {
-              group_bucket_entry.bucketData.mplsInterface.oamLmTxCountAction = 1;
-              group_bucket_entry.bucketData.mplsInterface.lmepId = group_bucket.lmepId;
-            }
+  return 1;
+}
 
-            group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-            break;
-            
-          case OFDPA_MPLS_L2_VPN_LABEL:
-          case OFDPA_MPLS_L3_VPN_LABEL:
-          case OFDPA_MPLS_TUNNEL_LABEL1:
-          case OFDPA_MPLS_TUNNEL_LABEL2:
-          case OFDPA_MPLS_SWAP_LABEL:
-            if((group_action_bitmap | IND_OFDPA_MPLSLABEL_BITMAP) != IND_OFDPA_MPLSLABEL_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            if((group_action_sf_bitmap | IND_OFDPA_MPLSLABEL_SF_BITMAP) != IND_OFDPA_MPLSLABEL_SF_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            
-            group_bucket_entry.bucketData.mplsLabel.pushL2Hdr = group_bucket.pushL2Hdr;
-            
-            if (group_action_bitmap & IND_OFDPA_PUSH_VLAN)
-            {
-              group_bucket_entry.bucketData.mplsLabel.pushVlan = 1;
-              group_bucket_entry.bucketData.mplsLabel.newTpid = group_bucket.newTpid;
-            }
-            
-            if (group_action_bitmap & IND_OFDPA_PUSH_MPLS)
-            {
-              group_bucket_entry.bucketData.mplsLabel.pushMplsHdr = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsEtherType = group_bucket.mplsEtherType;
-            }
-            
-            group_bucket_entry.bucketData.mplsLabel.pushCW = group_bucket.pushCW;
-            
-            group_bucket_entry.bucketData.mplsLabel.mplsLabel = group_bucket.mplsLabel;
-            
-            group_bucket_entry.bucketData.mplsLabel.mplsBOS = group_bucket.mplsBOS;
-            
-            group_bucket_entry.bucketData.mplsLabel.mplsCopyEXPOutwards = group_bucket.mplsCopyEXPOutwards;
-            if (group_action_sf_bitmap & IND_OFDPA_MPLS_TC)
-            {
-              group_bucket_entry.bucketData.mplsLabel.mplsEXPAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsEXP = group_bucket.mplsEXP;
-            }
-            if (group_action_bitmap & IND_OFDPA_MPLS_TC_REMARK_TABLE_INDEX)
-            {
-              group_bucket_entry.bucketData.mplsLabel.mplsEXPRemarkTableIndexAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsEXPRemarkTableIndex = group_bucket.mplsEXPRemarkTableIndex;
-            }
-            
-            group_bucket_entry.bucketData.mplsLabel.mplsCopyTTLOutwards = group_bucket.mplsCopyTTLOutwards;
-            if (group_action_bitmap & IND_OFDPA_SET_MPLS_TTL)
-            {
-              group_bucket_entry.bucketData.mplsLabel.mplsTTLAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsTTL = group_bucket.mplsTTL;
-            }
-            if (group_action_sf_bitmap & IND_OFDPA_MPLS_TTL)
-            {
-              group_bucket_entry.bucketData.mplsLabel.mplsTTLAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsTTL = group_bucket.mplsTTL;
-            }
-            
-            if (group_action_bitmap & IND_OFDPA_PCP_REMARK_TABLE_INDEX)
-            {
-              group_bucket_entry.bucketData.mplsLabel.mplsPriorityRemarkTableIndexAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.mplsPriorityRemarkTableIndex = group_bucket.priorityRemarkTableIndex;
-            }
+static int
+ind_ofdpa_group_egress_port(uint32_t group_id, uint32_t *port)
+{
+  return ind_ofdpa_group_egress_port_get(group_id, port, 0);
+}
 
-            if (group_action_bitmap & IND_OFDPA_OAM_LM_TX_COUNT)
-            {
-              group_bucket_entry.bucketData.mplsLabel.oamLmTxCountAction = 1;
-              group_bucket_entry.bucketData.mplsLabel.lmepId = group_bucket.lmepId;
-            }
+static void
+ind_ofdpa_group_ecmp_print(aim_pvs_t *pvs, ind_ofdpa_group_t *group)
+{
+  ofdpaGroupBucketEntry_t *members;
+  ind_ofdpa_group_port_rate_t *rate;
+  uint32_t num_members;
+  uint32_t *ports;
+  uint64_t *pps;
+  uint64_t sum = 0, max = 0, min = UINT64_MAX;
+  uint32_t resolved = 0;
+  uint32_t share;
+  uint32_t i, j;
+
+  /* Resilient groups are measured per controller bucket, not per slot */
+  members = (group->num_slots != 0) ? group->members : group->buckets;
+  num_members = (group->num_slots != 0) ? group->num_members : group->num_buckets;
+  if (num_members == 0)
+  {
+    return;
+  }
 
-            group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-            break;
-            
-          default:
-            LOG_ERROR("unsupported MPLS_SUBTYPE %d for GROUP_TYPE %d", sub_group_type, group_type);
-            return INDIGO_ERROR_COMPAT;
-        }
-        break;
-        
-      case OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING:
-        ofdpaGroupMplsSubTypeGet(group_id, &sub_group_type);
-        switch (sub_group_type)
-        {
-          case OFDPA_MPLS_FAST_FAILOVER:
-            if((group_action_bitmap | IND_OFDPA_MPLSFF_BITMAP) != IND_OFDPA_MPLSFF_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            
-            group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-            group_bucket_entry.bucketData.mplsFastFailOver.watchPort = watch_port;
-            break;
-            
-          case OFDPA_MPLS_L2_TAG:
-            if((group_action_bitmap | IND_OFDPA_MPLSL2TAG_BITMAP) != IND_OFDPA_MPLSL2TAG_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            if((group_action_sf_bitmap | IND_OFDPA_MPLSL2TAG_SF_BITMAP) != IND_OFDPA_MPLSL2TAG_SF_BITMAP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            
-            if (group_action_bitmap & IND_OFDPA_POP_VLAN)
-            {
-              group_bucket_entry.bucketData.mplsL2Tag.popVlan = 1;
-            }
-            if (group_action_bitmap & IND_OFDPA_PUSH_VLAN)
-            {
-              group_bucket_entry.bucketData.mplsL2Tag.pushVlan = 1;
-              group_bucket_entry.bucketData.mplsL2Tag.newTpid = group_bucket.newTpid;
-            }
-            group_bucket_entry.bucketData.mplsL2Tag.vlanId = group_bucket.vlanId;
-            
-            group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-            
-            break;
-            
-          case OFDPA_MPLS_L2_FLOOD:
-          case OFDPA_MPLS_L2_MULTICAST:
-          case OFDPA_MPLS_L2_LOCAL_FLOOD:
-          case OFDPA_MPLS_L2_LOCAL_MULTICAST:
-          case OFDPA_MPLS_L2_FLOOD_SPLIT_HORIZON:
-          case OFDPA_MPLS_L2_MULTICAST_SPLIT_HORIZON:
-          case OFDPA_MPLS_1_1_HEAD_END_PROTECT:
-          case OFDPA_MPLS_ECMP: 
-            if((group_action_bitmap | IND_OFDPA_REFGROUP) != IND_OFDPA_REFGROUP)
-            {
-              err = INDIGO_ERROR_COMPAT;
-              break;
-            }
-            
-            group_bucket_entry.referenceGroupId = group_bucket.referenceGroupId;
-            
-            break;
-            
-          default:
-            LOG_ERROR("unsupported MPLS_SUBTYPE %d for GROUP_TYPE %d", sub_group_type, group_type);
-            return INDIGO_ERROR_COMPAT;
-        }
-        break;
+  ports = calloc(num_members, sizeof(*ports));
+  pps = calloc(num_members, sizeof(*pps));
+  if ((ports == NULL) || (pps == NULL))
+  {
+    free(ports);
+    free(pps);
+    return;
+  }
 
-      default:
-        err = INDIGO_ERROR_PARAM;
-        LOG_ERROR("Invalid GROUP_TYPE %d", group_type);
-        break;
+  for (i = 0; i < num_members; i++)
+  {
+    if (!ind_ofdpa_group_egress_port(members[i].referenceGroupId, &ports[i]))
+    {
+      ports[i] = 0;
     }
+  }
 
-    if (err != INDIGO_ERROR_NONE)
+  for (i = 0; i < num_members; i++)
+  {
+    rate = (ports[i] != 0) ? ind_ofdpa_group_port_rate_find(ports[i]) : NULL;
+    if ((rate == NULL) || (rate->sampled_ns == 0))
     {
-      if (err == INDIGO_ERROR_COMPAT)
-      {
-        LOG_ERROR("Incompatible fields for Group Type");
-      }
-      if (group_added == 1) 
-      {
-        /* Delete the added group */
-        (void)ofdpaGroupDelete(group_id);
-      }
-      return err; 
+      continue;
     }
 
-    if (command == OF_GROUP_ADD) 
+    /* Members behind the same port split its rate evenly */
+    share = 0;
+    for (j = 0; j < num_members; j++)
     {
-      if (bucket_index == 0)
+      if (ports[j] == ports[i])
       {
-        /* First Bucket; Add Group first*/
-        group_entry.groupId = group_id;
-        ofdpa_rv = ofdpaGroupAdd(&group_entry);
-        if (ofdpa_rv != OFDPA_E_NONE)
-        {
-          LOG_ERROR("Error in adding Group, rv = %d",ofdpa_rv);
-          break;
-        }
-        group_added = 1;
+        share++;
       }
     }
-    else /* OF_GROUP_MODIFY */
+
+    pps[i] = rate->pps / share;
+    sum += pps[i];
+    if (pps[i] > max)
     {
-      if (bucket_index == 0)
-      {
-        /* First Bucket; Delete all buckets first */
-        ofdpa_rv = ofdpaGroupBucketsDeleteAll(group_id);
-        if (ofdpa_rv != OFDPA_E_NONE)
-        {
-          LOG_ERROR("Error in deleting Group buckets, rv = %d",ofdpa_rv);
-          break;
-        }
-      }
+      max = pps[i];
+    }
+    if (pps[i] < min)
+    {
+      min = pps[i];
     }
+    resolved++;
+  }
 
-    ofdpa_rv = ofdpaGroupBucketEntryAdd(&group_bucket_entry);
-    if (ofdpa_rv != OFDPA_E_NONE)
+  if (resolved == 0)
+  {
+    aim_printf(pvs, "0x%08x  members %u  no egress port rates yet\n", group->id, num_members);
+  }
+  else
+  {
+    aim_printf(pvs, "0x%08x  members %u  mean %llu pps  min %llu  max %llu  max/mean %.2f\n",
+               group->id, num_members, (unsigned long long)(sum / resolved),
+               (unsigned long long)min, (unsigned long long)max,
+               (sum == 0) ? 1.0 : ((double)max * resolved / sum));
+  }
+
+  for (i = 0; i < num_members; i++)
+  {
+    if (ports[i] == 0)
     {
-      LOG_ERROR("Error in adding Group bucket, rv = %d",ofdpa_rv);
-      if (group_added == 1) 
-      {
-        /* Delete the added group */
-        (void)ofdpaGroupDelete(group_id);
-      }
-      else /* OF_GROUP_MODIFY */
+      aim_printf(pvs, "    next hop 0x%08x  port unknown\n", members[i].referenceGroupId);
+    }
+    else
+    {
+      aim_printf(pvs, "    next hop 0x%08x  port %-6u %llu pps\n",
+                 members[i].referenceGroupId, ports[i], (unsigned long long)pps[i]);
+    }
+  }
+
+  free(ports);
+  free(pps);
+}
+
+void
+ind_ofdpa_group_ecmp_imbalance_show(aim_pvs_t *pvs)
+{
+  ind_ofdpa_group_t *group;
+  uint32_t i;
+
+  if (group_stats_interval_ms == 0)
+  {
+    aim_printf(pvs, "Group stats sampler disabled, no port rates available\n");
+    return;
+  }
+
+  for (i = 0; i < IND_OFDPA_GROUP_HASH_SIZE; i++)
+  {
+    for (group = group_hash[i]; group != NULL; group = group->hash_next)
+    {
+      if (ind_ofdpa_group_is_ecmp(&group->gid))
       {
-        /* Need to clean up and delete Group here as well.
-           Will be done by the caller as the Group also needs to
-           be deleted from the Indigo database. */
+        ind_ofdpa_group_ecmp_print(pvs, group);
       }
-      break;
     }
+  }
+}
+
+/* OF-DPA keeps no packet or byte counters for groups or buckets. The
+   bucket list still carries one all-ones entry per controller bucket, as
+   OpenFlow asks for counters that are not available. */
+static indigo_error_t
+ind_ofdpa_group_bucket_counters_set(ind_ofdpa_group_t *group,
+                                    of_group_stats_entry_t *entry)
+{
+  of_list_bucket_counter_t list;
+  of_bucket_counter_t counter;
+  uint32_t num_buckets;
+  uint32_t i;
+
+  num_buckets = (group->num_slots != 0) ? group->num_members : group->num_buckets;
 
-    bucket_index++;
+  of_group_stats_entry_bucket_stats_bind(entry, &list);
+  for (i = 0; i < num_buckets; i++)
+  {
+    of_bucket_counter_init(&counter, list.version, -1, 1);
+    if (of_list_bucket_counter_append_bind(&list, &counter) < 0)
+    {
+      LOG_ERROR("too many bucket stats for Group 0x%x", group->id);
+      return INDIGO_ERROR_UNKNOWN;
+    }
+    of_bucket_counter_packet_count_set(&counter, (uint64_t)-1);
+    of_bucket_counter_byte_count_set(&counter, (uint64_t)-1);
   }
 
-  return indigoConvertOfdpaRv(ofdpa_rv);
+  return INDIGO_ERROR_NONE;
+}
+
+/* Per-type counters for a completed create, modify or delete */
+static void
+ind_ofdpa_group_type_account(ind_ofdpa_group_type_t *desc, uint64_t *counter,
+                             indigo_error_t err, uint64_t start_ns)
+{
+  if (err == INDIGO_ERROR_NONE)
+  {
+    (*counter)++;
+  }
+  else
+  {
+    desc->stats.failures++;
+  }
+  desc->stats.time_ns += ind_ofdpa_rpc_now_ns() - start_ns;
 }
 
 static indigo_error_t
@@ -743,18 +2901,23 @@ group_create(void *table_priv, indigo_cxn_id_t cxn_id,
              void **entry_priv)
 {
   indigo_error_t err;
+  ind_ofdpa_group_id_t gid;
+  ind_ofdpa_group_t *restored;
+  ind_ofdpa_group_type_t *desc = table_priv;
+  uint64_t start = ind_ofdpa_rpc_now_ns();
 
-  if ((group_type != OF_GROUP_TYPE_INDIRECT) &&
-      (group_type != OF_GROUP_TYPE_SELECT) &&
-      (group_type != OF_GROUP_TYPE_FF) &&
-      (group_type != OF_GROUP_TYPE_ALL)) 
+  ind_ofdpa_group_id_decode(group_id, &gid);
+  restored = ind_ofdpa_group_find(group_id);
+
+  if ((restored != NULL) && restored->restored)
   {
-    return INDIGO_ERROR_NOT_SUPPORTED;
+    err = ind_ofdpa_group_claim(restored, group_type, buckets, entry_priv);
   }
-
-  err = ind_ofdpa_translate_group_buckets(group_id, buckets, OF_GROUP_ADD);
-
-  *entry_priv = INDIGO_COOKIE_TO_POINTER(group_id);
+  else
+  {
+    err = ind_ofdpa_group_create(&gid, group_id, group_type, buckets, entry_priv);
+  }
+  ind_ofdpa_group_type_account(desc, &desc->stats.creates, err, start);
 
   return err;
 }
@@ -766,9 +2929,11 @@ group_modify(void *table_priv,
              of_list_bucket_t *buckets)
 {
   indigo_error_t err;
-  uint32_t id = INDIGO_POINTER_TO_COOKIE(entry_priv);
+  ind_ofdpa_group_type_t *desc = table_priv;
+  uint64_t start = ind_ofdpa_rpc_now_ns();
 
-  err = ind_ofdpa_translate_group_buckets(id, buckets, OF_GROUP_MODIFY);
+  err = ind_ofdpa_group_update(entry_priv, buckets);
+  ind_ofdpa_group_type_account(desc, &desc->stats.modifies, err, start);
 
   return err;
 }
@@ -777,17 +2942,14 @@ static indigo_error_t
 group_delete(void *table_priv, indigo_cxn_id_t cxn_id,
              void *entry_priv)
 {
-  OFDPA_ERROR_t ofdpa_rv;
-  uint32_t id = INDIGO_POINTER_TO_COOKIE(entry_priv);
+  indigo_error_t err;
+  ind_ofdpa_group_type_t *desc = table_priv;
+  uint64_t start = ind_ofdpa_rpc_now_ns();
 
-  ofdpa_rv = ofdpaGroupDelete(id);
+  err = ind_ofdpa_group_delete(entry_priv);
+  ind_ofdpa_group_type_account(desc, &desc->stats.deletes, err, start);
 
-  if (ofdpa_rv != OFDPA_E_NONE)
-  {
-    LOG_ERROR("Group Delete failed, rv = %d",ofdpa_rv);
-  }
-  
-  return indigoConvertOfdpaRv(ofdpa_rv);
+  return err;
 }
 
 static indigo_error_t
@@ -795,23 +2957,37 @@ group_stats_get(void *table_priv, void *entry_priv,
                 of_group_stats_entry_t *entry)
 {
   OFDPA_ERROR_t ofdpa_rv;
-  ofdpaGroupEntryStats_t groupStats;
-  uint32_t id = INDIGO_POINTER_TO_COOKIE(entry_priv);
+  ind_ofdpa_group_t *group = entry_priv;
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
 
-  memset(&groupStats, 0, sizeof(groupStats));
-  ofdpa_rv = ofdpaGroupStatsGet(id, &groupStats);
+  if (group->swept)
+  {
+    return INDIGO_ERROR_NOT_FOUND;
+  }
 
-  if (ofdpa_rv != OFDPA_E_NONE)
+  /* Use the sampler's copy when it runs; its age is bounded by one sweep */
+  if ((group_stats_interval_ms != 0) && (group->stats_sampled_ns != 0))
   {
-    LOG_ERROR("Failed to get Group stats, rv = %d",ofdpa_rv);
+    group_stats.cache_hits++;
   }
   else
   {
-    of_group_stats_entry_ref_count_set(entry, groupStats.refCount);
-    of_group_stats_entry_duration_sec_set(entry, groupStats.duration);
+    group_stats.cache_misses++;
+    ofdpa_rv = ind_ofdpa_group_stats_sample(group, now_ns);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to get Group stats, rv = %d",ofdpa_rv);
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
   }
 
-  return indigoConvertOfdpaRv(ofdpa_rv);
+  of_group_stats_entry_ref_count_set(entry, group->stats_ref_count);
+  of_group_stats_entry_duration_sec_set(entry, group->stats_duration +
+                                        (uint32_t)((now_ns - group->stats_sampled_ns) / 1000000000ULL));
+  of_group_stats_entry_packet_count_set(entry, (uint64_t)-1);
+  of_group_stats_entry_byte_count_set(entry, (uint64_t)-1);
+
+  return ind_ofdpa_group_bucket_counters_set(group, entry);
 }
 
 static const indigo_core_group_table_ops_t group_table_ops = {
@@ -821,17 +2997,59 @@ static const indigo_core_group_table_ops_t group_table_ops = {
     .entry_stats_get = group_stats_get,
 };
 
+static indigo_error_t
+group_bench_buckets_translate(uint32_t group_id, of_list_bucket_t *buckets,
+                              ofdpaGroupBucketEntry_t **entries, uint32_t *count)
+{
+  ind_ofdpa_group_id_t gid;
+
+  ind_ofdpa_group_id_decode(group_id, &gid);
+  return ind_ofdpa_translate_group_buckets(group_id, &gid, buckets, entries, count);
+}
+
+static void *
+group_bench_table_priv_get(uint32_t group_id)
+{
+  ind_ofdpa_group_id_t gid;
+
+  ind_ofdpa_group_id_decode(group_id, &gid);
+  return &group_types[gid.type];
+}
+
+static const ind_ofdpa_group_bench_ops_t group_bench_ops = {
+    .buckets_translate = group_bench_buckets_translate,
+    .table_ops = &group_table_ops,
+    .table_priv_get = group_bench_table_priv_get,
+};
+
+const ind_ofdpa_group_bench_ops_t *
+ind_ofdpa_group_bench_ops_get(void)
+{
+    return &group_bench_ops;
+}
+
 void
 ind_ofdpa_group_init(void)
 {
     /*
-     * OFDPA uses the top 4 bits as the group table ID, where Indigo
-     * uses the top 8 bits. The ops for every table are the same
-     * so we just register all 256 tables.
+     * OFDPA uses the top 4 bits as the group type, where Indigo uses
+     * the top 8 bits as the group table ID. Each of the 16 Indigo tables
+     * covering a type gets that type's descriptor as table_priv, so the
+     * ops reach the type's translator and counters without decoding it.
+     * Tables of undefined types are left unregistered and Indigo rejects
+     * their groups.
      */
-    int i;
-    for (i = 0; i < 256; i++) {
-        indigo_core_group_table_register(i, "group", &group_table_ops, NULL);
+    ind_ofdpa_group_type_t *desc;
+    int type, i;
+    for (type = 0; type < 16; type++) {
+        desc = &group_types[type];
+        if (desc->name == NULL) {
+            continue;
+        }
+        for (i = 0; i < 16; i++) {
+            indigo_core_group_table_register((type << 4) | i, desc->name,
+                                             &group_table_ops, desc);
+        }
     }
 }
 
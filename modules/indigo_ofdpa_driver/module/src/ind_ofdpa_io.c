@@ -0,0 +1,501 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_io.c
+*
+* @purpose      OF-DPA event and packet socket I/O thread
+*
+* @component    OF-DPA
+*
+* @comments     Packets are received straight into preallocated ring
+*               slots, so the handoff needs no copy or allocation. When
+*               the ring is full the I/O thread stops reading the packet
+*               socket and lets the kernel drop. Flow and port events are
+*               fetched with RPCs, which stay on the main loop thread; the
+*               I/O thread only reads the event notification and flags it.
+*
+*               Two backends are available. The poll backend rebuilds its
+*               fd set every pass; the epoll backend registers the event
+*               and packet fds edge-triggered once and tracks readiness
+*               itself, since a socket left unread while the ring is full
+*               will not be reported again. Either way the thread only
+*               waits on these two sockets and its wake fd; controller
+*               and listener sockets stay on the socket manager's
+*               select loop.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_io.h>
+
+#define IND_OFDPA_IO_RING_MASK (IND_OFDPA_IO_PKT_RING_SIZE - 1)
+
+typedef struct ind_ofdpa_io_ring_s
+{
+  ofdpaPacket_t  slot[IND_OFDPA_IO_PKT_RING_SIZE];
+  char          *buffers;
+  uint32_t       buf_size;
+  uint32_t       head;          /* next slot to deliver, written by main loop */
+  uint32_t       tail;          /* next slot to fill, written by I/O thread */
+  int            waiting;       /* I/O thread is waiting for space */
+} ind_ofdpa_io_ring_t;
+
+typedef struct ind_ofdpa_io_stats_s
+{
+  /* Written by the I/O thread */
+  uint64_t pkts_received;
+  uint64_t ring_full;
+  uint64_t event_batches;
+  /* Written by the main loop */
+  uint64_t pkts_delivered;
+  uint64_t drain_yields;
+  uint32_t high_water;
+} ind_ofdpa_io_stats_t;
+
+static ind_ofdpa_io_ring_t io_ring;
+static ind_ofdpa_io_stats_t io_stats;
+static int io_events_pending;
+static int io_running = 0;
+static ind_ofdpa_io_backend_t io_backend = IND_OFDPA_IO_BACKEND_POLL;
+static int io_notify_fd = -1;   /* I/O thread -> main loop */
+static int io_wake_fd = -1;     /* main loop -> I/O thread */
+static pthread_t io_thread;
+
+static void ind_ofdpa_io_signal(int fd)
+{
+  uint64_t x = 1;
+
+  if (write(fd, &x, sizeof(x)) < 0)
+  {
+    /* silence warn_unused_result; the counter is already non-zero */
+  }
+}
+
+static void ind_ofdpa_io_clear(int fd)
+{
+  uint64_t x;
+
+  if (read(fd, &x, sizeof(x)) < 0)
+  {
+    /* silence warn_unused_result */
+  }
+}
+
+static inline uint32_t ind_ofdpa_io_ring_used(void)
+{
+  return __atomic_load_n(&io_ring.tail, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&io_ring.head, __ATOMIC_ACQUIRE);
+}
+
+/* I/O thread: receive packets into free slots until the socket is empty
+ * or the ring is full. Returns the number of packets queued. */
+static uint32_t ind_ofdpa_io_pkt_fill(void)
+{
+  struct timeval timeout = { 0, 0 };
+  uint32_t tail = io_ring.tail;
+  uint32_t count = 0;
+
+  while ((tail - __atomic_load_n(&io_ring.head, __ATOMIC_ACQUIRE)) < IND_OFDPA_IO_PKT_RING_SIZE)
+  {
+    ofdpaPacket_t *pkt = &io_ring.slot[tail & IND_OFDPA_IO_RING_MASK];
+
+    pkt->pktData.size = io_ring.buf_size;
+    if (ofdpaPktReceive(&timeout, pkt) != OFDPA_E_NONE)
+    {
+      break;
+    }
+    tail++;
+    count++;
+    __atomic_store_n(&io_ring.tail, tail, __ATOMIC_RELEASE);
+  }
+
+  io_stats.pkts_received += count;
+  return count;
+}
+
+static void ind_ofdpa_io_events_drain(void)
+{
+  struct timeval timeout = { 0, 0 };
+  int got = 0;
+
+  while (ofdpaEventReceive(&timeout) == OFDPA_E_NONE)
+  {
+    got++;
+  }
+  if (got)
+  {
+    io_stats.event_batches++;
+    __atomic_store_n(&io_events_pending, 1, __ATOMIC_RELEASE);
+    ind_ofdpa_io_signal(io_notify_fd);
+  }
+}
+
+/* I/O thread: announce that the ring is full and wait for the main loop.
+ * Returns 0 if space appeared in the meantime. */
+static int ind_ofdpa_io_ring_wait(void)
+{
+  /* Publish the wait, then recheck so a drain in between is not missed */
+  __atomic_store_n(&io_ring.waiting, 1, __ATOMIC_SEQ_CST);
+  if (ind_ofdpa_io_ring_used() < IND_OFDPA_IO_PKT_RING_SIZE)
+  {
+    __atomic_store_n(&io_ring.waiting, 0, __ATOMIC_RELAXED);
+    return 0;
+  }
+  io_stats.ring_full++;
+  return 1;
+}
+
+static void ind_ofdpa_io_poll_loop(void)
+{
+  struct pollfd fds[3];
+  int event_fd = ofdpaClientEventSockFdGet();
+  int pkt_fd = ofdpaClientPktSockFdGet();
+  int nfds;
+
+  while (__atomic_load_n(&io_running, __ATOMIC_ACQUIRE))
+  {
+    fds[0].fd = io_wake_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = event_fd;
+    fds[1].events = POLLIN;
+    nfds = 2;
+
+    if (ind_ofdpa_io_ring_used() < IND_OFDPA_IO_PKT_RING_SIZE)
+    {
+      fds[2].fd = pkt_fd;
+      fds[2].events = POLLIN;
+      nfds = 3;
+    }
+    else if (!ind_ofdpa_io_ring_wait())
+    {
+      continue;
+    }
+
+    if (poll(fds, nfds, -1) < 0)
+    {
+      if (errno != EINTR)
+      {
+        LOG_ERROR("OF-DPA I/O thread poll failed: %s", strerror(errno));
+      }
+      continue;
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+      ind_ofdpa_io_clear(io_wake_fd);
+    }
+
+    if (fds[1].revents & POLLIN)
+    {
+      ind_ofdpa_io_events_drain();
+    }
+
+    if ((nfds == 3) && (fds[2].revents & POLLIN))
+    {
+      if (ind_ofdpa_io_pkt_fill() != 0)
+      {
+        ind_ofdpa_io_signal(io_notify_fd);
+      }
+    }
+  }
+}
+
+static void ind_ofdpa_io_epoll_loop(void)
+{
+  struct epoll_event ev;
+  struct epoll_event events[3];
+  int event_fd = ofdpaClientEventSockFdGet();
+  int pkt_fd = ofdpaClientPktSockFdGet();
+  /* Anything queued before registration produces no edge, so start ready */
+  int event_ready = 1;
+  int pkt_ready = 1;
+  int epfd;
+  int n, i;
+
+  epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (epfd < 0)
+  {
+    LOG_ERROR("Failed to create epoll instance: %s", strerror(errno));
+    return;
+  }
+
+  ev.events = EPOLLIN;
+  ev.data.fd = io_wake_fd;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, io_wake_fd, &ev) < 0)
+  {
+    goto fail;
+  }
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.fd = event_fd;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, event_fd, &ev) < 0)
+  {
+    goto fail;
+  }
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.fd = pkt_fd;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, pkt_fd, &ev) < 0)
+  {
+    goto fail;
+  }
+
+  while (__atomic_load_n(&io_running, __ATOMIC_ACQUIRE))
+  {
+    if (event_ready)
+    {
+      ind_ofdpa_io_events_drain();
+      event_ready = 0;
+    }
+
+    if (pkt_ready)
+    {
+      if (ind_ofdpa_io_pkt_fill() != 0)
+      {
+        ind_ofdpa_io_signal(io_notify_fd);
+      }
+      /* The fill stops on an empty socket or a full ring; only the
+       * former consumes the edge. */
+      if (ind_ofdpa_io_ring_used() < IND_OFDPA_IO_PKT_RING_SIZE)
+      {
+        pkt_ready = 0;
+      }
+      else if (!ind_ofdpa_io_ring_wait())
+      {
+        continue;
+      }
+    }
+
+    n = epoll_wait(epfd, events, 3, -1);
+    if (n < 0)
+    {
+      if (errno != EINTR)
+      {
+        LOG_ERROR("OF-DPA I/O thread epoll_wait failed: %s", strerror(errno));
+      }
+      continue;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+      if (events[i].data.fd == io_wake_fd)
+      {
+        ind_ofdpa_io_clear(io_wake_fd);
+      }
+      else if (events[i].data.fd == event_fd)
+      {
+        event_ready = 1;
+      }
+      else if (events[i].data.fd == pkt_fd)
+      {
+        pkt_ready = 1;
+      }
+    }
+  }
+
+  close(epfd);
+  return;
+
+fail:
+  LOG_ERROR("Failed to add fd to epoll set: %s", strerror(errno));
+  close(epfd);
+}
+
+static void *ind_ofdpa_io_thread(void *arg)
+{
+  if (io_backend == IND_OFDPA_IO_BACKEND_EPOLL)
+  {
+    ind_ofdpa_io_epoll_loop();
+  }
+  else
+  {
+    ind_ofdpa_io_poll_loop();
+  }
+
+  return NULL;
+}
+
+/* Main loop: deliver events and up to a budget of packets */
+static void ind_ofdpa_io_notify_ready(int socket_id, void *cookie, int read_ready,
+                                      int write_ready, int error_seen)
+{
+  uint32_t head = io_ring.head;
+  uint32_t tail;
+  uint32_t used;
+  uint32_t budget = IND_OFDPA_IO_DRAIN_BUDGET;
+
+  ind_ofdpa_io_clear(io_notify_fd);
+
+  if (__atomic_exchange_n(&io_events_pending, 0, __ATOMIC_ACQ_REL))
+  {
+    ind_ofdpa_flow_event_receive();
+    ind_ofdpa_port_event_receive();
+  }
+
+  tail = __atomic_load_n(&io_ring.tail, __ATOMIC_ACQUIRE);
+  used = tail - head;
+  if (used > io_stats.high_water)
+  {
+    io_stats.high_water = used;
+  }
+
+  while ((head != tail) && (budget-- != 0))
+  {
+    ind_ofdpa_pkt_deliver(&io_ring.slot[head & IND_OFDPA_IO_RING_MASK]);
+    head++;
+    __atomic_store_n(&io_ring.head, head, __ATOMIC_RELEASE);
+    io_stats.pkts_delivered++;
+  }
+
+  if (__atomic_exchange_n(&io_ring.waiting, 0, __ATOMIC_SEQ_CST))
+  {
+    ind_ofdpa_io_signal(io_wake_fd);
+  }
+
+  if (head != tail)
+  {
+    /* Let other sockets (flow-mods) run before the rest of the burst */
+    io_stats.drain_yields++;
+    ind_ofdpa_io_signal(io_notify_fd);
+  }
+}
+
+indigo_error_t ind_ofdpa_io_start(ind_ofdpa_io_backend_t backend)
+{
+  uint32_t maxPktSize;
+  int i;
+
+  if (io_running)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  if (ofdpaMaxPktSizeGet(&maxPktSize) != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to determine maximum receive packet size.");
+    return INDIGO_ERROR_UNKNOWN;
+  }
+
+  memset(&io_ring, 0, sizeof(io_ring));
+  memset(&io_stats, 0, sizeof(io_stats));
+  io_backend = backend;
+  io_ring.buf_size = maxPktSize;
+  io_ring.buffers = malloc((size_t)maxPktSize * IND_OFDPA_IO_PKT_RING_SIZE);
+  if (io_ring.buffers == NULL)
+  {
+    LOG_ERROR("Failed to allocate packet ring.");
+    return INDIGO_ERROR_RESOURCE;
+  }
+  for (i = 0; i < IND_OFDPA_IO_PKT_RING_SIZE; i++)
+  {
+    io_ring.slot[i].pktData.pstart = io_ring.buffers + ((size_t)i * maxPktSize);
+  }
+
+  io_notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  io_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if ((io_notify_fd < 0) || (io_wake_fd < 0))
+  {
+    LOG_ERROR("Failed to allocate eventfd: %s", strerror(errno));
+    goto fail;
+  }
+
+  if (ind_ofdpa_loop_socket_register(io_notify_fd, ind_ofdpa_io_notify_ready, NULL, "ofdpa io") < 0)
+  {
+    LOG_ERROR("Failed to register OF-DPA I/O notification.");
+    goto fail;
+  }
+
+  io_running = 1;
+  if (pthread_create(&io_thread, NULL, ind_ofdpa_io_thread, NULL) != 0)
+  {
+    LOG_ERROR("Failed to start OF-DPA I/O thread.");
+    io_running = 0;
+    ind_ofdpa_loop_socket_unregister(io_notify_fd);
+    goto fail;
+  }
+
+  return INDIGO_ERROR_NONE;
+
+fail:
+  if (io_notify_fd >= 0)
+  {
+    close(io_notify_fd);
+    io_notify_fd = -1;
+  }
+  if (io_wake_fd >= 0)
+  {
+    close(io_wake_fd);
+    io_wake_fd = -1;
+  }
+  free(io_ring.buffers);
+  io_ring.buffers = NULL;
+  return INDIGO_ERROR_RESOURCE;
+}
+
+void ind_ofdpa_io_stop(void)
+{
+  if (!io_running)
+  {
+    return;
+  }
+
+  __atomic_store_n(&io_running, 0, __ATOMIC_RELEASE);
+  ind_ofdpa_io_signal(io_wake_fd);
+  pthread_join(io_thread, NULL);
+
+  ind_ofdpa_loop_socket_unregister(io_notify_fd);
+  close(io_notify_fd);
+  close(io_wake_fd);
+  io_notify_fd = -1;
+  io_wake_fd = -1;
+
+  free(io_ring.buffers);
+  io_ring.buffers = NULL;
+}
+
+void ind_ofdpa_io_stats_show(aim_pvs_t *pvs)
+{
+  if (!io_running)
+  {
+    aim_printf(pvs, "OF-DPA I/O thread not running\n");
+    return;
+  }
+
+  aim_printf(pvs, "backend              %s\n",
+             (io_backend == IND_OFDPA_IO_BACKEND_EPOLL) ? "epoll" : "poll");
+  aim_printf(pvs, "packets received     %llu\n", (unsigned long long)io_stats.pkts_received);
+  aim_printf(pvs, "packets delivered    %llu\n", (unsigned long long)io_stats.pkts_delivered);
+  aim_printf(pvs, "packets queued       %u / %u (high water %u)\n",
+             ind_ofdpa_io_ring_used(), IND_OFDPA_IO_PKT_RING_SIZE, io_stats.high_water);
+  aim_printf(pvs, "ring full stalls     %llu\n", (unsigned long long)io_stats.ring_full);
+  aim_printf(pvs, "drain yields         %llu\n", (unsigned long long)io_stats.drain_yields);
+  aim_printf(pvs, "event batches        %llu\n", (unsigned long long)io_stats.event_batches);
+}
@@ -0,0 +1,475 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_loop_stats.c
+*
+* @purpose      Service time accounting and stall detection for the
+*               socket manager main loop
+*
+* @component    OF-DPA
+*
+* @comments     A heartbeat timer measures how late the loop gets around
+*               to it, which covers time spent in callbacks we cannot
+*               wrap. The watchdog thread only reads the heartbeat and
+*               the current callback; all counters are owned by the main
+*               loop thread.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+
+#define IND_OFDPA_LOOP_BACKTRACE_DEPTH 32
+
+typedef struct ind_ofdpa_loop_hist_s
+{
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t bucket[IND_OFDPA_LOOP_HIST_BUCKETS];
+} ind_ofdpa_loop_hist_t;
+
+typedef struct ind_ofdpa_loop_cb_s
+{
+  const char                      *name;
+  int                              in_use;
+  int                              fd;
+  ind_soc_socket_ready_callback_f  socket_cb;
+  ind_soc_timer_callback_f         timer_cb;
+  void                            *cookie;
+  ind_ofdpa_loop_hist_t            service;
+} ind_ofdpa_loop_cb_t;
+
+static ind_ofdpa_loop_cb_t loop_callbacks[IND_OFDPA_LOOP_MAX_CALLBACKS];
+
+/* Heartbeat lateness, i.e. how long the loop was busy elsewhere */
+static ind_ofdpa_loop_hist_t loop_lag;
+static uint64_t loop_clear_ns;
+static uint64_t loop_expected_ns;
+
+/* Shared with the watchdog thread */
+static uint64_t loop_heartbeat_ns;
+static ind_ofdpa_loop_cb_t *loop_current;
+static uint64_t loop_current_start_ns;
+
+static pthread_t loop_main_thread;
+static pthread_t loop_watchdog_thread;
+static int loop_watchdog_running = 0;
+static uint32_t loop_stall_ms = 0;
+static int loop_initialized = 0;
+
+static uint64_t ind_ofdpa_loop_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void ind_ofdpa_loop_hist_add(ind_ofdpa_loop_hist_t *hist, uint64_t ns)
+{
+  uint64_t us = ns / 1000;
+  int bucket = 0;
+
+  if (us != 0)
+  {
+    bucket = 64 - __builtin_clzll(us);
+    if (bucket >= IND_OFDPA_LOOP_HIST_BUCKETS)
+    {
+      bucket = IND_OFDPA_LOOP_HIST_BUCKETS - 1;
+    }
+  }
+
+  hist->count++;
+  hist->total_ns += ns;
+  if (ns > hist->max_ns)
+  {
+    hist->max_ns = ns;
+  }
+  hist->bucket[bucket]++;
+}
+
+static void ind_ofdpa_loop_hist_show(aim_pvs_t *pvs, const char *name, const ind_ofdpa_loop_hist_t *hist)
+{
+  int i;
+
+  aim_printf(pvs, "%-20s %10llu %10.1f %10.1f %12.1f\n", name,
+             (unsigned long long)hist->count,
+             hist->count ? (double)hist->total_ns / hist->count / 1000.0 : 0.0,
+             (double)hist->max_ns / 1000.0,
+             (double)hist->total_ns / 1000000.0);
+
+  if (hist->count == 0)
+  {
+    return;
+  }
+
+  aim_printf(pvs, "    ");
+  for (i = 0; i < IND_OFDPA_LOOP_HIST_BUCKETS; i++)
+  {
+    if (hist->bucket[i] == 0)
+    {
+      continue;
+    }
+    if (i == IND_OFDPA_LOOP_HIST_BUCKETS - 1)
+    {
+      aim_printf(pvs, " >=%lluus=%llu", 1ULL << (i - 1), (unsigned long long)hist->bucket[i]);
+    }
+    else
+    {
+      aim_printf(pvs, " <%lluus=%llu", 1ULL << i, (unsigned long long)hist->bucket[i]);
+    }
+  }
+  aim_printf(pvs, "\n");
+}
+
+static inline uint64_t ind_ofdpa_loop_enter(ind_ofdpa_loop_cb_t *entry)
+{
+  uint64_t start = ind_ofdpa_loop_now_ns();
+
+  __atomic_store_n(&loop_current_start_ns, start, __ATOMIC_RELAXED);
+  __atomic_store_n(&loop_current, entry, __ATOMIC_RELEASE);
+  return start;
+}
+
+static inline void ind_ofdpa_loop_exit(ind_ofdpa_loop_cb_t *entry, uint64_t start)
+{
+  uint64_t end = ind_ofdpa_loop_now_ns();
+
+  __atomic_store_n(&loop_current, NULL, __ATOMIC_RELEASE);
+  ind_ofdpa_loop_hist_add(&entry->service, end - start);
+}
+
+static void ind_ofdpa_loop_socket_trampoline(int socket_id, void *cookie, int read_ready,
+                                             int write_ready, int error_seen)
+{
+  ind_ofdpa_loop_cb_t *entry = cookie;
+  uint64_t start = ind_ofdpa_loop_enter(entry);
+
+  entry->socket_cb(socket_id, entry->cookie, read_ready, write_ready, error_seen);
+  ind_ofdpa_loop_exit(entry, start);
+}
+
+static void ind_ofdpa_loop_timer_trampoline(void *cookie)
+{
+  ind_ofdpa_loop_cb_t *entry = cookie;
+  uint64_t start = ind_ofdpa_loop_enter(entry);
+
+  entry->timer_cb(entry->cookie);
+  ind_ofdpa_loop_exit(entry, start);
+}
+
+static ind_ofdpa_loop_cb_t *ind_ofdpa_loop_entry_alloc(const char *name)
+{
+  int i;
+
+  for (i = 0; i < IND_OFDPA_LOOP_MAX_CALLBACKS; i++)
+  {
+    if (!loop_callbacks[i].in_use)
+    {
+      memset(&loop_callbacks[i], 0, sizeof(loop_callbacks[i]));
+      loop_callbacks[i].in_use = 1;
+      loop_callbacks[i].fd = -1;
+      loop_callbacks[i].name = name;
+      return &loop_callbacks[i];
+    }
+  }
+
+  LOG_ERROR("No room to instrument callback %s.", name);
+  return NULL;
+}
+
+indigo_error_t ind_ofdpa_loop_socket_register(int fd, ind_soc_socket_ready_callback_f callback,
+                                              void *cookie, const char *name)
+{
+  ind_ofdpa_loop_cb_t *entry = ind_ofdpa_loop_entry_alloc(name);
+  indigo_error_t err;
+
+  if (entry == NULL)
+  {
+    /* Still service the socket, just without accounting */
+    return ind_soc_socket_register(fd, callback, cookie);
+  }
+
+  entry->fd = fd;
+  entry->socket_cb = callback;
+  entry->cookie = cookie;
+
+  err = ind_soc_socket_register(fd, ind_ofdpa_loop_socket_trampoline, entry);
+  if (err < 0)
+  {
+    entry->in_use = 0;
+  }
+  return err;
+}
+
+indigo_error_t ind_ofdpa_loop_socket_unregister(int fd)
+{
+  int i;
+
+  for (i = 0; i < IND_OFDPA_LOOP_MAX_CALLBACKS; i++)
+  {
+    if (loop_callbacks[i].in_use && (loop_callbacks[i].socket_cb != NULL) &&
+        (loop_callbacks[i].fd == fd))
+    {
+      loop_callbacks[i].in_use = 0;
+      break;
+    }
+  }
+  return ind_soc_socket_unregister(fd);
+}
+
+indigo_error_t ind_ofdpa_loop_timer_register(ind_soc_timer_callback_f callback, void *cookie,
+                                             int repeat_time_ms, const char *name)
+{
+  ind_ofdpa_loop_cb_t *entry = ind_ofdpa_loop_entry_alloc(name);
+  indigo_error_t err;
+
+  if (entry == NULL)
+  {
+    return ind_soc_timer_event_register(callback, cookie, repeat_time_ms);
+  }
+
+  entry->timer_cb = callback;
+  entry->cookie = cookie;
+
+  err = ind_soc_timer_event_register(ind_ofdpa_loop_timer_trampoline, entry, repeat_time_ms);
+  if (err < 0)
+  {
+    entry->in_use = 0;
+  }
+  return err;
+}
+
+indigo_error_t ind_ofdpa_loop_timer_unregister(ind_soc_timer_callback_f callback, void *cookie)
+{
+  int i;
+
+  for (i = 0; i < IND_OFDPA_LOOP_MAX_CALLBACKS; i++)
+  {
+    if (loop_callbacks[i].in_use && (loop_callbacks[i].timer_cb == callback) &&
+        (loop_callbacks[i].cookie == cookie))
+    {
+      loop_callbacks[i].in_use = 0;
+      return ind_soc_timer_event_unregister(ind_ofdpa_loop_timer_trampoline, &loop_callbacks[i]);
+    }
+  }
+  return ind_soc_timer_event_unregister(callback, cookie);
+}
+
+static void ind_ofdpa_loop_heartbeat(void *cookie)
+{
+  uint64_t now = ind_ofdpa_loop_now_ns();
+
+  if (loop_expected_ns != 0)
+  {
+    ind_ofdpa_loop_hist_add(&loop_lag, (now > loop_expected_ns) ? (now - loop_expected_ns) : 0);
+  }
+  loop_expected_ns = now + (IND_OFDPA_LOOP_HEARTBEAT_MS * 1000000ULL);
+
+  __atomic_store_n(&loop_heartbeat_ns, now, __ATOMIC_RELEASE);
+}
+
+static void ind_ofdpa_loop_backtrace_signal(int signum)
+{
+  static const char banner[] = "ofagent main loop stack:\n";
+  void *frames[IND_OFDPA_LOOP_BACKTRACE_DEPTH];
+  int depth;
+
+  if (write(STDERR_FILENO, banner, sizeof(banner) - 1) < 0)
+  {
+    /* silence warn_unused_result */
+  }
+  depth = backtrace(frames, IND_OFDPA_LOOP_BACKTRACE_DEPTH);
+  backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+}
+
+static void *ind_ofdpa_loop_watchdog(void *arg)
+{
+  uint64_t stall_ns = (uint64_t)loop_stall_ms * 1000000ULL;
+  uint64_t reported_heartbeat = 0;
+  struct timespec period;
+
+  period.tv_sec = (loop_stall_ms / 4) / 1000;
+  period.tv_nsec = ((loop_stall_ms / 4) % 1000) * 1000000L;
+
+  while (__atomic_load_n(&loop_watchdog_running, __ATOMIC_ACQUIRE))
+  {
+    uint64_t heartbeat;
+    uint64_t now;
+    ind_ofdpa_loop_cb_t *current;
+    uint64_t current_start;
+
+    nanosleep(&period, NULL);
+
+    heartbeat = __atomic_load_n(&loop_heartbeat_ns, __ATOMIC_ACQUIRE);
+    now = ind_ofdpa_loop_now_ns();
+    if ((heartbeat == 0) || ((now - heartbeat) < stall_ns) ||
+        (heartbeat == reported_heartbeat))
+    {
+      continue;
+    }
+
+    /* One report per stall */
+    reported_heartbeat = heartbeat;
+
+    current = __atomic_load_n(&loop_current, __ATOMIC_ACQUIRE);
+    current_start = __atomic_load_n(&loop_current_start_ns, __ATOMIC_RELAXED);
+    if (current != NULL)
+    {
+      LOG_ERROR("Main loop stalled for %llu ms in callback %s (running for %llu ms).",
+                (unsigned long long)((now - heartbeat) / 1000000),
+                current->name,
+                (unsigned long long)((now - current_start) / 1000000));
+    }
+    else
+    {
+      LOG_ERROR("Main loop stalled for %llu ms outside instrumented callbacks "
+                "(controller connection or core processing).",
+                (unsigned long long)((now - heartbeat) / 1000000));
+    }
+
+    pthread_kill(loop_main_thread, SIGUSR2);
+  }
+
+  return NULL;
+}
+
+indigo_error_t ind_ofdpa_loop_stats_init(uint32_t stall_ms)
+{
+  struct sigaction sa;
+  void *frame;
+
+  if (loop_initialized)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  loop_main_thread = pthread_self();
+  loop_clear_ns = ind_ofdpa_loop_now_ns();
+
+  if (ind_soc_timer_event_register(ind_ofdpa_loop_heartbeat, NULL, IND_OFDPA_LOOP_HEARTBEAT_MS) < 0)
+  {
+    LOG_ERROR("Failed to register main loop heartbeat.");
+    return INDIGO_ERROR_RESOURCE;
+  }
+  loop_initialized = 1;
+
+  if (stall_ms == 0)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+  if (stall_ms <= IND_OFDPA_LOOP_HEARTBEAT_MS)
+  {
+    /* Every heartbeat gap would look like a stall */
+    LOG_ERROR("Stall threshold %u ms must be more than the %u ms heartbeat.",
+              stall_ms, IND_OFDPA_LOOP_HEARTBEAT_MS);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  /* backtrace() loads libgcc on first use, which is not safe from a
+   * signal handler, so do that now. */
+  (void)backtrace(&frame, 1);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = ind_ofdpa_loop_backtrace_signal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR2, &sa, NULL);
+
+  loop_stall_ms = stall_ms;
+  loop_watchdog_running = 1;
+  if (pthread_create(&loop_watchdog_thread, NULL, ind_ofdpa_loop_watchdog, NULL) != 0)
+  {
+    LOG_ERROR("Failed to start main loop watchdog: %s", strerror(errno));
+    loop_watchdog_running = 0;
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_loop_stats_finish(void)
+{
+  if (!loop_initialized)
+  {
+    return;
+  }
+
+  if (loop_watchdog_running)
+  {
+    __atomic_store_n(&loop_watchdog_running, 0, __ATOMIC_RELEASE);
+    pthread_join(loop_watchdog_thread, NULL);
+  }
+
+  ind_soc_timer_event_unregister(ind_ofdpa_loop_heartbeat, NULL);
+  loop_initialized = 0;
+}
+
+void ind_ofdpa_loop_stats_show(aim_pvs_t *pvs)
+{
+  uint64_t wall_ns = ind_ofdpa_loop_now_ns() - loop_clear_ns;
+  uint64_t busy_ns = 0;
+  int i;
+
+  aim_printf(pvs, "%-20s %10s %10s %10s %12s\n", "callback", "calls", "avg_us", "max_us", "total_ms");
+  for (i = 0; i < IND_OFDPA_LOOP_MAX_CALLBACKS; i++)
+  {
+    if (!loop_callbacks[i].in_use)
+    {
+      continue;
+    }
+    ind_ofdpa_loop_hist_show(pvs, loop_callbacks[i].name, &loop_callbacks[i].service);
+    busy_ns += loop_callbacks[i].service.total_ns;
+  }
+
+  aim_printf(pvs, "\n");
+  ind_ofdpa_loop_hist_show(pvs, "heartbeat lag", &loop_lag);
+
+  aim_printf(pvs, "\nwall %.1f ms, instrumented callbacks %.1f ms (%.1f%%)\n",
+             (double)wall_ns / 1000000.0, (double)busy_ns / 1000000.0,
+             wall_ns ? (100.0 * busy_ns) / wall_ns : 0.0);
+  if (loop_stall_ms != 0)
+  {
+    aim_printf(pvs, "watchdog threshold %u ms\n", loop_stall_ms);
+  }
+}
+
+void ind_ofdpa_loop_stats_clear(void)
+{
+  int i;
+
+  for (i = 0; i < IND_OFDPA_LOOP_MAX_CALLBACKS; i++)
+  {
+    memset(&loop_callbacks[i].service, 0, sizeof(loop_callbacks[i].service));
+  }
+  memset(&loop_lag, 0, sizeof(loop_lag));
+  loop_clear_ns = ind_ofdpa_loop_now_ns();
+}
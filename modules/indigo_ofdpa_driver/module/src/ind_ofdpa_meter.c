@@ -29,18 +29,120 @@
 * @end
 *
 **********************************************************************/
+#include <stdlib.h>
+#include <string.h>
 #include <indigo/forwarding.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_util.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_meter.h>
 
-#ifdef OFDPA_FIXUP
-indigo_error_t indigo_fwd_meter_add(uint32_t id, uint16_t flag, of_list_meter_band_t *meters)
+/* OF-DPA meters are two-rate color markers; band 0 is the yellow band and
+   band 1 the red band, as ofdpaMeterGet() reports them */
+#define IND_OFDPA_METER_BAND_YELLOW_INDEX   0
+#define IND_OFDPA_METER_BAND_RED_INDEX      1
+
+/* Drop precedence levels a DSCP remark band may add: green to yellow */
+#define IND_OFDPA_METER_PREC_LEVEL_YELLOW   1
+
+#define IND_OFDPA_METER_HASH_SIZE           256
+
+/* Meter IDs tried for the stand-in of a meter in use while it is modified */
+#define IND_OFDPA_METER_SPARE_TRIES         64
+
+/* Driver state for an installed meter */
+typedef struct ind_ofdpa_meter_s
+{
+  struct ind_ofdpa_meter_s *next;
+  ofdpaMeterEntry_t         entry;          /* as last programmed */
+  uint32_t                  stats_ref_count;
+  uint32_t                  stats_duration;
+  uint64_t                  stats_sampled_ns;   /* 0 if never sampled */
+} ind_ofdpa_meter_t;
+
+static ind_ofdpa_meter_t *meter_hash[IND_OFDPA_METER_HASH_SIZE];
+static uint32_t meter_count;
+static uint32_t meter_stats_interval_ms;
+
+static ind_ofdpa_meter_t *ind_ofdpa_meter_find(uint32_t id)
+{
+  ind_ofdpa_meter_t *meter;
+
+  for (meter = meter_hash[id % IND_OFDPA_METER_HASH_SIZE]; meter != NULL; meter = meter->next)
+  {
+    if (meter->entry.meterId == id)
+    {
+      return meter;
+    }
+  }
+  return NULL;
+}
+
+static void ind_ofdpa_meter_insert(ind_ofdpa_meter_t *meter)
 {
-  indigo_error_t err = INDIGO_ERROR_NONE;
+  ind_ofdpa_meter_t **head = &meter_hash[meter->entry.meterId % IND_OFDPA_METER_HASH_SIZE];
+
+  meter->next = *head;
+  *head = meter;
+  meter_count++;
+}
+
+static void ind_ofdpa_meter_remove(ind_ofdpa_meter_t *meter)
+{
+  ind_ofdpa_meter_t **link = &meter_hash[meter->entry.meterId % IND_OFDPA_METER_HASH_SIZE];
+
+  while (*link != NULL)
+  {
+    if (*link == meter)
+    {
+      *link = meter->next;
+      meter_count--;
+      return;
+    }
+    link = &(*link)->next;
+  }
+}
+
+static indigo_error_t ind_ofdpa_meter_band_set(ofdpaMeterEntry_t *entry, uint32_t index,
+                                               uint32_t type, uint32_t rate, uint32_t burst)
+{
+  if (entry->meterBand[index].bandType != 0)
+  {
+    LOG_ERROR("Meter %d has more than one %s band", entry->meterId,
+              (type == OFDPA_METER_BAND_YELLOW) ? "yellow" : "red");
+    return INDIGO_ERROR_COMPAT;
+  }
+
+  entry->meterBand[index].bandType = type;
+  entry->meterBand[index].bandRate = rate;
+  entry->meterBand[index].bandBurst = burst;
+  return INDIGO_ERROR_NONE;
+}
+
+/*
+ * Map OpenFlow bands onto the yellow and red bands of an OF-DPA meter.
+ * Traffic above the red band rate is dropped, so a drop band becomes the
+ * red band. Traffic above the yellow band rate is marked yellow, which the
+ * color-based actions use to remark it, so a DSCP remark band becomes the
+ * yellow band. Yellow is one drop precedence level above green, and the
+ * next level is red, which drops, so a DSCP remark band must raise the
+ * precedence by exactly one level. An OF-DPA color set band names its
+ * band directly.
+ */
+static indigo_error_t ind_ofdpa_meter_translate(uint32_t id, uint16_t flag,
+                                                of_list_meter_band_t *meters,
+                                                ofdpaMeterEntry_t *entry)
+{
+  indigo_error_t err;
   of_meter_band_t of_meter_band;
+  uint32_t num_bands = 0;
   int rv;
 
-  LOG_TRACE("meter_add: id %d, flag 0x%x",id, flag);
+  memset(entry, 0, sizeof(*entry));
+  entry->meterId = id;
+  entry->meterFlag = flag;
+
   OF_LIST_METER_BAND_ITER(meters, &of_meter_band, rv) 
   {
     switch (of_meter_band.header.object_id) {
@@ -49,6 +151,8 @@ indigo_error_t indigo_fwd_meter_add(uint32_t id, uint16_t flag, of_list_meter_ba
         of_meter_band_drop_rate_get(&of_meter_band.drop, &rate);
         of_meter_band_drop_burst_size_get(&of_meter_band.drop, &burst);
         LOG_TRACE("meter_band: %d, %d",rate, burst);
+        err = ind_ofdpa_meter_band_set(entry, IND_OFDPA_METER_BAND_RED_INDEX,
+                                       OFDPA_METER_BAND_RED, rate, burst);
         break;
       }
       case OF_METER_BAND_DSCP_REMARK: {
@@ -58,6 +162,14 @@ indigo_error_t indigo_fwd_meter_add(uint32_t id, uint16_t flag, of_list_meter_ba
         of_meter_band_dscp_remark_burst_size_get(&of_meter_band.dscp_remark, &burst);
         of_meter_band_dscp_remark_prec_level_get(&of_meter_band.dscp_remark, &prec_level);
         LOG_TRACE("meter_band: %d, %d, %d",rate, burst, prec_level);
+        if (prec_level != IND_OFDPA_METER_PREC_LEVEL_YELLOW)
+        {
+          LOG_ERROR("unsupported meter_band prec_level %d", prec_level);
+          err = INDIGO_ERROR_COMPAT;
+          break;
+        }
+        err = ind_ofdpa_meter_band_set(entry, IND_OFDPA_METER_BAND_YELLOW_INDEX,
+                                       OFDPA_METER_BAND_YELLOW, rate, burst);
         break;
       }
       case OF_METER_BAND_OFDPA_COLOR_SET: {
@@ -67,26 +179,385 @@ indigo_error_t indigo_fwd_meter_add(uint32_t id, uint16_t flag, of_list_meter_ba
         of_meter_band_ofdpa_color_set_burst_size_get(&of_meter_band.ofdpa_color_set, &burst);
         of_meter_band_ofdpa_color_set_color_get(&of_meter_band.ofdpa_color_set, &color);
         LOG_TRACE("meter_band: %d, %d, %d",rate, burst, color);
+        if (color == OFDPA_QOS_YELLOW)
+        {
+          err = ind_ofdpa_meter_band_set(entry, IND_OFDPA_METER_BAND_YELLOW_INDEX,
+                                         OFDPA_METER_BAND_YELLOW, rate, burst);
+        }
+        else if (color == OFDPA_QOS_RED)
+        {
+          err = ind_ofdpa_meter_band_set(entry, IND_OFDPA_METER_BAND_RED_INDEX,
+                                         OFDPA_METER_BAND_RED, rate, burst);
+        }
+        else
+        {
+          LOG_ERROR("unsupported meter_band color %d", color);
+          err = INDIGO_ERROR_COMPAT;
+        }
         break;
       }
       default:
           LOG_ERROR("unsupported meter_band %d", of_meter_band.header.object_id);
           return INDIGO_ERROR_COMPAT;
     }
-    
+
+    if (err != INDIGO_ERROR_NONE)
+    {
+      return err;
+    }
+    num_bands++;
   }
-  return err;
+
+  if (num_bands == 0)
+  {
+    LOG_ERROR("No bands given for meter %d", id);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  return INDIGO_ERROR_NONE;
+}
+
+indigo_error_t indigo_fwd_meter_add(uint32_t id, uint16_t flag, of_list_meter_band_t *meters)
+{
+  indigo_error_t err;
+  OFDPA_ERROR_t ofdpa_rv;
+  ind_ofdpa_meter_t *meter;
+
+  LOG_TRACE("meter_add: id %d, flag 0x%x",id, flag);
+
+  if (ind_ofdpa_meter_find(id) != NULL)
+  {
+    LOG_ERROR("Meter %d already exists", id);
+    return INDIGO_ERROR_EXISTS;
+  }
+
+  meter = calloc(1, sizeof(*meter));
+  if (meter == NULL)
+  {
+    LOG_ERROR("Failed to allocate meter %d", id);
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  err = ind_ofdpa_meter_translate(id, flag, meters, &meter->entry);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    free(meter);
+    return err;
+  }
+
+  ofdpa_rv = ofdpaMeterAdd(&meter->entry);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to add meter %d, rv = %d", id, ofdpa_rv);
+    free(meter);
+    return indigoConvertOfdpaRv(ofdpa_rv);
+  }
+
+  ind_ofdpa_meter_insert(meter);
+  return INDIGO_ERROR_NONE;
 }
+
+/* Find a meter ID, above id, that neither the driver nor OF-DPA uses */
+static uint32_t ind_ofdpa_meter_spare_id(uint32_t id)
+{
+  ofdpaMeterEntry_t entry;
+  uint32_t spare = id;
+  uint32_t tries;
+
+  for (tries = 0; tries < IND_OFDPA_METER_SPARE_TRIES; tries++)
+  {
+    if (++spare == 0)
+    {
+      spare = 1;
+    }
+    if ((ind_ofdpa_meter_find(spare) == NULL) &&
+        (ofdpaMeterGet(spare, &entry) == OFDPA_E_NOT_FOUND))
+    {
+      return spare;
+    }
+  }
+  return 0;
+}
+
+/* Delete the meter and add it again with entry's bands. If the add fails
+   the old meter is restored, or forgotten if that fails too. */
+static OFDPA_ERROR_t ind_ofdpa_meter_replace(ind_ofdpa_meter_t *meter, ofdpaMeterEntry_t *entry)
+{
+  OFDPA_ERROR_t ofdpa_rv;
+
+  ofdpa_rv = ofdpaMeterDelete(entry->meterId);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to delete meter %d for modify, rv = %d", entry->meterId, ofdpa_rv);
+    return ofdpa_rv;
+  }
+
+  ofdpa_rv = ofdpaMeterAdd(entry);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to add modified meter %d, rv = %d", entry->meterId, ofdpa_rv);
+    if (ofdpaMeterAdd(&meter->entry) != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to restore meter %d", entry->meterId);
+      ind_ofdpa_meter_remove(meter);
+      free(meter);
+    }
+  }
+  return ofdpa_rv;
+}
+
+/*
+ * OF-DPA has no meter modify, so the meter is deleted and added again with
+ * the new bands, keeping the original flags. OF-DPA refuses to delete a
+ * meter that flows still use, so while it is replaced they are moved to a
+ * stand-in meter that already has the new bands, under a spare meter ID,
+ * and moved back after. Any failure before the meter is replaced leaves
+ * the old meter and its flows as they were.
+ */
 indigo_error_t indigo_fwd_meter_modify(uint32_t id, of_list_meter_band_t *meters)
 {
-  indigo_error_t err = INDIGO_ERROR_NONE;
+  indigo_error_t err;
+  OFDPA_ERROR_t ofdpa_rv;
+  ofdpaMeterEntry_t entry;
+  ofdpaMeterEntry_t spare;
+  ofdpaMeterEntryStats_t stats;
+  ind_ofdpa_meter_t *meter;
+  uint32_t moved = 0;
+  uint32_t back = 0;
+
   LOG_TRACE("meter_mod: id %d",id);
+
+  meter = ind_ofdpa_meter_find(id);
+  if (meter == NULL)
+  {
+    LOG_ERROR("Meter %d not found", id);
+    return INDIGO_ERROR_NOT_FOUND;
+  }
+
+  err = ind_ofdpa_meter_translate(id, meter->entry.meterFlag, meters, &entry);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  if (memcmp(&entry, &meter->entry, sizeof(entry)) == 0)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  memset(&stats, 0, sizeof(stats));
+  ofdpa_rv = ofdpaMeterStatsGet(id, &stats);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to get meter %d stats for modify, rv = %d", id, ofdpa_rv);
+    return indigoConvertOfdpaRv(ofdpa_rv);
+  }
+
+  if (stats.refCount == 0)
+  {
+    ofdpa_rv = ind_ofdpa_meter_replace(meter, &entry);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
+    meter->entry = entry;
+    meter->stats_sampled_ns = 0;
+    return INDIGO_ERROR_NONE;
+  }
+
+  spare = entry;
+  spare.meterId = ind_ofdpa_meter_spare_id(id);
+  if (spare.meterId == 0)
+  {
+    LOG_ERROR("No spare meter ID to modify meter %d", id);
+    return INDIGO_ERROR_RESOURCE;
+  }
+  ofdpa_rv = ofdpaMeterAdd(&spare);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to add stand-in meter %d for meter %d, rv = %d",
+              spare.meterId, id, ofdpa_rv);
+    return indigoConvertOfdpaRv(ofdpa_rv);
+  }
+
+  err = ind_ofdpa_flows_by_meter_move(id, spare.meterId, &moved);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    ofdpa_rv = ind_ofdpa_meter_replace(meter, &entry);
+    if (ofdpa_rv == OFDPA_E_NONE)
+    {
+      meter->entry = entry;
+      meter->stats_sampled_ns = 0;
+    }
+    else
+    {
+      err = indigoConvertOfdpaRv(ofdpa_rv);
+    }
+  }
+
+  /* Back onto the meter's own ID, whichever bands it now has */
+  if (ind_ofdpa_flows_by_meter_move(spare.meterId, id, &back) != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Meter %d: %u of %u flows left on stand-in meter %d",
+              id, moved - back, moved, spare.meterId);
+    return (err != INDIGO_ERROR_NONE) ? err : INDIGO_ERROR_UNKNOWN;
+  }
+  ofdpa_rv = ofdpaMeterDelete(spare.meterId);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to delete stand-in meter %d, rv = %d", spare.meterId, ofdpa_rv);
+  }
+
+  LOG_TRACE("Meter %d modified with %u flows moved", id, moved);
   return err;
 }
+
 indigo_error_t indigo_fwd_meter_delete(uint32_t id)
 {
-  indigo_error_t err = INDIGO_ERROR_NONE;
+  OFDPA_ERROR_t ofdpa_rv;
+  ind_ofdpa_meter_t *meter;
+
   LOG_TRACE("meter_del: id %d",id);
-  return err;
+
+  ofdpa_rv = ofdpaMeterDelete(id);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    LOG_ERROR("Failed to delete meter %d, rv = %d", id, ofdpa_rv);
+    return indigoConvertOfdpaRv(ofdpa_rv);
+  }
+
+  meter = ind_ofdpa_meter_find(id);
+  if (meter != NULL)
+  {
+    ind_ofdpa_meter_remove(meter);
+    free(meter);
+  }
+  return INDIGO_ERROR_NONE;
+}
+
+static OFDPA_ERROR_t ind_ofdpa_meter_stats_sample(ind_ofdpa_meter_t *meter, uint64_t now_ns)
+{
+  ofdpaMeterEntryStats_t meterStats;
+  OFDPA_ERROR_t ofdpa_rv;
+
+  memset(&meterStats, 0, sizeof(meterStats));
+  ofdpa_rv = ofdpaMeterStatsGet(meter->entry.meterId, &meterStats);
+  if (ofdpa_rv == OFDPA_E_NONE)
+  {
+    meter->stats_ref_count = meterStats.refCount;
+    meter->stats_duration = meterStats.duration;
+    meter->stats_sampled_ns = now_ns;
+  }
+  return ofdpa_rv;
+}
+
+static void ind_ofdpa_meter_stats_timer(void *cookie)
+{
+  ind_ofdpa_meter_t *meter;
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
+  int i;
+
+  for (i = 0; i < IND_OFDPA_METER_HASH_SIZE; i++)
+  {
+    for (meter = meter_hash[i]; meter != NULL; meter = meter->next)
+    {
+      (void)ind_ofdpa_meter_stats_sample(meter, now_ns);
+    }
+  }
+}
+
+indigo_error_t ind_ofdpa_meter_stats_init(uint32_t interval_ms)
+{
+  indigo_error_t err;
+
+  ind_ofdpa_meter_stats_finish();
+
+  if (interval_ms == 0)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  err = ind_ofdpa_loop_timer_register(ind_ofdpa_meter_stats_timer, NULL, interval_ms,
+                                      "meter stats");
+  if (err < 0)
+  {
+    LOG_ERROR("Failed to register meter stats timer.");
+    return err;
+  }
+
+  meter_stats_interval_ms = interval_ms;
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_meter_stats_finish(void)
+{
+  if (meter_stats_interval_ms != 0)
+  {
+    ind_ofdpa_loop_timer_unregister(ind_ofdpa_meter_stats_timer, NULL);
+    meter_stats_interval_ms = 0;
+  }
+}
+
+indigo_error_t ind_ofdpa_meter_stats_get(uint32_t meter_id, uint32_t *ref_count,
+                                         uint32_t *duration_sec)
+{
+  OFDPA_ERROR_t ofdpa_rv;
+  ind_ofdpa_meter_t *meter;
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
+
+  meter = ind_ofdpa_meter_find(meter_id);
+  if (meter == NULL)
+  {
+    return INDIGO_ERROR_NOT_FOUND;
+  }
+
+  if ((meter_stats_interval_ms == 0) || (meter->stats_sampled_ns == 0))
+  {
+    ofdpa_rv = ind_ofdpa_meter_stats_sample(meter, now_ns);
+    if (ofdpa_rv != OFDPA_E_NONE)
+    {
+      LOG_ERROR("Failed to get meter %d stats, rv = %d", meter_id, ofdpa_rv);
+      return indigoConvertOfdpaRv(ofdpa_rv);
+    }
+  }
+
+  *ref_count = meter->stats_ref_count;
+  *duration_sec = meter->stats_duration +
+    (uint32_t)((now_ns - meter->stats_sampled_ns) / 1000000000ULL);
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_meter_show(aim_pvs_t *pvs)
+{
+  ind_ofdpa_meter_t *meter;
+  uint32_t ref_count, duration;
+  int i, j;
+
+  aim_printf(pvs, "%u meters, stats poller %s\n", meter_count,
+             (meter_stats_interval_ms != 0) ? "running" : "stopped");
+
+  for (i = 0; i < IND_OFDPA_METER_HASH_SIZE; i++)
+  {
+    for (meter = meter_hash[i]; meter != NULL; meter = meter->next)
+    {
+      if (ind_ofdpa_meter_stats_get(meter->entry.meterId, &ref_count, &duration) != INDIGO_ERROR_NONE)
+      {
+        ref_count = 0;
+        duration = 0;
+      }
+      aim_printf(pvs, "meter %u  flags 0x%x  flows %u  duration %us\n",
+                 meter->entry.meterId, meter->entry.meterFlag, ref_count, duration);
+
+      for (j = 0; j < METER_BANDS_MAX; j++)
+      {
+        if (meter->entry.meterBand[j].bandType == 0)
+        {
+          continue;
+        }
+        aim_printf(pvs, "    %-6s rate %u  burst %u\n",
+                   (meter->entry.meterBand[j].bandType == OFDPA_METER_BAND_YELLOW) ? "yellow" : "red",
+                   meter->entry.meterBand[j].bandRate, meter->entry.meterBand[j].bandBurst);
+      }
+    }
+  }
 }
-#endif
@@ -34,6 +34,7 @@
 #include <indigo/of_state_manager.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_util.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
 #include <indigo/error.h>
 #include <loci/of_match.h>
 #include <loci/loci.h>
@@ -0,0 +1,303 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_rpc_stats.c
+*
+* @purpose      Per-API call counters and latency histograms for the
+*               libofdpa client calls made by the driver
+*
+* @component    OF-DPA
+*
+* @comments     Each thread that calls into libofdpa gets its own counter
+*               block, linked once into a global list with a CAS and never
+*               freed. Only the owning thread writes a block, so updates
+*               are plain relaxed stores. Clearing bumps a global epoch;
+*               a block whose epoch is stale reads as zero and is wiped
+*               by its owner on the next call.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#define IND_OFDPA_RPC_STATS_NO_WRAP
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+
+typedef struct ind_ofdpa_rpc_counters_s
+{
+  uint64_t calls;
+  uint64_t errors;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t err_codes[IND_OFDPA_RPC_ERR_SLOTS];
+  uint64_t hist[IND_OFDPA_RPC_HIST_BUCKETS];
+} ind_ofdpa_rpc_counters_t;
+
+typedef struct ind_ofdpa_rpc_thread_s
+{
+  struct ind_ofdpa_rpc_thread_s *next;
+  uint32_t                       epoch;
+  ind_ofdpa_rpc_counters_t       api[IND_OFDPA_RPC_COUNT];
+} ind_ofdpa_rpc_thread_t;
+
+#define IND_OFDPA_RPC_NAME_ENTRY(_name) "ofdpa" #_name,
+
+static const char *rpc_names[IND_OFDPA_RPC_COUNT] =
+{
+  IND_OFDPA_RPC_API_LIST(IND_OFDPA_RPC_NAME_ENTRY)
+};
+
+static ind_ofdpa_rpc_thread_t *rpc_threads = NULL;
+static uint32_t rpc_epoch = 0;
+static __thread ind_ofdpa_rpc_thread_t *rpc_self = NULL;
+
+#define RPC_LOAD(_p)       __atomic_load_n((_p), __ATOMIC_RELAXED)
+#define RPC_STORE(_p, _v)  __atomic_store_n((_p), (_v), __ATOMIC_RELAXED)
+#define RPC_ADD(_p, _v)    RPC_STORE((_p), RPC_LOAD(_p) + (_v))
+
+static ind_ofdpa_rpc_thread_t *ind_ofdpa_rpc_self_get(void)
+{
+  ind_ofdpa_rpc_thread_t *self = rpc_self;
+
+  if (self == NULL)
+  {
+    self = calloc(1, sizeof(*self));
+    if (self == NULL)
+    {
+      return NULL;
+    }
+    self->epoch = __atomic_load_n(&rpc_epoch, __ATOMIC_ACQUIRE);
+    self->next = __atomic_load_n(&rpc_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&rpc_threads, &self->next, self, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+      /* self->next was refreshed by the failed exchange */
+    }
+    rpc_self = self;
+  }
+  return self;
+}
+
+static inline int ind_ofdpa_rpc_bucket(uint64_t ns)
+{
+  int bucket;
+
+  if (ns == 0)
+  {
+    return 0;
+  }
+  bucket = 64 - __builtin_clzll(ns);
+  return (bucket < IND_OFDPA_RPC_HIST_BUCKETS) ? bucket : (IND_OFDPA_RPC_HIST_BUCKETS - 1);
+}
+
+void ind_ofdpa_rpc_record(ind_ofdpa_rpc_id_t id, OFDPA_ERROR_t rv, uint64_t elapsed_ns)
+{
+  ind_ofdpa_rpc_thread_t *self = ind_ofdpa_rpc_self_get();
+  ind_ofdpa_rpc_counters_t *c;
+  uint32_t epoch;
+
+  if ((self == NULL) || (id >= IND_OFDPA_RPC_COUNT))
+  {
+    return;
+  }
+
+  epoch = __atomic_load_n(&rpc_epoch, __ATOMIC_ACQUIRE);
+  if (self->epoch != epoch)
+  {
+    memset(self->api, 0, sizeof(self->api));
+    __atomic_store_n(&self->epoch, epoch, __ATOMIC_RELEASE);
+  }
+
+  c = &self->api[id];
+  RPC_ADD(&c->calls, 1);
+  RPC_ADD(&c->total_ns, elapsed_ns);
+  if (elapsed_ns > RPC_LOAD(&c->max_ns))
+  {
+    RPC_STORE(&c->max_ns, elapsed_ns);
+  }
+  RPC_ADD(&c->hist[ind_ofdpa_rpc_bucket(elapsed_ns)], 1);
+
+  if (rv != OFDPA_E_NONE)
+  {
+    int slot = -(int)rv;
+
+    if ((slot <= 0) || (slot >= IND_OFDPA_RPC_ERR_SLOTS))
+    {
+      slot = 0;
+    }
+    RPC_ADD(&c->errors, 1);
+    RPC_ADD(&c->err_codes[slot], 1);
+  }
+}
+
+void ind_ofdpa_rpc_stats_clear(void)
+{
+  __atomic_add_fetch(&rpc_epoch, 1, __ATOMIC_RELEASE);
+}
+
+const char *ind_ofdpa_rpc_error_name(OFDPA_ERROR_t rv)
+{
+  switch (rv)
+  {
+    case OFDPA_E_NONE:      return "NONE";
+    case OFDPA_E_RPC:       return "RPC";
+    case OFDPA_E_INTERNAL:  return "INTERNAL";
+    case OFDPA_E_PARAM:     return "PARAM";
+    case OFDPA_E_ERROR:     return "ERROR";
+    case OFDPA_E_FULL:      return "FULL";
+    case OFDPA_E_EXISTS:    return "EXISTS";
+    case OFDPA_E_TIMEOUT:   return "TIMEOUT";
+    case OFDPA_E_FAIL:      return "FAIL";
+    case OFDPA_E_DISABLED:  return "DISABLED";
+    case OFDPA_E_UNAVAIL:   return "UNAVAIL";
+    case OFDPA_E_NOT_FOUND: return "NOT_FOUND";
+    case OFDPA_E_EMPTY:     return "EMPTY";
+    default:                return "OTHER";
+  }
+}
+
+static void ind_ofdpa_rpc_aggregate(ind_ofdpa_rpc_counters_t *sum)
+{
+  ind_ofdpa_rpc_thread_t *t;
+  uint32_t epoch = __atomic_load_n(&rpc_epoch, __ATOMIC_ACQUIRE);
+  int i, j;
+
+  memset(sum, 0, sizeof(*sum) * IND_OFDPA_RPC_COUNT);
+
+  for (t = __atomic_load_n(&rpc_threads, __ATOMIC_ACQUIRE); t != NULL; t = t->next)
+  {
+    if (__atomic_load_n(&t->epoch, __ATOMIC_ACQUIRE) != epoch)
+    {
+      continue;
+    }
+    for (i = 0; i < IND_OFDPA_RPC_COUNT; i++)
+    {
+      ind_ofdpa_rpc_counters_t *c = &t->api[i];
+      uint64_t max_ns = RPC_LOAD(&c->max_ns);
+
+      sum[i].calls    += RPC_LOAD(&c->calls);
+      sum[i].errors   += RPC_LOAD(&c->errors);
+      sum[i].total_ns += RPC_LOAD(&c->total_ns);
+      if (max_ns > sum[i].max_ns)
+      {
+        sum[i].max_ns = max_ns;
+      }
+      for (j = 0; j < IND_OFDPA_RPC_ERR_SLOTS; j++)
+      {
+        sum[i].err_codes[j] += RPC_LOAD(&c->err_codes[j]);
+      }
+      for (j = 0; j < IND_OFDPA_RPC_HIST_BUCKETS; j++)
+      {
+        sum[i].hist[j] += RPC_LOAD(&c->hist[j]);
+      }
+    }
+  }
+}
+
+void ind_ofdpa_rpc_stats_show(aim_pvs_t *pvs)
+{
+  ind_ofdpa_rpc_counters_t *sum;
+  int i, j;
+
+  sum = calloc(IND_OFDPA_RPC_COUNT, sizeof(*sum));
+  if (sum == NULL)
+  {
+    return;
+  }
+  ind_ofdpa_rpc_aggregate(sum);
+
+  aim_printf(pvs, "%-28s %12s %10s %10s %10s\n", "API", "calls", "errors", "avg_us", "max_us");
+  for (i = 0; i < IND_OFDPA_RPC_COUNT; i++)
+  {
+    if (sum[i].calls == 0)
+    {
+      continue;
+    }
+    aim_printf(pvs, "%-28s %12llu %10llu %10.1f %10.1f\n", rpc_names[i],
+               (unsigned long long)sum[i].calls, (unsigned long long)sum[i].errors,
+               (double)sum[i].total_ns / sum[i].calls / 1000.0,
+               (double)sum[i].max_ns / 1000.0);
+
+    if (sum[i].errors != 0)
+    {
+      aim_printf(pvs, "    errors:");
+      for (j = 0; j < IND_OFDPA_RPC_ERR_SLOTS; j++)
+      {
+        if (sum[i].err_codes[j] != 0)
+        {
+          aim_printf(pvs, " %s(%d)=%llu",
+                     (j != 0) ? ind_ofdpa_rpc_error_name((OFDPA_ERROR_t)-j) : "OTHER", -j,
+                     (unsigned long long)sum[i].err_codes[j]);
+        }
+      }
+      aim_printf(pvs, "\n");
+    }
+
+    aim_printf(pvs, "    latency:");
+    for (j = 0; j < IND_OFDPA_RPC_HIST_BUCKETS; j++)
+    {
+      if (sum[i].hist[j] == 0)
+      {
+        continue;
+      }
+      if (j == IND_OFDPA_RPC_HIST_BUCKETS - 1)
+      {
+        aim_printf(pvs, " >=%lluns=%llu", 1ULL << (j - 1), (unsigned long long)sum[i].hist[j]);
+      }
+      else
+      {
+        aim_printf(pvs, " <%lluns=%llu", 1ULL << j, (unsigned long long)sum[i].hist[j]);
+      }
+    }
+    aim_printf(pvs, "\n");
+  }
+
+  free(sum);
+}
+
+int ind_ofdpa_rpc_trace_start(const char *path)
+{
+  return ind_ofdpa_trace_start(path, rpc_names, IND_OFDPA_RPC_COUNT);
+}
+
+void ind_ofdpa_rpc_trace_stop(void)
+{
+  ind_ofdpa_trace_stop();
+}
+
+void ind_ofdpa_rpc_trace_show(aim_pvs_t *pvs)
+{
+  ind_ofdpa_trace_status_t status;
+
+  ind_ofdpa_trace_status_get(&status);
+  if (status.path[0] == '\0')
+  {
+    aim_printf(pvs, "Not recording\n");
+    return;
+  }
+  aim_printf(pvs, "%s %s\n", status.active ? "Recording to" : "Stopped recording to", status.path);
+  aim_printf(pvs, "  records:      %llu\n", (unsigned long long)status.records);
+  aim_printf(pvs, "  bytes:        %llu\n", (unsigned long long)status.bytes);
+  aim_printf(pvs, "  truncated:    %llu\n", (unsigned long long)status.truncated);
+  aim_printf(pvs, "  write errors: %llu\n", (unsigned long long)status.write_errors);
+}
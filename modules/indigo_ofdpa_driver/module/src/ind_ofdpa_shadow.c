@@ -0,0 +1,605 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_shadow.c
+*
+* @purpose      Memory-mapped shadow of the flows and groups programmed
+*               in OF-DPA
+*
+* @component    OF-DPA
+*
+* @comments     The file is a header page followed by fixed size record
+*               slots. Only the slots live in the mapping; the index
+*               from type and key to slot, the free slot list and the
+*               per-record meta are rebuilt in memory on load. A record
+*               carries a sequence number, so if a crash leaves both
+*               the old and the new copy of a record the newer wins.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#define _GNU_SOURCE             /* mremap */
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+
+#define IND_OFDPA_SHADOW_MAGIC      0x4f465348    /* "OFSH" */
+#define IND_OFDPA_SHADOW_VERSION    1
+#define IND_OFDPA_SHADOW_HDR_SIZE   4096
+#define IND_OFDPA_SHADOW_DATA_MAX   sizeof(ofdpaFlowEntry_t)
+#define IND_OFDPA_SHADOW_TYPES      3
+
+#define IND_OFDPA_SHADOW_FREE       0
+#define IND_OFDPA_SHADOW_NIL        0xFFFFFFFF
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t hdr_size;
+  uint32_t rec_size;
+  uint32_t data_max;
+  uint32_t capacity;            /* record slots following the header */
+  uint32_t reserved[3];
+} ind_ofdpa_shadow_hdr_t;
+
+typedef struct
+{
+  uint32_t type;                /* FREE until the rest is written */
+  uint32_t check;               /* FNV-1a from seq to the end of the data */
+  uint64_t seq;
+  uint64_t key;
+  uint32_t len;
+  uint32_t reserved;
+  uint8_t  data[IND_OFDPA_SHADOW_DATA_MAX];
+} ind_ofdpa_shadow_rec_t;
+
+typedef struct
+{
+  uint64_t loaded;
+  uint64_t dropped_check;       /* records failing their check on load */
+  uint64_t dropped_dup;         /* older copies left by a crash */
+  uint64_t puts;
+  uint64_t deletes;
+  uint64_t grows;
+  uint64_t errors;
+} ind_ofdpa_shadow_stats_t;
+
+static int shadow_open;
+static int shadow_fd = -1;
+static char shadow_path[256];
+static uint8_t *shadow_map;
+static size_t shadow_map_size;
+static uint32_t shadow_capacity;
+static uint64_t shadow_seq;
+static ind_ofdpa_shadow_stats_t shadow_stats;
+
+static uint32_t *slot_next;                 /* hash chain, or free list */
+static ind_ofdpa_shadow_meta_t *slot_meta;
+static uint32_t *hash_head;
+static uint32_t hash_size;
+static uint32_t free_head = IND_OFDPA_SHADOW_NIL;
+static uint32_t type_count[IND_OFDPA_SHADOW_TYPES];
+
+static size_t ind_ofdpa_shadow_map_size(uint32_t capacity)
+{
+  return IND_OFDPA_SHADOW_HDR_SIZE + ((size_t)capacity * sizeof(ind_ofdpa_shadow_rec_t));
+}
+
+static ind_ofdpa_shadow_rec_t *ind_ofdpa_shadow_rec(uint32_t slot)
+{
+  return (ind_ofdpa_shadow_rec_t *)(shadow_map + IND_OFDPA_SHADOW_HDR_SIZE) + slot;
+}
+
+static uint32_t ind_ofdpa_shadow_check(const ind_ofdpa_shadow_rec_t *rec)
+{
+  const uint8_t *p = (const uint8_t *)&rec->seq;
+  const uint8_t *end = &rec->data[rec->len];
+  uint32_t h = 2166136261u;
+
+  while (p < end)
+  {
+    h = (h ^ *p++) * 16777619u;
+  }
+  return h;
+}
+
+static uint32_t ind_ofdpa_shadow_hash(ind_ofdpa_shadow_type_t type, uint64_t key)
+{
+  key ^= (uint64_t)type << 56;
+  return (uint32_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (hash_size - 1);
+}
+
+/* Slot of a record and the chain link pointing at it */
+static uint32_t ind_ofdpa_shadow_find(ind_ofdpa_shadow_type_t type, uint64_t key, uint32_t **link)
+{
+  ind_ofdpa_shadow_rec_t *rec;
+  uint32_t *prev;
+
+  for (prev = &hash_head[ind_ofdpa_shadow_hash(type, key)];
+       *prev != IND_OFDPA_SHADOW_NIL; prev = &slot_next[*prev])
+  {
+    rec = ind_ofdpa_shadow_rec(*prev);
+    if ((rec->key == key) && (rec->type == type))
+    {
+      if (link != NULL)
+      {
+        *link = prev;
+      }
+      return *prev;
+    }
+  }
+  return IND_OFDPA_SHADOW_NIL;
+}
+
+static void ind_ofdpa_shadow_link(uint32_t slot)
+{
+  ind_ofdpa_shadow_rec_t *rec = ind_ofdpa_shadow_rec(slot);
+  uint32_t bucket = ind_ofdpa_shadow_hash(rec->type, rec->key);
+
+  slot_next[slot] = hash_head[bucket];
+  hash_head[bucket] = slot;
+}
+
+static void ind_ofdpa_shadow_slot_free(uint32_t slot)
+{
+  __atomic_store_n(&ind_ofdpa_shadow_rec(slot)->type, IND_OFDPA_SHADOW_FREE, __ATOMIC_RELEASE);
+  slot_next[slot] = free_head;
+  free_head = slot;
+}
+
+static indigo_error_t ind_ofdpa_shadow_index_alloc(uint32_t capacity)
+{
+  uint32_t *next;
+  ind_ofdpa_shadow_meta_t *meta;
+  uint32_t size = IND_OFDPA_SHADOW_MIN_RECORDS;
+  uint32_t i;
+
+  while (size < capacity)
+  {
+    size *= 2;
+  }
+
+  next = realloc(slot_next, capacity * sizeof(*slot_next));
+  if (next == NULL)
+  {
+    return INDIGO_ERROR_RESOURCE;
+  }
+  slot_next = next;
+  meta = realloc(slot_meta, capacity * sizeof(*slot_meta));
+  if (meta == NULL)
+  {
+    return INDIGO_ERROR_RESOURCE;
+  }
+  slot_meta = meta;
+  memset(&slot_meta[shadow_capacity], 0,
+         (capacity - shadow_capacity) * sizeof(*slot_meta));
+
+  free(hash_head);
+  hash_head = malloc(size * sizeof(*hash_head));
+  if (hash_head == NULL)
+  {
+    hash_size = 0;
+    return INDIGO_ERROR_RESOURCE;
+  }
+  hash_size = size;
+  for (i = 0; i < size; i++)
+  {
+    hash_head[i] = IND_OFDPA_SHADOW_NIL;
+  }
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Double the slots. The mapping may move. */
+static indigo_error_t ind_ofdpa_shadow_grow(void)
+{
+  uint32_t capacity = shadow_capacity * 2;
+  size_t size = ind_ofdpa_shadow_map_size(capacity);
+  void *map;
+  uint32_t i;
+
+  if ((shadow_fd >= 0) && (ftruncate(shadow_fd, size) < 0))
+  {
+    LOG_ERROR("Failed to grow shadow file %s: %s", shadow_path, strerror(errno));
+    return INDIGO_ERROR_RESOURCE;
+  }
+  map = mremap(shadow_map, shadow_map_size, size, MREMAP_MAYMOVE);
+  if (map == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to remap shadow to %u records: %s", capacity, strerror(errno));
+    return INDIGO_ERROR_RESOURCE;
+  }
+  shadow_map = map;
+  shadow_map_size = size;
+
+  if (ind_ofdpa_shadow_index_alloc(capacity) != INDIGO_ERROR_NONE)
+  {
+    /* Everything written so far is in the slots; stop shadowing */
+    LOG_ERROR("Failed to grow shadow index to %u records, shadow closed", capacity);
+    ind_ofdpa_shadow_close();
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  for (i = capacity - 1; i >= shadow_capacity; i--)
+  {
+    slot_next[i] = free_head;
+    free_head = i;
+  }
+  for (i = 0; i < shadow_capacity; i++)
+  {
+    if (ind_ofdpa_shadow_rec(i)->type != IND_OFDPA_SHADOW_FREE)
+    {
+      ind_ofdpa_shadow_link(i);
+    }
+  }
+  shadow_capacity = capacity;
+  ((ind_ofdpa_shadow_hdr_t *)shadow_map)->capacity = capacity;
+  shadow_stats.grows++;
+
+  return INDIGO_ERROR_NONE;
+}
+
+/* Index the records found in the slots, dropping bad and stale copies */
+static void ind_ofdpa_shadow_load(void)
+{
+  ind_ofdpa_shadow_rec_t *rec;
+  ind_ofdpa_shadow_rec_t *other;
+  uint32_t *link;
+  uint32_t dup;
+  uint32_t i;
+
+  for (i = shadow_capacity; i-- > 0; )
+  {
+    rec = ind_ofdpa_shadow_rec(i);
+    if (rec->type == IND_OFDPA_SHADOW_FREE)
+    {
+      ind_ofdpa_shadow_slot_free(i);
+      continue;
+    }
+    if ((rec->type >= IND_OFDPA_SHADOW_TYPES) || (rec->len > IND_OFDPA_SHADOW_DATA_MAX) ||
+        (rec->check != ind_ofdpa_shadow_check(rec)))
+    {
+      shadow_stats.dropped_check++;
+      ind_ofdpa_shadow_slot_free(i);
+      continue;
+    }
+
+    dup = ind_ofdpa_shadow_find(rec->type, rec->key, &link);
+    if (dup != IND_OFDPA_SHADOW_NIL)
+    {
+      other = ind_ofdpa_shadow_rec(dup);
+      shadow_stats.dropped_dup++;
+      if (other->seq > rec->seq)
+      {
+        ind_ofdpa_shadow_slot_free(i);
+        continue;
+      }
+      *link = slot_next[dup];
+      type_count[other->type]--;
+      ind_ofdpa_shadow_slot_free(dup);
+    }
+
+    ind_ofdpa_shadow_link(i);
+    type_count[rec->type]++;
+    if (rec->seq > shadow_seq)
+    {
+      shadow_seq = rec->seq;
+    }
+  }
+
+  shadow_stats.loaded = type_count[IND_OFDPA_SHADOW_FLOW] + type_count[IND_OFDPA_SHADOW_GROUP];
+}
+
+indigo_error_t ind_ofdpa_shadow_open(const char *path)
+{
+  ind_ofdpa_shadow_hdr_t hdr;
+  struct stat st;
+  uint32_t capacity = IND_OFDPA_SHADOW_MIN_RECORDS;
+  int fresh = 1;
+  int flags = MAP_SHARED;
+  indigo_error_t err;
+
+  ind_ofdpa_shadow_close();
+  memset(&shadow_stats, 0, sizeof(shadow_stats));
+  shadow_path[0] = '\0';
+
+  if (path != NULL)
+  {
+    strncpy(shadow_path, path, sizeof(shadow_path) - 1);
+    shadow_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if ((shadow_fd < 0) || (fstat(shadow_fd, &st) < 0))
+    {
+      LOG_ERROR("Failed to open shadow file %s: %s", path, strerror(errno));
+      ind_ofdpa_shadow_close();
+      return INDIGO_ERROR_UNKNOWN;
+    }
+
+    if ((st.st_size >= (off_t)sizeof(hdr)) &&
+        (pread(shadow_fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr)) &&
+        (hdr.magic == IND_OFDPA_SHADOW_MAGIC) &&
+        (hdr.version == IND_OFDPA_SHADOW_VERSION) &&
+        (hdr.hdr_size == IND_OFDPA_SHADOW_HDR_SIZE) &&
+        (hdr.rec_size == sizeof(ind_ofdpa_shadow_rec_t)) &&
+        (hdr.data_max == IND_OFDPA_SHADOW_DATA_MAX) &&
+        (hdr.capacity != 0) &&
+        ((size_t)st.st_size >= ind_ofdpa_shadow_map_size(hdr.capacity)))
+    {
+      capacity = hdr.capacity;
+      fresh = 0;
+    }
+    else if (st.st_size != 0)
+    {
+      LOG_ERROR("Shadow file %s is not usable by this build, starting empty", path);
+    }
+
+    if (fresh && ((ftruncate(shadow_fd, 0) < 0) ||
+                  (ftruncate(shadow_fd, ind_ofdpa_shadow_map_size(capacity)) < 0)))
+    {
+      LOG_ERROR("Failed to size shadow file %s: %s", path, strerror(errno));
+      ind_ofdpa_shadow_close();
+      return INDIGO_ERROR_RESOURCE;
+    }
+  }
+  else
+  {
+    flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  }
+
+  shadow_map_size = ind_ofdpa_shadow_map_size(capacity);
+  shadow_map = mmap(NULL, shadow_map_size, PROT_READ | PROT_WRITE, flags, shadow_fd, 0);
+  if (shadow_map == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to map shadow: %s", strerror(errno));
+    shadow_map = NULL;
+    ind_ofdpa_shadow_close();
+    return INDIGO_ERROR_RESOURCE;
+  }
+
+  err = ind_ofdpa_shadow_index_alloc(capacity);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    LOG_ERROR("Failed to allocate shadow index for %u records", capacity);
+    ind_ofdpa_shadow_close();
+    return err;
+  }
+  shadow_capacity = capacity;
+
+  if (fresh)
+  {
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic    = IND_OFDPA_SHADOW_MAGIC;
+    hdr.version  = IND_OFDPA_SHADOW_VERSION;
+    hdr.hdr_size = IND_OFDPA_SHADOW_HDR_SIZE;
+    hdr.rec_size = sizeof(ind_ofdpa_shadow_rec_t);
+    hdr.data_max = IND_OFDPA_SHADOW_DATA_MAX;
+    hdr.capacity = capacity;
+    memcpy(shadow_map, &hdr, sizeof(hdr));
+  }
+
+  ind_ofdpa_shadow_load();
+  shadow_open = 1;
+
+  LOG_VERBOSE("Shadow %s: %u flows, %u groups loaded, %llu records dropped",
+              (path != NULL) ? path : "(memory)",
+              type_count[IND_OFDPA_SHADOW_FLOW], type_count[IND_OFDPA_SHADOW_GROUP],
+              (unsigned long long)(shadow_stats.dropped_check + shadow_stats.dropped_dup));
+
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_shadow_close(void)
+{
+  if (shadow_map != NULL)
+  {
+    if (shadow_fd >= 0)
+    {
+      (void)msync(shadow_map, shadow_map_size, MS_SYNC);
+    }
+    munmap(shadow_map, shadow_map_size);
+    shadow_map = NULL;
+  }
+  if (shadow_fd >= 0)
+  {
+    close(shadow_fd);
+    shadow_fd = -1;
+  }
+
+  free(slot_next);
+  slot_next = NULL;
+  free(slot_meta);
+  slot_meta = NULL;
+  free(hash_head);
+  hash_head = NULL;
+  hash_size = 0;
+  free_head = IND_OFDPA_SHADOW_NIL;
+  shadow_capacity = 0;
+  shadow_map_size = 0;
+  memset(type_count, 0, sizeof(type_count));
+  shadow_open = 0;
+}
+
+int ind_ofdpa_shadow_is_open(void)
+{
+  return shadow_open;
+}
+
+indigo_error_t ind_ofdpa_shadow_put(ind_ofdpa_shadow_type_t type, uint64_t key,
+                                    const void *data, uint32_t len)
+{
+  ind_ofdpa_shadow_rec_t *rec;
+  uint32_t *link;
+  uint32_t slot;
+  uint32_t old;
+
+  if (!shadow_open)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+  if (len > IND_OFDPA_SHADOW_DATA_MAX)
+  {
+    return INDIGO_ERROR_PARAM;
+  }
+
+  if ((free_head == IND_OFDPA_SHADOW_NIL) && (ind_ofdpa_shadow_grow() != INDIGO_ERROR_NONE))
+  {
+    shadow_stats.errors++;
+    return INDIGO_ERROR_RESOURCE;
+  }
+  slot = free_head;
+  free_head = slot_next[slot];
+
+  rec = ind_ofdpa_shadow_rec(slot);
+  rec->seq = ++shadow_seq;
+  rec->key = key;
+  rec->len = len;
+  rec->reserved = 0;
+  memcpy(rec->data, data, len);
+  rec->check = ind_ofdpa_shadow_check(rec);
+  __atomic_store_n(&rec->type, type, __ATOMIC_RELEASE);
+
+  old = ind_ofdpa_shadow_find(type, key, &link);
+  if (old != IND_OFDPA_SHADOW_NIL)
+  {
+    slot_meta[slot] = slot_meta[old];
+    slot_next[slot] = slot_next[old];
+    *link = slot;
+    ind_ofdpa_shadow_slot_free(old);
+  }
+  else
+  {
+    memset(&slot_meta[slot], 0, sizeof(slot_meta[slot]));
+    ind_ofdpa_shadow_link(slot);
+    type_count[type]++;
+  }
+  shadow_stats.puts++;
+
+  return INDIGO_ERROR_NONE;
+}
+
+void ind_ofdpa_shadow_delete(ind_ofdpa_shadow_type_t type, uint64_t key)
+{
+  uint32_t *link;
+  uint32_t slot;
+
+  if (!shadow_open)
+  {
+    return;
+  }
+
+  slot = ind_ofdpa_shadow_find(type, key, &link);
+  if (slot != IND_OFDPA_SHADOW_NIL)
+  {
+    *link = slot_next[slot];
+    ind_ofdpa_shadow_slot_free(slot);
+    type_count[type]--;
+    shadow_stats.deletes++;
+  }
+}
+
+int ind_ofdpa_shadow_get(ind_ofdpa_shadow_type_t type, uint64_t key, void *data, uint32_t len)
+{
+  ind_ofdpa_shadow_rec_t *rec;
+  uint32_t slot;
+
+  if (!shadow_open)
+  {
+    return 0;
+  }
+
+  slot = ind_ofdpa_shadow_find(type, key, NULL);
+  if (slot == IND_OFDPA_SHADOW_NIL)
+  {
+    return 0;
+  }
+  if (data != NULL)
+  {
+    rec = ind_ofdpa_shadow_rec(slot);
+    memcpy(data, rec->data, (rec->len < len) ? rec->len : len);
+  }
+  return 1;
+}
+
+ind_ofdpa_shadow_meta_t *ind_ofdpa_shadow_meta(ind_ofdpa_shadow_type_t type, uint64_t key)
+{
+  uint32_t slot;
+
+  if (!shadow_open)
+  {
+    return NULL;
+  }
+
+  slot = ind_ofdpa_shadow_find(type, key, NULL);
+  return (slot != IND_OFDPA_SHADOW_NIL) ? &slot_meta[slot] : NULL;
+}
+
+void ind_ofdpa_shadow_walk(ind_ofdpa_shadow_type_t type, ind_ofdpa_shadow_walk_f fn, void *cookie)
+{
+  ind_ofdpa_shadow_rec_t *rec;
+  uint32_t i;
+
+  for (i = 0; shadow_open && (i < shadow_capacity); i++)
+  {
+    rec = ind_ofdpa_shadow_rec(i);
+    if (rec->type == type)
+    {
+      fn(rec->key, rec->data, &slot_meta[i], cookie);
+    }
+  }
+}
+
+uint32_t ind_ofdpa_shadow_count(ind_ofdpa_shadow_type_t type)
+{
+  return type_count[type];
+}
+
+void ind_ofdpa_shadow_show(aim_pvs_t *pvs)
+{
+  if (!shadow_open)
+  {
+    aim_printf(pvs, "shadow closed\n");
+    return;
+  }
+
+  aim_printf(pvs, "shadow %s, %u slots of %u bytes (%llu KB mapped)\n",
+             (shadow_fd >= 0) ? shadow_path : "(memory)", shadow_capacity,
+             (uint32_t)sizeof(ind_ofdpa_shadow_rec_t),
+             (unsigned long long)(shadow_map_size / 1024));
+  aim_printf(pvs, "flows %u  groups %u  hash buckets %u\n",
+             type_count[IND_OFDPA_SHADOW_FLOW], type_count[IND_OFDPA_SHADOW_GROUP], hash_size);
+  aim_printf(pvs, "loaded %llu  dropped bad %llu  dropped stale %llu\n",
+             (unsigned long long)shadow_stats.loaded,
+             (unsigned long long)shadow_stats.dropped_check,
+             (unsigned long long)shadow_stats.dropped_dup);
+  aim_printf(pvs, "puts %llu  deletes %llu  grows %llu  errors %llu\n",
+             (unsigned long long)shadow_stats.puts,
+             (unsigned long long)shadow_stats.deletes,
+             (unsigned long long)shadow_stats.grows,
+             (unsigned long long)shadow_stats.errors);
+}
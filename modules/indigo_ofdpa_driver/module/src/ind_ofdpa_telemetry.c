@@ -0,0 +1,654 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_telemetry.c
+*
+* @purpose      Local streaming counter export for the OF-DPA agent
+*
+* @component    OF-DPA
+*
+* @comments     Each family (port, queue, table, group) runs on its own
+*               socket manager timer. A snapshot is formatted once and
+*               written to all clients with a non-blocking send. What a
+*               client's socket cannot take is kept for that client and
+*               flushed when the socket is writable again; until then it
+*               misses new snapshots, so its stream is never torn and its
+*               backlog is at most one snapshot.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <SocketManager/socketmanager.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_telemetry.h>
+
+#define IND_OFDPA_TELEMETRY_BUF_INIT 4096
+#define IND_OFDPA_TELEMETRY_BUF_MAX  (8 * 1024 * 1024)
+
+typedef struct ind_ofdpa_telemetry_buf_s
+{
+  char     *data;
+  uint32_t  len;
+  uint32_t  size;
+  int       truncated;          /* lines dropped at IND_OFDPA_TELEMETRY_BUF_MAX */
+} ind_ofdpa_telemetry_buf_t;
+
+typedef struct ind_ofdpa_telemetry_client_s
+{
+  int       fd;
+  char     *pending;            /* unsent tail of the last snapshot */
+  uint32_t  pending_len;
+  uint32_t  pending_sent;
+} ind_ofdpa_telemetry_client_t;
+
+typedef void (*ind_ofdpa_telemetry_collect_f)(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms);
+
+static void ind_ofdpa_telemetry_port_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms);
+static void ind_ofdpa_telemetry_queue_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms);
+static void ind_ofdpa_telemetry_table_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms);
+static void ind_ofdpa_telemetry_group_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms);
+
+static struct
+{
+  const char                    *name;
+  ind_ofdpa_telemetry_collect_f  collect;
+  uint32_t                       interval_ms;
+} telemetry_families[IND_OFDPA_TELEMETRY_FAMILY_COUNT] =
+{
+  [IND_OFDPA_TELEMETRY_FAMILY_PORT]  = {"port",  ind_ofdpa_telemetry_port_collect,  IND_OFDPA_TELEMETRY_PORT_MS_DEFAULT},
+  [IND_OFDPA_TELEMETRY_FAMILY_QUEUE] = {"queue", ind_ofdpa_telemetry_queue_collect, IND_OFDPA_TELEMETRY_QUEUE_MS_DEFAULT},
+  [IND_OFDPA_TELEMETRY_FAMILY_TABLE] = {"table", ind_ofdpa_telemetry_table_collect, IND_OFDPA_TELEMETRY_TABLE_MS_DEFAULT},
+  [IND_OFDPA_TELEMETRY_FAMILY_GROUP] = {"group", ind_ofdpa_telemetry_group_collect, IND_OFDPA_TELEMETRY_GROUP_MS_DEFAULT},
+};
+
+static int telemetry_listen_fd = -1;
+static ind_ofdpa_telemetry_client_t telemetry_clients[IND_OFDPA_TELEMETRY_MAX_CLIENTS];
+static int telemetry_num_clients = 0;
+static char telemetry_socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static ind_ofdpa_telemetry_buf_t telemetry_buf;
+
+static uint64_t ind_ofdpa_telemetry_now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static void ind_ofdpa_telemetry_printf(ind_ofdpa_telemetry_buf_t *buf, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  if (buf->truncated)
+  {
+    return;
+  }
+
+  while (1)
+  {
+    va_start(ap, fmt);
+    n = vsnprintf(buf->data + buf->len, buf->size - buf->len, fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+    {
+      return;
+    }
+    if ((buf->len + n) < buf->size)
+    {
+      buf->len += n;
+      return;
+    }
+
+    /* Grow and retry; the buffer is kept between snapshots */
+    {
+      uint32_t size = buf->size * 2;
+      char *data;
+
+      while (size <= (buf->len + n))
+      {
+        size *= 2;
+      }
+      if (size > IND_OFDPA_TELEMETRY_BUF_MAX)
+      {
+        /* Drop this line and the rest of the snapshot */
+        buf->data[buf->len] = '\0';
+        buf->truncated = 1;
+        return;
+      }
+      data = realloc(buf->data, size);
+      if (data == NULL)
+      {
+        LOG_ERROR("Failed to grow telemetry buffer to %u bytes.", size);
+        buf->data[buf->len] = '\0';
+        buf->truncated = 1;
+        return;
+      }
+      buf->data = data;
+      buf->size = size;
+    }
+  }
+}
+
+static void ind_ofdpa_telemetry_port_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms)
+{
+  ofdpaPortStats_t portStats;
+  uint32_t port = 0;
+
+  while (ofdpaPortNextGet(port, &port) == OFDPA_E_NONE)
+  {
+    memset(&portStats, 0, sizeof(portStats));
+    if (ofdpaPortStatsGet(port, &portStats) != OFDPA_E_NONE)
+    {
+      continue;
+    }
+    ind_ofdpa_telemetry_printf(buf,
+                               "{\"family\":\"port\",\"ts_ms\":%llu,\"port\":%u,"
+                               "\"rx_packets\":%llu,\"tx_packets\":%llu,"
+                               "\"rx_bytes\":%llu,\"tx_bytes\":%llu,"
+                               "\"rx_errors\":%llu,\"tx_errors\":%llu,"
+                               "\"rx_drops\":%llu,\"tx_drops\":%llu,"
+                               "\"rx_frame_err\":%llu,\"rx_over_err\":%llu,"
+                               "\"rx_crc_err\":%llu,\"collisions\":%llu,"
+                               "\"duration_sec\":%u}\n",
+                               (unsigned long long)ts_ms, port,
+                               (unsigned long long)portStats.rx_packets,
+                               (unsigned long long)portStats.tx_packets,
+                               (unsigned long long)portStats.rx_bytes,
+                               (unsigned long long)portStats.tx_bytes,
+                               (unsigned long long)portStats.rx_errors,
+                               (unsigned long long)portStats.tx_errors,
+                               (unsigned long long)portStats.rx_drops,
+                               (unsigned long long)portStats.tx_drops,
+                               (unsigned long long)portStats.rx_frame_err,
+                               (unsigned long long)portStats.rx_over_err,
+                               (unsigned long long)portStats.rx_crc_err,
+                               (unsigned long long)portStats.collisions,
+                               portStats.duration_seconds);
+  }
+}
+
+static void ind_ofdpa_telemetry_queue_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms)
+{
+  ofdpaPortQueueStats_t queueStats;
+  uint32_t port = 0;
+  uint32_t numQueues;
+  uint32_t queueId;
+
+  while (ofdpaPortNextGet(port, &port) == OFDPA_E_NONE)
+  {
+    if (ofdpaNumQueuesGet(port, &numQueues) != OFDPA_E_NONE)
+    {
+      continue;
+    }
+    for (queueId = 0; queueId < numQueues; queueId++)
+    {
+      memset(&queueStats, 0, sizeof(queueStats));
+      if (ofdpaQueueStatsGet(port, queueId, &queueStats) != OFDPA_E_NONE)
+      {
+        continue;
+      }
+      ind_ofdpa_telemetry_printf(buf,
+                                 "{\"family\":\"queue\",\"ts_ms\":%llu,\"port\":%u,\"queue\":%u,"
+                                 "\"tx_packets\":%llu,\"tx_bytes\":%llu,\"duration_sec\":%u}\n",
+                                 (unsigned long long)ts_ms, port, queueId,
+                                 (unsigned long long)queueStats.txPkts,
+                                 (unsigned long long)queueStats.txBytes,
+                                 queueStats.duration_seconds);
+    }
+  }
+}
+
+static void ind_ofdpa_telemetry_table_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms)
+{
+  ofdpaFlowTableInfo_t info;
+  uint32_t i;
+
+  for (i = 0; i < tableNameListSize; i++)
+  {
+    memset(&info, 0, sizeof(info));
+    if (ofdpaFlowTableInfoGet(tableNameList[i].type, &info) != OFDPA_E_NONE)
+    {
+      continue;
+    }
+    ind_ofdpa_telemetry_printf(buf,
+                               "{\"family\":\"table\",\"ts_ms\":%llu,\"table_id\":%u,"
+                               "\"name\":\"%s\",\"entries\":%u,\"max_entries\":%u}\n",
+                               (unsigned long long)ts_ms, tableNameList[i].type,
+                               tableNameList[i].name, info.numEntries, info.maxEntries);
+  }
+}
+
+static void ind_ofdpa_telemetry_group_collect(ind_ofdpa_telemetry_buf_t *buf, uint64_t ts_ms)
+{
+  ofdpaGroupEntry_t groupEntry;
+  ofdpaGroupEntryStats_t groupStats;
+  OFDPA_ERROR_t ofdpa_rv;
+
+  memset(&groupEntry, 0, sizeof(groupEntry));
+
+  /* Group id 0 is a valid entry, so try it before walking */
+  ofdpa_rv = ofdpaGroupStatsGet(groupEntry.groupId, &groupStats);
+  if (ofdpa_rv != OFDPA_E_NONE)
+  {
+    ofdpa_rv = ofdpaGroupNextGet(groupEntry.groupId, &groupEntry);
+    if (ofdpa_rv == OFDPA_E_NONE)
+    {
+      ofdpa_rv = ofdpaGroupStatsGet(groupEntry.groupId, &groupStats);
+    }
+  }
+
+  while (ofdpa_rv == OFDPA_E_NONE)
+  {
+    ind_ofdpa_telemetry_printf(buf,
+                               "{\"family\":\"group\",\"ts_ms\":%llu,\"group_id\":%u,"
+                               "\"ref_count\":%u,\"duration_sec\":%u}\n",
+                               (unsigned long long)ts_ms, groupEntry.groupId,
+                               groupStats.refCount, groupStats.duration);
+
+    ofdpa_rv = ofdpaGroupNextGet(groupEntry.groupId, &groupEntry);
+    if (ofdpa_rv == OFDPA_E_NONE)
+    {
+      ofdpa_rv = ofdpaGroupStatsGet(groupEntry.groupId, &groupStats);
+    }
+  }
+}
+
+static int ind_ofdpa_telemetry_client_find(int fd)
+{
+  int i;
+
+  for (i = 0; i < telemetry_num_clients; i++)
+  {
+    if (telemetry_clients[i].fd == fd)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void ind_ofdpa_telemetry_client_remove(int index)
+{
+  int fd = telemetry_clients[index].fd;
+
+  ind_soc_socket_unregister(fd);
+  close(fd);
+  free(telemetry_clients[index].pending);
+
+  telemetry_num_clients--;
+  telemetry_clients[index] = telemetry_clients[telemetry_num_clients];
+
+  LOG_VERBOSE("Telemetry client on fd %d removed, %d remaining.", fd, telemetry_num_clients);
+}
+
+/* Keep what the socket did not take, to be sent when it is writable */
+static int ind_ofdpa_telemetry_client_hold(ind_ofdpa_telemetry_client_t *client,
+                                           const char *data, uint32_t len)
+{
+  client->pending = malloc(len);
+  if (client->pending == NULL)
+  {
+    LOG_ERROR("Failed to hold %u telemetry bytes for fd %d.", len, client->fd);
+    return -1;
+  }
+  memcpy(client->pending, data, len);
+  client->pending_len = len;
+  client->pending_sent = 0;
+
+  if (ind_soc_data_out_ready(client->fd) < 0)
+  {
+    LOG_ERROR("Failed to wait for telemetry client fd %d to be writable.", client->fd);
+    return -1;
+  }
+  return 0;
+}
+
+/* Send the rest of the held snapshot; -1 if the client is gone */
+static int ind_ofdpa_telemetry_client_flush(ind_ofdpa_telemetry_client_t *client)
+{
+  ssize_t n;
+
+  while (client->pending_sent < client->pending_len)
+  {
+    n = send(client->fd, client->pending + client->pending_sent,
+             client->pending_len - client->pending_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0)
+    {
+      return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+    }
+    client->pending_sent += n;
+  }
+
+  free(client->pending);
+  client->pending = NULL;
+  client->pending_len = 0;
+  client->pending_sent = 0;
+  (void)ind_soc_data_out_clear(client->fd);
+  return 0;
+}
+
+static void ind_ofdpa_telemetry_publish(const ind_ofdpa_telemetry_buf_t *buf)
+{
+  ind_ofdpa_telemetry_client_t *client;
+  ssize_t n;
+  int i = 0;
+
+  while (i < telemetry_num_clients)
+  {
+    client = &telemetry_clients[i];
+    if (client->pending != NULL)
+    {
+      /* Still sending the previous snapshot; this one is skipped */
+      LOG_TRACE("Telemetry client on fd %d busy, snapshot dropped.", client->fd);
+      i++;
+      continue;
+    }
+
+    n = send(client->fd, buf->data, buf->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+    {
+      n = 0;
+    }
+    if ((n >= 0) && (n < (ssize_t)buf->len) &&
+        (ind_ofdpa_telemetry_client_hold(client, buf->data + n, buf->len - n) < 0))
+    {
+      n = -1;
+    }
+    if (n < 0)
+    {
+      LOG_VERBOSE("Telemetry client on fd %d gone (n = %zd).", client->fd, n);
+      ind_ofdpa_telemetry_client_remove(i);
+      continue;
+    }
+    i++;
+  }
+}
+
+static void ind_ofdpa_telemetry_timer(void *cookie)
+{
+  ind_ofdpa_telemetry_family_t family = (ind_ofdpa_telemetry_family_t)(uintptr_t)cookie;
+
+  if (telemetry_num_clients == 0)
+  {
+    return;
+  }
+
+  telemetry_buf.len = 0;
+  telemetry_buf.truncated = 0;
+  telemetry_families[family].collect(&telemetry_buf, ind_ofdpa_telemetry_now_ms());
+  if (telemetry_buf.truncated)
+  {
+    LOG_ERROR("%s telemetry snapshot cut at %u bytes.", telemetry_families[family].name,
+              telemetry_buf.len);
+  }
+  if (telemetry_buf.len != 0)
+  {
+    ind_ofdpa_telemetry_publish(&telemetry_buf);
+  }
+}
+
+static void ind_ofdpa_telemetry_client_ready(int socket_id, void *cookie, int read_ready,
+                                             int write_ready, int error_seen)
+{
+  char scratch[256];
+  ssize_t n;
+  int i;
+
+  i = ind_ofdpa_telemetry_client_find(socket_id);
+  if (i < 0)
+  {
+    return;
+  }
+
+  if (write_ready && !error_seen && (ind_ofdpa_telemetry_client_flush(&telemetry_clients[i]) < 0))
+  {
+    ind_ofdpa_telemetry_client_remove(i);
+    return;
+  }
+  if (!read_ready && !error_seen)
+  {
+    return;
+  }
+
+  /* Clients never send anything; readable means closed or junk */
+  n = read(socket_id, scratch, sizeof(scratch));
+  if (!error_seen && ((n > 0) || ((n < 0) && (errno == EAGAIN))))
+  {
+    return;
+  }
+  ind_ofdpa_telemetry_client_remove(i);
+}
+
+static void ind_ofdpa_telemetry_listen_ready(int socket_id, void *cookie, int read_ready,
+                                             int write_ready, int error_seen)
+{
+  int fd;
+
+  if (error_seen)
+  {
+    LOG_ERROR("Error seen on telemetry socket");
+    return;
+  }
+
+  fd = accept(socket_id, NULL, NULL);
+  if (fd < 0)
+  {
+    if (errno != EAGAIN)
+    {
+      LOG_ERROR("Failed to accept telemetry client: %s", strerror(errno));
+    }
+    return;
+  }
+
+  if (telemetry_num_clients >= IND_OFDPA_TELEMETRY_MAX_CLIENTS)
+  {
+    LOG_ERROR("Too many telemetry clients, rejecting fd %d.", fd);
+    close(fd);
+    return;
+  }
+
+  (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  if (ind_soc_socket_register(fd, ind_ofdpa_telemetry_client_ready, NULL) < 0)
+  {
+    LOG_ERROR("Failed to register telemetry client fd %d.", fd);
+    close(fd);
+    return;
+  }
+
+  memset(&telemetry_clients[telemetry_num_clients], 0, sizeof(telemetry_clients[0]));
+  telemetry_clients[telemetry_num_clients++].fd = fd;
+  LOG_VERBOSE("Telemetry client connected on fd %d.", fd);
+}
+
+indigo_error_t ind_ofdpa_telemetry_family_parse(const char *name,
+                                                ind_ofdpa_telemetry_family_t *family)
+{
+  int i;
+
+  for (i = 0; i < IND_OFDPA_TELEMETRY_FAMILY_COUNT; i++)
+  {
+    if (strcmp(name, telemetry_families[i].name) == 0)
+    {
+      *family = i;
+      return INDIGO_ERROR_NONE;
+    }
+  }
+  return INDIGO_ERROR_NOT_FOUND;
+}
+
+indigo_error_t ind_ofdpa_telemetry_interval_set(ind_ofdpa_telemetry_family_t family,
+                                                uint32_t interval_ms)
+{
+  void *cookie = (void *)(uintptr_t)family;
+
+  if (family >= IND_OFDPA_TELEMETRY_FAMILY_COUNT)
+  {
+    return INDIGO_ERROR_PARAM;
+  }
+
+  if (telemetry_listen_fd >= 0)
+  {
+    if (telemetry_families[family].interval_ms != 0)
+    {
+      ind_soc_timer_event_unregister(ind_ofdpa_telemetry_timer, cookie);
+    }
+    if ((interval_ms != 0) &&
+        (ind_soc_timer_event_register(ind_ofdpa_telemetry_timer, cookie, interval_ms) < 0))
+    {
+      LOG_ERROR("Failed to register %s telemetry timer.", telemetry_families[family].name);
+      telemetry_families[family].interval_ms = 0;
+      return INDIGO_ERROR_RESOURCE;
+    }
+  }
+
+  telemetry_families[family].interval_ms = interval_ms;
+  return INDIGO_ERROR_NONE;
+}
+
+indigo_error_t ind_ofdpa_telemetry_init(const char *socket_path)
+{
+  struct sockaddr_un addr;
+  int fd;
+  int i;
+
+  if (telemetry_listen_fd >= 0)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  if (socket_path == NULL)
+  {
+    socket_path = IND_OFDPA_TELEMETRY_SOCKET_DEFAULT;
+  }
+  if (strlen(socket_path) >= sizeof(addr.sun_path))
+  {
+    LOG_ERROR("Telemetry socket path \"%s\" too long.", socket_path);
+    return INDIGO_ERROR_PARAM;
+  }
+
+  telemetry_buf.data = malloc(IND_OFDPA_TELEMETRY_BUF_INIT);
+  if (telemetry_buf.data == NULL)
+  {
+    return INDIGO_ERROR_RESOURCE;
+  }
+  telemetry_buf.size = IND_OFDPA_TELEMETRY_BUF_INIT;
+  telemetry_buf.len = 0;
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+  {
+    LOG_ERROR("Failed to create telemetry socket: %s", strerror(errno));
+    goto fail;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+  /* A stale socket file from a previous run would make bind fail */
+  (void)unlink(addr.sun_path);
+
+  if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+      (listen(fd, IND_OFDPA_TELEMETRY_MAX_CLIENTS) < 0))
+  {
+    LOG_ERROR("Failed to listen on telemetry socket %s: %s", addr.sun_path, strerror(errno));
+    close(fd);
+    goto fail;
+  }
+
+  if (ind_soc_socket_register(fd, ind_ofdpa_telemetry_listen_ready, NULL) < 0)
+  {
+    LOG_ERROR("Failed to register telemetry socket.");
+    close(fd);
+    (void)unlink(addr.sun_path);
+    goto fail;
+  }
+
+  telemetry_listen_fd = fd;
+  strncpy(telemetry_socket_path, addr.sun_path, sizeof(telemetry_socket_path) - 1);
+
+  for (i = 0; i < IND_OFDPA_TELEMETRY_FAMILY_COUNT; i++)
+  {
+    if ((telemetry_families[i].interval_ms != 0) &&
+        (ind_soc_timer_event_register(ind_ofdpa_telemetry_timer, (void *)(uintptr_t)i,
+                                      telemetry_families[i].interval_ms) < 0))
+    {
+      LOG_ERROR("Failed to register %s telemetry timer.", telemetry_families[i].name);
+      telemetry_families[i].interval_ms = 0;
+    }
+  }
+
+  LOG_VERBOSE("Telemetry export listening on %s.", telemetry_socket_path);
+  return INDIGO_ERROR_NONE;
+
+fail:
+  free(telemetry_buf.data);
+  telemetry_buf.data = NULL;
+  telemetry_buf.size = 0;
+  return INDIGO_ERROR_UNKNOWN;
+}
+
+void ind_ofdpa_telemetry_finish(void)
+{
+  int i;
+
+  if (telemetry_listen_fd < 0)
+  {
+    return;
+  }
+
+  for (i = 0; i < IND_OFDPA_TELEMETRY_FAMILY_COUNT; i++)
+  {
+    if (telemetry_families[i].interval_ms != 0)
+    {
+      ind_soc_timer_event_unregister(ind_ofdpa_telemetry_timer, (void *)(uintptr_t)i);
+    }
+  }
+
+  while (telemetry_num_clients > 0)
+  {
+    ind_ofdpa_telemetry_client_remove(telemetry_num_clients - 1);
+  }
+
+  ind_soc_socket_unregister(telemetry_listen_fd);
+  close(telemetry_listen_fd);
+  telemetry_listen_fd = -1;
+  (void)unlink(telemetry_socket_path);
+
+  free(telemetry_buf.data);
+  telemetry_buf.data = NULL;
+  telemetry_buf.size = 0;
+}
@@ -0,0 +1,220 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_trace.c
+*
+* @purpose      Recorder for the libofdpa call trace
+*
+* @component    OF-DPA
+*
+* @comments     Each calling thread builds its record in a buffer of its
+*               own; only the write to the file is serialized. Records
+*               go through a large stdio buffer, so the tail of a trace
+*               is on disk only once recording is stopped.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_trace.h>
+
+#define IND_OFDPA_TRACE_FILE_BUFFER  (1024 * 1024)
+
+int ind_ofdpa_trace_enabled = 0;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *trace_file = NULL;
+static char *trace_file_buffer = NULL;
+static uint64_t trace_start_ns;
+static uint16_t trace_threads;
+static ind_ofdpa_trace_status_t trace_status;
+
+static __thread ind_ofdpa_trace_buf_t *trace_self = NULL;
+
+static uint64_t ind_ofdpa_trace_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void ind_ofdpa_trace_close_locked(void)
+{
+  if (trace_file != NULL)
+  {
+    if (fclose(trace_file) != 0)
+    {
+      trace_status.write_errors++;
+    }
+    trace_file = NULL;
+  }
+  free(trace_file_buffer);
+  trace_file_buffer = NULL;
+}
+
+int ind_ofdpa_trace_start(const char *path, const char * const *names, uint16_t num_names)
+{
+  ind_ofdpa_trace_file_hdr_t hdr;
+  uint16_t i;
+  int rc = 0;
+
+  pthread_mutex_lock(&trace_lock);
+
+  __atomic_store_n(&ind_ofdpa_trace_enabled, 0, __ATOMIC_RELEASE);
+  ind_ofdpa_trace_close_locked();
+  memset(&trace_status, 0, sizeof(trace_status));
+
+  trace_file = fopen(path, "wb");
+  if (trace_file == NULL)
+  {
+    LOG_ERROR("Failed to open trace file %s", path);
+    pthread_mutex_unlock(&trace_lock);
+    return -1;
+  }
+  trace_file_buffer = malloc(IND_OFDPA_TRACE_FILE_BUFFER);
+  if (trace_file_buffer != NULL)
+  {
+    setvbuf(trace_file, trace_file_buffer, _IOFBF, IND_OFDPA_TRACE_FILE_BUFFER);
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic             = IND_OFDPA_TRACE_MAGIC;
+  hdr.version           = IND_OFDPA_TRACE_VERSION;
+  hdr.num_apis          = num_names;
+  hdr.start_sec         = (uint64_t)time(NULL);
+  hdr.flow_entry_size   = sizeof(ofdpaFlowEntry_t);
+  hdr.group_entry_size  = sizeof(ofdpaGroupEntry_t);
+  hdr.bucket_entry_size = sizeof(ofdpaGroupBucketEntry_t);
+  hdr.meter_entry_size  = sizeof(ofdpaMeterEntry_t);
+  hdr.flow_event_size   = sizeof(ofdpaFlowEvent_t);
+  hdr.port_event_size   = sizeof(ofdpaPortEvent_t);
+
+  if (fwrite(&hdr, sizeof(hdr), 1, trace_file) != 1)
+  {
+    rc = -1;
+  }
+  for (i = 0; (i < num_names) && (rc == 0); i++)
+  {
+    if (fwrite(names[i], strlen(names[i]) + 1, 1, trace_file) != 1)
+    {
+      rc = -1;
+    }
+  }
+
+  if (rc != 0)
+  {
+    LOG_ERROR("Failed to write trace file %s", path);
+    ind_ofdpa_trace_close_locked();
+  }
+  else
+  {
+    strncpy(trace_status.path, path, sizeof(trace_status.path) - 1);
+    trace_start_ns = ind_ofdpa_trace_now_ns();
+    trace_status.active = 1;
+    __atomic_store_n(&ind_ofdpa_trace_enabled, 1, __ATOMIC_RELEASE);
+    LOG_VERBOSE("Recording libofdpa calls to %s", path);
+  }
+
+  pthread_mutex_unlock(&trace_lock);
+  return rc;
+}
+
+void ind_ofdpa_trace_stop(void)
+{
+  pthread_mutex_lock(&trace_lock);
+  __atomic_store_n(&ind_ofdpa_trace_enabled, 0, __ATOMIC_RELEASE);
+  ind_ofdpa_trace_close_locked();
+  trace_status.active = 0;
+  pthread_mutex_unlock(&trace_lock);
+}
+
+ind_ofdpa_trace_buf_t *ind_ofdpa_trace_buf_get(uint16_t api, uint64_t start_ns)
+{
+  ind_ofdpa_trace_buf_t *t = trace_self;
+  uint64_t trace_start;
+
+  if (t == NULL)
+  {
+    t = malloc(sizeof(*t));
+    if (t == NULL)
+    {
+      return NULL;
+    }
+    memset(&t->rec, 0, sizeof(t->rec));
+    t->rec.thread = __atomic_add_fetch(&trace_threads, 1, __ATOMIC_RELAXED);
+    trace_self = t;
+  }
+
+  if (!__atomic_load_n(&ind_ofdpa_trace_enabled, __ATOMIC_ACQUIRE))
+  {
+    return NULL;
+  }
+  trace_start = trace_start_ns;
+
+  t->rec.ts_ns   = (start_ns > trace_start) ? (start_ns - trace_start) : 0;
+  t->rec.api     = api;
+  t->rec.in_len  = 0;
+  t->rec.out_len = 0;
+  t->rec.flags   = 0;
+  t->len = 0;
+  return t;
+}
+
+void ind_ofdpa_trace_end(ind_ofdpa_trace_buf_t *t, OFDPA_ERROR_t rv, uint64_t elapsed_ns)
+{
+  t->rec.rv      = (int16_t)rv;
+  t->rec.dur_ns  = (elapsed_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed_ns;
+  t->rec.out_len = t->len - t->rec.in_len;
+
+  pthread_mutex_lock(&trace_lock);
+  if (trace_file != NULL)
+  {
+    if ((fwrite(&t->rec, sizeof(t->rec), 1, trace_file) != 1) ||
+        ((t->len != 0) && (fwrite(t->data, t->len, 1, trace_file) != 1)))
+    {
+      trace_status.write_errors++;
+    }
+    else
+    {
+      trace_status.records++;
+      trace_status.bytes += sizeof(t->rec) + t->len;
+      if (t->rec.flags & IND_OFDPA_TRACE_F_TRUNCATED)
+      {
+        trace_status.truncated++;
+      }
+    }
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+void ind_ofdpa_trace_status_get(ind_ofdpa_trace_status_t *status)
+{
+  pthread_mutex_lock(&trace_lock);
+  *status = trace_status;
+  pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,329 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ind_ofdpa_warm.c
+*
+* @purpose      Warm restart of the agent over a programmed switch, and
+*               controller resync
+*
+* @component    OF-DPA
+*
+* @comments     Indigo has no way to load entries into its tables other
+*               than from the controller, so restored entries stay
+*               driver-side until the controller's resync re-adds them;
+*               the driver then hands the existing entry to the core as
+*               the result of the add. A resync after a controller
+*               failover marks the entries Indigo already has and sweeps
+*               those the new controller does not send again.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <string.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_log.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
+
+/* Period of the window deadline check */
+#define IND_OFDPA_WARM_CHECK_MS   1000
+
+typedef struct
+{
+  uint32_t restored;
+  uint32_t drift;           /* entries whose shadow record was missing or differed */
+  uint32_t claimed;
+  uint32_t modified;        /* claims that had to change the entry */
+  uint32_t removed;         /* unclaimed at the end of the window */
+  uint32_t marked;          /* marked unconfirmed by a resync */
+  uint32_t confirmed;
+  uint32_t swept;           /* unconfirmed at the end of the window */
+} ind_ofdpa_warm_counts_t;
+
+static const char *warm_kind_names[IND_OFDPA_WARM_KINDS] = { "flows", "groups" };
+
+static int warm_active;
+static int warm_timer_running;
+static uint32_t warm_resyncs;           /* windows opened by a resync */
+static uint64_t warm_window_ns;         /* start of the open window */
+static uint64_t warm_start_ns;
+static uint64_t warm_deadline_ns;
+static uint64_t warm_restore_ns;        /* init to restored */
+static uint64_t warm_ready_ns;          /* init to window end, 0 until then */
+static ind_ofdpa_warm_counts_t warm_counts[IND_OFDPA_WARM_KINDS];
+
+static uint32_t ind_ofdpa_warm_pending(void)
+{
+  return ind_ofdpa_flow_warm_pending() + ind_ofdpa_group_warm_pending() +
+         ind_ofdpa_flow_resync_pending() + ind_ofdpa_group_resync_pending();
+}
+
+/* Delete what is left unclaimed or unconfirmed, flows first as they hold
+   groups */
+static void ind_ofdpa_warm_close(void)
+{
+  int resync = (warm_window_ns != warm_start_ns);
+
+  warm_counts[IND_OFDPA_WARM_FLOW].removed += ind_ofdpa_flow_warm_end();
+  warm_counts[IND_OFDPA_WARM_FLOW].swept += ind_ofdpa_flow_resync_end();
+  warm_counts[IND_OFDPA_WARM_GROUP].removed += ind_ofdpa_group_warm_end();
+  warm_counts[IND_OFDPA_WARM_GROUP].swept += ind_ofdpa_group_resync_end();
+
+  warm_active = 0;
+  if (resync)
+  {
+    LOG_VERBOSE("Resync done in %llu ms: %u/%u flows and %u/%u groups confirmed, "
+                "%u flows and %u groups removed",
+                (unsigned long long)((ind_ofdpa_rpc_now_ns() - warm_window_ns) / 1000000ULL),
+                warm_counts[IND_OFDPA_WARM_FLOW].confirmed, warm_counts[IND_OFDPA_WARM_FLOW].marked,
+                warm_counts[IND_OFDPA_WARM_GROUP].confirmed, warm_counts[IND_OFDPA_WARM_GROUP].marked,
+                warm_counts[IND_OFDPA_WARM_FLOW].swept, warm_counts[IND_OFDPA_WARM_GROUP].swept);
+    return;
+  }
+  warm_ready_ns = ind_ofdpa_rpc_now_ns() - warm_start_ns;
+
+  LOG_VERBOSE("Warm restart ready in %llu ms: %u/%u flows and %u/%u groups claimed, "
+              "%u flows and %u groups removed",
+              (unsigned long long)(warm_ready_ns / 1000000ULL),
+              warm_counts[IND_OFDPA_WARM_FLOW].claimed, warm_counts[IND_OFDPA_WARM_FLOW].restored,
+              warm_counts[IND_OFDPA_WARM_GROUP].claimed, warm_counts[IND_OFDPA_WARM_GROUP].restored,
+              warm_counts[IND_OFDPA_WARM_FLOW].removed, warm_counts[IND_OFDPA_WARM_GROUP].removed);
+}
+
+static void ind_ofdpa_warm_check(void)
+{
+  if (!warm_active || (ind_ofdpa_rpc_now_ns() < warm_deadline_ns))
+  {
+    return;
+  }
+
+  ind_ofdpa_warm_close();
+}
+
+static void ind_ofdpa_warm_timer(void *cookie)
+{
+  ind_ofdpa_warm_check();
+
+  if (!warm_active && warm_timer_running)
+  {
+    ind_ofdpa_loop_timer_unregister(ind_ofdpa_warm_timer, NULL);
+    warm_timer_running = 0;
+  }
+}
+
+static indigo_error_t ind_ofdpa_warm_timer_start(void)
+{
+  indigo_error_t err;
+
+  if (warm_timer_running)
+  {
+    return INDIGO_ERROR_NONE;
+  }
+
+  err = ind_ofdpa_loop_timer_register(ind_ofdpa_warm_timer, NULL, IND_OFDPA_WARM_CHECK_MS,
+                                      "warm restart");
+  if (err < 0)
+  {
+    LOG_ERROR("Failed to register warm restart timer, ending the window now.");
+    ind_ofdpa_warm_close();
+    return err;
+  }
+  warm_timer_running = 1;
+
+  return INDIGO_ERROR_NONE;
+}
+
+indigo_error_t ind_ofdpa_warm_init(const char *path, uint32_t window_ms)
+{
+  indigo_error_t err;
+  uint32_t drift = 0;
+
+  ind_ofdpa_warm_finish();
+  memset(warm_counts, 0, sizeof(warm_counts));
+  warm_ready_ns = 0;
+  warm_start_ns = ind_ofdpa_rpc_now_ns();
+  warm_window_ns = warm_start_ns;
+
+  err = ind_ofdpa_shadow_open(path);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return err;
+  }
+
+  warm_active = 1;
+  warm_counts[IND_OFDPA_WARM_GROUP].restored = ind_ofdpa_group_warm_restore(&drift);
+  warm_counts[IND_OFDPA_WARM_GROUP].drift = drift;
+  drift = 0;
+  warm_counts[IND_OFDPA_WARM_FLOW].restored = ind_ofdpa_flow_warm_restore(&drift);
+  warm_counts[IND_OFDPA_WARM_FLOW].drift = drift;
+  warm_restore_ns = ind_ofdpa_rpc_now_ns() - warm_start_ns;
+
+  LOG_VERBOSE("Restored %u flows and %u groups from OF-DPA in %llu ms, %u and %u differed from %s",
+              warm_counts[IND_OFDPA_WARM_FLOW].restored, warm_counts[IND_OFDPA_WARM_GROUP].restored,
+              (unsigned long long)(warm_restore_ns / 1000000ULL),
+              warm_counts[IND_OFDPA_WARM_FLOW].drift, warm_counts[IND_OFDPA_WARM_GROUP].drift,
+              (path != NULL) ? path : "the shadow");
+
+  if (ind_ofdpa_warm_pending() == 0)
+  {
+    ind_ofdpa_warm_close();
+    return INDIGO_ERROR_NONE;
+  }
+
+  warm_deadline_ns = warm_start_ns + ((uint64_t)window_ms * 1000000ULL);
+
+  return ind_ofdpa_warm_timer_start();
+}
+
+void ind_ofdpa_warm_resync(uint32_t window_ms)
+{
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
+  uint64_t deadline_ns = now_ns + ((uint64_t)window_ms * 1000000ULL);
+  uint32_t flows;
+  uint32_t groups;
+
+  if (window_ms == 0)
+  {
+    return;
+  }
+
+  /* Entries confirmed in the open window stay confirmed */
+  if (warm_active)
+  {
+    if (warm_deadline_ns < deadline_ns)
+    {
+      warm_deadline_ns = deadline_ns;
+      LOG_VERBOSE("Warm restart window extended by %u ms for a new controller", window_ms);
+    }
+    return;
+  }
+
+  flows = ind_ofdpa_flow_resync_mark();
+  groups = ind_ofdpa_group_resync_mark();
+  if ((flows == 0) && (groups == 0))
+  {
+    return;
+  }
+
+  warm_resyncs++;
+  warm_window_ns = now_ns;
+  warm_deadline_ns = deadline_ns;
+  warm_active = 1;
+  warm_counts[IND_OFDPA_WARM_FLOW].marked += flows;
+  warm_counts[IND_OFDPA_WARM_GROUP].marked += groups;
+  LOG_VERBOSE("Resync started: %u flows and %u groups unconfirmed for %u ms", flows, groups, window_ms);
+
+  (void)ind_ofdpa_warm_timer_start();
+}
+
+void ind_ofdpa_warm_finish(void)
+{
+  if (warm_timer_running)
+  {
+    ind_ofdpa_loop_timer_unregister(ind_ofdpa_warm_timer, NULL);
+    warm_timer_running = 0;
+  }
+  warm_active = 0;
+  ind_ofdpa_shadow_close();
+}
+
+void ind_ofdpa_warm_end(void)
+{
+  if (!warm_active)
+  {
+    return;
+  }
+  warm_deadline_ns = 0;
+  ind_ofdpa_warm_check();
+}
+
+int ind_ofdpa_warm_active(void)
+{
+  return warm_active;
+}
+
+void ind_ofdpa_warm_claimed(ind_ofdpa_warm_kind_t kind, int modified)
+{
+  warm_counts[kind].claimed++;
+  if (modified)
+  {
+    warm_counts[kind].modified++;
+  }
+
+  if (ind_ofdpa_warm_pending() == 0)
+  {
+    ind_ofdpa_warm_end();
+  }
+}
+
+void ind_ofdpa_warm_confirmed(ind_ofdpa_warm_kind_t kind)
+{
+  warm_counts[kind].confirmed++;
+
+  if (ind_ofdpa_warm_pending() == 0)
+  {
+    ind_ofdpa_warm_end();
+  }
+}
+
+void ind_ofdpa_warm_show(aim_pvs_t *pvs)
+{
+  uint64_t now_ns = ind_ofdpa_rpc_now_ns();
+  int i;
+
+  if ((warm_start_ns == 0) && (warm_resyncs == 0))
+  {
+    aim_printf(pvs, "warm restart not enabled, no resync\n");
+    return;
+  }
+
+  if (warm_active)
+  {
+    aim_printf(pvs, "%s window open, %llu ms elapsed, %lld ms left, %u entries unclaimed or unconfirmed\n",
+               (warm_window_ns != warm_start_ns) ? "resync" : "warm restart",
+               (unsigned long long)((now_ns - warm_window_ns) / 1000000ULL),
+               (long long)((int64_t)(warm_deadline_ns - now_ns) / 1000000LL),
+               ind_ofdpa_warm_pending());
+  }
+  else if (warm_start_ns != 0)
+  {
+    aim_printf(pvs, "warm restart done, restart-to-ready %llu ms\n",
+               (unsigned long long)(warm_ready_ns / 1000000ULL));
+  }
+  if (warm_start_ns != 0)
+  {
+    aim_printf(pvs, "restore took %llu ms\n", (unsigned long long)(warm_restore_ns / 1000000ULL));
+  }
+  aim_printf(pvs, "resyncs %u\n", warm_resyncs);
+
+  for (i = 0; i < IND_OFDPA_WARM_KINDS; i++)
+  {
+    aim_printf(pvs, "%-7s restored %u  drift %u  claimed %u  modified %u  removed %u\n",
+               warm_kind_names[i], warm_counts[i].restored, warm_counts[i].drift,
+               warm_counts[i].claimed, warm_counts[i].modified, warm_counts[i].removed);
+    aim_printf(pvs, "%-7s marked %u  confirmed %u  swept %u\n",
+               warm_kind_names[i], warm_counts[i].marked, warm_counts[i].confirmed,
+               warm_counts[i].swept);
+  }
+}
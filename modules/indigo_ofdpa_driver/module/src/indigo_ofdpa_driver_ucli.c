@@ -10,6 +10,16 @@
 #include <uCli/ucli.h>
 #include <uCli/ucli_argparse.h>
 #include <uCli/ucli_handler_macros.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_io.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_meter.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_expiry.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_index.h>
 
 static ucli_status_t
 indigo_ofdpa_driver_ucli_ucli__config__(ucli_context_t* uc)
@@ -27,6 +37,260 @@ indigo_ofdpa_driver_ucli_ucli__hello__(ucli_context_t* uc)
         return UCLI_STATUS_OK;
 }
 
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__rpc_stats__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "rpc_stats", 0,
+                        "$summary#Show libofdpa call counts, errors and latency.");
+        ind_ofdpa_rpc_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__rpc_stats_clear__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "rpc_stats_clear", 0,
+                        "$summary#Reset libofdpa call statistics.");
+        ind_ofdpa_rpc_stats_clear();
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__trace__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "trace", 0,
+                        "$summary#Show the libofdpa call trace recorder.");
+        ind_ofdpa_rpc_trace_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__trace_start__(ucli_context_t* uc)
+{
+        char *path;
+
+        UCLI_COMMAND_INFO(uc,
+                        "trace_start", 1,
+                        "$summary#Record libofdpa calls, packets and port events to a file."
+                        "$args#<path>");
+        UCLI_ARGPARSE_OR_RETURN(uc, "s", &path);
+        if (ind_ofdpa_rpc_trace_start(path) < 0)
+        {
+                return ucli_error(uc, "cannot record to %s", path);
+        }
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__trace_stop__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "trace_stop", 0,
+                        "$summary#Stop recording libofdpa calls and close the trace file.");
+        ind_ofdpa_rpc_trace_stop();
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__loop_stats__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "loop_stats", 0,
+                        "$summary#Show main loop callback service times.");
+        ind_ofdpa_loop_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__loop_stats_clear__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "loop_stats_clear", 0,
+                        "$summary#Reset main loop statistics.");
+        ind_ofdpa_loop_stats_clear();
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__io_stats__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "io_stats", 0,
+                        "$summary#Show OF-DPA I/O thread packet ring statistics.");
+        ind_ofdpa_io_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__group_resilient__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "group_resilient", 0,
+                        "$summary#Show resilient select group remap statistics.");
+        ind_ofdpa_group_resilient_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__group_deps__(ucli_context_t* uc)
+{
+        int group_id;
+
+        UCLI_COMMAND_INFO(uc,
+                        "group_deps", 1,
+                        "$summary#Show the groups and flows that depend on a group."
+                        "$args#<group_id>");
+        UCLI_ARGPARSE_OR_RETURN(uc, "i", &group_id);
+        ind_ofdpa_group_dependents_show(uc->pvs, (uint32_t)group_id);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__group_type_stats__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "group_type_stats", 0,
+                        "$summary#Show group operation counts and latency per OF-DPA group type.");
+        ind_ofdpa_group_type_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__group_stats__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "group_stats", 0,
+                        "$summary#Show group statistics sampler and cache counters.");
+        ind_ofdpa_group_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__group_ecmp__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "group_ecmp", 0,
+                        "$summary#Show per-member egress rates and imbalance of ECMP groups.");
+        ind_ofdpa_group_ecmp_imbalance_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__meters__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "meters", 0,
+                        "$summary#Show installed meters, their bands and cached stats.");
+        ind_ofdpa_meter_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__flow_expiry__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "flow_expiry", 0,
+                        "$summary#Show agent flow expiry timers and counters.");
+        ind_ofdpa_flow_expiry_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__flow_ops__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "flow_ops", 0,
+                        "$summary#Show flow add, modify and delete counts and the OF-DPA calls saved.");
+        ind_ofdpa_flow_op_stats_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__flow_index__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "flow_index", 0,
+                        "$summary#Show flows indexed per table and batched delete counters.");
+        ind_ofdpa_flow_index_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__flow_group_count__(ucli_context_t* uc)
+{
+        ind_ofdpa_flow_query_t query = { 0 };
+        int group_id;
+
+        UCLI_COMMAND_INFO(uc,
+                        "flow_group_count", 1,
+                        "$summary#Count the flows whose output is a group."
+                        "$args#<group_id>");
+        UCLI_ARGPARSE_OR_RETURN(uc, "i", &group_id);
+        query.fields = IND_OFDPA_FLOW_QUERY_GROUP;
+        query.group_id = (uint32_t)group_id;
+        aim_printf(uc->pvs, "%u flows\n", ind_ofdpa_flow_index_count(&query));
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__flow_port_count__(ucli_context_t* uc)
+{
+        ind_ofdpa_flow_query_t query = { 0 };
+        int port;
+
+        UCLI_COMMAND_INFO(uc,
+                        "flow_port_count", 1,
+                        "$summary#Count the flows whose output is a port."
+                        "$args#<port>");
+        UCLI_ARGPARSE_OR_RETURN(uc, "i", &port);
+        query.fields = IND_OFDPA_FLOW_QUERY_PORT;
+        query.port = (uint32_t)port;
+        aim_printf(uc->pvs, "%u flows\n", ind_ofdpa_flow_index_count(&query));
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__warm__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "warm", 0,
+                        "$summary#Show warm restart claims, resync confirmations and the flow and group shadow.");
+        ind_ofdpa_warm_show(uc->pvs);
+        ind_ofdpa_shadow_show(uc->pvs);
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__warm_end__(ucli_context_t* uc)
+{
+        UCLI_COMMAND_INFO(uc,
+                        "warm_end", 0,
+                        "$summary#End the warm restart or resync window, deleting unclaimed and unconfirmed entries.");
+        ind_ofdpa_warm_end();
+        return UCLI_STATUS_OK;
+}
+
+static ucli_status_t
+indigo_ofdpa_driver_ucli_ucli__resync__(ucli_context_t* uc)
+{
+        int window_ms;
+
+        UCLI_COMMAND_INFO(uc,
+                        "resync", 1,
+                        "$summary#Start a controller resync of <ms>, or keep the open window open for at least <ms> more."
+                        "$args#<ms>");
+        UCLI_ARGPARSE_OR_RETURN(uc, "i", &window_ms);
+        if (window_ms <= 0)
+        {
+                return ucli_error(uc, "window must be positive");
+        }
+        ind_ofdpa_warm_resync((uint32_t)window_ms);
+        return UCLI_STATUS_OK;
+}
+
 /* <auto.ucli.handlers.start> */
 /******************************************************************************
  * 
@@ -37,6 +301,28 @@ static ucli_command_handler_f indigo_ofdpa_driver_ucli_ucli_handlers__[] =
 {
         indigo_ofdpa_driver_ucli_ucli__config__,
         indigo_ofdpa_driver_ucli_ucli__hello__,
+        indigo_ofdpa_driver_ucli_ucli__rpc_stats__,
+        indigo_ofdpa_driver_ucli_ucli__rpc_stats_clear__,
+        indigo_ofdpa_driver_ucli_ucli__trace__,
+        indigo_ofdpa_driver_ucli_ucli__trace_start__,
+        indigo_ofdpa_driver_ucli_ucli__trace_stop__,
+        indigo_ofdpa_driver_ucli_ucli__loop_stats__,
+        indigo_ofdpa_driver_ucli_ucli__loop_stats_clear__,
+        indigo_ofdpa_driver_ucli_ucli__io_stats__,
+        indigo_ofdpa_driver_ucli_ucli__group_resilient__,
+        indigo_ofdpa_driver_ucli_ucli__group_deps__,
+        indigo_ofdpa_driver_ucli_ucli__group_type_stats__,
+        indigo_ofdpa_driver_ucli_ucli__group_stats__,
+        indigo_ofdpa_driver_ucli_ucli__group_ecmp__,
+        indigo_ofdpa_driver_ucli_ucli__meters__,
+        indigo_ofdpa_driver_ucli_ucli__flow_expiry__,
+        indigo_ofdpa_driver_ucli_ucli__flow_ops__,
+        indigo_ofdpa_driver_ucli_ucli__flow_index__,
+        indigo_ofdpa_driver_ucli_ucli__flow_group_count__,
+        indigo_ofdpa_driver_ucli_ucli__flow_port_count__,
+        indigo_ofdpa_driver_ucli_ucli__warm__,
+        indigo_ofdpa_driver_ucli_ucli__warm_end__,
+        indigo_ofdpa_driver_ucli_ucli__resync__,
         NULL
 };
 /******************************************************************************/
@@ -61,6 +61,16 @@ const char *versionBuf = BUILD_VERSION;
 #include <OFStateManager/ofstatemanager.h>
 #include <indigo/forwarding.h>
 #include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_telemetry.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_loop_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_io.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_meter.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_expiry.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_index.h>
 
 #define PIDFILE "/var/run/ofagent/.pid"
 
@@ -96,6 +106,8 @@ static int sigterm_eventfd;
 static biglist_t *controllers = NULL;
 static biglist_t *listeners = NULL;
 
+static uint32_t resync_ms;
+
 typedef struct
 {
   int           agentdebuglvl;
@@ -104,6 +116,17 @@ typedef struct
   int           debugComps[10]; // 10: TODO: update from OF Agent debug levels
 #endif
   of_dpid_t     dpid;
+  const char   *telemetry_path;
+  uint32_t      stall_ms;
+  int           io_thread;
+  ind_ofdpa_io_backend_t io_backend;
+  uint32_t      resilient_slots;
+  uint32_t      group_stats_ms;
+  int           group_delete_cascade;
+  const char   *trace_path;
+  int           agent_expiry;
+  const char   *warm_path;
+  uint32_t      resync_ms;
 } arguments_t;
 
 /* The options we understand. */
@@ -117,6 +140,17 @@ static struct argp_option options[] =
   { "controller", 't', "IP:PORT", 0,  "Controller" },
   { "listen",   'l',  "IP:PORT", 0,  "Listen" },
   { "dpid", 'i',  "DATAPATHID", 0,  "Specify Datapath ID." },
+  { "telemetry", 'T', "PATH", OPTION_ARG_OPTIONAL, "Export counter snapshots on a local Unix socket." },
+  { "telemetry-interval", 'P', "FAMILY:MS", 0, "Snapshot period for port, queue, table or group counters (0 disables)." },
+  { "stall-ms", 'w', "MS", 0, "Report main loop stalls longer than MS milliseconds, above 100 (0 disables)." },
+  { "io-thread", 'o', "BACKEND", OPTION_ARG_OPTIONAL, "Service the OF-DPA event and packet sockets on a separate thread using the poll (default) or epoll backend. Controller connections stay on the main loop." },
+  { "resilient-hash", 'r', "SLOTS", 0, "Spread the buckets of ECMP select groups over SLOTS fixed buckets so membership changes move few flows (0 disables)." },
+  { "group-stats-ms", 'G', "MS", 0, "Sample group statistics every MS milliseconds and answer group stats requests from the samples (0 disables)." },
+  { "group-delete-cascade", 'C', 0, 0, "Delete the flows pointing at a group when the group is deleted, instead of rejecting the delete." },
+  { "trace", 'R', "FILE", 0, "Record libofdpa calls, packets and port events to FILE for replay." },
+  { "agent-expiry", 'E', 0, 0, "Track flow idle and hard timeouts in the agent instead of OF-DPA." },
+  { "warm-restart", 'W', "FILE", 0, "Shadow programmed flows and groups in FILE, and on start take over those left in OF-DPA until the controller re-adds them." },
+  { "resync", 'S', "MS", 0, "On each controller handshake, give the controller MS milliseconds to add or modify again every flow and group; those it does not are then deleted. Also keeps an open warm restart window open at least that long (0 disables)." },
   { 0 }
 };
 
@@ -215,6 +249,16 @@ sigterm(int signum)
     }
 }
 
+static void
+cxn_status_change(indigo_cxn_id_t cxn_id,
+                  indigo_cxn_protocol_params_t *cxn_proto_params,
+                  indigo_cxn_state_t state, void *cookie)
+{
+    if (state == INDIGO_CXN_S_HANDSHAKE_COMPLETE) {
+        ind_ofdpa_warm_resync(resync_ms);
+    }
+}
+
 /* Parse a single option. */
 static error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
@@ -289,6 +333,137 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
 
     break;
 
+    case 'T':                           /* telemetry */
+      arguments->telemetry_path = (arg != NULL) ? arg : IND_OFDPA_TELEMETRY_SOCKET_DEFAULT;
+      break;
+
+    case 'P':                           /* telemetry-interval */
+      {
+        char familyName[16];
+        ind_ofdpa_telemetry_family_t family;
+        unsigned long interval;
+        char *intervalEnd;
+        char *sep = strchr(arg, ':');
+
+        errno = 0;
+        if ((sep == NULL) || ((sep - arg) >= sizeof(familyName)))
+        {
+          argp_error(state, "Invalid telemetry interval \"%s\", expected FAMILY:MS", arg);
+          return EINVAL;
+        }
+        memcpy(familyName, arg, sep - arg);
+        familyName[sep - arg] = '\0';
+
+        if (ind_ofdpa_telemetry_family_parse(familyName, &family) != INDIGO_ERROR_NONE)
+        {
+          argp_error(state, "Unknown telemetry family \"%s\"", familyName);
+          return EINVAL;
+        }
+
+        interval = strtoul(sep + 1, &intervalEnd, 0);
+        if ((errno != 0) || (*(sep + 1) == '\0') || (*intervalEnd != '\0') ||
+            (interval > UINT32_MAX))
+        {
+          argp_error(state, "Invalid telemetry interval \"%s\"", sep + 1);
+          return EINVAL;
+        }
+        (void)ind_ofdpa_telemetry_interval_set(family, interval);
+      }
+      break;
+
+    case 'w':                           /* stall-ms */
+      {
+        unsigned long stallMs;
+        char *stallEnd;
+
+        errno = 0;
+        stallMs = strtoul(arg, &stallEnd, 0);
+        if ((errno != 0) || (*arg == '\0') || (*stallEnd != '\0') || (stallMs > UINT32_MAX))
+        {
+          argp_error(state, "Invalid stall-ms \"%s\"", arg);
+          return EINVAL;
+        }
+        /* The watchdog can only see stalls longer than a heartbeat */
+        if ((stallMs != 0) && (stallMs <= IND_OFDPA_LOOP_HEARTBEAT_MS))
+        {
+          argp_error(state, "Invalid stall-ms \"%s\", must be 0 or more than %u",
+                     arg, IND_OFDPA_LOOP_HEARTBEAT_MS);
+          return EINVAL;
+        }
+        arguments->stall_ms = stallMs;
+      }
+      break;
+
+    case 'o':                           /* io-thread */
+      arguments->io_thread = 1;
+      if ((arg == NULL) || (strcmp(arg, "poll") == 0))
+      {
+        arguments->io_backend = IND_OFDPA_IO_BACKEND_POLL;
+      }
+      else if (strcmp(arg, "epoll") == 0)
+      {
+        arguments->io_backend = IND_OFDPA_IO_BACKEND_EPOLL;
+      }
+      else
+      {
+        argp_error(state, "Invalid I/O backend \"%s\", must be poll or epoll", arg);
+        return EINVAL;
+      }
+      break;
+
+    case 'r':                           /* resilient-hash */
+      errno = 0;
+
+      arguments->resilient_slots = strtoul(arg, NULL, 0);
+      if ((errno != 0) || (arguments->resilient_slots > IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS))
+      {
+        argp_error(state, "Invalid resilient-hash \"%s\", must be at most %u",
+                   arg, IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS);
+        return EINVAL;
+      }
+
+      break;
+
+    case 'G':                           /* group-stats-ms */
+      errno = 0;
+
+      arguments->group_stats_ms = strtoul(arg, NULL, 0);
+      if (errno != 0)
+      {
+        argp_error(state, "Invalid group-stats-ms \"%s\"", arg);
+        return EINVAL;
+      }
+
+      break;
+
+    case 'C':                           /* group-delete-cascade */
+      arguments->group_delete_cascade = 1;
+      break;
+
+    case 'R':                           /* trace */
+      arguments->trace_path = arg;
+      break;
+
+    case 'E':                           /* agent-expiry */
+      arguments->agent_expiry = 1;
+      break;
+
+    case 'W':                           /* warm-restart */
+      arguments->warm_path = arg;
+      break;
+
+    case 'S':                           /* resync */
+      errno = 0;
+
+      arguments->resync_ms = strtoul(arg, NULL, 0);
+      if (errno != 0)
+      {
+        argp_error(state, "Invalid resync \"%s\"", arg);
+        return EINVAL;
+      }
+
+      break;
+
     case ARGP_KEY_NO_ARGS:
     case ARGP_KEY_END:
       break;
@@ -523,6 +698,13 @@ int aim_main(int argc, char *argv[])
     .debugComps = { 0 },
 #endif
     .dpid = OFSTATEMANAGER_CONFIG_DPID_DEFAULT,
+    .telemetry_path = NULL,
+    .stall_ms = IND_OFDPA_LOOP_STALL_MS_DEFAULT,
+    .io_thread = 0,
+    .io_backend = IND_OFDPA_IO_BACKEND_POLL,
+    .resilient_slots = 0,
+    .group_stats_ms = IND_OFDPA_GROUP_STATS_MS_DEFAULT,
+    .resync_ms = 0,
   };
 
   fileStemName = stemname(strdup(__FILE__));
@@ -639,6 +821,14 @@ int aim_main(int argc, char *argv[])
   /* Initialize all modules */
   printf("Initializing the system.\r\n");
 
+  if (arguments.trace_path != NULL)
+  {
+    if (ind_ofdpa_rpc_trace_start(arguments.trace_path) < 0)
+    {
+      AIM_LOG_ERROR("Failed to record libofdpa calls to %s", arguments.trace_path);
+    }
+  }
+
   rc = ofdpaClientInitialize(programName);
   if (rc != OFDPA_E_NONE)
   {
@@ -689,6 +879,30 @@ int aim_main(int argc, char *argv[])
 
   ind_ofdpa_fwd_init();
   ind_ofdpa_group_init();
+  (void)ind_ofdpa_group_resilient_set(arguments.resilient_slots);
+  ind_ofdpa_group_delete_cascade_set(arguments.group_delete_cascade);
+  if (arguments.agent_expiry)
+  {
+    (void)indigo_fwd_expiration_enable_set(1);
+  }
+  if (arguments.warm_path != NULL)
+  {
+    if (ind_ofdpa_warm_init(arguments.warm_path, IND_OFDPA_WARM_WINDOW_MS) != INDIGO_ERROR_NONE)
+    {
+      AIM_LOG_ERROR("Failed to start warm restart from %s", arguments.warm_path);
+    }
+  }
+  /* Unchanged modifies compare against the shadow; without
+     -W keep it in memory */
+  if (!ind_ofdpa_shadow_is_open() && (ind_ofdpa_shadow_open(NULL) != INDIGO_ERROR_NONE))
+  {
+    AIM_LOG_ERROR("Failed to create the flow and group shadow");
+  }
+  if (arguments.resync_ms != 0)
+  {
+    resync_ms = arguments.resync_ms;
+    (void)indigo_cxn_status_change_register(cxn_status_change, NULL);
+  }
 
   /* Add controllers from command line */
   {
@@ -783,7 +997,7 @@ int aim_main(int argc, char *argv[])
       abort();
   }
   signal(SIGHUP, sighup);
-  if (ind_soc_socket_register(sighup_eventfd, sighup_callback, NULL) < 0) {
+  if (ind_ofdpa_loop_socket_register(sighup_eventfd, sighup_callback, NULL, "sighup") < 0) {
       abort();
   }
 
@@ -793,24 +1007,75 @@ int aim_main(int argc, char *argv[])
       abort();
   }
   signal(SIGTERM, sigterm);
-  if (ind_soc_socket_register(sigterm_eventfd, sigterm_callback, NULL) < 0) {
+  if (ind_ofdpa_loop_socket_register(sigterm_eventfd, sigterm_callback, NULL, "sigterm") < 0) {
       abort();
   }
 
-  if (ind_soc_socket_register(ofdpaClientEventSockFdGet(), ind_ofdpa_event_socket_ready, NULL) < 0)
+  if (arguments.io_thread)
   {
-    return 1;
+    if (ind_ofdpa_io_start(arguments.io_backend) != INDIGO_ERROR_NONE)
+    {
+      AIM_LOG_FATAL("Failed to start OF-DPA I/O thread");
+      return 1;
+    }
+  }
+  else
+  {
+    if (ind_ofdpa_loop_socket_register(ofdpaClientEventSockFdGet(), ind_ofdpa_event_socket_ready,
+                                       NULL, "ofdpa event") < 0)
+    {
+      return 1;
+    }
+
+    if (ind_ofdpa_loop_socket_register(ofdpaClientPktSockFdGet(), ind_ofdpa_pkt_socket_ready,
+                                       NULL, "ofdpa packet") < 0)
+    {
+      return 1;
+    }
   }
 
-  if (ind_soc_socket_register(ofdpaClientPktSockFdGet(), ind_ofdpa_pkt_socket_ready, NULL) < 0)
+  if (ind_ofdpa_loop_stats_init(arguments.stall_ms) != INDIGO_ERROR_NONE)
   {
-    return 1;
+    AIM_LOG_ERROR("Failed to start main loop instrumentation");
+  }
+
+  if (ind_ofdpa_group_stats_init(arguments.group_stats_ms) != INDIGO_ERROR_NONE)
+  {
+    AIM_LOG_ERROR("Failed to start group statistics sampler");
+  }
+
+  if (ind_ofdpa_meter_stats_init(IND_OFDPA_METER_STATS_MS_DEFAULT) != INDIGO_ERROR_NONE)
+  {
+    AIM_LOG_ERROR("Failed to start meter statistics poller");
+  }
+
+  if (ind_ofdpa_flow_expiry_init(IND_OFDPA_FLOW_EXPIRY_TICK_MS) != INDIGO_ERROR_NONE)
+  {
+    AIM_LOG_ERROR("Failed to start flow expiry timer");
+  }
+
+  if (arguments.telemetry_path != NULL)
+  {
+    if (ind_ofdpa_telemetry_init(arguments.telemetry_path) != INDIGO_ERROR_NONE)
+    {
+      AIM_LOG_ERROR("Failed to start telemetry export on %s", arguments.telemetry_path);
+    }
   }
 
   ind_soc_select_and_run(-1);
 
   AIM_LOG_MSG("Stopping %s", argp_program_version);
 
+  ind_ofdpa_io_stop();
+  ind_ofdpa_telemetry_finish();
+  ind_ofdpa_group_stats_finish();
+  ind_ofdpa_meter_stats_finish();
+  ind_ofdpa_flow_expiry_finish();
+  ind_ofdpa_warm_finish();
+  ind_ofdpa_flow_index_finish();
+  ind_ofdpa_loop_stats_finish();
+  ind_ofdpa_rpc_trace_stop();
+
   ind_core_finish();
   ind_cxn_finish();
   ind_soc_finish();
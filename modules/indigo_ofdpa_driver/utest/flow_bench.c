@@ -0,0 +1,738 @@
+/**************************************************************************//**
+ *
+ * Flow programming benchmark ("flows").
+ *
+ * Builds OpenFlow 1.3 flow adds for the main OF-DPA tables and times the
+ * driver against libofdpa_sim: match and instruction translation alone,
+ * then flow create, modify, unchanged modify and delete through the
+ * table operations Indigo calls. The ACL policy table also runs with
+ * modifies that only re-point the flow to another meter or queue. One
+ * record per table and operation:
+ *
+ *   {"label":"...","test":"flows","table":"Bridging","table_id":50,
+ *    "op":"create","flows":1000,"rounds":5,"errors":0,"ns_per_op":2213.4,
+ *    "best_ns_per_op":2101.9,"ofdpa_calls_per_op":1.00}
+ *
+ * -n sets the flows per table, capped at the table size (default 1000),
+ * -r the rounds (default 5) and -t limits the run to one table id.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <AIM/aim.h>
+#include <indigo/fi.h>
+
+#include "utest.h"
+
+#define BENCH_FLOWS_DEFAULT     1000
+#define BENCH_ROUNDS_DEFAULT    5
+#define BENCH_PORTS             32
+#define BENCH_VLAN              10
+#define BENCH_L3_UNICAST_GROUPS 64
+#define BENCH_L3_MCAST_GROUPS   16
+#define BENCH_METERS            16
+#define BENCH_QUEUES            8
+#define BENCH_PRIORITY          1000
+
+typedef enum
+{
+  BENCH_OP_MATCH = 0,
+  BENCH_OP_INSTRUCTIONS,
+  BENCH_OP_CREATE,
+  BENCH_OP_MODIFY,
+  BENCH_OP_MODIFY_UNCHANGED,
+  BENCH_OP_DELETE,
+  BENCH_OPS
+} bench_op_t;
+
+static const char *bench_op_names[BENCH_OPS] =
+{
+  "match", "instructions", "create", "modify", "modify_unchanged", "delete"
+};
+
+typedef struct
+{
+  uint64_t ns;
+  uint64_t best_ns;
+  uint64_t calls;
+  uint32_t errors;
+} bench_result_t;
+
+typedef struct bench_table_s bench_table_t;
+
+struct bench_table_s
+{
+  OFDPA_FLOW_TABLE_ID_t table_id;
+  const char *name;
+  void (*match_build)(uint32_t key, of_match_t *match);
+  /* generation changes the actions, so a modify has something to do */
+  of_list_instruction_t *(*instructions_new)(uint32_t key, uint32_t generation);
+};
+
+static uint32_t l2_interface_groups[BENCH_PORTS];
+static uint32_t l3_unicast_groups[BENCH_L3_UNICAST_GROUPS];
+static uint32_t l3_mcast_groups[BENCH_L3_MCAST_GROUPS];
+
+/* Groups */
+
+static void bench_groups_add(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < BENCH_PORTS; i++)
+  {
+    l2_interface_groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, BENCH_VLAN, i + 1);
+  }
+  for (i = 0; i < BENCH_L3_UNICAST_GROUPS; i++)
+  {
+    l3_unicast_groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, i + 1);
+  }
+  for (i = 0; i < BENCH_L3_MCAST_GROUPS; i++)
+  {
+    l3_mcast_groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST, BENCH_VLAN, i + 1);
+  }
+}
+
+static void bench_groups_delete(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < BENCH_L3_MCAST_GROUPS; i++)
+  {
+    (void)ofdpaGroupDelete(l3_mcast_groups[i]);
+  }
+  for (i = 0; i < BENCH_L3_UNICAST_GROUPS; i++)
+  {
+    (void)ofdpaGroupDelete(l3_unicast_groups[i]);
+  }
+  for (i = 0; i < BENCH_PORTS; i++)
+  {
+    (void)ofdpaGroupDelete(l2_interface_groups[i]);
+  }
+}
+
+/* Meters; the ACL policy flows must find theirs */
+
+static void bench_meters_add(void)
+{
+  ofdpaMeterEntry_t meter;
+  uint32_t i;
+
+  for (i = 0; i < BENCH_METERS; i++)
+  {
+    memset(&meter, 0, sizeof(meter));
+    meter.meterId = i + 1;
+    meter.meterBand[1].bandType = OFDPA_METER_BAND_RED;
+    meter.meterBand[1].bandRate = 1000 * (i + 1);
+    meter.meterBand[1].bandBurst = 64;
+    if (ofdpaMeterAdd(&meter) != OFDPA_E_NONE)
+    {
+      fprintf(stderr, "failed to add meter %u\n", meter.meterId);
+    }
+  }
+}
+
+static void bench_meters_delete(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < BENCH_METERS; i++)
+  {
+    (void)ofdpaMeterDelete(i + 1);
+  }
+}
+
+/* Instructions */
+
+static void bench_goto_append(of_list_instruction_t *insts, uint8_t table_id)
+{
+  of_instruction_goto_table_t *inst;
+
+  inst = of_instruction_goto_table_new(OF_VERSION_1_3);
+  of_instruction_goto_table_table_id_set(inst, table_id);
+  of_list_instruction_append(insts, inst);
+  of_object_delete(inst);
+}
+
+static void bench_write_actions_append(of_list_instruction_t *insts, of_list_action_t *actions)
+{
+  of_instruction_write_actions_t *inst;
+
+  inst = of_instruction_write_actions_new(OF_VERSION_1_3);
+  of_instruction_write_actions_actions_set(inst, actions);
+  of_list_instruction_append(insts, inst);
+  of_object_delete(inst);
+  of_object_delete(actions);
+}
+
+static void bench_group_action_append(of_list_action_t *actions, uint32_t group_id)
+{
+  of_action_group_t *act;
+
+  act = of_action_group_new(OF_VERSION_1_3);
+  of_action_group_group_id_set(act, group_id);
+  of_list_action_append(actions, act);
+  of_object_delete(act);
+}
+
+static void bench_meter_append(of_list_instruction_t *insts, uint32_t meter_id)
+{
+  of_instruction_meter_t *inst;
+
+  inst = of_instruction_meter_new(OF_VERSION_1_3);
+  of_instruction_meter_meter_id_set(inst, meter_id);
+  of_list_instruction_append(insts, inst);
+  of_object_delete(inst);
+}
+
+static void bench_set_queue_action_append(of_list_action_t *actions, uint32_t queue_id)
+{
+  of_action_set_queue_t *act;
+
+  act = of_action_set_queue_new(OF_VERSION_1_3);
+  of_action_set_queue_queue_id_set(act, queue_id);
+  of_list_action_append(actions, act);
+  of_object_delete(act);
+}
+
+/* goto only; a modify moves the flow to the other next table */
+static of_list_instruction_t *bench_vlan_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+
+  bench_goto_append(insts, (generation == 0) ? OFDPA_FLOW_TABLE_ID_TERMINATION_MAC :
+                                               OFDPA_FLOW_TABLE_ID_BRIDGING);
+  return insts;
+}
+
+static of_list_instruction_t *bench_termination_mac_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+
+  bench_goto_append(insts, (generation == 0) ? OFDPA_FLOW_TABLE_ID_UNICAST_ROUTING :
+                                               OFDPA_FLOW_TABLE_ID_MULTICAST_ROUTING);
+  return insts;
+}
+
+/* Write the next hop group and go to ACL, as a route does */
+static of_list_instruction_t *bench_next_hop_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_group_action_append(actions, l3_unicast_groups[(key + generation) % BENCH_L3_UNICAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  bench_goto_append(insts, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  return insts;
+}
+
+static of_list_instruction_t *bench_multicast_routing_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_group_action_append(actions, l3_mcast_groups[(key + generation) % BENCH_L3_MCAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  bench_goto_append(insts, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  return insts;
+}
+
+static of_list_instruction_t *bench_bridging_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_group_action_append(actions, l2_interface_groups[(key + generation) % BENCH_PORTS]);
+  bench_write_actions_append(insts, actions);
+  bench_goto_append(insts, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  return insts;
+}
+
+/* Redirect to a next hop; ACL policy flows cannot go to another table */
+static of_list_instruction_t *bench_acl_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_group_action_append(actions, l3_unicast_groups[(key + generation) % BENCH_L3_UNICAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  return insts;
+}
+
+/* Same next hop; a modify re-points the flow to another meter */
+static of_list_instruction_t *bench_acl_meter_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_meter_append(insts, 1 + (key + generation) % BENCH_METERS);
+  bench_group_action_append(actions, l3_unicast_groups[key % BENCH_L3_UNICAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  return insts;
+}
+
+/* Same next hop; a modify re-points the flow to another queue */
+static of_list_instruction_t *bench_acl_queue_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+
+  bench_set_queue_action_append(actions, (key + generation) % BENCH_QUEUES);
+  bench_group_action_append(actions, l3_unicast_groups[key % BENCH_L3_UNICAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  return insts;
+}
+
+/* Pop the label and route the payload */
+static of_list_instruction_t *bench_mpls_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+  of_action_pop_mpls_t *pop;
+
+  pop = of_action_pop_mpls_new(OF_VERSION_1_3);
+  of_action_pop_mpls_ethertype_set(pop, ETH_P_IP);
+  of_list_action_append(actions, pop);
+  of_object_delete(pop);
+  bench_group_action_append(actions, l3_unicast_groups[(key + generation) % BENCH_L3_UNICAST_GROUPS]);
+  bench_write_actions_append(insts, actions);
+  bench_goto_append(insts, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  return insts;
+}
+
+/* Untag on egress; a modify adds the goto to Egress VLAN 1 */
+static of_list_instruction_t *bench_egress_vlan_instructions_new(uint32_t key, uint32_t generation)
+{
+  of_list_instruction_t *insts = of_list_instruction_new(OF_VERSION_1_3);
+  of_instruction_apply_actions_t *inst;
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+  of_action_pop_vlan_t *pop;
+
+  pop = of_action_pop_vlan_new(OF_VERSION_1_3);
+  of_list_action_append(actions, pop);
+  of_object_delete(pop);
+
+  inst = of_instruction_apply_actions_new(OF_VERSION_1_3);
+  of_instruction_apply_actions_actions_set(inst, actions);
+  of_list_instruction_append(insts, inst);
+  of_object_delete(inst);
+  of_object_delete(actions);
+
+  if (generation != 0)
+  {
+    bench_goto_append(insts, OFDPA_FLOW_TABLE_ID_EGRESS_VLAN_1);
+  }
+  return insts;
+}
+
+/* Matches. Every key gives a distinct flow within its table. */
+
+static void bench_mac_set(of_mac_addr_t *mac, uint8_t prefix, uint32_t key)
+{
+  mac->addr[0] = 0x00;
+  mac->addr[1] = 0x00;
+  mac->addr[2] = prefix;
+  mac->addr[3] = (key >> 16) & 0xff;
+  mac->addr[4] = (key >> 8) & 0xff;
+  mac->addr[5] = key & 0xff;
+}
+
+static void bench_mac_mask_set(of_mac_addr_t *mac)
+{
+  memset(mac->addr, 0xff, sizeof(mac->addr));
+}
+
+/* Tagged traffic on a port and VLAN */
+static void bench_vlan_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.in_port = 1 + (key % BENCH_PORTS);
+  match->masks.in_port = 0xffffffff;
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | (2 + (key / BENCH_PORTS) % 4000);
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+}
+
+/* The router MAC on a port and VLAN */
+static void bench_termination_mac_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.in_port = 1 + (key % BENCH_PORTS);
+  match->masks.in_port = 0xffffffff;
+  match->fields.eth_type = ETH_P_IP;
+  match->masks.eth_type = 0xffff;
+  bench_mac_set(&match->fields.eth_dst, 0x5e, 1);
+  bench_mac_mask_set(&match->masks.eth_dst);
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | (2 + (key / BENCH_PORTS) % 4000);
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+}
+
+/* Host routes in 10/8 */
+static void bench_unicast_routing_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.eth_type = ETH_P_IP;
+  match->masks.eth_type = 0xffff;
+  match->fields.ipv4_dst = 0x0a000000 + key;
+  match->masks.ipv4_dst = 0xffffffff;
+}
+
+/* Any source multicast in 239/8 */
+static void bench_multicast_routing_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.eth_type = ETH_P_IP;
+  match->masks.eth_type = 0xffff;
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | BENCH_VLAN;
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+  match->fields.ipv4_dst = 0xef000000 + key;
+  match->masks.ipv4_dst = 0xffffffff;
+}
+
+/* Learned hosts on a VLAN */
+static void bench_bridging_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | BENCH_VLAN;
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+  bench_mac_set(&match->fields.eth_dst, 0x10, key);
+  bench_mac_mask_set(&match->masks.eth_dst);
+}
+
+/* TCP service to a host */
+static void bench_acl_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.eth_type = ETH_P_IP;
+  match->masks.eth_type = 0xffff;
+  match->fields.ip_proto = IPPROTO_TCP;
+  match->masks.ip_proto = 0xff;
+  match->fields.ipv4_dst = 0x0a000000 + key;
+  match->masks.ipv4_dst = 0xffffffff;
+  match->fields.tcp_dst = 80;
+  match->masks.tcp_dst = 0xffff;
+}
+
+/* Bottom of stack labels from 16 up */
+static void bench_mpls_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.eth_type = ETH_P_MPLS_UC;
+  match->masks.eth_type = 0xffff;
+  match->fields.mpls_label = 16 + key;
+  match->masks.mpls_label = 0xfffff;
+  match->fields.mpls_bos = 1;
+  match->masks.mpls_bos = 1;
+}
+
+/* Hosts on a VLAN sent out untagged */
+static void bench_egress_vlan_match_build(uint32_t key, of_match_t *match)
+{
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | (2 + key % 4000);
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+  bench_mac_set(&match->fields.eth_dst, 0x20, key);
+  bench_mac_mask_set(&match->masks.eth_dst);
+}
+
+static const bench_table_t bench_tables[] =
+{
+  { OFDPA_FLOW_TABLE_ID_VLAN, "VLAN",
+    bench_vlan_match_build, bench_vlan_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_TERMINATION_MAC, "Termination MAC",
+    bench_termination_mac_match_build, bench_termination_mac_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_MPLS_0, "MPLS 0",
+    bench_mpls_match_build, bench_mpls_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_MPLS_1, "MPLS 1",
+    bench_mpls_match_build, bench_mpls_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_MPLS_2, "MPLS 2",
+    bench_mpls_match_build, bench_mpls_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_UNICAST_ROUTING, "Unicast Routing",
+    bench_unicast_routing_match_build, bench_next_hop_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_MULTICAST_ROUTING, "Multicast Routing",
+    bench_multicast_routing_match_build, bench_multicast_routing_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_BRIDGING, "Bridging",
+    bench_bridging_match_build, bench_bridging_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_ACL_POLICY, "ACL Policy",
+    bench_acl_match_build, bench_acl_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_ACL_POLICY, "ACL Policy meter",
+    bench_acl_match_build, bench_acl_meter_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_ACL_POLICY, "ACL Policy queue",
+    bench_acl_match_build, bench_acl_queue_instructions_new },
+  { OFDPA_FLOW_TABLE_ID_EGRESS_VLAN, "Egress VLAN",
+    bench_egress_vlan_match_build, bench_egress_vlan_instructions_new },
+};
+
+#define BENCH_TABLES (sizeof(bench_tables) / sizeof(bench_tables[0]))
+
+/* Flow mod objects */
+
+static of_flow_add_t *bench_flow_add_new(const bench_table_t *table, uint32_t key)
+{
+  of_flow_add_t *flow_add;
+  of_list_instruction_t *insts;
+  of_match_t match;
+
+  flow_add = of_flow_add_new(OF_VERSION_1_3);
+  if (flow_add == NULL)
+  {
+    return NULL;
+  }
+  of_flow_add_table_id_set(flow_add, table->table_id);
+  of_flow_add_priority_set(flow_add, BENCH_PRIORITY);
+
+  memset(&match, 0, sizeof(match));
+  table->match_build(key, &match);
+  insts = table->instructions_new(key, 0);
+  if ((of_flow_add_match_set(flow_add, &match) < 0) ||
+      (of_flow_add_instructions_set(flow_add, insts) < 0))
+  {
+    of_object_delete(insts);
+    of_object_delete(flow_add);
+    return NULL;
+  }
+  of_object_delete(insts);
+
+  return flow_add;
+}
+
+static of_flow_modify_strict_t *bench_flow_modify_new(const bench_table_t *table, uint32_t key)
+{
+  of_flow_modify_strict_t *flow_modify;
+  of_list_instruction_t *insts;
+  of_match_t match;
+
+  flow_modify = of_flow_modify_strict_new(OF_VERSION_1_3);
+  if (flow_modify == NULL)
+  {
+    return NULL;
+  }
+  of_flow_modify_strict_table_id_set(flow_modify, table->table_id);
+  of_flow_modify_strict_priority_set(flow_modify, BENCH_PRIORITY);
+
+  memset(&match, 0, sizeof(match));
+  table->match_build(key, &match);
+  insts = table->instructions_new(key, 1);
+  if ((of_flow_modify_strict_match_set(flow_modify, &match) < 0) ||
+      (of_flow_modify_strict_instructions_set(flow_modify, insts) < 0))
+  {
+    of_object_delete(insts);
+    of_object_delete(flow_modify);
+    return NULL;
+  }
+  of_object_delete(insts);
+
+  return flow_modify;
+}
+
+/* Measurement */
+
+static uint64_t bench_flow_calls(void)
+{
+  return utest_sim_calls(OFDPA_SIM_CALL_FLOW);
+}
+
+static void bench_account(bench_result_t *result, uint64_t start_ns, uint64_t start_calls)
+{
+  uint64_t elapsed_ns = ind_ofdpa_rpc_now_ns() - start_ns;
+
+  result->ns += elapsed_ns;
+  if ((result->best_ns == 0) || (elapsed_ns < result->best_ns))
+  {
+    result->best_ns = elapsed_ns;
+  }
+  result->calls += bench_flow_calls() - start_calls;
+}
+
+static void bench_report(const bench_table_t *table, bench_op_t op, const bench_result_t *result,
+                         uint32_t flows, uint32_t rounds)
+{
+  double ops = (double)flows * rounds;
+
+  printf("{\"label\":\"%s\",\"test\":\"flows\",\"table\":\"%s\",\"table_id\":%u,\"op\":\"%s\","
+         "\"flows\":%u,\"rounds\":%u,\"errors\":%u,\"ns_per_op\":%.1f,"
+         "\"best_ns_per_op\":%.1f,\"ofdpa_calls_per_op\":%.2f}\n",
+         utest_label, table->name, table->table_id, bench_op_names[op],
+         flows, rounds, result->errors, (double)result->ns / ops,
+         (double)result->best_ns / flows, (double)result->calls / ops);
+  fflush(stdout);
+}
+
+static int bench_table_run(const bench_table_t *table, uint32_t flows, uint32_t rounds)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  void *table_priv = INDIGO_COOKIE_TO_POINTER(table->table_id);
+  bench_result_t results[BENCH_OPS];
+  of_flow_add_t **adds;
+  of_flow_modify_strict_t **modifies;
+  of_match_t *matches;
+  void **entries;
+  ofdpaFlowTableInfo_t info;
+  ofdpaFlowEntry_t flow;
+  indigo_fi_flow_stats_t flow_stats;
+  uint64_t start_ns, start_calls;
+  uint32_t round, i;
+  int op, rv = -1;
+
+  if ((ofdpaFlowTableInfoGet(table->table_id, &info) == OFDPA_E_NONE) &&
+      (info.maxEntries - info.numEntries < flows))
+  {
+    flows = info.maxEntries - info.numEntries;
+  }
+  if (flows == 0)
+  {
+    fprintf(stderr, "%s: table is full\n", table->name);
+    return -1;
+  }
+
+  memset(results, 0, sizeof(results));
+  adds = calloc(flows, sizeof(*adds));
+  modifies = calloc(flows, sizeof(*modifies));
+  matches = calloc(flows, sizeof(*matches));
+  entries = calloc(flows, sizeof(*entries));
+  if ((adds == NULL) || (modifies == NULL) || (matches == NULL) || (entries == NULL))
+  {
+    fprintf(stderr, "%s: out of memory\n", table->name);
+    goto done;
+  }
+
+  for (i = 0; i < flows; i++)
+  {
+    adds[i] = bench_flow_add_new(table, i);
+    modifies[i] = bench_flow_modify_new(table, i);
+    if ((adds[i] == NULL) || (modifies[i] == NULL) ||
+        (of_flow_add_match_get(adds[i], &matches[i]) < 0))
+    {
+      fprintf(stderr, "%s: failed to build flow %u\n", table->name, i);
+      goto done;
+    }
+  }
+
+  for (round = 0; round < rounds; round++)
+  {
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      memset(&flow, 0, sizeof(flow));
+      flow.tableId = table->table_id;
+      ind_ofdpa_match_fields_bitmask = 0;
+      if (ops->match_get(&matches[i], &flow) != INDIGO_ERROR_NONE)
+      {
+        results[BENCH_OP_MATCH].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_MATCH], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      memset(&flow, 0, sizeof(flow));
+      flow.tableId = table->table_id;
+      if (ops->instructions_get((of_flow_modify_t *)adds[i], &flow) != INDIGO_ERROR_NONE)
+      {
+        results[BENCH_OP_INSTRUCTIONS].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_INSTRUCTIONS], start_ns, start_calls);
+
+    /* Flow ids only have to be unique among the installed flows */
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      if (ops->table_ops->entry_create(table_priv, 0, adds[i], i + 1, &entries[i]) != INDIGO_ERROR_NONE)
+      {
+        entries[i] = NULL;
+        results[BENCH_OP_CREATE].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_CREATE], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (ops->table_ops->entry_modify(table_priv, 0, entries[i], modifies[i]) != INDIGO_ERROR_NONE))
+      {
+        results[BENCH_OP_MODIFY].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_MODIFY], start_ns, start_calls);
+
+    /* The same modify again, as a controller resync sends it */
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (ops->table_ops->entry_modify(table_priv, 0, entries[i], modifies[i]) != INDIGO_ERROR_NONE))
+      {
+        results[BENCH_OP_MODIFY_UNCHANGED].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_MODIFY_UNCHANGED], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = bench_flow_calls();
+    for (i = 0; i < flows; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (ops->table_ops->entry_delete(table_priv, 0, entries[i], &flow_stats) != INDIGO_ERROR_NONE))
+      {
+        results[BENCH_OP_DELETE].errors++;
+      }
+    }
+    bench_account(&results[BENCH_OP_DELETE], start_ns, start_calls);
+  }
+
+  for (op = 0; op < BENCH_OPS; op++)
+  {
+    bench_report(table, op, &results[op], flows, rounds);
+  }
+  rv = 0;
+
+done:
+  for (i = 0; i < flows; i++)
+  {
+    if ((adds != NULL) && (adds[i] != NULL))
+    {
+      of_object_delete(adds[i]);
+    }
+    if ((modifies != NULL) && (modifies[i] != NULL))
+    {
+      of_object_delete(modifies[i]);
+    }
+  }
+  free(adds);
+  free(modifies);
+  free(matches);
+  free(entries);
+  return rv;
+}
+
+int flow_bench_run(void)
+{
+  uint32_t flows = UTEST_COUNT(BENCH_FLOWS_DEFAULT);
+  uint32_t rounds = UTEST_ROUNDS(BENCH_ROUNDS_DEFAULT);
+  int rv = 0;
+  uint32_t i;
+
+  bench_groups_add();
+  bench_meters_add();
+
+  for (i = 0; i < BENCH_TABLES; i++)
+  {
+    if ((utest_table >= 0) && (bench_tables[i].table_id != (OFDPA_FLOW_TABLE_ID_t)utest_table))
+    {
+      continue;
+    }
+    if (bench_table_run(&bench_tables[i], flows, rounds) < 0)
+    {
+      rv = -1;
+    }
+  }
+
+  bench_meters_delete();
+  bench_groups_delete();
+
+  return rv;
+}
@@ -0,0 +1,417 @@
+/**************************************************************************//**
+ *
+ * Group programming benchmark ("groups").
+ *
+ * Builds OpenFlow 1.3 group buckets for each OF-DPA group type the
+ * controller programs, and times the driver against libofdpa_sim: bucket
+ * translation alone, then group create, modify, unchanged modify and
+ * delete through the group table operations Indigo calls. The "mixed" run interleaves every type, one group of
+ * each in turn, as a controller installing next hops does. One record
+ * per type and operation:
+ *
+ *   {"label":"...","test":"groups","type":"l3_ecmp","op":"create",
+ *    "groups":256,"rounds":5,"buckets_per_group":8.0,"errors":0,
+ *    "ns_per_op":5725.4,"best_ns_per_op":5133.1,"ns_per_bucket":715.7,
+ *    "ofdpa_calls_per_op":9.00}
+ *
+ * -n sets the groups per type (default 256) and -r the rounds (default
+ * 5). An operation OF-DPA rejects counts as an error and fails the test.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AIM/aim.h>
+
+#include "utest.h"
+
+#define GBENCH_GROUPS_DEFAULT   256
+#define GBENCH_ROUNDS_DEFAULT   5
+#define GBENCH_PORTS            32
+#define GBENCH_NEXT_HOPS        16
+#define GBENCH_NEXT_HOP_INDEX   0x8000
+#define GBENCH_VLAN             40      /* next hops, flood and multicast groups */
+#define GBENCH_L2_VLAN_BASE     41      /* benchmarked L2 interface groups */
+#define GBENCH_ECMP_MEMBERS     8
+#define GBENCH_FLOOD_MEMBERS    16
+
+typedef enum
+{
+  GBENCH_OP_TRANSLATE = 0,
+  GBENCH_OP_CREATE,
+  GBENCH_OP_MODIFY,
+  GBENCH_OP_MODIFY_UNCHANGED,
+  GBENCH_OP_DELETE,
+  GBENCH_OPS
+} gbench_op_t;
+
+static const char *gbench_op_names[GBENCH_OPS] =
+{
+  "translate", "create", "modify", "modify_unchanged", "delete"
+};
+
+typedef struct
+{
+  uint64_t ns;
+  uint64_t best_ns;
+  uint64_t calls;
+  uint32_t errors;
+} gbench_result_t;
+
+typedef struct
+{
+  const char *name;
+  uint8_t group_type;                   /* OpenFlow group type */
+  uint32_t buckets;                     /* per group */
+  uint32_t (*group_id)(uint32_t key);
+  /* generation changes the buckets, so a modify has something to do */
+  of_list_bucket_t *(*buckets_new)(uint32_t key, uint32_t generation);
+} gbench_type_t;
+
+static uint32_t l2_interface_groups[GBENCH_PORTS];
+static uint32_t l3_unicast_groups[GBENCH_NEXT_HOPS];
+
+/* Next hops */
+
+static void gbench_next_hops_add(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < GBENCH_PORTS; i++)
+  {
+    l2_interface_groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, GBENCH_VLAN, i + 1);
+  }
+  for (i = 0; i < GBENCH_NEXT_HOPS; i++)
+  {
+    l3_unicast_groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0,
+                                           GBENCH_NEXT_HOP_INDEX + i);
+  }
+}
+
+static void gbench_next_hops_delete(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < GBENCH_NEXT_HOPS; i++)
+  {
+    (void)ofdpaGroupDelete(l3_unicast_groups[i]);
+  }
+  for (i = 0; i < GBENCH_PORTS; i++)
+  {
+    (void)ofdpaGroupDelete(l2_interface_groups[i]);
+  }
+}
+
+/* Group IDs */
+
+static uint32_t gbench_l2_interface_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE,
+                        GBENCH_L2_VLAN_BASE + key / GBENCH_PORTS, 1 + key % GBENCH_PORTS);
+}
+
+static uint32_t gbench_l2_rewrite_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE, 0, key + 1);
+}
+
+static uint32_t gbench_l3_interface_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE, 0, key + 1);
+}
+
+static uint32_t gbench_l3_unicast_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, key + 1);
+}
+
+static uint32_t gbench_l3_ecmp_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_ECMP, 0, key + 1);
+}
+
+static uint32_t gbench_l2_flood_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD, GBENCH_VLAN, key + 1);
+}
+
+static uint32_t gbench_l3_multicast_id(uint32_t key)
+{
+  return utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST, GBENCH_VLAN, key + 1);
+}
+
+/* Buckets */
+
+static of_list_bucket_t *gbench_l2_interface_buckets_new(uint32_t key, uint32_t generation)
+{
+  return utest_l2_interface_buckets_new(1 + key % GBENCH_PORTS, generation & 1);
+}
+
+static of_list_bucket_t *gbench_rewrite_buckets_new(uint32_t key, uint32_t generation)
+{
+  return utest_l3_unicast_buckets_new(l2_interface_groups[key % GBENCH_PORTS], GBENCH_VLAN,
+                                      (generation << 16) | (key & 0xffff));
+}
+
+static of_list_bucket_t *gbench_l3_interface_buckets_new(uint32_t key, uint32_t generation)
+{
+  return utest_l3_interface_buckets_new(l2_interface_groups[key % GBENCH_PORTS], GBENCH_VLAN,
+                                        (generation << 16) | (key & 0xffff));
+}
+
+static of_list_bucket_t *gbench_l3_unicast_buckets_new(uint32_t key, uint32_t generation)
+{
+  return utest_l3_unicast_buckets_new(l2_interface_groups[(key + generation) % GBENCH_PORTS],
+                                      GBENCH_VLAN, (generation << 16) | (key & 0xffff));
+}
+
+/* count of the next hops from start on, wrapping around */
+static of_list_bucket_t *gbench_members_new(const uint32_t *next_hops, uint32_t num_next_hops,
+                                            uint32_t start, uint32_t count)
+{
+  uint32_t refs[GBENCH_PORTS];
+  uint32_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    refs[i] = next_hops[(start + i) % num_next_hops];
+  }
+  return utest_ref_buckets_new(refs, count);
+}
+
+/* A modify moves each group to the other half of the next hops */
+static of_list_bucket_t *gbench_l3_ecmp_buckets_new(uint32_t key, uint32_t generation)
+{
+  return gbench_members_new(l3_unicast_groups, GBENCH_NEXT_HOPS,
+                            key + generation * GBENCH_ECMP_MEMBERS, GBENCH_ECMP_MEMBERS);
+}
+
+static of_list_bucket_t *gbench_flood_buckets_new(uint32_t key, uint32_t generation)
+{
+  return gbench_members_new(l2_interface_groups, GBENCH_PORTS,
+                            key + generation * GBENCH_FLOOD_MEMBERS, GBENCH_FLOOD_MEMBERS);
+}
+
+static const gbench_type_t gbench_types[] =
+{
+  { "l2_interface", OF_GROUP_TYPE_INDIRECT, 1,
+    gbench_l2_interface_id, gbench_l2_interface_buckets_new },
+  { "l2_rewrite", OF_GROUP_TYPE_INDIRECT, 1,
+    gbench_l2_rewrite_id, gbench_rewrite_buckets_new },
+  { "l3_interface", OF_GROUP_TYPE_INDIRECT, 1,
+    gbench_l3_interface_id, gbench_l3_interface_buckets_new },
+  { "l3_unicast", OF_GROUP_TYPE_INDIRECT, 1,
+    gbench_l3_unicast_id, gbench_l3_unicast_buckets_new },
+  { "l3_ecmp", OF_GROUP_TYPE_SELECT, GBENCH_ECMP_MEMBERS,
+    gbench_l3_ecmp_id, gbench_l3_ecmp_buckets_new },
+  { "l2_flood", OF_GROUP_TYPE_ALL, GBENCH_FLOOD_MEMBERS,
+    gbench_l2_flood_id, gbench_flood_buckets_new },
+  { "l3_multicast", OF_GROUP_TYPE_ALL, GBENCH_FLOOD_MEMBERS,
+    gbench_l3_multicast_id, gbench_flood_buckets_new },
+};
+
+#define GBENCH_TYPES (sizeof(gbench_types) / sizeof(gbench_types[0]))
+
+/* Measurement */
+
+static uint64_t gbench_group_calls(void)
+{
+  return utest_sim_calls(OFDPA_SIM_CALL_GROUP);
+}
+
+static void gbench_account(gbench_result_t *result, uint64_t start_ns, uint64_t start_calls)
+{
+  uint64_t elapsed_ns = ind_ofdpa_rpc_now_ns() - start_ns;
+
+  result->ns += elapsed_ns;
+  if ((result->best_ns == 0) || (elapsed_ns < result->best_ns))
+  {
+    result->best_ns = elapsed_ns;
+  }
+  result->calls += gbench_group_calls() - start_calls;
+}
+
+static void gbench_report(const char *name, gbench_op_t op, const gbench_result_t *result,
+                          uint32_t groups, uint32_t rounds, double buckets_per_group)
+{
+  double ops = (double)groups * rounds;
+
+  printf("{\"label\":\"%s\",\"test\":\"groups\",\"type\":\"%s\",\"op\":\"%s\","
+         "\"groups\":%u,\"rounds\":%u,\"buckets_per_group\":%.1f,\"errors\":%u,"
+         "\"ns_per_op\":%.1f,\"best_ns_per_op\":%.1f,\"ns_per_bucket\":%.1f,"
+         "\"ofdpa_calls_per_op\":%.2f}\n",
+         utest_label, name, gbench_op_names[op], groups, rounds, buckets_per_group,
+         result->errors, (double)result->ns / ops, (double)result->best_ns / groups,
+         (double)result->ns / (ops * buckets_per_group), (double)result->calls / ops);
+  fflush(stdout);
+}
+
+/*
+ * Time groups of the given types, group i of type types[i % num_types]
+ * with key i / num_types. Returns the number of errors, or -1 if the
+ * run could not be set up.
+ */
+static int gbench_run(const char *name, const gbench_type_t *types, uint32_t num_types,
+                      uint32_t groups, uint32_t rounds)
+{
+  const ind_ofdpa_group_bench_ops_t *ops = ind_ofdpa_group_bench_ops_get();
+  gbench_result_t results[GBENCH_OPS];
+  const gbench_type_t *type;
+  ofdpaGroupBucketEntry_t *bucket_entries;
+  uint32_t num_bucket_entries;
+  of_list_bucket_t **adds;
+  of_list_bucket_t **modifies;
+  uint32_t *group_ids;
+  void **entries;
+  uint64_t start_ns, start_calls;
+  uint32_t buckets = 0;
+  uint32_t round, i;
+  int op, rv = -1;
+
+  memset(results, 0, sizeof(results));
+  adds = calloc(groups, sizeof(*adds));
+  modifies = calloc(groups, sizeof(*modifies));
+  group_ids = calloc(groups, sizeof(*group_ids));
+  entries = calloc(groups, sizeof(*entries));
+  if ((adds == NULL) || (modifies == NULL) || (group_ids == NULL) || (entries == NULL))
+  {
+    fprintf(stderr, "%s: out of memory\n", name);
+    goto done;
+  }
+
+  for (i = 0; i < groups; i++)
+  {
+    type = &types[i % num_types];
+    group_ids[i] = type->group_id(i / num_types);
+    adds[i] = type->buckets_new(i / num_types, 0);
+    modifies[i] = type->buckets_new(i / num_types, 1);
+    buckets += type->buckets;
+    if ((adds[i] == NULL) || (modifies[i] == NULL))
+    {
+      fprintf(stderr, "%s: failed to build group %u\n", name, i);
+      goto done;
+    }
+  }
+
+  for (round = 0; round < rounds; round++)
+  {
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = gbench_group_calls();
+    for (i = 0; i < groups; i++)
+    {
+      if (ops->buckets_translate(group_ids[i], adds[i], &bucket_entries,
+                                 &num_bucket_entries) != INDIGO_ERROR_NONE)
+      {
+        results[GBENCH_OP_TRANSLATE].errors++;
+        continue;
+      }
+      free(bucket_entries);
+    }
+    gbench_account(&results[GBENCH_OP_TRANSLATE], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = gbench_group_calls();
+    for (i = 0; i < groups; i++)
+    {
+      if (utest_driver_group_create(group_ids[i], types[i % num_types].group_type, adds[i],
+                                    &entries[i]) != INDIGO_ERROR_NONE)
+      {
+        entries[i] = NULL;
+        results[GBENCH_OP_CREATE].errors++;
+      }
+    }
+    gbench_account(&results[GBENCH_OP_CREATE], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = gbench_group_calls();
+    for (i = 0; i < groups; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (utest_driver_group_modify(group_ids[i], entries[i], modifies[i]) != INDIGO_ERROR_NONE))
+      {
+        results[GBENCH_OP_MODIFY].errors++;
+      }
+    }
+    gbench_account(&results[GBENCH_OP_MODIFY], start_ns, start_calls);
+
+    /* The same modify again, as a controller resync sends it */
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = gbench_group_calls();
+    for (i = 0; i < groups; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (utest_driver_group_modify(group_ids[i], entries[i], modifies[i]) != INDIGO_ERROR_NONE))
+      {
+        results[GBENCH_OP_MODIFY_UNCHANGED].errors++;
+      }
+    }
+    gbench_account(&results[GBENCH_OP_MODIFY_UNCHANGED], start_ns, start_calls);
+
+    start_ns = ind_ofdpa_rpc_now_ns();
+    start_calls = gbench_group_calls();
+    for (i = 0; i < groups; i++)
+    {
+      if ((entries[i] == NULL) ||
+          (utest_driver_group_delete(group_ids[i], entries[i]) != INDIGO_ERROR_NONE))
+      {
+        results[GBENCH_OP_DELETE].errors++;
+      }
+      entries[i] = NULL;
+    }
+    gbench_account(&results[GBENCH_OP_DELETE], start_ns, start_calls);
+  }
+
+  rv = 0;
+  for (op = 0; op < GBENCH_OPS; op++)
+  {
+    gbench_report(name, op, &results[op], groups, rounds, (double)buckets / groups);
+    rv += results[op].errors;
+  }
+
+done:
+  for (i = 0; i < groups; i++)
+  {
+    if ((adds != NULL) && (adds[i] != NULL))
+    {
+      of_object_delete(adds[i]);
+    }
+    if ((modifies != NULL) && (modifies[i] != NULL))
+    {
+      of_object_delete(modifies[i]);
+    }
+  }
+  free(adds);
+  free(modifies);
+  free(group_ids);
+  free(entries);
+  return rv;
+}
+
+int group_bench_run(void)
+{
+  uint32_t groups = UTEST_COUNT(GBENCH_GROUPS_DEFAULT);
+  uint32_t rounds = UTEST_ROUNDS(GBENCH_ROUNDS_DEFAULT);
+  int rv = 0;
+  uint32_t i;
+
+  gbench_next_hops_add();
+
+  for (i = 0; i < GBENCH_TYPES; i++)
+  {
+    if (gbench_run(gbench_types[i].name, &gbench_types[i], 1, groups, rounds) != 0)
+    {
+      rv = -1;
+    }
+  }
+  if (gbench_run("mixed", gbench_types, GBENCH_TYPES, groups * GBENCH_TYPES, rounds) != 0)
+  {
+    rv = -1;
+  }
+
+  gbench_next_hops_delete();
+
+  return rv;
+}
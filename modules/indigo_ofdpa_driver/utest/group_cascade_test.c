@@ -0,0 +1,267 @@
+/**************************************************************************//**
+ *
+ * Group delete cascade test ("group_cascade").
+ *
+ * Adds bridging flows through the driver's flow table operations, most
+ * of them writing one L2 interface group and one writing another. A
+ * delete of the first group is rejected while cascading is off and must
+ * not touch its flows. With cascading on, the delete removes exactly the
+ * flows that use the group, and each of them is reported to Indigo as
+ * removed by a delete, under the flow id Indigo gave it. The flow using
+ * the other group stays and is not reported.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AIM/aim.h>
+#include <indigo/fi.h>
+
+#include "utest.h"
+
+#define CASCADE_VLAN            40
+#define CASCADE_FLOWS           16
+#define CASCADE_FLOW_ID_BASE    0xca5c0000ULL
+#define CASCADE_PRIORITY        1000
+
+static of_flow_add_t *cascade_flow_add_new(uint32_t key, uint32_t group_id)
+{
+  of_flow_add_t *flow_add;
+  of_list_instruction_t *insts;
+  of_list_action_t *actions;
+  of_instruction_write_actions_t *write_actions;
+  of_instruction_goto_table_t *goto_table;
+  of_action_group_t *group;
+  of_match_t match;
+
+  flow_add = of_flow_add_new(OF_VERSION_1_3);
+  if (flow_add == NULL)
+  {
+    return NULL;
+  }
+  of_flow_add_table_id_set(flow_add, OFDPA_FLOW_TABLE_ID_BRIDGING);
+  of_flow_add_priority_set(flow_add, CASCADE_PRIORITY);
+
+  memset(&match, 0, sizeof(match));
+  match.fields.vlan_vid = OFDPA_VID_PRESENT | CASCADE_VLAN;
+  match.masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+  match.fields.eth_dst.addr[2] = 0x10;
+  match.fields.eth_dst.addr[4] = (key >> 8) & 0xff;
+  match.fields.eth_dst.addr[5] = key & 0xff;
+  memset(match.masks.eth_dst.addr, 0xff, sizeof(match.masks.eth_dst.addr));
+
+  insts = of_list_instruction_new(OF_VERSION_1_3);
+  actions = of_list_action_new(OF_VERSION_1_3);
+  group = of_action_group_new(OF_VERSION_1_3);
+  of_action_group_group_id_set(group, group_id);
+  of_list_action_append(actions, group);
+  of_object_delete(group);
+  write_actions = of_instruction_write_actions_new(OF_VERSION_1_3);
+  of_instruction_write_actions_actions_set(write_actions, actions);
+  of_list_instruction_append(insts, write_actions);
+  of_object_delete(write_actions);
+  of_object_delete(actions);
+  goto_table = of_instruction_goto_table_new(OF_VERSION_1_3);
+  of_instruction_goto_table_table_id_set(goto_table, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  of_list_instruction_append(insts, goto_table);
+  of_object_delete(goto_table);
+
+  if ((of_flow_add_match_set(flow_add, &match) < 0) ||
+      (of_flow_add_instructions_set(flow_add, insts) < 0))
+  {
+    of_object_delete(insts);
+    of_object_delete(flow_add);
+    return NULL;
+  }
+  of_object_delete(insts);
+
+  return flow_add;
+}
+
+static uint32_t cascade_bridging_flows(void)
+{
+  ofdpaFlowTableInfo_t info;
+
+  if (ofdpaFlowTableInfoGet(OFDPA_FLOW_TABLE_ID_BRIDGING, &info) != OFDPA_E_NONE)
+  {
+    return 0;
+  }
+  return info.numEntries;
+}
+
+/* Add flow key through the driver, as Indigo flow flow_id */
+static int cascade_flow_create(uint32_t key, uint32_t group_id, indigo_cookie_t flow_id,
+                               void **entry_priv)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  of_flow_add_t *flow_add;
+  indigo_error_t err;
+  int failures = 0;
+
+  flow_add = cascade_flow_add_new(key, group_id);
+  UTEST_CHECK(failures, flow_add != NULL, "flow %u: failed to build", key);
+  if (flow_add == NULL)
+  {
+    *entry_priv = NULL;
+    return failures;
+  }
+  err = ops->table_ops->entry_create(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                     flow_add, flow_id, entry_priv);
+  of_object_delete(flow_add);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: create failed, err %d", key, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    *entry_priv = NULL;
+  }
+  return failures;
+}
+
+int group_cascade_test_run(void)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  const utest_flow_removed_t *removed;
+  of_list_bucket_t *buckets;
+  indigo_fi_flow_stats_t flow_stats;
+  uint32_t group_id = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, CASCADE_VLAN, 1);
+  uint32_t other_id = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, CASCADE_VLAN, 2);
+  void *group_entry = NULL;
+  void *other_entry = NULL;
+  void *other_flow = NULL;
+  void *flows[CASCADE_FLOWS];
+  uint32_t base_flows = cascade_bridging_flows();
+  uint32_t reported[CASCADE_FLOWS];
+  uint32_t count;
+  uint32_t i;
+  uint32_t key;
+  indigo_error_t err;
+  int failures = 0;
+
+  memset(flows, 0, sizeof(flows));
+  memset(reported, 0, sizeof(reported));
+
+  buckets = utest_l2_interface_buckets_new(1, 1);
+  err = utest_driver_group_create(group_id, OF_GROUP_TYPE_INDIRECT, buckets, &group_entry);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: create failed, err %d",
+              group_id, err);
+  buckets = utest_l2_interface_buckets_new(2, 1);
+  err = utest_driver_group_create(other_id, OF_GROUP_TYPE_INDIRECT, buckets, &other_entry);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: create failed, err %d",
+              other_id, err);
+  if (failures != 0)
+  {
+    goto done;
+  }
+
+  for (i = 0; i < CASCADE_FLOWS; i++)
+  {
+    failures += cascade_flow_create(i, group_id, CASCADE_FLOW_ID_BASE + i, &flows[i]);
+  }
+  failures += cascade_flow_create(CASCADE_FLOWS, other_id, CASCADE_FLOW_ID_BASE + CASCADE_FLOWS,
+                                  &other_flow);
+  if (failures != 0)
+  {
+    goto done;
+  }
+  utest_flow_removed_clear();
+
+  /* Without cascading the group is still in use */
+  ind_ofdpa_group_delete_cascade_set(0);
+  err = utest_driver_group_delete(group_id, group_entry);
+  UTEST_CHECK(failures, err != INDIGO_ERROR_NONE,
+              "group 0x%08x: delete with %u flows succeeded without cascade",
+              group_id, CASCADE_FLOWS);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    group_entry = NULL;
+    goto done;
+  }
+  (void)utest_flow_removed_get(&count);
+  UTEST_CHECK(failures, count == 0, "rejected delete reported %u flows removed", count);
+  UTEST_CHECK(failures, cascade_bridging_flows() == base_flows + CASCADE_FLOWS + 1,
+              "rejected delete left %u bridging flows, expected %u",
+              cascade_bridging_flows() - base_flows, CASCADE_FLOWS + 1);
+
+  ind_ofdpa_group_delete_cascade_set(1);
+  err = utest_driver_group_delete(group_id, group_entry);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: cascaded delete failed, err %d",
+              group_id, err);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    group_entry = NULL;
+    memset(flows, 0, sizeof(flows));
+  }
+  UTEST_CHECK(failures, cascade_bridging_flows() == base_flows + 1,
+              "cascaded delete left %u bridging flows, expected 1",
+              cascade_bridging_flows() - base_flows);
+
+  removed = utest_flow_removed_get(&count);
+  UTEST_CHECK(failures, count == CASCADE_FLOWS, "cascaded delete reported %u flows removed, expected %u",
+              count, CASCADE_FLOWS);
+  for (i = 0; i < count; i++)
+  {
+    UTEST_CHECK(failures, removed[i].reason == INDIGO_FLOW_REMOVED_DELETE,
+                "flow 0x%llx reported removed with reason %d",
+                (unsigned long long)removed[i].flow_id, removed[i].reason);
+    if ((removed[i].flow_id < CASCADE_FLOW_ID_BASE) ||
+        (removed[i].flow_id >= CASCADE_FLOW_ID_BASE + CASCADE_FLOWS))
+    {
+      UTEST_CHECK(failures, 0, "flow 0x%llx reported removed, it does not use group 0x%08x",
+                  (unsigned long long)removed[i].flow_id, group_id);
+      continue;
+    }
+    reported[removed[i].flow_id - CASCADE_FLOW_ID_BASE]++;
+  }
+  for (key = 0; key < CASCADE_FLOWS; key++)
+  {
+    UTEST_CHECK(failures, reported[key] == 1, "flow 0x%llx reported removed %u times",
+                (unsigned long long)(CASCADE_FLOW_ID_BASE + key), reported[key]);
+  }
+
+  /* Indigo deletes its own flows and is not told about them */
+  utest_flow_removed_clear();
+  err = ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                     other_flow, &flow_stats);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: delete failed, err %d",
+              CASCADE_FLOWS, err);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    other_flow = NULL;
+  }
+  (void)utest_flow_removed_get(&count);
+  UTEST_CHECK(failures, count == 0, "flow delete by Indigo reported %u flows removed", count);
+
+  printf("group_cascade: %u flows using the deleted group, %d failures\n",
+         CASCADE_FLOWS, failures);
+
+done:
+  for (i = 0; i < CASCADE_FLOWS; i++)
+  {
+    if (flows[i] != NULL)
+    {
+      (void)ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                         flows[i], &flow_stats);
+    }
+  }
+  if (other_flow != NULL)
+  {
+    (void)ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                       other_flow, &flow_stats);
+  }
+  if (group_entry != NULL)
+  {
+    (void)utest_driver_group_delete(group_id, group_entry);
+  }
+  if (other_entry != NULL)
+  {
+    (void)utest_driver_group_delete(other_id, other_entry);
+  }
+  ind_ofdpa_group_delete_cascade_set(0);
+  utest_flow_removed_clear();
+
+  return (failures == 0) ? 0 : -1;
+}
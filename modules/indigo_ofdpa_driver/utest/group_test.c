@@ -0,0 +1,461 @@
+/**************************************************************************//**
+ *
+ * Group member swap test ("group_swap").
+ *
+ * A group modify replaces buckets make-before-break, so a group keeps
+ * forwarding while its members change. This test swaps the members of
+ * ECMP, flood, resilient ECMP and indirect groups through the driver's
+ * group table operations. After every modify it checks that
+ * libofdpa_sim never saw the group lose its last bucket, and that the
+ * buckets programmed chain to exactly the new members. Modifies that
+ * OF-DPA rejects must leave the previous members in place. An MPLS fast
+ * failover group is modified while OF-DPA refuses bucket modifies, and
+ * must keep its primary bucket ahead of its backup.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AIM/aim.h>
+
+#include "utest.h"
+
+#define SWAP_VLAN               20
+#define SWAP_NEXT_HOPS          8
+#define SWAP_MEMBERS_MAX        4
+#define SWAP_RESILIENT_SLOTS    64
+#define SWAP_MISSING            (-1)    /* a next hop that was never added */
+#define SWAP_TUNNELS            3
+
+/* A member set, as indices into the next hops */
+typedef struct
+{
+  const char *name;
+  uint32_t count;
+  int members[SWAP_MEMBERS_MAX];
+  int fails;                            /* OF-DPA must reject the modify */
+} swap_step_t;
+
+static const swap_step_t swap_steps[] =
+{
+  { "replace one member",       4, { 0, 1, 2, 4 } },
+  { "reorder",                  4, { 4, 2, 1, 0 } },
+  { "replace every member",     4, { 5, 6, 7, 3 } },
+  { "shrink to one member",     1, { 6 } },
+  { "swap the only member",     1, { 7 } },
+  { "grow to four members",     4, { 0, 1, 2, 3 } },
+  { "add a missing member",     4, { 0, 1, 2, SWAP_MISSING }, 1 },
+  { "shrink to one member",     1, { 0 } },
+  { "swap to a missing member", 1, { SWAP_MISSING }, 1 },
+};
+
+#define SWAP_STEPS (sizeof(swap_steps) / sizeof(swap_steps[0]))
+
+static uint32_t l2_interface_ids[SWAP_NEXT_HOPS];
+static void *l2_interface_entries[SWAP_NEXT_HOPS];
+static uint32_t l3_unicast_ids[SWAP_NEXT_HOPS];
+static void *l3_unicast_entries[SWAP_NEXT_HOPS];
+
+static uint64_t swap_groups_emptied(void)
+{
+  ofdpa_sim_stats_t stats;
+
+  ofdpa_sim_stats_get(&stats);
+  return stats.groups_emptied;
+}
+
+static int swap_ref_cmp(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return (x < y) ? -1 : (x > y);
+}
+
+/* The referenced group IDs of the buckets OF-DPA holds for a group */
+static uint32_t swap_refs_read(uint32_t group_id, uint32_t *refs, uint32_t max_refs)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t count = 0;
+
+  memset(&bucket, 0, sizeof(bucket));
+  ofdpa_rv = ofdpaGroupBucketEntryFirstGet(group_id, &bucket);
+  while (ofdpa_rv == OFDPA_E_NONE)
+  {
+    if (count < max_refs)
+    {
+      refs[count] = bucket.referenceGroupId;
+    }
+    count++;
+    ofdpa_rv = ofdpaGroupBucketEntryNextGet(group_id, bucket.bucketIndex, &bucket);
+  }
+  return count;
+}
+
+/*
+ * Check that the group's buckets chain to exactly the expected groups. A
+ * resilient group has num_slots buckets instead, shared out evenly among
+ * the expected groups.
+ */
+static int swap_refs_check(const char *what, uint32_t group_id, uint32_t num_slots,
+                           const uint32_t *expected, uint32_t count)
+{
+  uint32_t refs[SWAP_RESILIENT_SLOTS];
+  uint32_t sorted[SWAP_MEMBERS_MAX];
+  uint32_t share[SWAP_MEMBERS_MAX];
+  uint32_t num_refs, i, m;
+  int failures = 0;
+
+  num_refs = swap_refs_read(group_id, refs, SWAP_RESILIENT_SLOTS);
+
+  if (num_slots == 0)
+  {
+    UTEST_CHECK(failures, num_refs == count, "%s: %u buckets, expected %u", what, num_refs, count);
+    if (num_refs == count)
+    {
+      memcpy(sorted, expected, count * sizeof(*sorted));
+      qsort(sorted, count, sizeof(*sorted), swap_ref_cmp);
+      qsort(refs, num_refs, sizeof(*refs), swap_ref_cmp);
+      UTEST_CHECK(failures, memcmp(refs, sorted, count * sizeof(*refs)) == 0,
+                  "%s: buckets chain to the wrong groups", what);
+    }
+    return failures;
+  }
+
+  UTEST_CHECK(failures, num_refs == num_slots, "%s: %u slots, expected %u", what, num_refs, num_slots);
+  memset(share, 0, sizeof(share));
+  for (i = 0; (i < num_refs) && (i < num_slots); i++)
+  {
+    for (m = 0; (m < count) && (refs[i] != expected[m]); m++)
+      ;
+    UTEST_CHECK(failures, m < count, "%s: slot %u chains to 0x%08x, not a member", what, i, refs[i]);
+    if (m < count)
+    {
+      share[m]++;
+    }
+  }
+  for (m = 0; m < count; m++)
+  {
+    UTEST_CHECK(failures, (share[m] >= num_slots / count) && (share[m] <= (num_slots + count - 1) / count),
+                "%s: member 0x%08x holds %u of %u slots", what, expected[m], share[m], num_slots);
+  }
+  return failures;
+}
+
+static void swap_step_refs(const swap_step_t *step, const uint32_t *next_hops,
+                           uint32_t missing, uint32_t *refs)
+{
+  uint32_t i;
+
+  for (i = 0; i < step->count; i++)
+  {
+    refs[i] = (step->members[i] == SWAP_MISSING) ? missing : next_hops[step->members[i]];
+  }
+}
+
+/* Create a group over the first four next hops and walk it through every
+   swap step */
+static int swap_group_run(const char *name, uint32_t group_id, uint8_t group_type,
+                          const uint32_t *next_hops, uint32_t missing, uint32_t num_slots)
+{
+  of_list_bucket_t *buckets;
+  uint32_t refs[SWAP_MEMBERS_MAX];
+  uint32_t current[SWAP_MEMBERS_MAX];
+  uint32_t num_current;
+  uint64_t emptied;
+  void *entry = NULL;
+  indigo_error_t err;
+  char what[128];
+  uint32_t i;
+  int failures = 0;
+
+  memcpy(current, next_hops, SWAP_MEMBERS_MAX * sizeof(*current));
+  num_current = SWAP_MEMBERS_MAX;
+
+  buckets = utest_ref_buckets_new(current, num_current);
+  err = utest_driver_group_create(group_id, group_type, buckets, &entry);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%s: create failed, err %d", name, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return failures;
+  }
+  snprintf(what, sizeof(what), "%s create", name);
+  failures += swap_refs_check(what, group_id, num_slots, current, num_current);
+
+  for (i = 0; i < SWAP_STEPS; i++)
+  {
+    snprintf(what, sizeof(what), "%s %s", name, swap_steps[i].name);
+    swap_step_refs(&swap_steps[i], next_hops, missing, refs);
+
+    emptied = swap_groups_emptied();
+    buckets = utest_ref_buckets_new(refs, swap_steps[i].count);
+    err = utest_driver_group_modify(group_id, entry, buckets);
+    of_object_delete(buckets);
+
+    UTEST_CHECK(failures, swap_groups_emptied() == emptied, "%s: the group lost all its buckets", what);
+    if (swap_steps[i].fails)
+    {
+      UTEST_CHECK(failures, err != INDIGO_ERROR_NONE, "%s: modify succeeded", what);
+    }
+    else
+    {
+      UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%s: modify failed, err %d", what, err);
+      if (err == INDIGO_ERROR_NONE)
+      {
+        memcpy(current, refs, swap_steps[i].count * sizeof(*current));
+        num_current = swap_steps[i].count;
+      }
+    }
+    failures += swap_refs_check(what, group_id, num_slots, current, num_current);
+  }
+
+  err = utest_driver_group_delete(group_id, entry);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%s: delete failed, err %d", name, err);
+
+  printf("%s: %u swaps, %d failures\n", name, (unsigned)SWAP_STEPS, failures);
+  return failures;
+}
+
+/* Re-point an indirect L3 unicast group at another L2 interface group, and
+   at one that does not exist */
+static int swap_indirect_run(void)
+{
+  of_list_bucket_t *buckets;
+  uint32_t missing = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, SWAP_VLAN, 30);
+  uint32_t expected = l2_interface_ids[SWAP_NEXT_HOPS - 1];
+  uint64_t emptied;
+  indigo_error_t err;
+  int failures = 0;
+
+  emptied = swap_groups_emptied();
+  buckets = utest_l3_unicast_buckets_new(expected, SWAP_VLAN, 100);
+  err = utest_driver_group_modify(l3_unicast_ids[0], l3_unicast_entries[0], buckets);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "l3_unicast re-point: modify failed, err %d", err);
+  UTEST_CHECK(failures, swap_groups_emptied() == emptied, "l3_unicast re-point: the group lost its bucket");
+  if (err == INDIGO_ERROR_NONE)
+  {
+    failures += swap_refs_check("l3_unicast re-point", l3_unicast_ids[0], 0, &expected, 1);
+  }
+
+  emptied = swap_groups_emptied();
+  buckets = utest_l3_unicast_buckets_new(missing, SWAP_VLAN, 101);
+  err = utest_driver_group_modify(l3_unicast_ids[0], l3_unicast_entries[0], buckets);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err != INDIGO_ERROR_NONE, "l3_unicast missing next hop: modify succeeded");
+  UTEST_CHECK(failures, swap_groups_emptied() == emptied, "l3_unicast missing next hop: the group lost its bucket");
+  failures += swap_refs_check("l3_unicast missing next hop", l3_unicast_ids[0], 0, &expected, 1);
+
+  printf("l3_unicast: 2 swaps, %d failures\n", failures);
+  return failures;
+}
+
+/* Fast failover buckets, each chaining to a tunnel and watching a port */
+static of_list_bucket_t *swap_ff_buckets_new(const uint32_t *refs, const uint32_t *ports, uint32_t count)
+{
+  of_list_bucket_t *buckets = of_list_bucket_new(OF_VERSION_1_3);
+  of_list_action_t *actions;
+  of_action_group_t *act;
+  of_bucket_t *bucket;
+  uint32_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    actions = of_list_action_new(OF_VERSION_1_3);
+    act = of_action_group_new(OF_VERSION_1_3);
+    of_action_group_group_id_set(act, refs[i]);
+    of_list_action_append(actions, act);
+    of_object_delete(act);
+
+    bucket = of_bucket_new(OF_VERSION_1_3);
+    of_bucket_watch_port_set(bucket, ports[i]);
+    of_bucket_actions_set(bucket, actions);
+    of_list_bucket_append(buckets, bucket);
+    of_object_delete(bucket);
+    of_object_delete(actions);
+  }
+  return buckets;
+}
+
+static int swap_ff_check(const char *what, uint32_t group_id, const uint32_t *expected, uint32_t count)
+{
+  uint32_t refs[SWAP_MEMBERS_MAX];
+  uint32_t num_refs, i;
+  int failures = 0;
+
+  num_refs = swap_refs_read(group_id, refs, SWAP_MEMBERS_MAX);
+  UTEST_CHECK(failures, num_refs == count, "%s: %u buckets, expected %u", what, num_refs, count);
+  for (i = 0; (i < num_refs) && (i < count); i++)
+  {
+    UTEST_CHECK(failures, refs[i] == expected[i], "%s: bucket %u chains to 0x%08x, expected 0x%08x",
+                what, i, refs[i], expected[i]);
+  }
+  return failures;
+}
+
+/* Replace the primary, then the backup, of an MPLS fast failover group on
+   a switch that cannot modify a bucket in place */
+static int swap_fast_failover_run(void)
+{
+  ofdpaGroupEntry_t tunnel;
+  of_list_bucket_t *buckets;
+  uint32_t tunnel_ids[SWAP_TUNNELS];
+  uint32_t group_id = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING, 0, 1);
+  uint32_t refs[2];
+  uint32_t ports[2] = { 1, 2 };
+  uint32_t spare;
+  uint32_t next;
+  uint64_t emptied;
+  void *entry = NULL;
+  indigo_error_t err;
+  uint32_t i;
+  int failures = 0;
+
+  (void)ofdpaGroupMplsSubTypeSet(&group_id, OFDPA_MPLS_FAST_FAILOVER);
+  for (i = 0; i < SWAP_TUNNELS; i++)
+  {
+    tunnel_ids[i] = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL, 0, i + 1);
+    (void)ofdpaGroupMplsSubTypeSet(&tunnel_ids[i], OFDPA_MPLS_TUNNEL_LABEL1);
+    ofdpaGroupEntryInit(OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL, &tunnel);
+    tunnel.groupId = tunnel_ids[i];
+    UTEST_CHECK(failures, ofdpaGroupAdd(&tunnel) == OFDPA_E_NONE,
+                "mpls tunnel 0x%08x: add failed", tunnel_ids[i]);
+  }
+  if (failures != 0)
+  {
+    goto done;
+  }
+
+  refs[0] = tunnel_ids[0];
+  refs[1] = tunnel_ids[1];
+  buckets = swap_ff_buckets_new(refs, ports, 2);
+  err = utest_driver_group_create(group_id, OF_GROUP_TYPE_FF, buckets, &entry);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "mpls_ff: create failed, err %d", err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    goto done;
+  }
+
+  next = tunnel_ids[2];
+  ofdpa_sim_bucket_modify_set(0);
+  for (i = 0; i < 2; i++)
+  {
+    const char *what = (i == 0) ? "mpls_ff replace primary" : "mpls_ff replace backup";
+
+    spare = refs[i];
+    refs[i] = next;
+    ports[i] = 3;
+    emptied = swap_groups_emptied();
+    buckets = swap_ff_buckets_new(refs, ports, 2);
+    err = utest_driver_group_modify(group_id, entry, buckets);
+    of_object_delete(buckets);
+    UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%s: modify failed, err %d", what, err);
+    UTEST_CHECK(failures, swap_groups_emptied() == emptied, "%s: the group lost all its buckets", what);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      break;
+    }
+    failures += swap_ff_check(what, group_id, refs, 2);
+
+    /* The next step moves to the tunnel this one let go */
+    next = spare;
+  }
+  ofdpa_sim_bucket_modify_set(1);
+
+  err = utest_driver_group_delete(group_id, entry);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "mpls_ff: delete failed, err %d", err);
+
+  printf("mpls_ff: 2 swaps, %d failures\n", failures);
+
+done:
+  for (i = 0; i < SWAP_TUNNELS; i++)
+  {
+    (void)ofdpaGroupDelete(tunnel_ids[i]);
+  }
+  return failures;
+}
+
+static int swap_next_hops_add(void)
+{
+  of_list_bucket_t *buckets;
+  indigo_error_t err;
+  uint32_t i;
+  int failures = 0;
+
+  for (i = 0; i < SWAP_NEXT_HOPS; i++)
+  {
+    l2_interface_ids[i] = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, SWAP_VLAN, i + 1);
+    buckets = utest_l2_interface_buckets_new(i + 1, 1);
+    err = utest_driver_group_create(l2_interface_ids[i], OF_GROUP_TYPE_INDIRECT, buckets,
+                                    &l2_interface_entries[i]);
+    of_object_delete(buckets);
+    UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "l2_interface 0x%08x: create failed, err %d",
+                l2_interface_ids[i], err);
+
+    l3_unicast_ids[i] = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, i + 1);
+    buckets = utest_l3_unicast_buckets_new(l2_interface_ids[i], SWAP_VLAN, i + 1);
+    err = utest_driver_group_create(l3_unicast_ids[i], OF_GROUP_TYPE_INDIRECT, buckets,
+                                    &l3_unicast_entries[i]);
+    of_object_delete(buckets);
+    UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "l3_unicast 0x%08x: create failed, err %d",
+                l3_unicast_ids[i], err);
+  }
+  return failures;
+}
+
+static void swap_next_hops_delete(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < SWAP_NEXT_HOPS; i++)
+  {
+    if (l3_unicast_entries[i] != NULL)
+    {
+      (void)utest_driver_group_delete(l3_unicast_ids[i], l3_unicast_entries[i]);
+      l3_unicast_entries[i] = NULL;
+    }
+    if (l2_interface_entries[i] != NULL)
+    {
+      (void)utest_driver_group_delete(l2_interface_ids[i], l2_interface_entries[i]);
+      l2_interface_entries[i] = NULL;
+    }
+  }
+}
+
+int group_swap_test_run(void)
+{
+  uint32_t missing_next_hop = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, 1000);
+  uint32_t missing_port = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, SWAP_VLAN, 30);
+  int failures;
+
+  failures = swap_next_hops_add();
+  if (failures == 0)
+  {
+    failures += swap_group_run("l3_ecmp",
+                               utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_ECMP, 0, 1),
+                               OF_GROUP_TYPE_SELECT, l3_unicast_ids, missing_next_hop, 0);
+    failures += swap_group_run("l2_flood",
+                               utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD, SWAP_VLAN, 1),
+                               OF_GROUP_TYPE_ALL, l2_interface_ids, missing_port, 0);
+
+    /* Resilient hashing applies to the select groups created while set */
+    (void)ind_ofdpa_group_resilient_set(SWAP_RESILIENT_SLOTS);
+    failures += swap_group_run("l3_ecmp resilient",
+                               utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_ECMP, 0, 2),
+                               OF_GROUP_TYPE_SELECT, l3_unicast_ids, missing_next_hop,
+                               SWAP_RESILIENT_SLOTS);
+    (void)ind_ofdpa_group_resilient_set(0);
+
+    failures += swap_indirect_run();
+    failures += swap_fast_failover_run();
+  }
+  swap_next_hops_delete();
+
+  return (failures == 0) ? 0 : -1;
+}
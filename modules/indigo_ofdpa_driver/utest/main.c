@@ -1,19 +1,403 @@
 /**************************************************************************//**
  *
+ * indigo_ofdpa_driver tests and benchmarks.
  *
+ * Runs the named tests, or all of them, against libofdpa_sim:
+ *
+ *   indigo_ofdpa_driver_utest [-n COUNT] [-r ROUNDS] [-t TABLE] [-l LABEL] [TEST...]
+ *
+ * Options:
+ *   -n COUNT   flows or groups per measurement; each test has a default
+ *   -r ROUNDS  rounds of each measurement; each test has a default
+ *   -t TABLE   only benchmark this flow table id
+ *   -l LABEL   copied into every record, e.g. the commit measured
  *
  *****************************************************************************/
 #include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_shadow.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_flow_index.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <AIM/aim.h>
 
-int aim_main(int argc, char* argv[])
+#include "utest.h"
+
+uint32_t utest_count = 0;
+uint32_t utest_rounds = 0;
+int utest_table = -1;
+const char *utest_label = "";
+
+typedef struct
+{
+  const char *name;
+  int (*run)(void);
+} utest_test_t;
+
+static const utest_test_t utest_tests[] =
+{
+  { "flows", flow_bench_run },
+  { "groups", group_bench_run },
+  { "group_swap", group_swap_test_run },
+  { "group_cascade", group_cascade_test_run },
+  { "resync", resync_test_run },
+  { "meter", meter_test_run },
+  { "resilient", resilient_bench_run },
+  { "telemetry", telemetry_test_run },
+};
+
+#define UTEST_TESTS (sizeof(utest_tests) / sizeof(utest_tests[0]))
+
+uint32_t utest_group_id(OFDPA_GROUP_ENTRY_TYPE_t type, uint32_t vlan, uint32_t port_or_index)
+{
+  uint32_t group_id = 0;
+
+  ofdpaGroupTypeSet(&group_id, type);
+  if (type == OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE)
+  {
+    ofdpaGroupVlanSet(&group_id, vlan);
+    ofdpaGroupPortIdSet(&group_id, port_or_index);
+  }
+  else
+  {
+    if ((type == OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST) ||
+        (type == OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD) ||
+        (type == OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST))
+    {
+      ofdpaGroupVlanSet(&group_id, vlan);
+    }
+    ofdpaGroupIndexSet(&group_id, port_or_index);
+  }
+  return group_id;
+}
+
+uint32_t utest_group_add(OFDPA_GROUP_ENTRY_TYPE_t type, uint32_t vlan, uint32_t port_or_index)
+{
+  ofdpaGroupEntry_t group;
+  uint32_t group_id = utest_group_id(type, vlan, port_or_index);
+
+  ofdpaGroupEntryInit(type, &group);
+  group.groupId = group_id;
+  if (ofdpaGroupAdd(&group) != OFDPA_E_NONE)
+  {
+    fprintf(stderr, "failed to add group 0x%08x\n", group_id);
+  }
+  return group_id;
+}
+
+uint64_t utest_sim_calls(ofdpa_sim_call_t call)
+{
+  ofdpa_sim_stats_t stats;
+
+  ofdpa_sim_stats_get(&stats);
+  return stats.calls[call];
+}
+
+/* Indigo core. The utest stands in for the flow-removed handler and
+   records what the driver reports. */
+
+static utest_flow_removed_t *utest_removed;
+static uint32_t utest_removed_count;
+static uint32_t utest_removed_size;
+
+void ind_core_flow_expiry_handler(indigo_cookie_t flow_id, indigo_fi_flow_removed_t reason)
+{
+  utest_flow_removed_t *removed;
+  uint32_t size;
+
+  if (utest_removed_count == utest_removed_size)
+  {
+    size = (utest_removed_size == 0) ? 64 : (utest_removed_size * 2);
+    removed = realloc(utest_removed, size * sizeof(*removed));
+    if (removed == NULL)
+    {
+      fprintf(stderr, "out of memory recording flow 0x%llx removed\n",
+              (unsigned long long)flow_id);
+      return;
+    }
+    utest_removed = removed;
+    utest_removed_size = size;
+  }
+  utest_removed[utest_removed_count].flow_id = flow_id;
+  utest_removed[utest_removed_count].reason = reason;
+  utest_removed_count++;
+}
+
+const utest_flow_removed_t *utest_flow_removed_get(uint32_t *count)
+{
+  *count = utest_removed_count;
+  return utest_removed;
+}
+
+void utest_flow_removed_clear(void)
+{
+  utest_removed_count = 0;
+}
+
+/* Bucket lists */
+
+static void utest_bucket_append(of_list_bucket_t *buckets, of_list_action_t *actions)
+{
+  of_bucket_t *bucket = of_bucket_new(OF_VERSION_1_3);
+
+  of_bucket_actions_set(bucket, actions);
+  of_list_bucket_append(buckets, bucket);
+  of_object_delete(bucket);
+  of_object_delete(actions);
+}
+
+static void utest_group_action_append(of_list_action_t *actions, uint32_t group_id)
+{
+  of_action_group_t *act = of_action_group_new(OF_VERSION_1_3);
+
+  of_action_group_group_id_set(act, group_id);
+  of_list_action_append(actions, act);
+  of_object_delete(act);
+}
+
+static void utest_set_field_append(of_list_action_t *actions, of_oxm_t *oxm)
+{
+  of_action_set_field_t *act = of_action_set_field_new(OF_VERSION_1_3);
+
+  of_action_set_field_field_set(act, oxm);
+  of_list_action_append(actions, act);
+  of_object_delete(act);
+  of_object_delete(oxm);
+}
+
+static void utest_mac_set(of_mac_addr_t *mac, uint8_t prefix, uint32_t key)
+{
+  mac->addr[0] = 0x00;
+  mac->addr[1] = 0x00;
+  mac->addr[2] = prefix;
+  mac->addr[3] = (key >> 16) & 0xff;
+  mac->addr[4] = (key >> 8) & 0xff;
+  mac->addr[5] = key & 0xff;
+}
+
+of_list_bucket_t *utest_l2_interface_buckets_new(uint32_t port, int pop_vlan)
+{
+  of_list_bucket_t *buckets = of_list_bucket_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+  of_action_output_t *output;
+  of_action_pop_vlan_t *pop;
+
+  if (pop_vlan)
+  {
+    pop = of_action_pop_vlan_new(OF_VERSION_1_3);
+    of_list_action_append(actions, pop);
+    of_object_delete(pop);
+  }
+  output = of_action_output_new(OF_VERSION_1_3);
+  of_action_output_port_set(output, port);
+  of_list_action_append(actions, output);
+  of_object_delete(output);
+
+  utest_bucket_append(buckets, actions);
+  return buckets;
+}
+
+of_list_bucket_t *utest_l3_unicast_buckets_new(uint32_t ref_group_id, uint16_t vlan, uint32_t mac_key)
+{
+  of_list_bucket_t *buckets = of_list_bucket_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+  of_oxm_eth_src_t *eth_src;
+  of_oxm_eth_dst_t *eth_dst;
+  of_oxm_vlan_vid_t *vlan_vid;
+  of_mac_addr_t mac;
+
+  eth_src = of_oxm_eth_src_new(OF_VERSION_1_3);
+  utest_mac_set(&mac, 0x5e, 1);
+  of_oxm_eth_src_value_set(eth_src, mac);
+  utest_set_field_append(actions, eth_src);
+
+  eth_dst = of_oxm_eth_dst_new(OF_VERSION_1_3);
+  utest_mac_set(&mac, 0x30, mac_key);
+  of_oxm_eth_dst_value_set(eth_dst, mac);
+  utest_set_field_append(actions, eth_dst);
+
+  vlan_vid = of_oxm_vlan_vid_new(OF_VERSION_1_3);
+  of_oxm_vlan_vid_value_set(vlan_vid, OFDPA_VID_PRESENT | vlan);
+  utest_set_field_append(actions, vlan_vid);
+
+  utest_group_action_append(actions, ref_group_id);
+
+  utest_bucket_append(buckets, actions);
+  return buckets;
+}
+
+of_list_bucket_t *utest_l3_interface_buckets_new(uint32_t ref_group_id, uint16_t vlan, uint32_t mac_key)
+{
+  of_list_bucket_t *buckets = of_list_bucket_new(OF_VERSION_1_3);
+  of_list_action_t *actions = of_list_action_new(OF_VERSION_1_3);
+  of_oxm_eth_src_t *eth_src;
+  of_oxm_vlan_vid_t *vlan_vid;
+  of_mac_addr_t mac;
+
+  eth_src = of_oxm_eth_src_new(OF_VERSION_1_3);
+  utest_mac_set(&mac, 0x5e, mac_key);
+  of_oxm_eth_src_value_set(eth_src, mac);
+  utest_set_field_append(actions, eth_src);
+
+  vlan_vid = of_oxm_vlan_vid_new(OF_VERSION_1_3);
+  of_oxm_vlan_vid_value_set(vlan_vid, OFDPA_VID_PRESENT | vlan);
+  utest_set_field_append(actions, vlan_vid);
+
+  utest_group_action_append(actions, ref_group_id);
+
+  utest_bucket_append(buckets, actions);
+  return buckets;
+}
+
+of_list_bucket_t *utest_ref_buckets_new(const uint32_t *ref_group_ids, uint32_t count)
+{
+  of_list_bucket_t *buckets = of_list_bucket_new(OF_VERSION_1_3);
+  of_list_action_t *actions;
+  uint32_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    actions = of_list_action_new(OF_VERSION_1_3);
+    utest_group_action_append(actions, ref_group_ids[i]);
+    utest_bucket_append(buckets, actions);
+  }
+  return buckets;
+}
+
+/* Driver groups */
+
+indigo_error_t utest_driver_group_create(uint32_t group_id, uint8_t group_type,
+                                         of_list_bucket_t *buckets, void **entry_priv)
+{
+  const ind_ofdpa_group_bench_ops_t *ops = ind_ofdpa_group_bench_ops_get();
+
+  return ops->table_ops->entry_create(ops->table_priv_get(group_id), 0, group_id,
+                                      group_type, buckets, entry_priv);
+}
+
+indigo_error_t utest_driver_group_modify(uint32_t group_id, void *entry_priv,
+                                         of_list_bucket_t *buckets)
+{
+  const ind_ofdpa_group_bench_ops_t *ops = ind_ofdpa_group_bench_ops_get();
+
+  return ops->table_ops->entry_modify(ops->table_priv_get(group_id), 0, entry_priv, buckets);
+}
+
+indigo_error_t utest_driver_group_delete(uint32_t group_id, void *entry_priv)
+{
+  const ind_ofdpa_group_bench_ops_t *ops = ind_ofdpa_group_bench_ops_get();
+
+  return ops->table_ops->entry_delete(ops->table_priv_get(group_id), 0, entry_priv);
+}
+
+static const utest_test_t *utest_find(const char *name)
+{
+  uint32_t i;
+
+  for (i = 0; i < UTEST_TESTS; i++)
+  {
+    if (strcmp(utest_tests[i].name, name) == 0)
+    {
+      return &utest_tests[i];
+    }
+  }
+  return NULL;
+}
+
+static void utest_usage(const char *argv0)
 {
-    printf("indigo_ofdpa_driver Utest Is Empty\n");
-    indigo_ofdpa_driver_config_show(&aim_pvs_stdout);
-    return 0;
+  uint32_t i;
+
+  fprintf(stderr, "usage: %s [-n count] [-r rounds] [-t table] [-l label] [test...]\n", argv0);
+  fprintf(stderr, "tests:");
+  for (i = 0; i < UTEST_TESTS; i++)
+  {
+    fprintf(stderr, " %s", utest_tests[i].name);
+  }
+  fprintf(stderr, "\n");
+}
+
+static int utest_run(const utest_test_t *test)
+{
+  if (test->run() < 0)
+  {
+    fprintf(stderr, "%s: FAILED\n", test->name);
+    return 1;
+  }
+  return 0;
 }
 
+int aim_main(int argc, char* argv[])
+{
+  char client_name[] = "indigo_ofdpa_driver_utest";
+  int opt;
+  int rv = 0;
+  int i;
+
+  while ((opt = getopt(argc, argv, "n:r:t:l:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        utest_count = strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        utest_rounds = strtoul(optarg, NULL, 0);
+        break;
+      case 't':
+        utest_table = strtol(optarg, NULL, 0);
+        break;
+      case 'l':
+        utest_label = optarg;
+        break;
+      default:
+        utest_usage(argv[0]);
+        return 1;
+    }
+  }
+  for (i = optind; i < argc; i++)
+  {
+    if (utest_find(argv[i]) == NULL)
+    {
+      fprintf(stderr, "unknown test %s\n", argv[i]);
+      utest_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (ofdpaClientInitialize(client_name) != OFDPA_E_NONE)
+  {
+    fprintf(stderr, "failed to initialize OF-DPA\n");
+    return 1;
+  }
+
+  /* As ofagent runs without a warm restart file */
+  if (ind_ofdpa_shadow_open(NULL) != INDIGO_ERROR_NONE)
+  {
+    fprintf(stderr, "failed to create the flow and group shadow\n");
+    return 1;
+  }
+
+  if (optind == argc)
+  {
+    for (i = 0; i < (int)UTEST_TESTS; i++)
+    {
+      rv |= utest_run(&utest_tests[i]);
+    }
+  }
+  else
+  {
+    for (i = optind; i < argc; i++)
+    {
+      rv |= utest_run(utest_find(argv[i]));
+    }
+  }
+
+  ind_ofdpa_flow_index_finish();
+  ind_ofdpa_shadow_close();
+  free(utest_removed);
+
+  return rv;
+}
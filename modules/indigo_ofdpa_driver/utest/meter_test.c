@@ -0,0 +1,233 @@
+/**************************************************************************//**
+ *
+ * Meter modify test ("meter").
+ *
+ * Adds a meter through the driver and ACL policy flows that use it.
+ * OF-DPA has no meter modify and refuses to delete a meter in use, so a
+ * modify of the meter must take its flows along: afterwards OF-DPA holds
+ * the new bands under the same meter ID, every flow still uses it and no
+ * stand-in meter is left behind. A DSCP remark band that would raise the
+ * drop precedence past yellow is rejected and leaves the meter as it was.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <AIM/aim.h>
+#include <indigo/fi.h>
+#include <indigo/forwarding.h>
+
+#include "utest.h"
+
+#define METER_ID                200
+#define METER_FLOWS             16
+#define METER_FLOW_ID_BASE      0x3e7e0000ULL
+#define METER_PRIORITY          1000
+
+static of_list_meter_band_t *meter_bands_new(uint32_t drop_rate, uint32_t remark_rate,
+                                             uint8_t prec_level)
+{
+  of_list_meter_band_t *bands = of_list_meter_band_new(OF_VERSION_1_3);
+  of_meter_band_drop_t *drop;
+  of_meter_band_dscp_remark_t *remark;
+
+  drop = of_meter_band_drop_new(OF_VERSION_1_3);
+  of_meter_band_drop_rate_set(drop, drop_rate);
+  of_meter_band_drop_burst_size_set(drop, 64);
+  of_list_meter_band_append(bands, drop);
+  of_object_delete(drop);
+
+  if (remark_rate != 0)
+  {
+    remark = of_meter_band_dscp_remark_new(OF_VERSION_1_3);
+    of_meter_band_dscp_remark_rate_set(remark, remark_rate);
+    of_meter_band_dscp_remark_burst_size_set(remark, 64);
+    of_meter_band_dscp_remark_prec_level_set(remark, prec_level);
+    of_list_meter_band_append(bands, remark);
+    of_object_delete(remark);
+  }
+  return bands;
+}
+
+static of_flow_add_t *meter_flow_add_new(uint32_t key, uint32_t group_id)
+{
+  of_flow_add_t *flow_add;
+  of_list_instruction_t *insts;
+  of_list_action_t *actions;
+  of_instruction_meter_t *meter;
+  of_instruction_write_actions_t *write_actions;
+  of_action_group_t *group;
+  of_match_t match;
+
+  flow_add = of_flow_add_new(OF_VERSION_1_3);
+  if (flow_add == NULL)
+  {
+    return NULL;
+  }
+  of_flow_add_table_id_set(flow_add, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  of_flow_add_priority_set(flow_add, METER_PRIORITY);
+
+  memset(&match, 0, sizeof(match));
+  match.fields.eth_type = ETH_P_IP;
+  match.masks.eth_type = 0xffff;
+  match.fields.ip_proto = IPPROTO_UDP;
+  match.masks.ip_proto = 0xff;
+  match.fields.ipv4_dst = 0x0a3e0000 + key;
+  match.masks.ipv4_dst = 0xffffffff;
+
+  insts = of_list_instruction_new(OF_VERSION_1_3);
+  meter = of_instruction_meter_new(OF_VERSION_1_3);
+  of_instruction_meter_meter_id_set(meter, METER_ID);
+  of_list_instruction_append(insts, meter);
+  of_object_delete(meter);
+  actions = of_list_action_new(OF_VERSION_1_3);
+  group = of_action_group_new(OF_VERSION_1_3);
+  of_action_group_group_id_set(group, group_id);
+  of_list_action_append(actions, group);
+  of_object_delete(group);
+  write_actions = of_instruction_write_actions_new(OF_VERSION_1_3);
+  of_instruction_write_actions_actions_set(write_actions, actions);
+  of_list_instruction_append(insts, write_actions);
+  of_object_delete(write_actions);
+  of_object_delete(actions);
+
+  if ((of_flow_add_match_set(flow_add, &match) < 0) ||
+      (of_flow_add_instructions_set(flow_add, insts) < 0))
+  {
+    of_object_delete(insts);
+    of_object_delete(flow_add);
+    return NULL;
+  }
+  of_object_delete(insts);
+
+  return flow_add;
+}
+
+static uint32_t meter_count(void)
+{
+  ofdpaMeterEntry_t meter;
+  uint32_t meter_id = 0;
+  uint32_t count = 0;
+
+  while (ofdpaMeterNextGet(meter_id, &meter) == OFDPA_E_NONE)
+  {
+    meter_id = meter.meterId;
+    count++;
+  }
+  return count;
+}
+
+/* Check the bands OF-DPA holds and that every flow still uses the meter */
+static int meter_check(const char *what, uint32_t red_rate, uint32_t yellow_rate)
+{
+  ofdpaMeterEntry_t meter;
+  ofdpaMeterEntryStats_t stats;
+  ofdpaFlowEntry_t flow;
+  uint32_t i;
+  int failures = 0;
+
+  UTEST_CHECK(failures, ofdpaMeterGet(METER_ID, &meter) == OFDPA_E_NONE, "%s: meter is gone", what);
+  UTEST_CHECK(failures, meter.meterBand[1].bandRate == red_rate,
+              "%s: red rate %u, expected %u", what, meter.meterBand[1].bandRate, red_rate);
+  UTEST_CHECK(failures, meter.meterBand[0].bandRate == yellow_rate,
+              "%s: yellow rate %u, expected %u", what, meter.meterBand[0].bandRate, yellow_rate);
+
+  memset(&stats, 0, sizeof(stats));
+  (void)ofdpaMeterStatsGet(METER_ID, &stats);
+  UTEST_CHECK(failures, stats.refCount == METER_FLOWS, "%s: %u flows use the meter, expected %u",
+              what, stats.refCount, METER_FLOWS);
+
+  for (i = 0; i < METER_FLOWS; i++)
+  {
+    if (ofdpaFlowByCookieGet(METER_FLOW_ID_BASE + i, &flow, NULL) != OFDPA_E_NONE)
+    {
+      UTEST_CHECK(failures, 0, "%s: flow %u is gone", what, i);
+      continue;
+    }
+    UTEST_CHECK(failures, flow.flowData.policyAclFlowEntry.meterId == METER_ID,
+                "%s: flow %u uses meter %u", what, i, flow.flowData.policyAclFlowEntry.meterId);
+  }
+  return failures;
+}
+
+int meter_test_run(void)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  of_list_meter_band_t *bands;
+  of_flow_add_t *flow_add;
+  indigo_fi_flow_stats_t flow_stats;
+  uint32_t group_id;
+  uint32_t base_meters;
+  void *flows[METER_FLOWS];
+  uint32_t i;
+  indigo_error_t err;
+  int failures = 0;
+
+  memset(flows, 0, sizeof(flows));
+  group_id = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, 900);
+  base_meters = meter_count();
+
+  bands = meter_bands_new(1000, 0, 0);
+  err = indigo_fwd_meter_add(METER_ID, 0, bands);
+  of_object_delete(bands);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "meter %u: add failed, err %d", METER_ID, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    goto done;
+  }
+
+  for (i = 0; i < METER_FLOWS; i++)
+  {
+    flow_add = meter_flow_add_new(i, group_id);
+    if (flow_add == NULL)
+    {
+      UTEST_CHECK(failures, 0, "flow %u: failed to build", i);
+      goto done;
+    }
+    err = ops->table_ops->entry_create(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_ACL_POLICY), 0,
+                                       flow_add, METER_FLOW_ID_BASE + i, &flows[i]);
+    of_object_delete(flow_add);
+    UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: create failed, err %d", i, err);
+    if (err != INDIGO_ERROR_NONE)
+    {
+      flows[i] = NULL;
+      goto done;
+    }
+  }
+
+  bands = meter_bands_new(2000, 500, 1);
+  err = indigo_fwd_meter_modify(METER_ID, bands);
+  of_object_delete(bands);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "modify in use: failed, err %d", err);
+  failures += meter_check("modify in use", 2000, 500);
+  UTEST_CHECK(failures, meter_count() == base_meters + 1, "modify in use: %u meters left, expected %u",
+              meter_count() - base_meters, 1);
+
+  bands = meter_bands_new(3000, 500, 2);
+  err = indigo_fwd_meter_modify(METER_ID, bands);
+  of_object_delete(bands);
+  UTEST_CHECK(failures, err != INDIGO_ERROR_NONE, "remark past yellow: modify succeeded");
+  failures += meter_check("remark past yellow", 2000, 500);
+
+  err = indigo_fwd_meter_delete(METER_ID);
+  UTEST_CHECK(failures, err != INDIGO_ERROR_NONE, "delete in use: succeeded");
+
+  printf("meter: %u flows on the modified meter, %d failures\n", METER_FLOWS, failures);
+
+done:
+  for (i = 0; i < METER_FLOWS; i++)
+  {
+    if (flows[i] != NULL)
+    {
+      (void)ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_ACL_POLICY), 0,
+                                         flows[i], &flow_stats);
+    }
+  }
+  (void)indigo_fwd_meter_delete(METER_ID);
+  (void)ofdpaGroupDelete(group_id);
+
+  return (failures == 0) ? 0 : -1;
+}
@@ -0,0 +1,241 @@
+/**************************************************************************//**
+ *
+ * Resilient hashing remap simulation ("resilient").
+ *
+ * Builds ECMP select groups through the driver, with resilient hashing
+ * off and with 64, 256 and 1024 slots, over 4, 8 and 16 members. Each
+ * group goes through a member removal, its re-add, a new member and a
+ * member replacement. After every change the buckets are read back from
+ * libofdpa_sim in index order, and a set of flows is hashed over them
+ * the way an ASIC hashes over a select group: hash modulo the bucket
+ * count. The record for each change gives the fraction of flows whose
+ * next hop moved, next to the ideal of one member's share.
+ *
+ * Without resilient hashing most flows move. With it, the fraction must
+ * stay near the ideal, and every flow must land on a current member.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_groups.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AIM/aim.h>
+
+#include "utest.h"
+
+#define RESILIENT_FLOWS         100000
+#define RESILIENT_MEMBERS_MAX   16
+#define RESILIENT_NEXT_HOPS     (RESILIENT_MEMBERS_MAX + 2)
+#define RESILIENT_GROUP_INDEX   100
+#define RESILIENT_TOLERANCE     2       /* remap allowed, in ideal fractions */
+
+static const uint32_t resilient_slots[] = { 0, 64, 256, 1024 };
+static const uint32_t resilient_members[] = { 4, 8, 16 };
+
+#define RESILIENT_CONFIGS(_a) (sizeof(_a) / sizeof((_a)[0]))
+
+static uint32_t next_hop_ids[RESILIENT_NEXT_HOPS];
+
+/* Per flow hash, fixed for the whole run */
+static uint32_t *flow_hashes;
+static uint32_t num_flows;
+
+/* Flow to next hop before and after a change */
+static uint32_t *flow_before;
+static uint32_t *flow_after;
+
+static uint32_t resilient_hash(uint32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x85ebca6b;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35;
+  x ^= x >> 16;
+  return x;
+}
+
+/* Map every flow to the next hop of its bucket, in bucket index order */
+static uint32_t resilient_flows_map(uint32_t group_id, uint32_t *next_hops)
+{
+  static uint32_t refs[IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS];
+  ofdpaGroupBucketEntry_t bucket;
+  OFDPA_ERROR_t ofdpa_rv;
+  uint32_t count = 0;
+  uint32_t i;
+
+  memset(&bucket, 0, sizeof(bucket));
+  ofdpa_rv = ofdpaGroupBucketEntryFirstGet(group_id, &bucket);
+  while ((ofdpa_rv == OFDPA_E_NONE) && (count < IND_OFDPA_GROUP_RESILIENT_MAX_SLOTS))
+  {
+    refs[count++] = bucket.referenceGroupId;
+    ofdpa_rv = ofdpaGroupBucketEntryNextGet(group_id, bucket.bucketIndex, &bucket);
+  }
+
+  for (i = 0; (count != 0) && (i < num_flows); i++)
+  {
+    next_hops[i] = refs[flow_hashes[i] % count];
+  }
+  return count;
+}
+
+/* Program the members and report how many flows moved */
+static int resilient_change(uint32_t group_id, void *entry, uint32_t num_slots,
+                            uint32_t num_members, const char *event,
+                            const uint32_t *members, uint32_t count, double ideal)
+{
+  of_list_bucket_t *buckets;
+  indigo_error_t err;
+  uint32_t *swap;
+  uint32_t remapped = 0;
+  uint32_t stray = 0;
+  uint32_t num_buckets;
+  uint32_t i, m;
+  double fraction;
+  int failures = 0;
+
+  buckets = utest_ref_buckets_new(members, count);
+  err = utest_driver_group_modify(group_id, entry, buckets);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%u slots, %s: modify failed, err %d",
+              num_slots, event, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return failures;
+  }
+
+  num_buckets = resilient_flows_map(group_id, flow_after);
+  for (i = 0; i < num_flows; i++)
+  {
+    if (flow_after[i] != flow_before[i])
+    {
+      remapped++;
+    }
+    for (m = 0; (m < count) && (flow_after[i] != members[m]); m++)
+      ;
+    if (m == count)
+    {
+      stray++;
+    }
+  }
+  fraction = (double)remapped / num_flows;
+
+  printf("{\"label\":\"%s\",\"test\":\"resilient\",\"slots\":%u,\"members\":%u,"
+         "\"event\":\"%s\",\"members_after\":%u,\"buckets\":%u,\"flows\":%u,\"remapped\":%u,"
+         "\"fraction\":%.4f,\"ideal\":%.4f}\n",
+         utest_label, num_slots, num_members, event, count, num_buckets, num_flows, remapped,
+         fraction, ideal);
+
+  UTEST_CHECK(failures, stray == 0, "%u slots, %s: %u flows hash to a removed member",
+              num_slots, event, stray);
+  if (num_slots != 0)
+  {
+    UTEST_CHECK(failures, num_buckets == num_slots, "%u slots, %s: %u buckets",
+                num_slots, event, num_buckets);
+    UTEST_CHECK(failures, fraction <= RESILIENT_TOLERANCE * ideal,
+                "%u slots, %u members, %s: %.4f of the flows moved, ideal %.4f",
+                num_slots, count, event, fraction, ideal);
+  }
+
+  swap = flow_before;
+  flow_before = flow_after;
+  flow_after = swap;
+  return failures;
+}
+
+/* One group through remove, re-add, add and replace */
+static int resilient_group_run(uint32_t num_slots, uint32_t num_members)
+{
+  uint32_t group_id = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L3_ECMP, 0, RESILIENT_GROUP_INDEX);
+  uint32_t members[RESILIENT_MEMBERS_MAX + 1];
+  of_list_bucket_t *buckets;
+  void *entry = NULL;
+  indigo_error_t err;
+  uint32_t removed;
+  uint32_t count = num_members;
+  int failures = 0;
+
+  memcpy(members, next_hop_ids, num_members * sizeof(*members));
+
+  (void)ind_ofdpa_group_resilient_set(num_slots);
+  buckets = utest_ref_buckets_new(members, count);
+  err = utest_driver_group_create(group_id, OF_GROUP_TYPE_SELECT, buckets, &entry);
+  of_object_delete(buckets);
+  (void)ind_ofdpa_group_resilient_set(0);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%u slots: create failed, err %d", num_slots, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    return failures;
+  }
+  (void)resilient_flows_map(group_id, flow_before);
+
+  /* Remove a member from the middle, then add it back at the end */
+  removed = members[1];
+  memmove(&members[1], &members[2], (count - 2) * sizeof(*members));
+  count--;
+  failures += resilient_change(group_id, entry, num_slots, num_members, "remove", members, count,
+                               1.0 / (count + 1));
+  members[count++] = removed;
+  failures += resilient_change(group_id, entry, num_slots, num_members, "re-add", members, count,
+                               1.0 / count);
+
+  /* A member never seen before, then one member replaced by another */
+  members[count++] = next_hop_ids[num_members];
+  failures += resilient_change(group_id, entry, num_slots, num_members, "add", members, count,
+                               1.0 / count);
+  members[0] = next_hop_ids[num_members + 1];
+  failures += resilient_change(group_id, entry, num_slots, num_members, "replace", members, count,
+                               1.0 / count);
+
+  err = utest_driver_group_delete(group_id, entry);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "%u slots: delete failed, err %d", num_slots, err);
+  return failures;
+}
+
+int resilient_bench_run(void)
+{
+  uint32_t s, m, i;
+  int failures = 0;
+
+  num_flows = UTEST_COUNT(RESILIENT_FLOWS);
+  flow_hashes = malloc(num_flows * sizeof(*flow_hashes));
+  flow_before = malloc(num_flows * sizeof(*flow_before));
+  flow_after = malloc(num_flows * sizeof(*flow_after));
+  if ((flow_hashes == NULL) || (flow_before == NULL) || (flow_after == NULL))
+  {
+    fprintf(stderr, "failed to allocate %u flows\n", num_flows);
+    free(flow_hashes);
+    free(flow_before);
+    free(flow_after);
+    return -1;
+  }
+  for (i = 0; i < num_flows; i++)
+  {
+    flow_hashes[i] = resilient_hash(i);
+  }
+
+  /* The next hops only need to exist in OF-DPA */
+  for (i = 0; i < RESILIENT_NEXT_HOPS; i++)
+  {
+    next_hop_ids[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST, 0, RESILIENT_GROUP_INDEX + i);
+  }
+
+  for (s = 0; s < RESILIENT_CONFIGS(resilient_slots); s++)
+  {
+    for (m = 0; m < RESILIENT_CONFIGS(resilient_members); m++)
+    {
+      failures += resilient_group_run(resilient_slots[s], resilient_members[m]);
+    }
+  }
+
+  for (i = 0; i < RESILIENT_NEXT_HOPS; i++)
+  {
+    (void)ofdpaGroupDelete(next_hop_ids[i]);
+  }
+  free(flow_hashes);
+  free(flow_before);
+  free(flow_after);
+
+  return (failures == 0) ? 0 : -1;
+}
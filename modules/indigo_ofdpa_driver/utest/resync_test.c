@@ -0,0 +1,322 @@
+/**************************************************************************//**
+ *
+ * Controller resync test ("resync").
+ *
+ * Programs bridging flows on two L2 interface groups, plus two groups no
+ * flow uses, through the driver's table operations, then starts a resync
+ * as a controller failover would. The new controller sends back only the
+ * flows on the first group, as Indigo passes on a re-sent add: a modify
+ * with the same content. It also deletes one of the other flows, adds a
+ * new flow on the second group and modifies one of the unused groups.
+ *
+ * When the window ends, exactly the flows it did not send back are
+ * deleted and each is reported to Indigo once as removed by a delete.
+ * The deleted flow is gone at once and not reported again. Of the
+ * groups, only the unused one the controller did not modify is deleted;
+ * the second group stays for the new flow. The driver still answers
+ * Indigo for the deleted group until Indigo deletes it.
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_warm.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AIM/aim.h>
+#include <indigo/fi.h>
+
+#include "utest.h"
+
+#define RESYNC_VLAN             50
+#define RESYNC_FLOWS            16      /* half on each group */
+#define RESYNC_FLOW_ID_BASE     0x5e5c0000ULL
+#define RESYNC_PRIORITY         1000
+#define RESYNC_WINDOW_MS        60000
+
+/* Flow RESYNC_FLOWS - 1 is deleted and RESYNC_FLOWS added in the window */
+#define RESYNC_DELETED          (RESYNC_FLOWS - 1)
+#define RESYNC_ADDED            RESYNC_FLOWS
+
+enum { RESYNC_GROUP_A, RESYNC_GROUP_B, RESYNC_GROUP_UNUSED, RESYNC_GROUP_MODIFIED, RESYNC_GROUPS };
+
+static void resync_match_build(uint32_t key, of_match_t *match)
+{
+  memset(match, 0, sizeof(*match));
+  match->fields.vlan_vid = OFDPA_VID_PRESENT | RESYNC_VLAN;
+  match->masks.vlan_vid = OFDPA_VID_PRESENT | OFDPA_VID_EXACT_MASK;
+  match->fields.eth_dst.addr[2] = 0x5e;
+  match->fields.eth_dst.addr[4] = (key >> 8) & 0xff;
+  match->fields.eth_dst.addr[5] = key & 0xff;
+  memset(match->masks.eth_dst.addr, 0xff, sizeof(match->masks.eth_dst.addr));
+}
+
+static of_list_instruction_t *resync_instructions_new(uint32_t group_id)
+{
+  of_list_instruction_t *insts;
+  of_list_action_t *actions;
+  of_instruction_write_actions_t *write_actions;
+  of_instruction_goto_table_t *goto_table;
+  of_action_group_t *group;
+
+  insts = of_list_instruction_new(OF_VERSION_1_3);
+  actions = of_list_action_new(OF_VERSION_1_3);
+  group = of_action_group_new(OF_VERSION_1_3);
+  of_action_group_group_id_set(group, group_id);
+  of_list_action_append(actions, group);
+  of_object_delete(group);
+  write_actions = of_instruction_write_actions_new(OF_VERSION_1_3);
+  of_instruction_write_actions_actions_set(write_actions, actions);
+  of_list_instruction_append(insts, write_actions);
+  of_object_delete(write_actions);
+  of_object_delete(actions);
+  goto_table = of_instruction_goto_table_new(OF_VERSION_1_3);
+  of_instruction_goto_table_table_id_set(goto_table, OFDPA_FLOW_TABLE_ID_ACL_POLICY);
+  of_list_instruction_append(insts, goto_table);
+  of_object_delete(goto_table);
+
+  return insts;
+}
+
+static int resync_flow_create(uint32_t key, uint32_t group_id, void **entry_priv)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  of_flow_add_t *flow_add;
+  of_list_instruction_t *insts;
+  of_match_t match;
+  indigo_error_t err = INDIGO_ERROR_RESOURCE;
+  int failures = 0;
+
+  *entry_priv = NULL;
+  flow_add = of_flow_add_new(OF_VERSION_1_3);
+  if (flow_add != NULL)
+  {
+    of_flow_add_table_id_set(flow_add, OFDPA_FLOW_TABLE_ID_BRIDGING);
+    of_flow_add_priority_set(flow_add, RESYNC_PRIORITY);
+    resync_match_build(key, &match);
+    insts = resync_instructions_new(group_id);
+    if ((of_flow_add_match_set(flow_add, &match) == 0) &&
+        (of_flow_add_instructions_set(flow_add, insts) == 0))
+    {
+      err = ops->table_ops->entry_create(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                         flow_add, RESYNC_FLOW_ID_BASE + key, entry_priv);
+    }
+    of_object_delete(insts);
+    of_object_delete(flow_add);
+  }
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: create failed, err %d", key, err);
+  if (err != INDIGO_ERROR_NONE)
+  {
+    *entry_priv = NULL;
+  }
+  return failures;
+}
+
+/* The modify Indigo makes of a re-sent add of the same flow */
+static int resync_flow_resend(uint32_t key, uint32_t group_id, void *entry_priv)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  of_flow_modify_strict_t *flow_modify;
+  of_list_instruction_t *insts;
+  of_match_t match;
+  indigo_error_t err = INDIGO_ERROR_RESOURCE;
+  int failures = 0;
+
+  flow_modify = of_flow_modify_strict_new(OF_VERSION_1_3);
+  if (flow_modify != NULL)
+  {
+    of_flow_modify_strict_table_id_set(flow_modify, OFDPA_FLOW_TABLE_ID_BRIDGING);
+    of_flow_modify_strict_priority_set(flow_modify, RESYNC_PRIORITY);
+    resync_match_build(key, &match);
+    insts = resync_instructions_new(group_id);
+    if ((of_flow_modify_strict_match_set(flow_modify, &match) == 0) &&
+        (of_flow_modify_strict_instructions_set(flow_modify, insts) == 0))
+    {
+      err = ops->table_ops->entry_modify(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                         entry_priv, flow_modify);
+    }
+    of_object_delete(insts);
+    of_object_delete(flow_modify);
+  }
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: re-sent add failed, err %d", key, err);
+  return failures;
+}
+
+static uint32_t resync_bridging_flows(void)
+{
+  ofdpaFlowTableInfo_t info;
+
+  if (ofdpaFlowTableInfoGet(OFDPA_FLOW_TABLE_ID_BRIDGING, &info) != OFDPA_E_NONE)
+  {
+    return 0;
+  }
+  return info.numEntries;
+}
+
+static int resync_group_programmed(uint32_t group_id)
+{
+  ofdpaGroupEntryStats_t stats;
+
+  return (ofdpaGroupStatsGet(group_id, &stats) == OFDPA_E_NONE);
+}
+
+int resync_test_run(void)
+{
+  const ind_ofdpa_flow_bench_ops_t *ops = ind_ofdpa_flow_bench_ops_get();
+  const utest_flow_removed_t *removed;
+  of_list_bucket_t *buckets;
+  indigo_fi_flow_stats_t flow_stats;
+  uint32_t group_ids[RESYNC_GROUPS];
+  void *groups[RESYNC_GROUPS];
+  void *flows[RESYNC_FLOWS + 1];
+  uint32_t reported[RESYNC_FLOWS + 1];
+  uint32_t base_flows = resync_bridging_flows();
+  uint32_t count;
+  uint32_t key;
+  uint32_t i;
+  indigo_error_t err;
+  int failures = 0;
+
+  memset(groups, 0, sizeof(groups));
+  memset(flows, 0, sizeof(flows));
+  memset(reported, 0, sizeof(reported));
+
+  for (i = 0; i < RESYNC_GROUPS; i++)
+  {
+    group_ids[i] = utest_group_id(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, RESYNC_VLAN, i + 1);
+    buckets = utest_l2_interface_buckets_new(i + 1, 1);
+    err = utest_driver_group_create(group_ids[i], OF_GROUP_TYPE_INDIRECT, buckets, &groups[i]);
+    of_object_delete(buckets);
+    UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: create failed, err %d",
+                group_ids[i], err);
+  }
+  if (failures != 0)
+  {
+    goto done;
+  }
+
+  for (key = 0; key < RESYNC_FLOWS; key++)
+  {
+    failures += resync_flow_create(key, group_ids[(key < RESYNC_FLOWS / 2) ? RESYNC_GROUP_A : RESYNC_GROUP_B],
+                                   &flows[key]);
+  }
+  if (failures != 0)
+  {
+    goto done;
+  }
+  utest_flow_removed_clear();
+
+  /* A new controller connects */
+  ind_ofdpa_warm_resync(RESYNC_WINDOW_MS);
+  UTEST_CHECK(failures, ind_ofdpa_warm_active(), "resync opened no window");
+  if (!ind_ofdpa_warm_active())
+  {
+    goto done;
+  }
+
+  for (key = 0; key < RESYNC_FLOWS / 2; key++)
+  {
+    failures += resync_flow_resend(key, group_ids[RESYNC_GROUP_A], flows[key]);
+  }
+
+  /* Deletes are not held for the window */
+  err = ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                     flows[RESYNC_DELETED], &flow_stats);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "flow %u: delete failed, err %d", RESYNC_DELETED, err);
+  if (err == INDIGO_ERROR_NONE)
+  {
+    flows[RESYNC_DELETED] = NULL;
+  }
+  UTEST_CHECK(failures, resync_bridging_flows() == base_flows + RESYNC_FLOWS - 1,
+              "delete in the window left %u bridging flows, expected %u",
+              resync_bridging_flows() - base_flows, RESYNC_FLOWS - 1);
+
+  failures += resync_flow_create(RESYNC_ADDED, group_ids[RESYNC_GROUP_B], &flows[RESYNC_ADDED]);
+
+  buckets = utest_l2_interface_buckets_new(RESYNC_GROUP_MODIFIED + 1, 1);
+  err = utest_driver_group_modify(group_ids[RESYNC_GROUP_MODIFIED], groups[RESYNC_GROUP_MODIFIED], buckets);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: modify failed, err %d",
+              group_ids[RESYNC_GROUP_MODIFIED], err);
+
+  (void)utest_flow_removed_get(&count);
+  UTEST_CHECK(failures, count == 0, "%u flows reported removed before the window ended", count);
+
+  ind_ofdpa_warm_end();
+  UTEST_CHECK(failures, !ind_ofdpa_warm_active(), "resync window still open after its end");
+
+  /* The re-sent half and the new flow stay */
+  UTEST_CHECK(failures, resync_bridging_flows() == base_flows + RESYNC_FLOWS / 2 + 1,
+              "resync left %u bridging flows, expected %u",
+              resync_bridging_flows() - base_flows, RESYNC_FLOWS / 2 + 1);
+
+  removed = utest_flow_removed_get(&count);
+  for (i = 0; i < count; i++)
+  {
+    if ((removed[i].flow_id < RESYNC_FLOW_ID_BASE) ||
+        (removed[i].flow_id > RESYNC_FLOW_ID_BASE + RESYNC_ADDED))
+    {
+      /* Left by an earlier test */
+      continue;
+    }
+    UTEST_CHECK(failures, removed[i].reason == INDIGO_FLOW_REMOVED_DELETE,
+                "flow 0x%llx reported removed with reason %d",
+                (unsigned long long)removed[i].flow_id, removed[i].reason);
+    reported[removed[i].flow_id - RESYNC_FLOW_ID_BASE]++;
+  }
+  for (key = 0; key <= RESYNC_ADDED; key++)
+  {
+    if ((key >= RESYNC_FLOWS / 2) && (key < RESYNC_DELETED))
+    {
+      UTEST_CHECK(failures, reported[key] == 1, "unconfirmed flow %u reported removed %u times",
+                  key, reported[key]);
+      flows[key] = NULL;
+    }
+    else
+    {
+      UTEST_CHECK(failures, reported[key] == 0, "flow %u reported removed %u times",
+                  key, reported[key]);
+    }
+  }
+
+  UTEST_CHECK(failures, resync_group_programmed(group_ids[RESYNC_GROUP_A]),
+              "group 0x%08x used by re-sent flows deleted", group_ids[RESYNC_GROUP_A]);
+  UTEST_CHECK(failures, resync_group_programmed(group_ids[RESYNC_GROUP_B]),
+              "group 0x%08x used by a new flow deleted", group_ids[RESYNC_GROUP_B]);
+  UTEST_CHECK(failures, resync_group_programmed(group_ids[RESYNC_GROUP_MODIFIED]),
+              "modified group 0x%08x deleted", group_ids[RESYNC_GROUP_MODIFIED]);
+  UTEST_CHECK(failures, !resync_group_programmed(group_ids[RESYNC_GROUP_UNUSED]),
+              "unused group 0x%08x not deleted", group_ids[RESYNC_GROUP_UNUSED]);
+
+  /* Indigo still has the deleted group */
+  buckets = utest_l2_interface_buckets_new(RESYNC_GROUP_UNUSED + 1, 1);
+  err = utest_driver_group_modify(group_ids[RESYNC_GROUP_UNUSED], groups[RESYNC_GROUP_UNUSED], buckets);
+  of_object_delete(buckets);
+  UTEST_CHECK(failures, err == INDIGO_ERROR_NOT_FOUND,
+              "modify of deleted group 0x%08x returned %d", group_ids[RESYNC_GROUP_UNUSED], err);
+
+  printf("resync: %u of %u flows sent back, %d failures\n", RESYNC_FLOWS / 2, RESYNC_FLOWS, failures);
+
+done:
+  ind_ofdpa_warm_end();
+  for (key = 0; key <= RESYNC_ADDED; key++)
+  {
+    if (flows[key] != NULL)
+    {
+      (void)ops->table_ops->entry_delete(INDIGO_COOKIE_TO_POINTER(OFDPA_FLOW_TABLE_ID_BRIDGING), 0,
+                                         flows[key], &flow_stats);
+    }
+  }
+  for (i = 0; i < RESYNC_GROUPS; i++)
+  {
+    if (groups[i] != NULL)
+    {
+      err = utest_driver_group_delete(group_ids[i], groups[i]);
+      UTEST_CHECK(failures, err == INDIGO_ERROR_NONE, "group 0x%08x: delete failed, err %d",
+                  group_ids[i], err);
+    }
+  }
+  utest_flow_removed_clear();
+
+  return (failures == 0) ? 0 : -1;
+}
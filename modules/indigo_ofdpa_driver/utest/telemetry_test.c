@@ -0,0 +1,484 @@
+/**************************************************************************//**
+ *
+ * Telemetry export test ("telemetry").
+ *
+ * Stands in for the consumers of the telemetry socket. The exporter runs
+ * on the socket manager of this process with every family at 50 ms, and
+ * the consumers read its NDJSON stream:
+ *   - a consumer receives all four families, and every line is one
+ *     complete JSON object with the family and timestamp first
+ *   - a consumer that stops reading may miss snapshots or be dropped,
+ *     but never tears a line in another consumer's stream or stalls it
+ *   - a group snapshot a few times larger than the socket buffer still
+ *     reaches a consumer whole, every time
+ *   - clients that connect and go away, including the ones turned away
+ *     over the client limit, free their slots for later consumers
+ *
+ *****************************************************************************/
+#include <indigo_ofdpa_driver/indigo_ofdpa_driver_config.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_telemetry.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_rpc_stats.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <AIM/aim.h>
+#include <SocketManager/socketmanager.h>
+
+#include "utest.h"
+
+#define TELEMETRY_INTERVAL_MS   50
+#define TELEMETRY_RUN_MS        20
+#define TELEMETRY_DEADLINE_MS   5000
+#define TELEMETRY_STALL_MS      1000
+#define TELEMETRY_GROUPS        4
+#define TELEMETRY_VLAN          30
+#define TELEMETRY_LARGE_GROUPS  6000    /* about 500 KB per group snapshot */
+#define TELEMETRY_LARGE_SNAPSHOTS 3
+#define TELEMETRY_CHURN         (3 * IND_OFDPA_TELEMETRY_MAX_CLIENTS)
+
+static const char *telemetry_family_names[IND_OFDPA_TELEMETRY_FAMILY_COUNT] =
+{
+  "port", "queue", "table", "group"
+};
+
+#define TELEMETRY_ALL_FAMILIES  ((1 << IND_OFDPA_TELEMETRY_FAMILY_COUNT) - 1)
+
+typedef struct
+{
+  int fd;
+  char buf[65536];
+  size_t len;                   /* bytes of an incomplete line */
+  uint32_t lines;
+  uint32_t bad_lines;
+  uint32_t families;            /* bitmap of the families seen */
+  int closed;                   /* the exporter closed the stream */
+  int torn;                     /* it closed it in the middle of a line */
+  uint32_t group_expected;      /* group lines in a whole snapshot, 0 if unchecked */
+  uint64_t group_ts;            /* timestamp of the group snapshot being read */
+  uint32_t group_lines;         /* its lines so far */
+  uint32_t group_snapshots;     /* group snapshots read whole */
+  uint32_t group_short;         /* group snapshots with lines missing */
+} telemetry_consumer_t;
+
+static char telemetry_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static int telemetry_connect(int rcvbuf)
+{
+  struct sockaddr_un addr;
+  int fd;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return -1;
+  }
+  if (rcvbuf != 0)
+  {
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, telemetry_path, sizeof(addr.sun_path) - 1);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+  (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+static void telemetry_consumer_open(telemetry_consumer_t *consumer, int rcvbuf)
+{
+  memset(consumer, 0, sizeof(*consumer));
+  consumer->fd = telemetry_connect(rcvbuf);
+}
+
+static void telemetry_consumer_close(telemetry_consumer_t *consumer)
+{
+  if (consumer->fd >= 0)
+  {
+    close(consumer->fd);
+    consumer->fd = -1;
+  }
+}
+
+/* Count the lines of each group snapshot, which share one timestamp */
+static void telemetry_group_line(telemetry_consumer_t *consumer, const char *ts_ms)
+{
+  uint64_t ts = strtoull(ts_ms, NULL, 10);
+
+  if (consumer->group_expected == 0)
+  {
+    return;
+  }
+  if ((ts != consumer->group_ts) && (consumer->group_lines != 0))
+  {
+    if (consumer->group_lines == consumer->group_expected)
+    {
+      consumer->group_snapshots++;
+    }
+    else
+    {
+      consumer->group_short++;
+    }
+    consumer->group_lines = 0;
+  }
+  consumer->group_ts = ts;
+  consumer->group_lines++;
+}
+
+/* Check one line: {"family":"<name>","ts_ms":<digits>,...} */
+static void telemetry_line_check(telemetry_consumer_t *consumer, const char *line, size_t len)
+{
+  static const char prefix[] = "{\"family\":\"";
+  static const char ts[] = "\",\"ts_ms\":";
+  size_t name_len;
+  int i;
+
+  consumer->lines++;
+  if ((len < sizeof(prefix)) || (memcmp(line, prefix, sizeof(prefix) - 1) != 0) ||
+      (line[len - 1] != '}'))
+  {
+    consumer->bad_lines++;
+    return;
+  }
+
+  line += sizeof(prefix) - 1;
+  len -= sizeof(prefix) - 1;
+  for (i = 0; i < IND_OFDPA_TELEMETRY_FAMILY_COUNT; i++)
+  {
+    name_len = strlen(telemetry_family_names[i]);
+    if ((len > name_len + sizeof(ts)) &&
+        (memcmp(line, telemetry_family_names[i], name_len) == 0) &&
+        (memcmp(line + name_len, ts, sizeof(ts) - 1) == 0) &&
+        (line[name_len + sizeof(ts) - 1] >= '0') && (line[name_len + sizeof(ts) - 1] <= '9'))
+    {
+      consumer->families |= 1 << i;
+      if (i == IND_OFDPA_TELEMETRY_FAMILY_GROUP)
+      {
+        telemetry_group_line(consumer, line + name_len + sizeof(ts) - 1);
+      }
+      return;
+    }
+  }
+  consumer->bad_lines++;
+}
+
+/* Read what the exporter has sent so far and check every complete line */
+static void telemetry_consumer_drain(telemetry_consumer_t *consumer)
+{
+  char *start, *end;
+  ssize_t n;
+
+  while ((consumer->fd >= 0) && !consumer->closed)
+  {
+    n = recv(consumer->fd, consumer->buf + consumer->len,
+             sizeof(consumer->buf) - consumer->len, 0);
+    if (n < 0)
+    {
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+      {
+        consumer->closed = 1;
+        consumer->torn = (consumer->len != 0);
+      }
+      return;
+    }
+    if (n == 0)
+    {
+      consumer->closed = 1;
+      consumer->torn = (consumer->len != 0);
+      return;
+    }
+
+    consumer->len += n;
+    start = consumer->buf;
+    while ((end = memchr(start, '\n', consumer->len - (start - consumer->buf))) != NULL)
+    {
+      telemetry_line_check(consumer, start, end - start);
+      start = end + 1;
+    }
+    consumer->len -= start - consumer->buf;
+    memmove(consumer->buf, start, consumer->len);
+
+    if (consumer->len == sizeof(consumer->buf))
+    {
+      /* No line is this long */
+      consumer->bad_lines++;
+      consumer->len = 0;
+    }
+  }
+}
+
+/* Run the exporter for ms, draining the consumers as it goes */
+static void telemetry_run(telemetry_consumer_t **consumers, int num_consumers, uint32_t ms)
+{
+  uint64_t deadline = ind_ofdpa_rpc_now_ns() + (uint64_t)ms * 1000000;
+  int i;
+
+  while (ind_ofdpa_rpc_now_ns() < deadline)
+  {
+    ind_soc_select_and_run(TELEMETRY_RUN_MS);
+    for (i = 0; i < num_consumers; i++)
+    {
+      telemetry_consumer_drain(consumers[i]);
+    }
+  }
+}
+
+/* Run the exporter until the consumer has seen every family and at least
+   min_lines more lines, or the deadline passes */
+static void telemetry_run_until(telemetry_consumer_t *consumer, uint32_t min_lines)
+{
+  uint64_t deadline = ind_ofdpa_rpc_now_ns() + (uint64_t)TELEMETRY_DEADLINE_MS * 1000000;
+  uint32_t lines = consumer->lines;
+
+  consumer->families = 0;
+  while ((ind_ofdpa_rpc_now_ns() < deadline) &&
+         ((consumer->families != TELEMETRY_ALL_FAMILIES) || (consumer->lines - lines < min_lines)))
+  {
+    ind_soc_select_and_run(TELEMETRY_RUN_MS);
+    telemetry_consumer_drain(consumer);
+  }
+}
+
+static int telemetry_stream_test(telemetry_consumer_t *fast)
+{
+  int failures = 0;
+
+  telemetry_run_until(fast, 1);
+  UTEST_CHECK(failures, fast->families == TELEMETRY_ALL_FAMILIES,
+              "stream: families 0x%x seen within %u ms", fast->families, TELEMETRY_DEADLINE_MS);
+  UTEST_CHECK(failures, fast->bad_lines == 0, "stream: %u of %u lines malformed",
+              fast->bad_lines, fast->lines);
+  UTEST_CHECK(failures, !fast->closed, "stream: the exporter closed the consumer");
+
+  printf("telemetry stream: %u lines, %d failures\n", fast->lines, failures);
+  return failures;
+}
+
+/* A consumer with a small receive buffer that never reads, next to one
+   that keeps up */
+static int telemetry_slow_test(telemetry_consumer_t *fast)
+{
+  telemetry_consumer_t *slow = malloc(sizeof(*slow));
+  telemetry_consumer_t *consumers[1] = { fast };
+  uint32_t lines;
+  int failures = 0;
+
+  if (slow == NULL)
+  {
+    return 1;
+  }
+  telemetry_consumer_open(slow, 4096);
+  UTEST_CHECK(failures, slow->fd >= 0, "slow: connect failed: %s", strerror(errno));
+
+  telemetry_run(consumers, 1, TELEMETRY_STALL_MS);
+
+  lines = fast->lines;
+  telemetry_run_until(fast, 1);
+  UTEST_CHECK(failures, fast->lines > lines, "slow: the other consumer stalled");
+  UTEST_CHECK(failures, fast->bad_lines == 0, "slow: %u of %u lines malformed next to a stalled consumer",
+              fast->bad_lines, fast->lines);
+  UTEST_CHECK(failures, !fast->closed, "slow: the exporter closed the consumer that kept up");
+
+  /* What the stalled consumer did get must still parse, up to where it
+     was cut off */
+  telemetry_consumer_drain(slow);
+  UTEST_CHECK(failures, slow->bad_lines == 0, "slow: %u of its %u lines malformed",
+              slow->bad_lines, slow->lines);
+  UTEST_CHECK(failures, !slow->torn || slow->closed, "slow: torn line in an open stream");
+
+  printf("telemetry slow consumer: %u lines before it stalled, %s, %d failures\n",
+         slow->lines, slow->closed ? "dropped" : "skipped", failures);
+
+  telemetry_consumer_close(slow);
+  free(slow);
+  return failures;
+}
+
+/* Group snapshots several times the socket buffer, read by a consumer
+   that keeps up. Each must arrive whole: the exporter sends what the
+   socket takes and the rest as it drains, without dropping the consumer. */
+static int telemetry_large_test(telemetry_consumer_t *fast)
+{
+  telemetry_consumer_t *large = malloc(sizeof(*large));
+  telemetry_consumer_t *consumers[2] = { fast, large };
+  uint32_t *groups = malloc(TELEMETRY_LARGE_GROUPS * sizeof(*groups));
+  uint64_t deadline;
+  int failures = 0;
+  int i;
+
+  if ((large == NULL) || (groups == NULL))
+  {
+    free(large);
+    free(groups);
+    return 1;
+  }
+
+  for (i = 0; i < TELEMETRY_LARGE_GROUPS; i++)
+  {
+    groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, TELEMETRY_VLAN + 1, i + 1);
+  }
+
+  telemetry_consumer_open(large, 0);
+  UTEST_CHECK(failures, large->fd >= 0, "large: connect failed: %s", strerror(errno));
+  large->group_expected = TELEMETRY_GROUPS + TELEMETRY_LARGE_GROUPS;
+
+  deadline = ind_ofdpa_rpc_now_ns() + (uint64_t)TELEMETRY_DEADLINE_MS * 1000000;
+  while ((ind_ofdpa_rpc_now_ns() < deadline) && !large->closed &&
+         (large->group_snapshots < TELEMETRY_LARGE_SNAPSHOTS))
+  {
+    ind_soc_select_and_run(TELEMETRY_RUN_MS);
+    for (i = 0; i < 2; i++)
+    {
+      telemetry_consumer_drain(consumers[i]);
+    }
+  }
+
+  UTEST_CHECK(failures, large->group_snapshots >= TELEMETRY_LARGE_SNAPSHOTS,
+              "large: %u whole group snapshots of %u lines within %u ms",
+              large->group_snapshots, large->group_expected, TELEMETRY_DEADLINE_MS);
+  UTEST_CHECK(failures, large->group_short == 0, "large: %u group snapshots with lines missing",
+              large->group_short);
+  UTEST_CHECK(failures, large->bad_lines == 0, "large: %u of %u lines malformed",
+              large->bad_lines, large->lines);
+  UTEST_CHECK(failures, !large->closed, "large: the exporter closed the consumer");
+  UTEST_CHECK(failures, fast->bad_lines == 0 && !fast->closed,
+              "large: the other consumer saw %u malformed lines%s", fast->bad_lines,
+              fast->closed ? " and was closed" : "");
+
+  printf("telemetry large snapshots: %u groups, %u whole snapshots, %u lines, %d failures\n",
+         large->group_expected, large->group_snapshots, large->lines, failures);
+
+  telemetry_consumer_close(large);
+  for (i = 0; i < TELEMETRY_LARGE_GROUPS; i++)
+  {
+    (void)ofdpaGroupDelete(groups[i]);
+  }
+  free(groups);
+  free(large);
+  return failures;
+}
+
+/* Connect more clients than the exporter takes, close them all, and see
+   that a new consumer still gets a stream */
+static int telemetry_churn_test(telemetry_consumer_t *fast)
+{
+  int fds[IND_OFDPA_TELEMETRY_MAX_CLIENTS + 2];
+  telemetry_consumer_t *last = malloc(sizeof(*last));
+  int i, j;
+  int failures = 0;
+
+  if (last == NULL)
+  {
+    return 1;
+  }
+
+  for (i = 0; i < TELEMETRY_CHURN; i++)
+  {
+    for (j = 0; j < (int)(sizeof(fds) / sizeof(fds[0])); j++)
+    {
+      fds[j] = telemetry_connect(0);
+      ind_soc_select_and_run(1);
+    }
+    for (j = 0; j < (int)(sizeof(fds) / sizeof(fds[0])); j++)
+    {
+      if (fds[j] >= 0)
+      {
+        close(fds[j]);
+      }
+    }
+    ind_soc_select_and_run(1);
+    ind_soc_select_and_run(1);
+  }
+
+  /* Let the exporter notice every close */
+  telemetry_run(&fast, 1, 200);
+
+  telemetry_consumer_open(last, 0);
+  UTEST_CHECK(failures, last->fd >= 0, "churn: connect failed: %s", strerror(errno));
+  telemetry_run_until(last, 1);
+  UTEST_CHECK(failures, last->families == TELEMETRY_ALL_FAMILIES,
+              "churn: a consumer after %d rounds of %d clients saw families 0x%x",
+              TELEMETRY_CHURN, (int)(sizeof(fds) / sizeof(fds[0])), last->families);
+  UTEST_CHECK(failures, last->bad_lines == 0, "churn: %u of %u lines malformed",
+              last->bad_lines, last->lines);
+
+  printf("telemetry churn: %d connects, %u lines after, %d failures\n",
+         TELEMETRY_CHURN * (int)(sizeof(fds) / sizeof(fds[0])), last->lines, failures);
+
+  telemetry_consumer_close(last);
+  free(last);
+  return failures;
+}
+
+int telemetry_test_run(void)
+{
+  static ind_soc_config_t soc_cfg;
+  telemetry_consumer_t *fast;
+  uint32_t groups[TELEMETRY_GROUPS];
+  int failures = 0;
+  int i;
+
+  fast = malloc(sizeof(*fast));
+  if (fast == NULL)
+  {
+    return -1;
+  }
+
+  /* Something for the group family to report */
+  for (i = 0; i < TELEMETRY_GROUPS; i++)
+  {
+    groups[i] = utest_group_add(OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE, TELEMETRY_VLAN, i + 1);
+  }
+
+  if ((ind_soc_init(&soc_cfg) < 0) || (ind_soc_enable_set(1) < 0))
+  {
+    fprintf(stderr, "failed to start the socket manager\n");
+    free(fast);
+    return -1;
+  }
+
+  for (i = 0; i < IND_OFDPA_TELEMETRY_FAMILY_COUNT; i++)
+  {
+    (void)ind_ofdpa_telemetry_interval_set(i, TELEMETRY_INTERVAL_MS);
+  }
+  snprintf(telemetry_path, sizeof(telemetry_path), "/tmp/ofdpa_utest_telemetry.%d.sock", (int)getpid());
+
+  if (ind_ofdpa_telemetry_init(telemetry_path) != INDIGO_ERROR_NONE)
+  {
+    fprintf(stderr, "failed to start the telemetry export on %s\n", telemetry_path);
+    failures++;
+  }
+  else
+  {
+    telemetry_consumer_open(fast, 0);
+    UTEST_CHECK(failures, fast->fd >= 0, "connect failed: %s", strerror(errno));
+    if (fast->fd >= 0)
+    {
+      failures += telemetry_stream_test(fast);
+      failures += telemetry_slow_test(fast);
+      failures += telemetry_large_test(fast);
+      failures += telemetry_churn_test(fast);
+    }
+    telemetry_consumer_close(fast);
+    ind_ofdpa_telemetry_finish();
+  }
+
+  ind_soc_finish();
+  for (i = 0; i < TELEMETRY_GROUPS; i++)
+  {
+    (void)ofdpaGroupDelete(groups[i]);
+  }
+  free(fast);
+
+  return (failures == 0) ? 0 : -1;
+}
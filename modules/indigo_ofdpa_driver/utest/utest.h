@@ -0,0 +1,89 @@
+/**************************************************************************//**
+ *
+ * Shared declarations of the indigo_ofdpa_driver tests and benchmarks.
+ *
+ * Every test runs the driver against libofdpa_sim in this process. The
+ * benchmarks print one JSON object per line, each starting with the -l
+ * label and the test name, for comparing runs across commits. The
+ * tests print what they checked and return non-zero on a failure.
+ *
+ *****************************************************************************/
+#ifndef __INDIGO_OFDPA_DRIVER_UTEST_H__
+#define __INDIGO_OFDPA_DRIVER_UTEST_H__
+
+#include <stdint.h>
+#include <indigo_ofdpa_driver/ind_ofdpa_util.h>
+#include <ofdpa_sim/ofdpa_sim.h>
+
+/* Command line settings. A count or rounds of 0 leaves each test its
+   own default. */
+extern uint32_t utest_count;
+extern uint32_t utest_rounds;
+extern int utest_table;                 /* flow table id, -1 for all */
+extern const char *utest_label;
+
+#define UTEST_COUNT(_default)   ((utest_count != 0) ? utest_count : (_default))
+#define UTEST_ROUNDS(_default)  ((utest_rounds != 0) ? utest_rounds : (_default))
+
+/* Report a failed check and count it */
+#define UTEST_CHECK(_failures, _cond, ...)                              \
+  do {                                                                  \
+    if (!(_cond))                                                       \
+    {                                                                   \
+      fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                   \
+      fprintf(stderr, __VA_ARGS__);                                     \
+      fprintf(stderr, "\n");                                            \
+      (_failures)++;                                                    \
+    }                                                                   \
+  } while (0)
+
+/* Add a group straight to OF-DPA, bypassing the driver. The VLAN is used
+   by L2 interface, flood and multicast groups, the port by L2 interface
+   groups and the index by all others. Returns the group ID. */
+uint32_t utest_group_add(OFDPA_GROUP_ENTRY_TYPE_t type, uint32_t vlan, uint32_t port_or_index);
+
+/* The ID utest_group_add() gives such a group, without adding it */
+uint32_t utest_group_id(OFDPA_GROUP_ENTRY_TYPE_t type, uint32_t vlan, uint32_t port_or_index);
+
+/* OF-DPA calls of one class made so far */
+uint64_t utest_sim_calls(ofdpa_sim_call_t call);
+
+/* Bucket lists as a controller sends them; free with of_object_delete().
+   L2 interface buckets output to a port, L3 unicast buckets rewrite the
+   MACs and VLAN and chain to an L2 interface group, L3 interface
+   buckets do the same for the source MAC and VLAN only, and reference
+   buckets chain to one group each. */
+of_list_bucket_t *utest_l2_interface_buckets_new(uint32_t port, int pop_vlan);
+of_list_bucket_t *utest_l3_unicast_buckets_new(uint32_t ref_group_id, uint16_t vlan, uint32_t mac_key);
+of_list_bucket_t *utest_l3_interface_buckets_new(uint32_t ref_group_id, uint16_t vlan, uint32_t mac_key);
+of_list_bucket_t *utest_ref_buckets_new(const uint32_t *ref_group_ids, uint32_t count);
+
+/* Group adds, modifies and deletes through the driver's group table
+   operations, as Indigo calls them */
+indigo_error_t utest_driver_group_create(uint32_t group_id, uint8_t group_type,
+                                         of_list_bucket_t *buckets, void **entry_priv);
+indigo_error_t utest_driver_group_modify(uint32_t group_id, void *entry_priv,
+                                         of_list_bucket_t *buckets);
+indigo_error_t utest_driver_group_delete(uint32_t group_id, void *entry_priv);
+
+/* The tests, each returning 0 on success */
+/* Flow-removed reports the driver made to Indigo, oldest first */
+typedef struct
+{
+  indigo_cookie_t flow_id;
+  indigo_fi_flow_removed_t reason;
+} utest_flow_removed_t;
+
+const utest_flow_removed_t *utest_flow_removed_get(uint32_t *count);
+void utest_flow_removed_clear(void);
+
+int flow_bench_run(void);
+int group_bench_run(void);
+int group_swap_test_run(void);
+int group_cascade_test_run(void);
+int meter_test_run(void);
+int resilient_bench_run(void);
+int resync_test_run(void);
+int telemetry_test_run(void);
+
+#endif /* __INDIGO_OFDPA_DRIVER_UTEST_H__ */
@@ -0,0 +1,109 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim.h
+*
+* @purpose      Control interface of the simulated OF-DPA library
+*
+* @component    OF-DPA
+*
+* @comments     libofdpa_sim implements the ofdpa_api.h client calls
+*               against in-memory tables so that ofagent and the client
+*               tools run without a switch. Link it in place of the
+*               OF-DPA RPC client library. The calls below configure the
+*               simulation and inject events; all are thread safe.
+*
+*               The environment is read on the first OF-DPA call:
+*                 OFDPA_SIM_PORTS             physical ports (default 32)
+*                 OFDPA_SIM_LATENCY_US        latency added to every call
+*                 OFDPA_SIM_FLOW_LATENCY_US   } override the latency of
+*                 OFDPA_SIM_GROUP_LATENCY_US  } one class of calls
+*                 OFDPA_SIM_PORT_LATENCY_US   }
+*                 OFDPA_SIM_PKT_LATENCY_US    }
+*                 OFDPA_SIM_TABLE_MAX         capacity overrides, as a list
+*                                             of table:entries, e.g. 50:4096
+*                 OFDPA_SIM_PORT_PPS          synthetic rx and tx rate of
+*                                             each port (default 1000)
+*                 OFDPA_SIM_PKT_IN_PPS        synthetic packet-in rate,
+*                                             spread over all ports
+*                 OFDPA_SIM_PKT_LOOPBACK      if 1, a packet sent out of a
+*                                             port comes back in on it
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __OFDPA_SIM_H__
+#define __OFDPA_SIM_H__
+
+#include <stdint.h>
+#include <ofdpa_api.h>
+
+/* Classes of calls that can be given their own latency */
+typedef enum
+{
+  OFDPA_SIM_CALL_FLOW = 0,
+  OFDPA_SIM_CALL_GROUP,
+  OFDPA_SIM_CALL_PORT,
+  OFDPA_SIM_CALL_PKT,
+  OFDPA_SIM_CALL_OTHER,
+  OFDPA_SIM_CALL_COUNT,
+} ofdpa_sim_call_t;
+
+/* Latency added to each call of a class, in microseconds */
+void ofdpa_sim_latency_set(ofdpa_sim_call_t call, uint32_t usec);
+
+/* Capacity reported by ofdpaFlowTableInfoGet() and enforced by ofdpaFlowAdd() */
+OFDPA_ERROR_t ofdpa_sim_table_max_set(OFDPA_FLOW_TABLE_ID_t tableId, uint32_t maxEntries);
+
+/* If disabled, ofdpaGroupBucketEntryModify() fails with OFDPA_E_UNAVAIL, as
+   it does on switches that cannot rewrite a bucket in place */
+void ofdpa_sim_bucket_modify_set(int enable);
+
+/* Queue a packet-in; it is dropped if the packet queue is full */
+OFDPA_ERROR_t ofdpa_sim_pkt_inject(uint32_t inPortNum, OFDPA_PACKET_IN_REASON_t reason,
+                                   OFDPA_FLOW_TABLE_ID_t tableId,
+                                   const void *data, uint32_t size);
+
+/* Change link state, or create and delete ports, and raise the port event */
+OFDPA_ERROR_t ofdpa_sim_port_link_set(uint32_t portNum, int up);
+OFDPA_ERROR_t ofdpa_sim_port_create(uint32_t portNum);
+OFDPA_ERROR_t ofdpa_sim_port_delete(uint32_t portNum);
+
+/* Count traffic against a flow, which also restarts its idle timer */
+OFDPA_ERROR_t ofdpa_sim_flow_hit(uint64_t cookie, uint64_t packets, uint64_t bytes);
+
+/* Calls made, entries held and events raised since start */
+typedef struct
+{
+  uint64_t calls[OFDPA_SIM_CALL_COUNT];
+  uint32_t flows;
+  uint32_t groups;
+  uint32_t buckets;
+  uint64_t groups_emptied;      /* times a group lost its last bucket */
+  uint64_t flow_events;
+  uint64_t port_events;
+  uint64_t pkts_in;
+  uint64_t pkts_in_dropped;
+  uint64_t pkts_out;
+} ofdpa_sim_stats_t;
+
+void ofdpa_sim_stats_get(ofdpa_sim_stats_t *stats);
+
+#endif /* __OFDPA_SIM_H__ */
@@ -0,0 +1,8 @@
+###############################################################################
+#
+# 
+#
+###############################################################################
+THIS_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+ofdpa_sim_INCLUDES := -I $(THIS_DIR)inc
+ofdpa_sim_INTERNAL_INCLUDES := -I $(THIS_DIR)src
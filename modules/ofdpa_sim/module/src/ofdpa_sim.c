@@ -0,0 +1,708 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim.c
+*
+* @purpose      Simulated OF-DPA client: setup, latency, event and packet
+*               sockets
+*
+* @component    OF-DPA
+*
+* @comments     The event and packet "sockets" are pipes. A byte is
+*               written when the event set or the packet queue goes from
+*               empty to non-empty, so the read end stays readable exactly
+*               while there is something to receive, as a level triggered
+*               socket would.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "ofdpa_sim_int.h"
+
+#define OFDPA_SIM_PORTS_DEFAULT       32
+#define OFDPA_SIM_PORT_PPS_DEFAULT    1000
+#define OFDPA_SIM_MAX_PKT_SIZE        9216
+#define OFDPA_SIM_PKT_QUEUE_SIZE      1024      /* power of 2 */
+#define OFDPA_SIM_TICK_MS             10
+#define OFDPA_SIM_EXPIRE_TICKS        10        /* flow timeouts checked every 100 ms */
+#define OFDPA_SIM_SPIN_USEC           200       /* shorter waits spin instead of sleeping */
+#define OFDPA_SIM_SYNTH_PKT_SIZE      64
+
+pthread_mutex_t ofdpa_sim_lock = PTHREAD_MUTEX_INITIALIZER;
+ofdpa_sim_stats_t ofdpa_sim_stats;
+
+typedef struct
+{
+  uint32_t                  inPortNum;
+  OFDPA_PACKET_IN_REASON_t  reason;
+  OFDPA_FLOW_TABLE_ID_t     tableId;
+  uint32_t                  size;
+  uint8_t                  *data;
+} ofdpa_sim_pkt_t;
+
+static pthread_once_t sim_once = PTHREAD_ONCE_INIT;
+static uint32_t sim_latency_usec[OFDPA_SIM_CALL_COUNT];
+
+static int event_fds[2] = { -1, -1 };
+static int event_pending;
+
+static int pkt_fds[2] = { -1, -1 };
+static ofdpa_sim_pkt_t pkt_queue[OFDPA_SIM_PKT_QUEUE_SIZE];
+static uint32_t pkt_head;
+static uint32_t pkt_tail;
+static int pkt_loopback;
+
+static uint32_t pkt_in_pps;
+static uint32_t pkt_in_port;
+
+static int debug_level;
+static int debug_verbosity;
+static uint8_t debug_components[64];
+
+static OFDPA_CONTROL_t src_mac_learn_mode;
+static ofdpaSrcMacLearnModeCfg_t src_mac_learn_cfg;
+
+uint64_t ofdpa_sim_now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static uint32_t ofdpa_sim_env_u32(const char *name, uint32_t dflt)
+{
+  const char *value = getenv(name);
+
+  return (value != NULL) ? (uint32_t)strtoul(value, NULL, 0) : dflt;
+}
+
+static void ofdpa_sim_pipe_open(int fds[2])
+{
+  if (pipe(fds) != 0)
+  {
+    fprintf(stderr, "ofdpa_sim: pipe() failed, %s\n", strerror(errno));
+    abort();
+  }
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+}
+
+static void ofdpa_sim_pipe_post(int fds[2])
+{
+  char c = 0;
+
+  if (write(fds[1], &c, 1) < 0)
+  {
+    /* Full pipe: the reader is already awake */
+  }
+}
+
+static void ofdpa_sim_pipe_drain(int fds[2])
+{
+  char buf[64];
+
+  while (read(fds[0], buf, sizeof(buf)) > 0)
+  {
+  }
+}
+
+/* Wait until fd is readable. A NULL timeout waits forever. Returns non-zero
+   if the fd is readable. */
+static int ofdpa_sim_wait(int fd, struct timeval *timeout)
+{
+  struct pollfd pfd;
+  int ms = -1;
+
+  if (timeout != NULL)
+  {
+    ms = (timeout->tv_sec * 1000) + (timeout->tv_usec / 1000);
+  }
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  while (poll(&pfd, 1, ms) < 0)
+  {
+    if (errno != EINTR)
+    {
+      return 0;
+    }
+  }
+  return (pfd.revents & POLLIN) != 0;
+}
+
+void ofdpa_sim_event_signal_locked(void)
+{
+  if (!event_pending)
+  {
+    event_pending = 1;
+    ofdpa_sim_pipe_post(event_fds);
+  }
+}
+
+static OFDPA_ERROR_t ofdpa_sim_pkt_queue_locked(uint32_t inPortNum, OFDPA_PACKET_IN_REASON_t reason,
+                                                OFDPA_FLOW_TABLE_ID_t tableId,
+                                                const void *data, uint32_t size)
+{
+  ofdpa_sim_pkt_t *pkt;
+
+  if ((pkt_tail - pkt_head) == OFDPA_SIM_PKT_QUEUE_SIZE)
+  {
+    ofdpa_sim_stats.pkts_in_dropped++;
+    return OFDPA_E_FULL;
+  }
+
+  pkt = &pkt_queue[pkt_tail & (OFDPA_SIM_PKT_QUEUE_SIZE - 1)];
+  pkt->data = malloc(size ? size : 1);
+  if (pkt->data == NULL)
+  {
+    ofdpa_sim_stats.pkts_in_dropped++;
+    return OFDPA_E_FAIL;
+  }
+  memcpy(pkt->data, data, size);
+  pkt->size = size;
+  pkt->inPortNum = inPortNum;
+  pkt->reason = reason;
+  pkt->tableId = tableId;
+
+  if (pkt_tail++ == pkt_head)
+  {
+    ofdpa_sim_pipe_post(pkt_fds);
+  }
+  ofdpa_sim_stats.pkts_in++;
+  ofdpa_sim_port_count_locked(inPortNum, 1, size);
+
+  return OFDPA_E_NONE;
+}
+
+/* Synthetic packet-ins: a broadcast frame from each up port in turn */
+static void ofdpa_sim_pkt_in_generate_locked(uint32_t count)
+{
+  uint8_t frame[OFDPA_SIM_SYNTH_PKT_SIZE];
+
+  memset(frame, 0, sizeof(frame));
+  memset(frame, 0xff, 6);
+  frame[6] = 0x02;
+  frame[12] = 0x08;
+
+  while (count-- > 0)
+  {
+    pkt_in_port = ofdpa_sim_port_next_up_locked(pkt_in_port);
+    if (pkt_in_port == 0)
+    {
+      return;
+    }
+    frame[10] = (pkt_in_port >> 8) & 0xff;
+    frame[11] = pkt_in_port & 0xff;
+    ofdpa_sim_pkt_queue_locked(pkt_in_port, OFDPA_PACKET_IN_REASON_NO_MATCH,
+                               OFDPA_FLOW_TABLE_ID_ACL_POLICY, frame, sizeof(frame));
+  }
+}
+
+static void *ofdpa_sim_tick_thread(void *arg)
+{
+  struct timespec tick = { 0, OFDPA_SIM_TICK_MS * 1000000 };
+  uint64_t pkt_credit = 0;
+  uint32_t ticks = 0;
+
+  (void)arg;
+
+  for (;;)
+  {
+    nanosleep(&tick, NULL);
+
+    OFDPA_SIM_LOCK();
+    if (pkt_in_pps != 0)
+    {
+      /* Credit in thousandths of a packet so low rates still trickle */
+      pkt_credit += (uint64_t)pkt_in_pps * OFDPA_SIM_TICK_MS;
+      ofdpa_sim_pkt_in_generate_locked(pkt_credit / 1000000);
+      pkt_credit %= 1000000;
+    }
+    if (++ticks == OFDPA_SIM_EXPIRE_TICKS)
+    {
+      ticks = 0;
+      ofdpa_sim_flow_expire_locked(ofdpa_sim_now_ms());
+    }
+    OFDPA_SIM_UNLOCK();
+  }
+
+  return NULL;
+}
+
+static void ofdpa_sim_table_max_parse(const char *spec)
+{
+  char *copy = strdup(spec);
+  char *save = NULL;
+  char *item;
+  unsigned long table, max;
+
+  if (copy == NULL)
+  {
+    return;
+  }
+
+  for (item = strtok_r(copy, ", ", &save); item != NULL; item = strtok_r(NULL, ", ", &save))
+  {
+    if ((sscanf(item, "%lu:%lu", &table, &max) != 2) ||
+        (ofdpa_sim_flow_table_max_set_locked((OFDPA_FLOW_TABLE_ID_t)table, max) != OFDPA_E_NONE))
+    {
+      fprintf(stderr, "ofdpa_sim: ignoring OFDPA_SIM_TABLE_MAX entry \"%s\"\n", item);
+    }
+  }
+  free(copy);
+}
+
+static void ofdpa_sim_init_once(void)
+{
+  static const char *latency_env[OFDPA_SIM_CALL_COUNT] =
+  {
+    "OFDPA_SIM_FLOW_LATENCY_US",
+    "OFDPA_SIM_GROUP_LATENCY_US",
+    "OFDPA_SIM_PORT_LATENCY_US",
+    "OFDPA_SIM_PKT_LATENCY_US",
+    NULL,
+  };
+  pthread_t thread;
+  uint32_t latency;
+  const char *spec;
+  int i;
+
+  latency = ofdpa_sim_env_u32("OFDPA_SIM_LATENCY_US", 0);
+  for (i = 0; i < OFDPA_SIM_CALL_COUNT; i++)
+  {
+    sim_latency_usec[i] = (latency_env[i] != NULL) ? ofdpa_sim_env_u32(latency_env[i], latency) : latency;
+  }
+
+  spec = getenv("OFDPA_SIM_TABLE_MAX");
+  if (spec != NULL)
+  {
+    ofdpa_sim_table_max_parse(spec);
+  }
+
+  ofdpa_sim_port_init(ofdpa_sim_env_u32("OFDPA_SIM_PORTS", OFDPA_SIM_PORTS_DEFAULT),
+                      ofdpa_sim_env_u32("OFDPA_SIM_PORT_PPS", OFDPA_SIM_PORT_PPS_DEFAULT));
+  pkt_in_pps = ofdpa_sim_env_u32("OFDPA_SIM_PKT_IN_PPS", 0);
+  pkt_loopback = ofdpa_sim_env_u32("OFDPA_SIM_PKT_LOOPBACK", 0);
+
+  ofdpa_sim_pipe_open(event_fds);
+  ofdpa_sim_pipe_open(pkt_fds);
+
+  if (pthread_create(&thread, NULL, ofdpa_sim_tick_thread, NULL) != 0)
+  {
+    fprintf(stderr, "ofdpa_sim: failed to start tick thread\n");
+    abort();
+  }
+  pthread_detach(thread);
+}
+
+static void ofdpa_sim_delay(uint32_t usec)
+{
+  struct timespec end, now;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  end.tv_sec += usec / 1000000;
+  end.tv_nsec += (usec % 1000000) * 1000;
+  if (end.tv_nsec >= 1000000000)
+  {
+    end.tv_sec++;
+    end.tv_nsec -= 1000000000;
+  }
+
+  if (usec >= OFDPA_SIM_SPIN_USEC)
+  {
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &end, NULL) == EINTR)
+    {
+    }
+    return;
+  }
+
+  do
+  {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while ((now.tv_sec < end.tv_sec) ||
+           ((now.tv_sec == end.tv_sec) && (now.tv_nsec < end.tv_nsec)));
+}
+
+void ofdpa_sim_init(void)
+{
+  pthread_once(&sim_once, ofdpa_sim_init_once);
+}
+
+void ofdpa_sim_call(ofdpa_sim_call_t call)
+{
+  uint32_t usec;
+
+  ofdpa_sim_init();
+
+  __atomic_fetch_add(&ofdpa_sim_stats.calls[call], 1, __ATOMIC_RELAXED);
+  usec = __atomic_load_n(&sim_latency_usec[call], __ATOMIC_RELAXED);
+  if (usec != 0)
+  {
+    ofdpa_sim_delay(usec);
+  }
+}
+
+/*
+ * Control interface
+ */
+void ofdpa_sim_latency_set(ofdpa_sim_call_t call, uint32_t usec)
+{
+  ofdpa_sim_init();
+
+  if (call < OFDPA_SIM_CALL_COUNT)
+  {
+    __atomic_store_n(&sim_latency_usec[call], usec, __ATOMIC_RELAXED);
+  }
+}
+
+OFDPA_ERROR_t ofdpa_sim_table_max_set(OFDPA_FLOW_TABLE_ID_t tableId, uint32_t maxEntries)
+{
+  OFDPA_ERROR_t rc;
+
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  rc = ofdpa_sim_flow_table_max_set_locked(tableId, maxEntries);
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpa_sim_pkt_inject(uint32_t inPortNum, OFDPA_PACKET_IN_REASON_t reason,
+                                   OFDPA_FLOW_TABLE_ID_t tableId,
+                                   const void *data, uint32_t size)
+{
+  OFDPA_ERROR_t rc;
+
+  ofdpa_sim_init();
+
+  if ((data == NULL) || (size > OFDPA_SIM_MAX_PKT_SIZE))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  rc = ofdpa_sim_pkt_queue_locked(inPortNum, reason, tableId, data, size);
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+void ofdpa_sim_stats_get(ofdpa_sim_stats_t *stats)
+{
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  *stats = ofdpa_sim_stats;
+  OFDPA_SIM_UNLOCK();
+}
+
+/*
+ * Client setup
+ */
+OFDPA_ERROR_t ofdpaClientInitialize(char *clientName)
+{
+  (void)clientName;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaClientEventSockBind(void)
+{
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaClientPktSockBind(void)
+{
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NONE;
+}
+
+int ofdpaClientEventSockFdGet(void)
+{
+  ofdpa_sim_init();
+  return event_fds[0];
+}
+
+int ofdpaClientPktSockFdGet(void)
+{
+  ofdpa_sim_init();
+  return pkt_fds[0];
+}
+
+/*
+ * Events. A successful receive tells the client to collect port and flow
+ * events with ofdpaPortEventNextGet() and ofdpaFlowEventNextGet().
+ */
+OFDPA_ERROR_t ofdpaEventReceive(struct timeval *timeout)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  if (!ofdpa_sim_wait(event_fds[0], timeout))
+  {
+    return OFDPA_E_TIMEOUT;
+  }
+
+  OFDPA_SIM_LOCK();
+  ofdpa_sim_pipe_drain(event_fds);
+  event_pending = 0;
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+/*
+ * Packets
+ */
+OFDPA_ERROR_t ofdpaMaxPktSizeGet(uint32_t *pktSize)
+{
+  OFDPA_SIM_CALL(PKT);
+
+  if (pktSize == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *pktSize = OFDPA_SIM_MAX_PKT_SIZE;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPktReceive(struct timeval *timeout, ofdpaPacket_t *pkt)
+{
+  ofdpa_sim_pkt_t *queued;
+
+  OFDPA_SIM_CALL(PKT);
+
+  if ((pkt == NULL) || (pkt->pktData.pstart == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  for (;;)
+  {
+    OFDPA_SIM_LOCK();
+    if (pkt_head != pkt_tail)
+    {
+      break;
+    }
+    OFDPA_SIM_UNLOCK();
+
+    if (!ofdpa_sim_wait(pkt_fds[0], timeout))
+    {
+      return OFDPA_E_TIMEOUT;
+    }
+  }
+
+  queued = &pkt_queue[pkt_head & (OFDPA_SIM_PKT_QUEUE_SIZE - 1)];
+  if (queued->size > pkt->pktData.size)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_PARAM;
+  }
+
+  memcpy(pkt->pktData.pstart, queued->data, queued->size);
+  pkt->pktData.size = queued->size;
+  pkt->inPortNum = queued->inPortNum;
+  pkt->reason = queued->reason;
+  pkt->tableId = queued->tableId;
+  free(queued->data);
+  queued->data = NULL;
+
+  if (++pkt_head == pkt_tail)
+  {
+    ofdpa_sim_pipe_drain(pkt_fds);
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPktSend(ofdpa_buffdesc *pkt, uint32_t flags, uint32_t outPortNum, uint32_t inPortNum)
+{
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(PKT);
+
+  if ((pkt == NULL) || (pkt->pstart == NULL) || (pkt->size > OFDPA_SIM_MAX_PKT_SIZE))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  ofdpa_sim_stats.pkts_out++;
+  if (flags & OFDPA_PKT_LOOKUP)
+  {
+    /* Sent through the pipeline as if received on inPortNum */
+    ofdpa_sim_port_count_locked(inPortNum, 1, pkt->size);
+  }
+  else if (!ofdpa_sim_port_exists_locked(outPortNum))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else
+  {
+    ofdpa_sim_port_count_locked(outPortNum, 0, pkt->size);
+    if (pkt_loopback)
+    {
+      ofdpa_sim_pkt_queue_locked(outPortNum, OFDPA_PACKET_IN_REASON_NO_MATCH,
+                                 OFDPA_FLOW_TABLE_ID_ACL_POLICY, pkt->pstart, pkt->size);
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+/*
+ * Debug and configuration calls that only keep state
+ */
+OFDPA_ERROR_t ofdpaDebugLvl(int lvl)
+{
+  OFDPA_SIM_CALL(OTHER);
+  debug_level = lvl;
+  return OFDPA_E_NONE;
+}
+
+int ofdpaDebugLvlGet(void)
+{
+  OFDPA_SIM_CALL(OTHER);
+  return debug_level;
+}
+
+OFDPA_ERROR_t ofdpaDebugComponentSet(int component, int enable)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  if ((component < OFDPA_COMPONENT_FIRST) || (component >= OFDPA_COMPONENT_MAX) ||
+      (component >= (int)sizeof(debug_components)))
+  {
+    return OFDPA_E_PARAM;
+  }
+  debug_components[component] = (enable != 0);
+  return OFDPA_E_NONE;
+}
+
+int ofdpaDebugComponentGet(int component)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  if ((component < 0) || (component >= (int)sizeof(debug_components)))
+  {
+    return 0;
+  }
+  return debug_components[component];
+}
+
+OFDPA_ERROR_t ofdpaComponentNameGet(int component, ofdpa_buffdesc *name)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  if ((component < OFDPA_COMPONENT_FIRST) || (component >= OFDPA_COMPONENT_MAX) ||
+      (name == NULL) || (name->pstart == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+  snprintf(name->pstart, name->size, "component-%d", component);
+  return OFDPA_E_NONE;
+}
+
+const char *ofdpaDebugComponentNameGet(int component)
+{
+  static char names[64][16];
+
+  if ((component < 0) || (component >= (int)(sizeof(names)/sizeof(names[0]))))
+  {
+    return NULL;
+  }
+  snprintf(names[component], sizeof(names[component]), "component-%d", component);
+  return names[component];
+}
+
+OFDPA_ERROR_t ofdpaDebugComponentEnable(int component)
+{
+  return ofdpaDebugComponentSet(component, 1);
+}
+
+OFDPA_ERROR_t ofdpaDebugVerbositySet(int dbgLevel)
+{
+  OFDPA_SIM_CALL(OTHER);
+  debug_verbosity = dbgLevel;
+  return OFDPA_E_NONE;
+}
+
+int ofdpaDebugVerbosityGet(void)
+{
+  OFDPA_SIM_CALL(OTHER);
+  return debug_verbosity;
+}
+
+OFDPA_ERROR_t ofdpaBcmCommand(ofdpa_buffdesc buffer)
+{
+  (void)buffer;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_UNAVAIL;
+}
+
+OFDPA_ERROR_t ofdpaSourceMacLearningSet(OFDPA_CONTROL_t mode, ofdpaSrcMacLearnModeCfg_t *srcMacLearnModeCfg)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  OFDPA_SIM_LOCK();
+  src_mac_learn_mode = mode;
+  if (srcMacLearnModeCfg != NULL)
+  {
+    src_mac_learn_cfg = *srcMacLearnModeCfg;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaSourceMacLearningGet(OFDPA_CONTROL_t *mode, ofdpaSrcMacLearnModeCfg_t *srcMacLearnModeCfg)
+{
+  OFDPA_SIM_CALL(OTHER);
+
+  if (mode == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  *mode = src_mac_learn_mode;
+  if (srcMacLearnModeCfg != NULL)
+  {
+    *srcMacLearnModeCfg = src_mac_learn_cfg;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
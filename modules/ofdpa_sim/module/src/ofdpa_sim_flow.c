@@ -0,0 +1,718 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_flow.c
+*
+* @purpose      Simulated OF-DPA flow tables
+*
+* @component    OF-DPA
+*
+* @comments     A flow is identified by its table, priority and match
+*               criteria. Each table keeps its flows in an array sorted on
+*               that key, so ofdpaFlowNextGet() continues from the key it
+*               is given even if that flow was deleted in the meantime.
+*               Cookies are indexed by a hash for the by-cookie calls.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "ofdpa_sim_int.h"
+
+#define OFDPA_SIM_COOKIE_HASH_SIZE   65536     /* power of 2 */
+#define OFDPA_SIM_FLOW_EVENTS_MAX    4096
+
+typedef struct ofdpa_sim_flow_s
+{
+  ofdpaFlowEntry_t          entry;
+  uint64_t                  install_ms;
+  uint64_t                  hit_ms;
+  uint64_t                  packets;
+  uint64_t                  bytes;
+  struct ofdpa_sim_flow_s  *cookie_next;
+} ofdpa_sim_flow_t;
+
+typedef struct
+{
+  OFDPA_FLOW_TABLE_ID_t  tableId;
+  uint32_t               match_offset;
+  uint32_t               match_size;
+  uint32_t               group_offset;    /* 0 if the table's flows use no group */
+  uint32_t               max_entries;
+  uint32_t               num_entries;
+  uint32_t               alloc;
+  ofdpa_sim_flow_t     **flows;           /* sorted on priority, then match */
+} ofdpa_sim_table_t;
+
+typedef struct ofdpa_sim_flow_event_s
+{
+  ofdpaFlowEvent_t                event;
+  struct ofdpa_sim_flow_event_s  *next;
+} ofdpa_sim_flow_event_t;
+
+#define OFDPA_SIM_FLOW_FIELD_OFFSET(_entry, _field) \
+  offsetof(ofdpaFlowEntry_t, flowData._entry._field)
+#define OFDPA_SIM_FLOW_MATCH_SIZE(_entry) \
+  sizeof(((ofdpaFlowEntry_t *)0)->flowData._entry.match_criteria)
+
+#define OFDPA_SIM_TABLE(_id, _entry, _max)                          \
+  { OFDPA_FLOW_TABLE_ID_##_id,                                      \
+    OFDPA_SIM_FLOW_FIELD_OFFSET(_entry, match_criteria),            \
+    OFDPA_SIM_FLOW_MATCH_SIZE(_entry), 0, _max, 0, 0, NULL }
+#define OFDPA_SIM_GROUP_TABLE(_id, _entry, _group, _max)            \
+  { OFDPA_FLOW_TABLE_ID_##_id,                                      \
+    OFDPA_SIM_FLOW_FIELD_OFFSET(_entry, match_criteria),            \
+    OFDPA_SIM_FLOW_MATCH_SIZE(_entry),                              \
+    OFDPA_SIM_FLOW_FIELD_OFFSET(_entry, _group), _max, 0, 0, NULL }
+
+/* Default capacities are those of a Trident2 based switch */
+static ofdpa_sim_table_t sim_tables[] =
+{
+  OFDPA_SIM_TABLE(INGRESS_PORT,               ingressPortFlowEntry,        64),
+  OFDPA_SIM_TABLE(PORT_DSCP_TRUST,            dscpTrustFlowEntry,          64),
+  OFDPA_SIM_TABLE(PORT_PCP_TRUST,             pcpTrustFlowEntry,           64),
+  OFDPA_SIM_TABLE(TUNNEL_DSCP_TRUST,          dscpTrustFlowEntry,          64),
+  OFDPA_SIM_TABLE(TUNNEL_PCP_TRUST,           pcpTrustFlowEntry,           64),
+  OFDPA_SIM_TABLE(VLAN,                       vlanFlowEntry,             8192),
+  OFDPA_SIM_TABLE(VLAN_1,                     vlan1FlowEntry,            4096),
+  OFDPA_SIM_TABLE(MAINTENANCE_POINT,          mpFlowEntry,               1024),
+  OFDPA_SIM_GROUP_TABLE(MPLS_L2_PORT,         mplsL2PortFlowEntry, groupId, 2048),
+  OFDPA_SIM_TABLE(MPLS_DSCP_TRUST,            dscpTrustFlowEntry,          64),
+  OFDPA_SIM_TABLE(MPLS_PCP_TRUST,             pcpTrustFlowEntry,           64),
+  OFDPA_SIM_TABLE(TERMINATION_MAC,            terminationMacFlowEntry,    512),
+  OFDPA_SIM_GROUP_TABLE(MPLS_0,               mplsFlowEntry, groupID,    4096),
+  OFDPA_SIM_GROUP_TABLE(MPLS_1,               mplsFlowEntry, groupID,    8192),
+  OFDPA_SIM_GROUP_TABLE(MPLS_2,               mplsFlowEntry, groupID,    8192),
+  OFDPA_SIM_TABLE(MPLS_MAINTENANCE_POINT,     mplsMpFlowEntry,           1024),
+  OFDPA_SIM_GROUP_TABLE(UNICAST_ROUTING,      unicastRoutingFlowEntry, groupID, 16384),
+  OFDPA_SIM_GROUP_TABLE(MULTICAST_ROUTING,    multicastRoutingFlowEntry, groupID, 4096),
+  OFDPA_SIM_GROUP_TABLE(BRIDGING,             bridgingFlowEntry, groupID, 32768),
+  OFDPA_SIM_GROUP_TABLE(ACL_POLICY,           policyAclFlowEntry, groupID, 2048),
+  OFDPA_SIM_TABLE(EGRESS_VLAN,                egressVlanFlowEntry,       4096),
+  OFDPA_SIM_TABLE(EGRESS_VLAN_1,              egressVlan1FlowEntry,      4096),
+  OFDPA_SIM_TABLE(EGRESS_MAINTENANCE_POINT,   egressMpFlowEntry,         1024),
+  OFDPA_SIM_TABLE(MPLS_QOS,                   mplsQosFlowEntry,           256),
+};
+
+static ofdpa_sim_flow_t *cookie_hash[OFDPA_SIM_COOKIE_HASH_SIZE];
+static uint32_t num_timed_flows;
+
+static ofdpa_sim_flow_event_t *flow_events_head;
+static ofdpa_sim_flow_event_t *flow_events_tail;
+static uint32_t num_flow_events;
+
+static ofdpa_sim_table_t *ofdpa_sim_table_get(OFDPA_FLOW_TABLE_ID_t tableId)
+{
+  uint32_t i;
+
+  for (i = 0; i < sizeof(sim_tables)/sizeof(sim_tables[0]); i++)
+  {
+    if (sim_tables[i].tableId == tableId)
+    {
+      return &sim_tables[i];
+    }
+  }
+  return NULL;
+}
+
+static uint32_t ofdpa_sim_flow_group(const ofdpa_sim_table_t *table, const ofdpaFlowEntry_t *flow)
+{
+  uint32_t groupId;
+
+  if (table->group_offset == 0)
+  {
+    return 0;
+  }
+  memcpy(&groupId, (const uint8_t *)flow + table->group_offset, sizeof(groupId));
+  return groupId;
+}
+
+static uint32_t ofdpa_sim_flow_meter(const ofdpa_sim_table_t *table, const ofdpaFlowEntry_t *flow)
+{
+  if ((table->tableId != OFDPA_FLOW_TABLE_ID_ACL_POLICY) ||
+      !flow->flowData.policyAclFlowEntry.meterIdAction)
+  {
+    return 0;
+  }
+  return flow->flowData.policyAclFlowEntry.meterId;
+}
+
+static int ofdpa_sim_flow_key_cmp(const ofdpa_sim_table_t *table,
+                                  const ofdpaFlowEntry_t *a, const ofdpaFlowEntry_t *b)
+{
+  if (a->priority != b->priority)
+  {
+    return (a->priority < b->priority) ? -1 : 1;
+  }
+  return memcmp((const uint8_t *)a + table->match_offset,
+                (const uint8_t *)b + table->match_offset, table->match_size);
+}
+
+/* Index of the first flow whose key is not below flow's. *found is set if
+   that flow has the same key. */
+static uint32_t ofdpa_sim_flow_search(const ofdpa_sim_table_t *table,
+                                      const ofdpaFlowEntry_t *flow, int *found)
+{
+  uint32_t lo = 0;
+  uint32_t hi = table->num_entries;
+  uint32_t mid;
+  int cmp;
+
+  *found = 0;
+  while (lo < hi)
+  {
+    mid = lo + ((hi - lo) / 2);
+    cmp = ofdpa_sim_flow_key_cmp(table, &table->flows[mid]->entry, flow);
+    if (cmp < 0)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      *found = (cmp == 0);
+      hi = mid;
+    }
+  }
+  *found = *found && (lo < table->num_entries) &&
+           (ofdpa_sim_flow_key_cmp(table, &table->flows[lo]->entry, flow) == 0);
+  return lo;
+}
+
+static ofdpa_sim_flow_t **ofdpa_sim_cookie_slot(uint64_t cookie)
+{
+  uint64_t h = cookie * 0x9e3779b97f4a7c15ULL;
+
+  return &cookie_hash[(h >> 32) & (OFDPA_SIM_COOKIE_HASH_SIZE - 1)];
+}
+
+static ofdpa_sim_flow_t *ofdpa_sim_cookie_find(uint64_t cookie)
+{
+  ofdpa_sim_flow_t *flow;
+
+  for (flow = *ofdpa_sim_cookie_slot(cookie); flow != NULL; flow = flow->cookie_next)
+  {
+    if (flow->entry.cookie == cookie)
+    {
+      return flow;
+    }
+  }
+  return NULL;
+}
+
+static void ofdpa_sim_cookie_remove(ofdpa_sim_flow_t *flow)
+{
+  ofdpa_sim_flow_t **link = ofdpa_sim_cookie_slot(flow->entry.cookie);
+
+  while (*link != flow)
+  {
+    link = &(*link)->cookie_next;
+  }
+  *link = flow->cookie_next;
+}
+
+static void ofdpa_sim_cookie_insert(ofdpa_sim_flow_t *flow)
+{
+  ofdpa_sim_flow_t **slot = ofdpa_sim_cookie_slot(flow->entry.cookie);
+
+  flow->cookie_next = *slot;
+  *slot = flow;
+}
+
+static int ofdpa_sim_flow_timed(const ofdpaFlowEntry_t *entry)
+{
+  return (entry->hard_time != 0) || (entry->idle_time != 0);
+}
+
+static void ofdpa_sim_flow_remove_locked(ofdpa_sim_table_t *table, uint32_t index)
+{
+  ofdpa_sim_flow_t *flow = table->flows[index];
+
+  memmove(&table->flows[index], &table->flows[index + 1],
+          (table->num_entries - index - 1) * sizeof(table->flows[0]));
+  table->num_entries--;
+
+  ofdpa_sim_cookie_remove(flow);
+  ofdpa_sim_group_ref_locked(ofdpa_sim_flow_group(table, &flow->entry), -1);
+  ofdpa_sim_meter_ref_locked(ofdpa_sim_flow_meter(table, &flow->entry), -1);
+  num_timed_flows -= ofdpa_sim_flow_timed(&flow->entry);
+  ofdpa_sim_stats.flows--;
+  free(flow);
+}
+
+static void ofdpa_sim_flow_stats_fill(const ofdpa_sim_flow_t *flow, ofdpaFlowEntryStats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->durationSec = (ofdpa_sim_now_ms() - flow->install_ms) / 1000;
+  stats->receivedPackets = flow->packets;
+  stats->receivedBytes = flow->bytes;
+}
+
+OFDPA_ERROR_t ofdpa_sim_flow_table_max_set_locked(OFDPA_FLOW_TABLE_ID_t tableId,
+                                                  uint32_t maxEntries)
+{
+  ofdpa_sim_table_t *table = ofdpa_sim_table_get(tableId);
+
+  if (table == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  table->max_entries = maxEntries;
+  return OFDPA_E_NONE;
+}
+
+/* Remove the flows whose hard or idle timeout has run out and queue an
+   event for each */
+void ofdpa_sim_flow_expire_locked(uint64_t now_ms)
+{
+  ofdpa_sim_flow_event_t *event;
+  ofdpa_sim_table_t *table;
+  ofdpa_sim_flow_t *flow;
+  OFDPA_FLOW_EVENT_MASK_t mask;
+  uint32_t t, i;
+
+  if (num_timed_flows == 0)
+  {
+    return;
+  }
+
+  for (t = 0; t < sizeof(sim_tables)/sizeof(sim_tables[0]); t++)
+  {
+    table = &sim_tables[t];
+    i = table->num_entries;
+    while (i > 0)
+    {
+      flow = table->flows[--i];
+      if ((flow->entry.hard_time != 0) &&
+          (now_ms - flow->install_ms >= (uint64_t)flow->entry.hard_time * 1000))
+      {
+        mask = OFDPA_FLOW_EVENT_HARD_TIMEOUT;
+      }
+      else if ((flow->entry.idle_time != 0) &&
+               (now_ms - flow->hit_ms >= (uint64_t)flow->entry.idle_time * 1000))
+      {
+        mask = OFDPA_FLOW_EVENT_IDLE_TIMEOUT;
+      }
+      else
+      {
+        continue;
+      }
+
+      if ((num_flow_events < OFDPA_SIM_FLOW_EVENTS_MAX) &&
+          ((event = calloc(1, sizeof(*event))) != NULL))
+      {
+        event->event.eventMask = mask;
+        event->event.flowMatch = flow->entry;
+        if (flow_events_tail != NULL)
+        {
+          flow_events_tail->next = event;
+        }
+        else
+        {
+          flow_events_head = event;
+        }
+        flow_events_tail = event;
+        num_flow_events++;
+        ofdpa_sim_stats.flow_events++;
+        ofdpa_sim_event_signal_locked();
+      }
+      ofdpa_sim_flow_remove_locked(table, i);
+    }
+  }
+}
+
+OFDPA_ERROR_t ofdpa_sim_flow_hit(uint64_t cookie, uint64_t packets, uint64_t bytes)
+{
+  ofdpa_sim_flow_t *flow;
+  OFDPA_ERROR_t rc = OFDPA_E_NOT_FOUND;
+
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  flow = ofdpa_sim_cookie_find(cookie);
+  if (flow != NULL)
+  {
+    flow->packets += packets;
+    flow->bytes += bytes;
+    flow->hit_ms = ofdpa_sim_now_ms();
+    rc = OFDPA_E_NONE;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+/*
+ * OF-DPA flow calls
+ */
+OFDPA_ERROR_t ofdpaFlowEntryInit(OFDPA_FLOW_TABLE_ID_t tableId, ofdpaFlowEntry_t *flow)
+{
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || (ofdpa_sim_table_get(tableId) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+  memset(flow, 0, sizeof(*flow));
+  flow->tableId = tableId;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaFlowTableSupported(OFDPA_FLOW_TABLE_ID_t tableId)
+{
+  OFDPA_SIM_CALL(FLOW);
+  return (ofdpa_sim_table_get(tableId) != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaFlowTableInfoGet(OFDPA_FLOW_TABLE_ID_t tableId, ofdpaFlowTableInfo_t *info)
+{
+  ofdpa_sim_table_t *table;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  table = ofdpa_sim_table_get(tableId);
+  if ((table == NULL) || (info == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  memset(info, 0, sizeof(*info));
+  OFDPA_SIM_LOCK();
+  info->numEntries = table->num_entries;
+  info->maxEntries = table->max_entries;
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaFlowAdd(ofdpaFlowEntry_t *flow)
+{
+  ofdpa_sim_table_t *table;
+  ofdpa_sim_flow_t *entry;
+  ofdpa_sim_flow_t **grown;
+  uint32_t groupId;
+  uint32_t meterId;
+  uint32_t index;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || ((table = ofdpa_sim_table_get(flow->tableId)) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+
+  index = ofdpa_sim_flow_search(table, flow, &found);
+  groupId = ofdpa_sim_flow_group(table, flow);
+  meterId = ofdpa_sim_flow_meter(table, flow);
+  if (found || (ofdpa_sim_cookie_find(flow->cookie) != NULL))
+  {
+    rc = OFDPA_E_EXISTS;
+  }
+  else if (table->num_entries >= table->max_entries)
+  {
+    rc = OFDPA_E_FULL;
+  }
+  else if ((groupId != 0) && !ofdpa_sim_group_exists_locked(groupId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if ((meterId != 0) && !ofdpa_sim_meter_exists_locked(meterId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if (table->num_entries == table->alloc)
+  {
+    uint32_t alloc = (table->alloc == 0) ? 256 : (table->alloc * 2);
+
+    grown = realloc(table->flows, alloc * sizeof(*grown));
+    if (grown == NULL)
+    {
+      rc = OFDPA_E_FAIL;
+    }
+    else
+    {
+      table->flows = grown;
+      table->alloc = alloc;
+    }
+  }
+
+  if ((rc == OFDPA_E_NONE) && ((entry = calloc(1, sizeof(*entry))) == NULL))
+  {
+    rc = OFDPA_E_FAIL;
+  }
+
+  if (rc == OFDPA_E_NONE)
+  {
+    entry->entry = *flow;
+    entry->install_ms = ofdpa_sim_now_ms();
+    entry->hit_ms = entry->install_ms;
+
+    memmove(&table->flows[index + 1], &table->flows[index],
+            (table->num_entries - index) * sizeof(table->flows[0]));
+    table->flows[index] = entry;
+    table->num_entries++;
+
+    ofdpa_sim_cookie_insert(entry);
+    ofdpa_sim_group_ref_locked(groupId, 1);
+    ofdpa_sim_meter_ref_locked(meterId, 1);
+    num_timed_flows += ofdpa_sim_flow_timed(flow);
+    ofdpa_sim_stats.flows++;
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaFlowModify(ofdpaFlowEntry_t *flow)
+{
+  ofdpa_sim_table_t *table;
+  ofdpa_sim_flow_t *entry;
+  uint32_t oldGroupId, newGroupId;
+  uint32_t oldMeterId, newMeterId;
+  uint32_t index;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || ((table = ofdpa_sim_table_get(flow->tableId)) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+
+  index = ofdpa_sim_flow_search(table, flow, &found);
+  if (!found)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_NOT_FOUND;
+  }
+
+  entry = table->flows[index];
+  oldGroupId = ofdpa_sim_flow_group(table, &entry->entry);
+  newGroupId = ofdpa_sim_flow_group(table, flow);
+  oldMeterId = ofdpa_sim_flow_meter(table, &entry->entry);
+  newMeterId = ofdpa_sim_flow_meter(table, flow);
+  if ((newGroupId != 0) && !ofdpa_sim_group_exists_locked(newGroupId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if ((newMeterId != 0) && !ofdpa_sim_meter_exists_locked(newMeterId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if ((flow->cookie != entry->entry.cookie) && (ofdpa_sim_cookie_find(flow->cookie) != NULL))
+  {
+    rc = OFDPA_E_EXISTS;
+  }
+  else
+  {
+    ofdpa_sim_cookie_remove(entry);
+    num_timed_flows -= ofdpa_sim_flow_timed(&entry->entry);
+    entry->entry = *flow;
+    num_timed_flows += ofdpa_sim_flow_timed(&entry->entry);
+    ofdpa_sim_cookie_insert(entry);
+
+    ofdpa_sim_group_ref_locked(newGroupId, 1);
+    ofdpa_sim_group_ref_locked(oldGroupId, -1);
+    ofdpa_sim_meter_ref_locked(newMeterId, 1);
+    ofdpa_sim_meter_ref_locked(oldMeterId, -1);
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaFlowDelete(ofdpaFlowEntry_t *flow)
+{
+  ofdpa_sim_table_t *table;
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || ((table = ofdpa_sim_table_get(flow->tableId)) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_flow_search(table, flow, &found);
+  if (found)
+  {
+    ofdpa_sim_flow_remove_locked(table, index);
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+/* The flow after the given one in the same table. The given flow need not
+   exist; a zeroed match starts the walk. */
+OFDPA_ERROR_t ofdpaFlowNextGet(ofdpaFlowEntry_t *flow, ofdpaFlowEntry_t *nextFlow)
+{
+  ofdpa_sim_table_t *table;
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || (nextFlow == NULL) ||
+      ((table = ofdpa_sim_table_get(flow->tableId)) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_flow_search(table, flow, &found);
+  /* Keys are unique, so the cookie only breaks the tie with a zeroed
+     starting entry whose key equals that of a real flow */
+  if (found && (table->flows[index]->entry.cookie <= flow->cookie))
+  {
+    index++;
+  }
+  if (index >= table->num_entries)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_NOT_FOUND;
+  }
+  *nextFlow = table->flows[index]->entry;
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaFlowStatsGet(ofdpaFlowEntry_t *flow, ofdpaFlowEntryStats_t *flowStats)
+{
+  ofdpa_sim_table_t *table;
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if ((flow == NULL) || (flowStats == NULL) ||
+      ((table = ofdpa_sim_table_get(flow->tableId)) == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_flow_search(table, flow, &found);
+  if (found)
+  {
+    ofdpa_sim_flow_stats_fill(table->flows[index], flowStats);
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaFlowByCookieGet(uint64_t cookie, ofdpaFlowEntry_t *flow, ofdpaFlowEntryStats_t *flowStats)
+{
+  ofdpa_sim_flow_t *entry;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  OFDPA_SIM_LOCK();
+  entry = ofdpa_sim_cookie_find(cookie);
+  if (entry != NULL)
+  {
+    if (flow != NULL)
+    {
+      *flow = entry->entry;
+    }
+    if (flowStats != NULL)
+    {
+      ofdpa_sim_flow_stats_fill(entry, flowStats);
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (entry != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaFlowByCookieDelete(uint64_t cookie)
+{
+  ofdpa_sim_table_t *table;
+  ofdpa_sim_flow_t *entry;
+  uint32_t index;
+  int found = 0;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  OFDPA_SIM_LOCK();
+  entry = ofdpa_sim_cookie_find(cookie);
+  if (entry != NULL)
+  {
+    table = ofdpa_sim_table_get(entry->entry.tableId);
+    index = ofdpa_sim_flow_search(table, &entry->entry, &found);
+    if (found)
+    {
+      ofdpa_sim_flow_remove_locked(table, index);
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+/* Expired flows, oldest first. They are already gone from their tables. */
+OFDPA_ERROR_t ofdpaFlowEventNextGet(ofdpaFlowEvent_t *eventData)
+{
+  ofdpa_sim_flow_event_t *event;
+
+  OFDPA_SIM_CALL(FLOW);
+
+  if (eventData == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  event = flow_events_head;
+  if (event != NULL)
+  {
+    flow_events_head = event->next;
+    if (flow_events_head == NULL)
+    {
+      flow_events_tail = NULL;
+    }
+    num_flow_events--;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  if (event == NULL)
+  {
+    return OFDPA_E_NOT_FOUND;
+  }
+  *eventData = event->event;
+  free(event);
+
+  return OFDPA_E_NONE;
+}
@@ -0,0 +1,846 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_group.c
+*
+* @purpose      Simulated OF-DPA group table and group ID encoding
+*
+* @component    OF-DPA
+*
+* @comments     Groups are kept in an array sorted on group ID, each with
+*               its buckets sorted on bucket index. A group is referenced
+*               by the flows that point at it and by the buckets of other
+*               groups, and cannot be deleted while referenced.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ofdpa_sim_int.h"
+
+#define OFDPA_SIM_GROUP_TYPE_SHIFT      28
+#define OFDPA_SIM_GROUP_TYPE_MASK       0xf
+#define OFDPA_SIM_GROUP_VLAN_SHIFT      16
+#define OFDPA_SIM_GROUP_VLAN_MASK       0xfff
+#define OFDPA_SIM_GROUP_PORT_MASK       0xffff
+#define OFDPA_SIM_GROUP_INDEX_SHORT_MASK 0xffff
+#define OFDPA_SIM_GROUP_INDEX_MASK      0x0fffffff
+#define OFDPA_SIM_GROUP_MPLS_SUBTYPE_SHIFT 24
+#define OFDPA_SIM_GROUP_MPLS_SUBTYPE_MASK 0xf
+#define OFDPA_SIM_GROUP_MPLS_INDEX_MASK 0x00ffffff
+
+#define OFDPA_SIM_GROUP_BUCKETS_MAX     1024
+
+typedef struct
+{
+  uint32_t                  groupId;
+  uint32_t                  refCount;
+  uint64_t                  install_ms;
+  uint32_t                  num_buckets;
+  uint32_t                  alloc;
+  ofdpaGroupBucketEntry_t  *buckets;       /* sorted on bucketIndex */
+} ofdpa_sim_group_t;
+
+static ofdpa_sim_group_t **sim_groups;     /* sorted on groupId */
+static uint32_t num_groups;
+static uint32_t alloc_groups;
+static int sim_bucket_modify_off;          /* refuse ofdpaGroupBucketEntryModify() */
+
+/* Capacity of each group type */
+static const uint32_t sim_group_type_max[16] =
+{
+  [OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE]            = 4096 * 8,
+  [OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE]              = 8192,
+  [OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST]              = 16384,
+  [OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST]            = 4096,
+  [OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD]                = 4096,
+  [OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE]            = 8192,
+  [OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST]            = 4096,
+  [OFDPA_GROUP_ENTRY_TYPE_L3_ECMP]                 = 1024,
+  [OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY]              = 4096,
+  [OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL]              = 16384,
+  [OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING]         = 4096,
+  [OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE] = 4096,
+};
+static uint32_t sim_group_type_count[16];
+
+static uint32_t ofdpa_sim_group_type(uint32_t groupId)
+{
+  return (groupId >> OFDPA_SIM_GROUP_TYPE_SHIFT) & OFDPA_SIM_GROUP_TYPE_MASK;
+}
+
+/* Groups holding one bucket that points at the next group in a chain, or
+   at a port */
+static int ofdpa_sim_group_type_single(uint32_t groupId)
+{
+  switch (ofdpa_sim_group_type(groupId))
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/* Buckets of these groups point at a port rather than another group */
+static int ofdpa_sim_group_type_leaf(uint32_t groupId)
+{
+  switch (ofdpa_sim_group_type(groupId))
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static uint32_t ofdpa_sim_group_search(uint32_t groupId, int *found)
+{
+  uint32_t lo = 0;
+  uint32_t hi = num_groups;
+  uint32_t mid;
+
+  while (lo < hi)
+  {
+    mid = lo + ((hi - lo) / 2);
+    if (sim_groups[mid]->groupId < groupId)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  *found = (lo < num_groups) && (sim_groups[lo]->groupId == groupId);
+  return lo;
+}
+
+static ofdpa_sim_group_t *ofdpa_sim_group_find(uint32_t groupId)
+{
+  uint32_t index;
+  int found;
+
+  index = ofdpa_sim_group_search(groupId, &found);
+  return found ? sim_groups[index] : NULL;
+}
+
+static uint32_t ofdpa_sim_bucket_search(const ofdpa_sim_group_t *group, uint32_t bucketIndex, int *found)
+{
+  uint32_t i;
+
+  for (i = 0; i < group->num_buckets; i++)
+  {
+    if (group->buckets[i].bucketIndex >= bucketIndex)
+    {
+      break;
+    }
+  }
+  *found = (i < group->num_buckets) && (group->buckets[i].bucketIndex == bucketIndex);
+  return i;
+}
+
+static uint32_t ofdpa_sim_bucket_ref(const ofdpaGroupBucketEntry_t *bucket)
+{
+  return ofdpa_sim_group_type_leaf(bucket->groupId) ? 0 : bucket->referenceGroupId;
+}
+
+int ofdpa_sim_group_exists_locked(uint32_t groupId)
+{
+  return ofdpa_sim_group_find(groupId) != NULL;
+}
+
+void ofdpa_sim_group_ref_locked(uint32_t groupId, int delta)
+{
+  ofdpa_sim_group_t *group;
+
+  if ((groupId != 0) && ((group = ofdpa_sim_group_find(groupId)) != NULL))
+  {
+    group->refCount += delta;
+  }
+}
+
+/*
+ * Group ID encoding
+ */
+OFDPA_ERROR_t ofdpaGroupTypeGet(uint32_t groupId, uint32_t *type)
+{
+  if (type == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *type = ofdpa_sim_group_type(groupId);
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupTypeSet(uint32_t *groupId, uint32_t type)
+{
+  if ((groupId == NULL) || (type >= OFDPA_GROUP_ENTRY_TYPE_LAST))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId &= ~(OFDPA_SIM_GROUP_TYPE_MASK << OFDPA_SIM_GROUP_TYPE_SHIFT);
+  *groupId |= type << OFDPA_SIM_GROUP_TYPE_SHIFT;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupVlanGet(uint32_t groupId, uint32_t *vlanId)
+{
+  if (vlanId == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *vlanId = (groupId >> OFDPA_SIM_GROUP_VLAN_SHIFT) & OFDPA_SIM_GROUP_VLAN_MASK;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupVlanSet(uint32_t *groupId, uint32_t vlanId)
+{
+  if ((groupId == NULL) || (vlanId > OFDPA_SIM_GROUP_VLAN_MASK))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId &= ~(OFDPA_SIM_GROUP_VLAN_MASK << OFDPA_SIM_GROUP_VLAN_SHIFT);
+  *groupId |= vlanId << OFDPA_SIM_GROUP_VLAN_SHIFT;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupPortIdGet(uint32_t groupId, uint32_t *portId)
+{
+  if (portId == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *portId = groupId & OFDPA_SIM_GROUP_PORT_MASK;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupPortIdSet(uint32_t *groupId, uint32_t portId)
+{
+  if ((groupId == NULL) || (portId > OFDPA_SIM_GROUP_PORT_MASK))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId = (*groupId & ~OFDPA_SIM_GROUP_PORT_MASK) | portId;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupIndexShortGet(uint32_t groupId, uint32_t *index)
+{
+  if (index == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *index = groupId & OFDPA_SIM_GROUP_INDEX_SHORT_MASK;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupIndexShortSet(uint32_t *groupId, uint32_t index)
+{
+  if ((groupId == NULL) || (index > OFDPA_SIM_GROUP_INDEX_SHORT_MASK))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId = (*groupId & ~OFDPA_SIM_GROUP_INDEX_SHORT_MASK) | index;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupIndexGet(uint32_t groupId, uint32_t *index)
+{
+  if (index == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *index = groupId & OFDPA_SIM_GROUP_INDEX_MASK;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupIndexSet(uint32_t *groupId, uint32_t index)
+{
+  if ((groupId == NULL) || (index > OFDPA_SIM_GROUP_INDEX_MASK))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId = (*groupId & ~OFDPA_SIM_GROUP_INDEX_MASK) | index;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupMplsSubTypeGet(uint32_t groupId, uint32_t *subType)
+{
+  if (subType == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *subType = (groupId >> OFDPA_SIM_GROUP_MPLS_SUBTYPE_SHIFT) & OFDPA_SIM_GROUP_MPLS_SUBTYPE_MASK;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupMplsSubTypeSet(uint32_t *groupId, uint32_t subType)
+{
+  if ((groupId == NULL) || (subType > OFDPA_SIM_GROUP_MPLS_SUBTYPE_MASK))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *groupId &= ~(OFDPA_SIM_GROUP_MPLS_SUBTYPE_MASK << OFDPA_SIM_GROUP_MPLS_SUBTYPE_SHIFT);
+  *groupId |= subType << OFDPA_SIM_GROUP_MPLS_SUBTYPE_SHIFT;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupDecode(uint32_t groupId, char *outBuf, int bufSize)
+{
+  static const char *type_names[16] =
+  {
+    [OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE]            = "L2 Interface",
+    [OFDPA_GROUP_ENTRY_TYPE_L2_REWRITE]              = "L2 Rewrite",
+    [OFDPA_GROUP_ENTRY_TYPE_L3_UNICAST]              = "L3 Unicast",
+    [OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST]            = "L2 Multicast",
+    [OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD]                = "L2 Flood",
+    [OFDPA_GROUP_ENTRY_TYPE_L3_INTERFACE]            = "L3 Interface",
+    [OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST]            = "L3 Multicast",
+    [OFDPA_GROUP_ENTRY_TYPE_L3_ECMP]                 = "L3 ECMP",
+    [OFDPA_GROUP_ENTRY_TYPE_L2_OVERLAY]              = "L2 Overlay",
+    [OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL]              = "MPLS Label",
+    [OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING]         = "MPLS Forwarding",
+    [OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE] = "L2 Unfiltered Interface",
+  };
+  uint32_t type = ofdpa_sim_group_type(groupId);
+  const char *name = (type_names[type] != NULL) ? type_names[type] : "Unknown";
+
+  if ((outBuf == NULL) || (bufSize <= 0))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  switch (type)
+  {
+    case OFDPA_GROUP_ENTRY_TYPE_L2_INTERFACE:
+      snprintf(outBuf, bufSize, "%s: VLAN ID = %u, Port ID = %u", name,
+               (groupId >> OFDPA_SIM_GROUP_VLAN_SHIFT) & OFDPA_SIM_GROUP_VLAN_MASK,
+               groupId & OFDPA_SIM_GROUP_PORT_MASK);
+      break;
+    case OFDPA_GROUP_ENTRY_TYPE_L2_UNFILTERED_INTERFACE:
+      snprintf(outBuf, bufSize, "%s: Port ID = %u", name, groupId & OFDPA_SIM_GROUP_PORT_MASK);
+      break;
+    case OFDPA_GROUP_ENTRY_TYPE_L2_MULTICAST:
+    case OFDPA_GROUP_ENTRY_TYPE_L2_FLOOD:
+    case OFDPA_GROUP_ENTRY_TYPE_L3_MULTICAST:
+      snprintf(outBuf, bufSize, "%s: VLAN ID = %u, Index = %u", name,
+               (groupId >> OFDPA_SIM_GROUP_VLAN_SHIFT) & OFDPA_SIM_GROUP_VLAN_MASK,
+               groupId & OFDPA_SIM_GROUP_INDEX_SHORT_MASK);
+      break;
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_LABEL:
+    case OFDPA_GROUP_ENTRY_TYPE_MPLS_FORWARDING:
+      snprintf(outBuf, bufSize, "%s: Subtype = %u, Index = %u", name,
+               (groupId >> OFDPA_SIM_GROUP_MPLS_SUBTYPE_SHIFT) & OFDPA_SIM_GROUP_MPLS_SUBTYPE_MASK,
+               groupId & OFDPA_SIM_GROUP_MPLS_INDEX_MASK);
+      break;
+    default:
+      snprintf(outBuf, bufSize, "%s: Index = %u", name, groupId & OFDPA_SIM_GROUP_INDEX_MASK);
+      break;
+  }
+  return OFDPA_E_NONE;
+}
+
+/*
+ * Groups
+ */
+OFDPA_ERROR_t ofdpaGroupEntryInit(OFDPA_GROUP_ENTRY_TYPE_t groupType, ofdpaGroupEntry_t *group)
+{
+  OFDPA_SIM_CALL(GROUP);
+
+  if ((group == NULL) || (groupType >= OFDPA_GROUP_ENTRY_TYPE_LAST))
+  {
+    return OFDPA_E_PARAM;
+  }
+  memset(group, 0, sizeof(*group));
+  return ofdpaGroupTypeSet(&group->groupId, groupType);
+}
+
+OFDPA_ERROR_t ofdpaGroupAdd(ofdpaGroupEntry_t *group)
+{
+  ofdpa_sim_group_t *entry;
+  ofdpa_sim_group_t **grown;
+  uint32_t index, type;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (group == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  type = ofdpa_sim_group_type(group->groupId);
+  if (type >= OFDPA_GROUP_ENTRY_TYPE_LAST)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+
+  index = ofdpa_sim_group_search(group->groupId, &found);
+  if (found)
+  {
+    rc = OFDPA_E_EXISTS;
+  }
+  else if (sim_group_type_count[type] >= sim_group_type_max[type])
+  {
+    rc = OFDPA_E_FULL;
+  }
+  else if (num_groups == alloc_groups)
+  {
+    uint32_t alloc = (alloc_groups == 0) ? 256 : (alloc_groups * 2);
+
+    grown = realloc(sim_groups, alloc * sizeof(*grown));
+    if (grown == NULL)
+    {
+      rc = OFDPA_E_FAIL;
+    }
+    else
+    {
+      sim_groups = grown;
+      alloc_groups = alloc;
+    }
+  }
+
+  if ((rc == OFDPA_E_NONE) && ((entry = calloc(1, sizeof(*entry))) == NULL))
+  {
+    rc = OFDPA_E_FAIL;
+  }
+
+  if (rc == OFDPA_E_NONE)
+  {
+    entry->groupId = group->groupId;
+    entry->install_ms = ofdpa_sim_now_ms();
+
+    memmove(&sim_groups[index + 1], &sim_groups[index], (num_groups - index) * sizeof(sim_groups[0]));
+    sim_groups[index] = entry;
+    num_groups++;
+    sim_group_type_count[type]++;
+    ofdpa_sim_stats.groups++;
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaGroupDelete(uint32_t groupId)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t index, i;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  OFDPA_SIM_LOCK();
+
+  index = ofdpa_sim_group_search(groupId, &found);
+  if (!found)
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if (sim_groups[index]->refCount != 0)
+  {
+    rc = OFDPA_E_FAIL;
+  }
+  else
+  {
+    group = sim_groups[index];
+    memmove(&sim_groups[index], &sim_groups[index + 1], (num_groups - index - 1) * sizeof(sim_groups[0]));
+    num_groups--;
+    sim_group_type_count[ofdpa_sim_group_type(groupId)]--;
+
+    for (i = 0; i < group->num_buckets; i++)
+    {
+      ofdpa_sim_group_ref_locked(ofdpa_sim_bucket_ref(&group->buckets[i]), -1);
+    }
+    ofdpa_sim_stats.buckets -= group->num_buckets;
+    ofdpa_sim_stats.groups--;
+    free(group->buckets);
+    free(group);
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaGroupNextGet(uint32_t groupId, ofdpaGroupEntry_t *nextGroup)
+{
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (nextGroup == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_group_search(groupId, &found);
+  index += found;
+  if (index < num_groups)
+  {
+    memset(nextGroup, 0, sizeof(*nextGroup));
+    nextGroup->groupId = sim_groups[index]->groupId;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (index < num_groups) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaGroupTypeNextGet(uint32_t groupId, OFDPA_GROUP_ENTRY_TYPE_t groupType,
+                                    ofdpaGroupEntry_t *nextGroup)
+{
+  OFDPA_ERROR_t rc;
+
+  while ((rc = ofdpaGroupNextGet(groupId, nextGroup)) == OFDPA_E_NONE)
+  {
+    if (ofdpa_sim_group_type(nextGroup->groupId) == (uint32_t)groupType)
+    {
+      break;
+    }
+    groupId = nextGroup->groupId;
+  }
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaGroupStatsGet(uint32_t groupId, ofdpaGroupEntryStats_t *groupStats)
+{
+  ofdpa_sim_group_t *group;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (groupStats == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  group = ofdpa_sim_group_find(groupId);
+  if (group != NULL)
+  {
+    memset(groupStats, 0, sizeof(*groupStats));
+    groupStats->refCount = group->refCount;
+    groupStats->duration = (ofdpa_sim_now_ms() - group->install_ms) / 1000;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (group != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+/*
+ * Buckets
+ */
+OFDPA_ERROR_t ofdpaGroupBucketEntryInit(OFDPA_GROUP_ENTRY_TYPE_t groupType, ofdpaGroupBucketEntry_t *bucket)
+{
+  OFDPA_SIM_CALL(GROUP);
+
+  if ((bucket == NULL) || (groupType >= OFDPA_GROUP_ENTRY_TYPE_LAST))
+  {
+    return OFDPA_E_PARAM;
+  }
+  memset(bucket, 0, sizeof(*bucket));
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryAdd(ofdpaGroupBucketEntry_t *bucket)
+{
+  ofdpa_sim_group_t *group;
+  ofdpaGroupBucketEntry_t *grown;
+  uint32_t refId, index;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (bucket == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+
+  group = ofdpa_sim_group_find(bucket->groupId);
+  refId = ofdpa_sim_bucket_ref(bucket);
+  if (group == NULL)
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if ((ofdpa_sim_group_type_single(group->groupId) && (group->num_buckets != 0)) ||
+           (group->num_buckets >= OFDPA_SIM_GROUP_BUCKETS_MAX))
+  {
+    rc = OFDPA_E_FULL;
+  }
+  else if ((refId != 0) && !ofdpa_sim_group_exists_locked(refId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else
+  {
+    index = ofdpa_sim_bucket_search(group, bucket->bucketIndex, &found);
+    if (found)
+    {
+      rc = OFDPA_E_EXISTS;
+    }
+    else if (group->num_buckets == group->alloc)
+    {
+      uint32_t alloc = (group->alloc == 0) ? 4 : (group->alloc * 2);
+
+      grown = realloc(group->buckets, alloc * sizeof(*grown));
+      if (grown == NULL)
+      {
+        rc = OFDPA_E_FAIL;
+      }
+      else
+      {
+        group->buckets = grown;
+        group->alloc = alloc;
+      }
+    }
+
+    if (rc == OFDPA_E_NONE)
+    {
+      memmove(&group->buckets[index + 1], &group->buckets[index],
+              (group->num_buckets - index) * sizeof(group->buckets[0]));
+      group->buckets[index] = *bucket;
+      group->num_buckets++;
+      ofdpa_sim_group_ref_locked(refId, 1);
+      ofdpa_sim_stats.buckets++;
+    }
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+void ofdpa_sim_bucket_modify_set(int enable)
+{
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  sim_bucket_modify_off = !enable;
+  OFDPA_SIM_UNLOCK();
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryModify(ofdpaGroupBucketEntry_t *bucket)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t oldRefId, newRefId, index;
+  int found = 0;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (bucket == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+
+  group = ofdpa_sim_group_find(bucket->groupId);
+  if (group != NULL)
+  {
+    index = ofdpa_sim_bucket_search(group, bucket->bucketIndex, &found);
+  }
+  newRefId = ofdpa_sim_bucket_ref(bucket);
+  if (!found)
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if (sim_bucket_modify_off)
+  {
+    rc = OFDPA_E_UNAVAIL;
+  }
+  else if ((newRefId != 0) && !ofdpa_sim_group_exists_locked(newRefId))
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else
+  {
+    oldRefId = ofdpa_sim_bucket_ref(&group->buckets[index]);
+    group->buckets[index] = *bucket;
+    ofdpa_sim_group_ref_locked(newRefId, 1);
+    ofdpa_sim_group_ref_locked(oldRefId, -1);
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryDelete(uint32_t groupId, uint32_t bucketIndex)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t index;
+  int found = 0;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  OFDPA_SIM_LOCK();
+
+  group = ofdpa_sim_group_find(groupId);
+  if (group != NULL)
+  {
+    index = ofdpa_sim_bucket_search(group, bucketIndex, &found);
+  }
+  if (found)
+  {
+    ofdpa_sim_group_ref_locked(ofdpa_sim_bucket_ref(&group->buckets[index]), -1);
+    memmove(&group->buckets[index], &group->buckets[index + 1],
+            (group->num_buckets - index - 1) * sizeof(group->buckets[0]));
+    group->num_buckets--;
+    ofdpa_sim_stats.buckets--;
+    if (group->num_buckets == 0)
+    {
+      ofdpa_sim_stats.groups_emptied++;
+    }
+  }
+
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketsDeleteAll(uint32_t groupId)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t i;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  OFDPA_SIM_LOCK();
+  group = ofdpa_sim_group_find(groupId);
+  if (group != NULL)
+  {
+    for (i = 0; i < group->num_buckets; i++)
+    {
+      ofdpa_sim_group_ref_locked(ofdpa_sim_bucket_ref(&group->buckets[i]), -1);
+    }
+    if (group->num_buckets != 0)
+    {
+      ofdpa_sim_stats.groups_emptied++;
+    }
+    ofdpa_sim_stats.buckets -= group->num_buckets;
+    group->num_buckets = 0;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (group != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryGet(uint32_t groupId, uint32_t bucketIndex,
+                                       ofdpaGroupBucketEntry_t *groupBucket)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t index;
+  int found = 0;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (groupBucket == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  group = ofdpa_sim_group_find(groupId);
+  if (group != NULL)
+  {
+    index = ofdpa_sim_bucket_search(group, bucketIndex, &found);
+    if (found)
+    {
+      *groupBucket = group->buckets[index];
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryFirstGet(uint32_t groupId, ofdpaGroupBucketEntry_t *firstGroupBucket)
+{
+  ofdpa_sim_group_t *group;
+  int found = 0;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (firstGroupBucket == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  group = ofdpa_sim_group_find(groupId);
+  if ((group != NULL) && (group->num_buckets != 0))
+  {
+    *firstGroupBucket = group->buckets[0];
+    found = 1;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaGroupBucketEntryNextGet(uint32_t groupId, uint32_t bucketIndex,
+                                           ofdpaGroupBucketEntry_t *nextBucketEntry)
+{
+  ofdpa_sim_group_t *group;
+  uint32_t index;
+  int found = 0;
+
+  OFDPA_SIM_CALL(GROUP);
+
+  if (nextBucketEntry == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  group = ofdpa_sim_group_find(groupId);
+  if (group != NULL)
+  {
+    index = ofdpa_sim_bucket_search(group, bucketIndex, &found);
+    index += found;
+    found = (index < group->num_buckets);
+    if (found)
+    {
+      *nextBucketEntry = group->buckets[index];
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
@@ -0,0 +1,79 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_int.h
+*
+* @purpose      Shared state of the simulated OF-DPA library
+*
+* @component    OF-DPA
+*
+* @comments     All tables are protected by ofdpa_sim_lock. Functions
+*               named _locked expect the caller to hold it.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#ifndef __OFDPA_SIM_INT_H__
+#define __OFDPA_SIM_INT_H__
+
+#include <pthread.h>
+#include <ofdpa_sim/ofdpa_sim.h>
+
+extern pthread_mutex_t ofdpa_sim_lock;
+extern ofdpa_sim_stats_t ofdpa_sim_stats;
+
+#define OFDPA_SIM_LOCK()    pthread_mutex_lock(&ofdpa_sim_lock)
+#define OFDPA_SIM_UNLOCK()  pthread_mutex_unlock(&ofdpa_sim_lock)
+
+/* Every OF-DPA entry point starts with this: it initializes the library
+   on first use, counts the call and waits out the configured latency.
+   The wait happens before the lock is taken, like an RPC round trip. */
+void ofdpa_sim_call(ofdpa_sim_call_t call);
+#define OFDPA_SIM_CALL(_call)  ofdpa_sim_call(OFDPA_SIM_CALL_##_call)
+
+/* Initialize on first use, for the control interface */
+void ofdpa_sim_init(void);
+
+/* Monotonic time */
+uint64_t ofdpa_sim_now_ms(void);
+
+/* Wake up a client waiting in ofdpaEventReceive() */
+void ofdpa_sim_event_signal_locked(void);
+
+/* Flow tables */
+OFDPA_ERROR_t ofdpa_sim_flow_table_max_set_locked(OFDPA_FLOW_TABLE_ID_t tableId,
+                                                  uint32_t maxEntries);
+void ofdpa_sim_flow_expire_locked(uint64_t now_ms);
+
+/* Group table; flows and buckets hold references on the groups they use */
+int ofdpa_sim_group_exists_locked(uint32_t groupId);
+void ofdpa_sim_group_ref_locked(uint32_t groupId, int delta);
+
+/* Meter table; ACL policy flows hold references on the meters they use */
+int ofdpa_sim_meter_exists_locked(uint32_t meterId);
+void ofdpa_sim_meter_ref_locked(uint32_t meterId, int delta);
+
+/* Ports */
+void ofdpa_sim_port_init(uint32_t numPorts, uint32_t pps);
+int ofdpa_sim_port_exists_locked(uint32_t portNum);
+void ofdpa_sim_port_count_locked(uint32_t portNum, int rx, uint32_t bytes);
+uint32_t ofdpa_sim_port_next_up_locked(uint32_t portNum);
+
+#endif /* __OFDPA_SIM_INT_H__ */
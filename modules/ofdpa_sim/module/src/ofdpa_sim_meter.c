@@ -0,0 +1,230 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_meter.c
+*
+* @purpose      Simulated OF-DPA meter table
+*
+* @component    OF-DPA
+*
+* @comments     Meters are kept in an array sorted on meter ID.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "ofdpa_sim_int.h"
+
+#define OFDPA_SIM_METERS_MAX   1024
+
+typedef struct
+{
+  ofdpaMeterEntry_t  entry;
+  uint64_t           install_ms;
+  uint32_t           refCount;
+} ofdpa_sim_meter_t;
+
+static ofdpa_sim_meter_t sim_meters[OFDPA_SIM_METERS_MAX];
+static uint32_t num_meters;
+
+static uint32_t ofdpa_sim_meter_search(uint32_t meterId, int *found)
+{
+  uint32_t lo = 0;
+  uint32_t hi = num_meters;
+  uint32_t mid;
+
+  while (lo < hi)
+  {
+    mid = lo + ((hi - lo) / 2);
+    if (sim_meters[mid].entry.meterId < meterId)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  *found = (lo < num_meters) && (sim_meters[lo].entry.meterId == meterId);
+  return lo;
+}
+
+int ofdpa_sim_meter_exists_locked(uint32_t meterId)
+{
+  int found;
+
+  (void)ofdpa_sim_meter_search(meterId, &found);
+  return found;
+}
+
+void ofdpa_sim_meter_ref_locked(uint32_t meterId, int delta)
+{
+  uint32_t index;
+  int found;
+
+  if (meterId == 0)
+  {
+    return;
+  }
+  index = ofdpa_sim_meter_search(meterId, &found);
+  if (found)
+  {
+    sim_meters[index].refCount += delta;
+  }
+}
+
+OFDPA_ERROR_t ofdpaMeterAdd(ofdpaMeterEntry_t *meter)
+{
+  uint32_t index;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(OTHER);
+
+  if ((meter == NULL) || (meter->meterId == 0))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_meter_search(meter->meterId, &found);
+  if (found)
+  {
+    rc = OFDPA_E_EXISTS;
+  }
+  else if (num_meters == OFDPA_SIM_METERS_MAX)
+  {
+    rc = OFDPA_E_FULL;
+  }
+  else
+  {
+    memmove(&sim_meters[index + 1], &sim_meters[index], (num_meters - index) * sizeof(sim_meters[0]));
+    sim_meters[index].entry = *meter;
+    sim_meters[index].install_ms = ofdpa_sim_now_ms();
+    sim_meters[index].refCount = 0;
+    num_meters++;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaMeterDelete(uint32_t meterId)
+{
+  uint32_t index;
+  int found;
+  OFDPA_ERROR_t rc = OFDPA_E_NONE;
+
+  OFDPA_SIM_CALL(OTHER);
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_meter_search(meterId, &found);
+  if (!found)
+  {
+    rc = OFDPA_E_NOT_FOUND;
+  }
+  else if (sim_meters[index].refCount != 0)
+  {
+    rc = OFDPA_E_FAIL;
+  }
+  else
+  {
+    memmove(&sim_meters[index], &sim_meters[index + 1], (num_meters - index - 1) * sizeof(sim_meters[0]));
+    num_meters--;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaMeterGet(uint32_t meterId, ofdpaMeterEntry_t *meter)
+{
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(OTHER);
+
+  if (meter == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_meter_search(meterId, &found);
+  if (found)
+  {
+    *meter = sim_meters[index].entry;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaMeterNextGet(uint32_t meterId, ofdpaMeterEntry_t *nextMeter)
+{
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(OTHER);
+
+  if (nextMeter == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_meter_search(meterId, &found);
+  index += found;
+  found = (index < num_meters);
+  if (found)
+  {
+    *nextMeter = sim_meters[index].entry;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaMeterStatsGet(uint32_t meterId, ofdpaMeterEntryStats_t *meterStats)
+{
+  uint32_t index;
+  int found;
+
+  OFDPA_SIM_CALL(OTHER);
+
+  if (meterStats == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  index = ofdpa_sim_meter_search(meterId, &found);
+  if (found)
+  {
+    memset(meterStats, 0, sizeof(*meterStats));
+    meterStats->refCount = sim_meters[index].refCount;
+    meterStats->duration = (ofdpa_sim_now_ms() - sim_meters[index].install_ms) / 1000;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return found ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
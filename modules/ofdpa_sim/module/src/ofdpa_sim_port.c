@@ -0,0 +1,700 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_port.c
+*
+* @purpose      Simulated OF-DPA ports, queues and port events
+*
+* @component    OF-DPA
+*
+* @comments     Every up port receives and transmits at the configured
+*               synthetic rate, on top of the packets actually sent and
+*               injected. Port events are kept as a pending mask per port
+*               and collected in port order.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "ofdpa_sim_int.h"
+
+#define OFDPA_SIM_PORTS_MAX         256
+#define OFDPA_SIM_QUEUES            8
+#define OFDPA_SIM_PORT_SPEED_KBPS   10000000
+#define OFDPA_SIM_SYNTH_BYTES       512       /* average synthetic frame size */
+
+/* OpenFlow port feature bits: 10 Gb full duplex, fiber */
+#define OFDPA_SIM_PORT_FEATURES     ((1 << 6) | (1 << 12))
+
+typedef struct
+{
+  int                  exists;
+  OFDPA_PORT_STATE_t   state;
+  OFDPA_PORT_CONFIG_t  config;
+  uint32_t             advertised;
+  uint32_t             pending_events;
+  uint64_t             create_ms;
+  uint64_t             clear_ms;            /* start of the synthetic counters */
+  uint64_t             rx_packets;          /* traffic actually sent and injected */
+  uint64_t             rx_bytes;
+  uint64_t             tx_packets;
+  uint64_t             tx_bytes;
+  uint64_t             queue_clear_ms[OFDPA_SIM_QUEUES];
+  uint32_t             queue_min_rate[OFDPA_SIM_QUEUES];
+  uint32_t             queue_max_rate[OFDPA_SIM_QUEUES];
+} ofdpa_sim_port_t;
+
+static ofdpa_sim_port_t sim_ports[OFDPA_SIM_PORTS_MAX + 1];
+static uint32_t sim_port_pps;
+
+static ofdpa_sim_port_t *ofdpa_sim_port_get(uint32_t portNum)
+{
+  if ((portNum == 0) || (portNum > OFDPA_SIM_PORTS_MAX) || !sim_ports[portNum].exists)
+  {
+    return NULL;
+  }
+  return &sim_ports[portNum];
+}
+
+static int ofdpa_sim_port_up(const ofdpa_sim_port_t *port)
+{
+  return !(port->state & OFDPA_PORT_STATE_LINK_DOWN) && !(port->config & OFDPA_PORT_CONFIG_DOWN);
+}
+
+static uint64_t ofdpa_sim_port_synth_packets(const ofdpa_sim_port_t *port, uint64_t since_ms)
+{
+  if (!ofdpa_sim_port_up(port))
+  {
+    return 0;
+  }
+  return ((ofdpa_sim_now_ms() - since_ms) * sim_port_pps) / 1000;
+}
+
+static void ofdpa_sim_port_event_locked(uint32_t portNum, uint32_t mask)
+{
+  sim_ports[portNum].pending_events |= mask;
+  ofdpa_sim_stats.port_events++;
+  ofdpa_sim_event_signal_locked();
+}
+
+static void ofdpa_sim_port_reset(ofdpa_sim_port_t *port)
+{
+  uint32_t q;
+
+  memset(port, 0, sizeof(*port));
+  port->exists = 1;
+  port->state = OFDPA_PORT_STATE_LIVE;
+  port->advertised = OFDPA_SIM_PORT_FEATURES;
+  port->create_ms = ofdpa_sim_now_ms();
+  port->clear_ms = port->create_ms;
+  for (q = 0; q < OFDPA_SIM_QUEUES; q++)
+  {
+    port->queue_clear_ms[q] = port->create_ms;
+  }
+}
+
+void ofdpa_sim_port_init(uint32_t numPorts, uint32_t pps)
+{
+  uint32_t portNum;
+
+  if (numPorts > OFDPA_SIM_PORTS_MAX)
+  {
+    numPorts = OFDPA_SIM_PORTS_MAX;
+  }
+  for (portNum = 1; portNum <= numPorts; portNum++)
+  {
+    ofdpa_sim_port_reset(&sim_ports[portNum]);
+  }
+  sim_port_pps = pps;
+}
+
+int ofdpa_sim_port_exists_locked(uint32_t portNum)
+{
+  return ofdpa_sim_port_get(portNum) != NULL;
+}
+
+void ofdpa_sim_port_count_locked(uint32_t portNum, int rx, uint32_t bytes)
+{
+  ofdpa_sim_port_t *port = ofdpa_sim_port_get(portNum);
+
+  if (port == NULL)
+  {
+    return;
+  }
+  if (rx)
+  {
+    port->rx_packets++;
+    port->rx_bytes += bytes;
+  }
+  else
+  {
+    port->tx_packets++;
+    port->tx_bytes += bytes;
+  }
+}
+
+/* The next up port after portNum, wrapping around; 0 if none is up */
+uint32_t ofdpa_sim_port_next_up_locked(uint32_t portNum)
+{
+  uint32_t i;
+
+  for (i = 0; i < OFDPA_SIM_PORTS_MAX; i++)
+  {
+    portNum = (portNum % OFDPA_SIM_PORTS_MAX) + 1;
+    if (sim_ports[portNum].exists && ofdpa_sim_port_up(&sim_ports[portNum]))
+    {
+      return portNum;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Control interface
+ */
+OFDPA_ERROR_t ofdpa_sim_port_link_set(uint32_t portNum, int up)
+{
+  ofdpa_sim_port_t *port;
+  OFDPA_PORT_STATE_t state;
+
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port == NULL)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_NOT_FOUND;
+  }
+
+  state = up ? OFDPA_PORT_STATE_LIVE : OFDPA_PORT_STATE_LINK_DOWN;
+  if (port->state != state)
+  {
+    port->state = state;
+    ofdpa_sim_port_event_locked(portNum, OFDPA_EVENT_PORT_STATE);
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpa_sim_port_create(uint32_t portNum)
+{
+  ofdpa_sim_init();
+
+  if ((portNum == 0) || (portNum > OFDPA_SIM_PORTS_MAX))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  if (sim_ports[portNum].exists)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_EXISTS;
+  }
+  ofdpa_sim_port_reset(&sim_ports[portNum]);
+  ofdpa_sim_port_event_locked(portNum, OFDPA_EVENT_PORT_CREATE);
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpa_sim_port_delete(uint32_t portNum)
+{
+  ofdpa_sim_port_t *port;
+
+  ofdpa_sim_init();
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port == NULL)
+  {
+    OFDPA_SIM_UNLOCK();
+    return OFDPA_E_NOT_FOUND;
+  }
+  port->exists = 0;
+  port->pending_events = 0;
+  ofdpa_sim_port_event_locked(portNum, OFDPA_EVENT_PORT_DELETE);
+  OFDPA_SIM_UNLOCK();
+
+  return OFDPA_E_NONE;
+}
+
+/*
+ * OF-DPA port calls
+ */
+OFDPA_ERROR_t ofdpaPortTypeGet(uint32_t portNum, uint32_t *type)
+{
+  if (type == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *type = portNum >> 16;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPortTypeSet(uint32_t *portNum, uint32_t type)
+{
+  if ((portNum == NULL) || (type > 0xffff))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *portNum = (*portNum & 0xffff) | (type << 16);
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPortIndexGet(uint32_t portNum, uint32_t *index)
+{
+  if (index == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+  *index = portNum & 0xffff;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPortIndexSet(uint32_t *portNum, uint32_t index)
+{
+  if ((portNum == NULL) || (index > 0xffff))
+  {
+    return OFDPA_E_PARAM;
+  }
+  *portNum = (*portNum & 0xffff0000) | index;
+  return OFDPA_E_NONE;
+}
+
+OFDPA_ERROR_t ofdpaPortNextGet(uint32_t portNum, uint32_t *nextPortNum)
+{
+  uint32_t next;
+  OFDPA_ERROR_t rc = OFDPA_E_NOT_FOUND;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (nextPortNum == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  for (next = portNum + 1; (next != 0) && (next <= OFDPA_SIM_PORTS_MAX); next++)
+  {
+    if (sim_ports[next].exists)
+    {
+      *nextPortNum = next;
+      rc = OFDPA_E_NONE;
+      break;
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaPortMacGet(uint32_t portNum, ofdpaMacAddr_t *mac)
+{
+  OFDPA_ERROR_t rc = OFDPA_E_NOT_FOUND;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (mac == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  if (ofdpa_sim_port_get(portNum) != NULL)
+  {
+    /* Locally administered address with the port number in the low bytes */
+    memset(mac, 0, sizeof(*mac));
+    mac->addr[0] = 0x02;
+    mac->addr[4] = (portNum >> 8) & 0xff;
+    mac->addr[5] = portNum & 0xff;
+    rc = OFDPA_E_NONE;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaPortNameGet(uint32_t portNum, ofdpa_buffdesc *name)
+{
+  OFDPA_ERROR_t rc = OFDPA_E_NOT_FOUND;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if ((name == NULL) || (name->pstart == NULL) || (name->size == 0))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  if (ofdpa_sim_port_get(portNum) != NULL)
+  {
+    snprintf(name->pstart, name->size, "port%u", portNum);
+    rc = OFDPA_E_NONE;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+OFDPA_ERROR_t ofdpaPortStateGet(uint32_t portNum, OFDPA_PORT_STATE_t *state)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (state == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    *state = port->state;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortConfigSet(uint32_t portNum, OFDPA_PORT_CONFIG_t config)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if ((port != NULL) && (port->config != config))
+  {
+    port->config = config;
+    ofdpa_sim_port_event_locked(portNum, OFDPA_EVENT_PORT_STATE);
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortConfigGet(uint32_t portNum, OFDPA_PORT_CONFIG_t *config)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (config == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    *config = port->config;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortMaxSpeedGet(uint32_t portNum, uint32_t *maxSpeed)
+{
+  int exists;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (maxSpeed == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  exists = ofdpa_sim_port_exists_locked(portNum);
+  OFDPA_SIM_UNLOCK();
+
+  *maxSpeed = OFDPA_SIM_PORT_SPEED_KBPS;
+  return exists ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortCurrSpeedGet(uint32_t portNum, uint32_t *currSpeed)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (currSpeed == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    *currSpeed = ofdpa_sim_port_up(port) ? OFDPA_SIM_PORT_SPEED_KBPS : 0;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortFeatureGet(uint32_t portNum, ofdpaPortFeature_t *feature)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (feature == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    memset(feature, 0, sizeof(*feature));
+    feature->curr = OFDPA_SIM_PORT_FEATURES;
+    feature->supported = OFDPA_SIM_PORT_FEATURES;
+    feature->advertised = port->advertised;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortAdvertiseFeatureSet(uint32_t portNum, uint32_t advertise)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    port->advertised = advertise;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortStatsClear(uint32_t portNum)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    port->clear_ms = ofdpa_sim_now_ms();
+    port->rx_packets = port->rx_bytes = 0;
+    port->tx_packets = port->tx_bytes = 0;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaPortStatsGet(uint32_t portNum, ofdpaPortStats_t *stats)
+{
+  ofdpa_sim_port_t *port;
+  uint64_t synth;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (stats == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    synth = ofdpa_sim_port_synth_packets(port, port->clear_ms);
+    memset(stats, 0, sizeof(*stats));
+    stats->rx_packets = port->rx_packets + synth;
+    stats->rx_bytes = port->rx_bytes + (synth * OFDPA_SIM_SYNTH_BYTES);
+    stats->tx_packets = port->tx_packets + synth;
+    stats->tx_bytes = port->tx_bytes + (synth * OFDPA_SIM_SYNTH_BYTES);
+    stats->duration_seconds = (ofdpa_sim_now_ms() - port->clear_ms) / 1000;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+/* Ports with pending events, in port order after eventData->portNum */
+OFDPA_ERROR_t ofdpaPortEventNextGet(ofdpaPortEvent_t *eventData)
+{
+  uint32_t portNum;
+  OFDPA_ERROR_t rc = OFDPA_E_NOT_FOUND;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (eventData == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  for (portNum = eventData->portNum + 1; (portNum != 0) && (portNum <= OFDPA_SIM_PORTS_MAX); portNum++)
+  {
+    if (sim_ports[portNum].pending_events != 0)
+    {
+      eventData->eventMask = sim_ports[portNum].pending_events;
+      eventData->portNum = portNum;
+      eventData->state = sim_ports[portNum].state;
+      sim_ports[portNum].pending_events = 0;
+      rc = OFDPA_E_NONE;
+      break;
+    }
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return rc;
+}
+
+/*
+ * Queues. Synthetic transmit traffic is spread evenly over the queues.
+ */
+OFDPA_ERROR_t ofdpaNumQueuesGet(uint32_t portNum, uint32_t *numQueues)
+{
+  int exists;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (numQueues == NULL)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  exists = ofdpa_sim_port_exists_locked(portNum);
+  OFDPA_SIM_UNLOCK();
+
+  *numQueues = OFDPA_SIM_QUEUES;
+  return exists ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaQueueStatsGet(uint32_t portNum, uint32_t queueId, ofdpaPortQueueStats_t *stats)
+{
+  ofdpa_sim_port_t *port;
+  uint64_t synth;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if ((stats == NULL) || (queueId >= OFDPA_SIM_QUEUES))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    synth = ofdpa_sim_port_synth_packets(port, port->queue_clear_ms[queueId]) / OFDPA_SIM_QUEUES;
+    memset(stats, 0, sizeof(*stats));
+    stats->txPkts = synth;
+    stats->txBytes = synth * OFDPA_SIM_SYNTH_BYTES;
+    stats->duration = (ofdpa_sim_now_ms() - port->queue_clear_ms[queueId]) / 1000;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaQueueStatsClear(uint32_t portNum, uint32_t queueId)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if (queueId >= OFDPA_SIM_QUEUES)
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    port->queue_clear_ms[queueId] = ofdpa_sim_now_ms();
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaQueueRateSet(uint32_t portNum, uint32_t queueId, uint32_t minRate, uint32_t maxRate)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if ((queueId >= OFDPA_SIM_QUEUES) || ((maxRate != 0) && (minRate > maxRate)))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    port->queue_min_rate[queueId] = minRate;
+    port->queue_max_rate[queueId] = maxRate;
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaQueueRateGet(uint32_t portNum, uint32_t queueId, uint32_t *minRate, uint32_t *maxRate)
+{
+  ofdpa_sim_port_t *port;
+
+  OFDPA_SIM_CALL(PORT);
+
+  if ((queueId >= OFDPA_SIM_QUEUES) || (minRate == NULL) || (maxRate == NULL))
+  {
+    return OFDPA_E_PARAM;
+  }
+
+  OFDPA_SIM_LOCK();
+  port = ofdpa_sim_port_get(portNum);
+  if (port != NULL)
+  {
+    *minRate = port->queue_min_rate[queueId];
+    *maxRate = port->queue_max_rate[queueId];
+  }
+  OFDPA_SIM_UNLOCK();
+
+  return (port != NULL) ? OFDPA_E_NONE : OFDPA_E_NOT_FOUND;
+}
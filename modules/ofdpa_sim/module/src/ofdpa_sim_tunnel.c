@@ -0,0 +1,371 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     ofdpa_sim_tunnel.c
+*
+* @purpose      Simulated OF-DPA tunnel and OAM tables
+*
+* @component    OF-DPA
+*
+* @comments     The simulation has no overlay tunnels or OAM. Its tunnel
+*               and OAM tables are always empty: lookups find nothing and
+*               creates report OFDPA_E_UNAVAIL, so the clients that list
+*               or delete these objects run and show none.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include "ofdpa_sim_int.h"
+
+/*
+ * Tunnels
+ */
+OFDPA_ERROR_t ofdpaTunnelTenantCreate(uint32_t tunnelId, ofdpaTunnelTenantConfig_t *config)
+{
+  (void)tunnelId;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_UNAVAIL;
+}
+
+OFDPA_ERROR_t ofdpaTunnelTenantDelete(uint32_t tunnelId)
+{
+  (void)tunnelId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelTenantGet(uint32_t tunnelId, ofdpaTunnelTenantConfig_t *config, ofdpaTunnelTenantStatus_t *status)
+{
+  (void)tunnelId;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelTenantNextGet(uint32_t tunnelId, uint32_t *nextTunnelId)
+{
+  (void)tunnelId;
+  (void)nextTunnelId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelNextHopCreate(uint32_t nextHopId, ofdpaTunnelNextHopConfig_t *config)
+{
+  (void)nextHopId;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_UNAVAIL;
+}
+
+OFDPA_ERROR_t ofdpaTunnelNextHopModify(uint32_t nextHopId, ofdpaTunnelNextHopConfig_t *config)
+{
+  (void)nextHopId;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelNextHopDelete(uint32_t nextHopId)
+{
+  (void)nextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelNextHopGet(uint32_t nextHopId, ofdpaTunnelNextHopConfig_t *config, ofdpaTunnelNextHopStatus_t *status)
+{
+  (void)nextHopId;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelNextHopNextGet(uint32_t nextHopId, uint32_t *nextNextHopId)
+{
+  (void)nextHopId;
+  (void)nextNextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupCreate(uint32_t ecmpNextHopGroupId, ofdpaTunnelEcmpNextHopGroupConfig_t *config)
+{
+  (void)ecmpNextHopGroupId;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_UNAVAIL;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupDelete(uint32_t ecmpNextHopGroupId)
+{
+  (void)ecmpNextHopGroupId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupGet(uint32_t ecmpNextHopGroupId, ofdpaTunnelEcmpNextHopGroupConfig_t *config, ofdpaTunnelEcmpNextHopGroupStatus_t *status)
+{
+  (void)ecmpNextHopGroupId;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupNextGet(uint32_t ecmpNextHopGroupId, uint32_t *nextEcmpNextHopGroupId)
+{
+  (void)ecmpNextHopGroupId;
+  (void)nextEcmpNextHopGroupId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupMemberAdd(uint32_t ecmpNextHopGroupId, uint32_t nextHopId)
+{
+  (void)ecmpNextHopGroupId;
+  (void)nextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupMemberDelete(uint32_t ecmpNextHopGroupId, uint32_t nextHopId)
+{
+  (void)ecmpNextHopGroupId;
+  (void)nextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupMemberGet(uint32_t ecmpNextHopGroupId, uint32_t nextHopId)
+{
+  (void)ecmpNextHopGroupId;
+  (void)nextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelEcmpNextHopGroupMemberNextGet(uint32_t ecmpNextHopGroupId, uint32_t nextHopId, uint32_t *nextNextHopId)
+{
+  (void)ecmpNextHopGroupId;
+  (void)nextHopId;
+  (void)nextNextHopId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortCreate(uint32_t portNum, ofdpa_buffdesc *name, ofdpaTunnelPortConfig_t *config)
+{
+  (void)portNum;
+  (void)name;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_UNAVAIL;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortDelete(uint32_t portNum)
+{
+  (void)portNum;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortGet(uint32_t portNum, ofdpaTunnelPortConfig_t *config, ofdpaTunnelPortStatus_t *status)
+{
+  (void)portNum;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortNextGet(uint32_t portNum, uint32_t *nextPortNum)
+{
+  (void)portNum;
+  (void)nextPortNum;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortTenantAdd(uint32_t portNum, uint32_t tunnelId)
+{
+  (void)portNum;
+  (void)tunnelId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortTenantDelete(uint32_t portNum, uint32_t tunnelId)
+{
+  (void)portNum;
+  (void)tunnelId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortTenantGet(uint32_t portNum, uint32_t tunnelId, ofdpaTunnelPortTenantStatus_t *status)
+{
+  (void)portNum;
+  (void)tunnelId;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaTunnelPortTenantNextGet(uint32_t portNum, uint32_t tunnelId, uint32_t *nextTunnelId)
+{
+  (void)portNum;
+  (void)tunnelId;
+  (void)nextTunnelId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+
+/*
+ * OAM
+ */
+OFDPA_ERROR_t ofdpaOamMegDelete(uint32_t megIndex)
+{
+  (void)megIndex;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMegGet(uint32_t megIndex, ofdpaOamMegConfig_t *config, ofdpaOamMegStatus_t *status)
+{
+  (void)megIndex;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMegNextGet(uint32_t megIndex, uint32_t *nextMegIndex)
+{
+  (void)megIndex;
+  (void)nextMegIndex;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepDelete(uint32_t lmepId)
+{
+  (void)lmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepGet(uint32_t lmepId, ofdpaOamMepConfig_t *config, ofdpaOamMepStatus_t *status)
+{
+  (void)lmepId;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepNextGet(uint32_t lmepId, uint32_t *nextLmepId)
+{
+  (void)lmepId;
+  (void)nextLmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamRemoteMepDelete(uint32_t lmepId, uint32_t rmepId)
+{
+  (void)lmepId;
+  (void)rmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamRemoteMepGet(uint32_t lmepId, uint32_t rmepId, ofdpaOamRemoteMepConfig_t *config)
+{
+  (void)lmepId;
+  (void)rmepId;
+  (void)config;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamRemoteMepNextGet(uint32_t lmepId, uint32_t rmepId, uint32_t *nextRmepId)
+{
+  (void)lmepId;
+  (void)rmepId;
+  (void)nextRmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMLPGroupGet(uint32_t mlpIndex, ofdpaOamMLPGroupConfig_t *config, ofdpaOamMLPGroupStatus_t *status)
+{
+  (void)mlpIndex;
+  (void)config;
+  (void)status;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMLPGroupNextGet(uint32_t mlpIndex, uint32_t *nextMlpIndex)
+{
+  (void)mlpIndex;
+  (void)nextMlpIndex;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepHeadEndProtectionGet(uint32_t mlpIndex, uint32_t lmepId)
+{
+  (void)mlpIndex;
+  (void)lmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepHeadEndProtectionNextGet(uint32_t mlpIndex, uint32_t lmepId, uint32_t *nextLmepId)
+{
+  (void)mlpIndex;
+  (void)lmepId;
+  (void)nextLmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepTailEndProtectionGet(uint32_t mlpIndex, uint32_t lmepId)
+{
+  (void)mlpIndex;
+  (void)lmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
+
+OFDPA_ERROR_t ofdpaOamMepTailEndProtectionNextGet(uint32_t mlpIndex, uint32_t lmepId, uint32_t *nextLmepId)
+{
+  (void)mlpIndex;
+  (void)lmepId;
+  (void)nextLmepId;
+  OFDPA_SIM_CALL(OTHER);
+  return OFDPA_E_NOT_FOUND;
+}
@@ -0,0 +1,9 @@
+
+###############################################################################
+#
+# Inclusive Makefile for the ofdpa_sim module.
+#
+###############################################################################
+ofdpa_sim_BASEDIR := $(dir $(abspath $(lastword $(MAKEFILE_LIST))))
+include $(ofdpa_sim_BASEDIR)/module/make.mk
+include $(ofdpa_sim_BASEDIR)/module/src/make.mk
@@ -0,0 +1,852 @@
+/*********************************************************************
+*
+* (C) Copyright Broadcom Corporation 2013-2014
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+**********************************************************************
+*
+* @filename     client_trace_replay.c
+*
+* @purpose      Replays a libofdpa call trace recorded by ofagent --trace.
+*               Uses RPC calls.
+*
+* @component    Unit Test
+*
+* @comments     Calls are issued in trace order at their recorded times,
+*               scaled by --speed, and timed. Packets received and port
+*               events in the trace can only be fed back when linked
+*               against libofdpa_sim (--inject); flow events are not
+*               replayed, the backend raises its own from the replayed
+*               flow timeouts.
+*
+* @create       18 Oct 2026
+*
+* @end
+*
+**********************************************************************/
+#include "ofdpa_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <argp.h>
+
+#include <indigo_ofdpa_driver/ind_ofdpa_trace.h>
+#include <ofdpa_sim/ofdpa_sim.h>
+
+/* Only present when linked against libofdpa_sim */
+#pragma weak ofdpa_sim_pkt_inject
+#pragma weak ofdpa_sim_port_link_set
+#pragma weak ofdpa_sim_port_create
+#pragma weak ofdpa_sim_port_delete
+
+const char *argp_program_version = "client_trace_replay v1.0";
+
+/* The options we understand. */
+static struct argp_option options[] =
+{
+  { "speed",   's', "FACTOR", 0, "Replay FACTOR times faster than recorded; 0 replays as fast as possible. (default 1)", 0 },
+  { "inject",  'i',        0, 0, "Feed recorded packet-ins and port events to libofdpa_sim.",                         0 },
+  { "verbose", 'v',        0, 0, "Print every call whose return code differs from the trace.",                        0 },
+  { 0 }
+};
+
+static const char *traceFile = NULL;
+static double speed = 1.0;
+static int inject = 0;
+static int verbose = 0;
+
+/* Replays one record; in and out are the recorded inputs and outputs */
+typedef OFDPA_ERROR_t replayFcn_t(const uint8_t *in, uint32_t inLen,
+                                  const uint8_t *out, uint32_t outLen, int *skip);
+
+typedef struct
+{
+  const char  *name;
+  replayFcn_t *replayFcn;
+  uint64_t     calls;
+  uint64_t     rvDiffs;
+  uint64_t     skipped;
+  uint64_t     recordedNs;
+  uint64_t     replayNs;
+  uint64_t     replayMaxNs;
+} apiList_t;
+
+/* Cursor over the inputs of a record */
+typedef struct
+{
+  const uint8_t *p;
+  uint32_t       len;
+  int            short_read;
+} argCursor_t;
+
+static void argGet(argCursor_t *c, void *value, uint32_t size)
+{
+  if (c->len < size)
+  {
+    memset(value, 0, size);
+    c->short_read = 1;
+    return;
+  }
+  memcpy(value, c->p, size);
+  c->p += size;
+  c->len -= size;
+}
+
+static uint32_t argU32(argCursor_t *c)
+{
+  uint32_t value;
+
+  argGet(c, &value, sizeof(value));
+  return value;
+}
+
+static uint64_t argU64(argCursor_t *c)
+{
+  uint64_t value;
+
+  argGet(c, &value, sizeof(value));
+  return value;
+}
+
+#define REPLAY_BEGIN(_in, _inLen)  argCursor_t c = { (_in), (_inLen), 0 }
+#define REPLAY_CALL(_call)         (*skip = c.short_read) ? OFDPA_E_PARAM : (_call)
+
+static OFDPA_ERROR_t replayFlowAdd(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaFlowEntry_t flow;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &flow, sizeof(flow));
+  return REPLAY_CALL(ofdpaFlowAdd(&flow));
+}
+
+static OFDPA_ERROR_t replayFlowModify(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaFlowEntry_t flow;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &flow, sizeof(flow));
+  return REPLAY_CALL(ofdpaFlowModify(&flow));
+}
+
+static OFDPA_ERROR_t replayFlowByCookieGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaFlowEntry_t flow;
+  ofdpaFlowEntryStats_t stats;
+  uint64_t cookie;
+  REPLAY_BEGIN(in, inLen);
+
+  cookie = argU64(&c);
+  return REPLAY_CALL(ofdpaFlowByCookieGet(cookie, &flow, &stats));
+}
+
+static OFDPA_ERROR_t replayFlowByCookieDelete(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint64_t cookie;
+  REPLAY_BEGIN(in, inLen);
+
+  cookie = argU64(&c);
+  return REPLAY_CALL(ofdpaFlowByCookieDelete(cookie));
+}
+
+static OFDPA_ERROR_t replayFlowTableInfoGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaFlowTableInfo_t info;
+  uint32_t tableId;
+  REPLAY_BEGIN(in, inLen);
+
+  tableId = argU32(&c);
+  return REPLAY_CALL(ofdpaFlowTableInfoGet(tableId, &info));
+}
+
+static OFDPA_ERROR_t replayFlowNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaFlowEntry_t flow, nextFlow;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &flow, sizeof(flow));
+  return REPLAY_CALL(ofdpaFlowNextGet(&flow, &nextFlow));
+}
+
+static OFDPA_ERROR_t replayGroupAdd(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupEntry_t group;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &group, sizeof(group));
+  return REPLAY_CALL(ofdpaGroupAdd(&group));
+}
+
+static OFDPA_ERROR_t replayGroupDelete(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t groupId;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupDelete(groupId));
+}
+
+static OFDPA_ERROR_t replayGroupTypeGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t groupId, type;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupTypeGet(groupId, &type));
+}
+
+static OFDPA_ERROR_t replayGroupMplsSubTypeGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t groupId, subType;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupMplsSubTypeGet(groupId, &subType));
+}
+
+static OFDPA_ERROR_t replayGroupStatsGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupEntryStats_t stats;
+  uint32_t groupId;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupStatsGet(groupId, &stats));
+}
+
+static OFDPA_ERROR_t replayGroupNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupEntry_t nextGroup;
+  uint32_t groupId;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupNextGet(groupId, &nextGroup));
+}
+
+static OFDPA_ERROR_t replayGroupBucketEntryAdd(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &bucket, sizeof(bucket));
+  return REPLAY_CALL(ofdpaGroupBucketEntryAdd(&bucket));
+}
+
+static OFDPA_ERROR_t replayGroupBucketEntryModify(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &bucket, sizeof(bucket));
+  return REPLAY_CALL(ofdpaGroupBucketEntryModify(&bucket));
+}
+
+static OFDPA_ERROR_t replayGroupBucketEntryDelete(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t groupId, bucketIndex;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  bucketIndex = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupBucketEntryDelete(groupId, bucketIndex));
+}
+
+static OFDPA_ERROR_t replayGroupBucketEntryFirstGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  uint32_t groupId;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupBucketEntryFirstGet(groupId, &bucket));
+}
+
+static OFDPA_ERROR_t replayGroupBucketEntryNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaGroupBucketEntry_t bucket;
+  uint32_t groupId, bucketIndex;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  bucketIndex = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupBucketEntryNextGet(groupId, bucketIndex, &bucket));
+}
+
+static OFDPA_ERROR_t replayGroupBucketsDeleteAll(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t groupId;
+  REPLAY_BEGIN(in, inLen);
+
+  groupId = argU32(&c);
+  return REPLAY_CALL(ofdpaGroupBucketsDeleteAll(groupId));
+}
+
+static OFDPA_ERROR_t replayMeterAdd(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaMeterEntry_t meter;
+  REPLAY_BEGIN(in, inLen);
+
+  argGet(&c, &meter, sizeof(meter));
+  return REPLAY_CALL(ofdpaMeterAdd(&meter));
+}
+
+static OFDPA_ERROR_t replayMeterDelete(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t meterId;
+  REPLAY_BEGIN(in, inLen);
+
+  meterId = argU32(&c);
+  return REPLAY_CALL(ofdpaMeterDelete(meterId));
+}
+
+static OFDPA_ERROR_t replayMeterStatsGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaMeterEntryStats_t stats;
+  uint32_t meterId;
+  REPLAY_BEGIN(in, inLen);
+
+  meterId = argU32(&c);
+  return REPLAY_CALL(ofdpaMeterStatsGet(meterId, &stats));
+}
+
+static OFDPA_ERROR_t replayPktSend(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpa_buffdesc pkt;
+  uint32_t flags, outPortNum, inPortNum;
+  REPLAY_BEGIN(in, inLen);
+
+  flags = argU32(&c);
+  outPortNum = argU32(&c);
+  inPortNum = argU32(&c);
+  pkt.pstart = (char *)c.p;
+  pkt.size = c.len;
+  return REPLAY_CALL(ofdpaPktSend(&pkt, flags, outPortNum, inPortNum));
+}
+
+static OFDPA_ERROR_t replayMaxPktSizeGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t pktSize;
+
+  return ofdpaMaxPktSizeGet(&pktSize);
+}
+
+static OFDPA_ERROR_t replayPortNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, nextPortNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortNextGet(portNum, &nextPortNum));
+}
+
+static OFDPA_ERROR_t replayPortMacGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaMacAddr_t mac;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortMacGet(portNum, &mac));
+}
+
+static OFDPA_ERROR_t replayPortNameGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  char buf[OFDPA_PORT_NAME_STRING_SIZE];
+  ofdpa_buffdesc name;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  name.pstart = buf;
+  name.size = sizeof(buf);
+  return REPLAY_CALL(ofdpaPortNameGet(portNum, &name));
+}
+
+static OFDPA_ERROR_t replayPortStateGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  OFDPA_PORT_STATE_t state;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortStateGet(portNum, &state));
+}
+
+static OFDPA_ERROR_t replayPortConfigGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  OFDPA_PORT_CONFIG_t config;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortConfigGet(portNum, &config));
+}
+
+static OFDPA_ERROR_t replayPortConfigSet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, config;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  config = argU32(&c);
+  return REPLAY_CALL(ofdpaPortConfigSet(portNum, (OFDPA_PORT_CONFIG_t)config));
+}
+
+static OFDPA_ERROR_t replayPortCurrSpeedGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, currSpeed;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortCurrSpeedGet(portNum, &currSpeed));
+}
+
+static OFDPA_ERROR_t replayPortMaxSpeedGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, maxSpeed;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortMaxSpeedGet(portNum, &maxSpeed));
+}
+
+static OFDPA_ERROR_t replayPortFeatureGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaPortFeature_t feature;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaPortFeatureGet(portNum, &feature));
+}
+
+static OFDPA_ERROR_t replayPortAdvertiseFeatureSet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, advertise;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  advertise = argU32(&c);
+  return REPLAY_CALL(ofdpaPortAdvertiseFeatureSet(portNum, advertise));
+}
+
+static OFDPA_ERROR_t replayPortStatsGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaPortStats_t stats;
+  uint32_t portNum;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  memset(&stats, 0, sizeof(stats));
+  return REPLAY_CALL(ofdpaPortStatsGet(portNum, &stats));
+}
+
+static OFDPA_ERROR_t replayNumQueuesGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, numQueues;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  return REPLAY_CALL(ofdpaNumQueuesGet(portNum, &numQueues));
+}
+
+static OFDPA_ERROR_t replayQueueStatsGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaPortQueueStats_t stats;
+  uint32_t portNum, queueId;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  queueId = argU32(&c);
+  memset(&stats, 0, sizeof(stats));
+  return REPLAY_CALL(ofdpaQueueStatsGet(portNum, queueId, &stats));
+}
+
+static OFDPA_ERROR_t replayQueueRateGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t portNum, queueId, minRate, maxRate;
+  REPLAY_BEGIN(in, inLen);
+
+  portNum = argU32(&c);
+  queueId = argU32(&c);
+  return REPLAY_CALL(ofdpaQueueRateGet(portNum, queueId, &minRate, &maxRate));
+}
+
+/* Packets and events the switch produced: fed to libofdpa_sim with
+   --inject, otherwise skipped */
+static OFDPA_ERROR_t replayPktReceive(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  uint32_t reason, tableId, inPortNum;
+  argCursor_t c = { out, outLen, 0 };
+
+  if (!inject || (ofdpa_sim_pkt_inject == NULL) || (outLen == 0))
+  {
+    *skip = 1;
+    return OFDPA_E_NONE;
+  }
+  reason = argU32(&c);
+  tableId = argU32(&c);
+  inPortNum = argU32(&c);
+  return REPLAY_CALL(ofdpa_sim_pkt_inject(inPortNum, reason, tableId, c.p, c.len));
+}
+
+static OFDPA_ERROR_t replayPortEventNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  ofdpaPortEvent_t event;
+  argCursor_t c = { out, outLen, 0 };
+
+  if (!inject || (ofdpa_sim_port_link_set == NULL) || (outLen == 0))
+  {
+    *skip = 1;
+    return OFDPA_E_NONE;
+  }
+  argGet(&c, &event, sizeof(event));
+  if (c.short_read)
+  {
+    *skip = 1;
+    return OFDPA_E_PARAM;
+  }
+  if (event.eventMask & OFDPA_EVENT_PORT_DELETE)
+  {
+    return ofdpa_sim_port_delete(event.portNum);
+  }
+  if (event.eventMask & OFDPA_EVENT_PORT_CREATE)
+  {
+    (void)ofdpa_sim_port_create(event.portNum);
+  }
+  return ofdpa_sim_port_link_set(event.portNum, !(event.state & OFDPA_PORT_STATE_LINK_DOWN));
+}
+
+static OFDPA_ERROR_t replayFlowEventNextGet(const uint8_t *in, uint32_t inLen, const uint8_t *out, uint32_t outLen, int *skip)
+{
+  *skip = 1;
+  return OFDPA_E_NONE;
+}
+
+#define API_ENTRY(_name) { .name = "ofdpa" #_name, .replayFcn = replay##_name }
+
+static apiList_t apiList[] =
+{
+  API_ENTRY(FlowAdd),
+  API_ENTRY(FlowModify),
+  API_ENTRY(FlowByCookieGet),
+  API_ENTRY(FlowByCookieDelete),
+  API_ENTRY(FlowTableInfoGet),
+  API_ENTRY(FlowEventNextGet),
+  API_ENTRY(FlowNextGet),
+  API_ENTRY(GroupAdd),
+  API_ENTRY(GroupDelete),
+  API_ENTRY(GroupTypeGet),
+  API_ENTRY(GroupMplsSubTypeGet),
+  API_ENTRY(GroupStatsGet),
+  API_ENTRY(GroupNextGet),
+  API_ENTRY(GroupBucketEntryAdd),
+  API_ENTRY(GroupBucketEntryModify),
+  API_ENTRY(GroupBucketEntryDelete),
+  API_ENTRY(GroupBucketEntryFirstGet),
+  API_ENTRY(GroupBucketEntryNextGet),
+  API_ENTRY(GroupBucketsDeleteAll),
+  API_ENTRY(MeterAdd),
+  API_ENTRY(MeterDelete),
+  API_ENTRY(MeterStatsGet),
+  API_ENTRY(PktSend),
+  API_ENTRY(PktReceive),
+  API_ENTRY(MaxPktSizeGet),
+  API_ENTRY(PortNextGet),
+  API_ENTRY(PortMacGet),
+  API_ENTRY(PortNameGet),
+  API_ENTRY(PortStateGet),
+  API_ENTRY(PortConfigGet),
+  API_ENTRY(PortConfigSet),
+  API_ENTRY(PortCurrSpeedGet),
+  API_ENTRY(PortMaxSpeedGet),
+  API_ENTRY(PortFeatureGet),
+  API_ENTRY(PortAdvertiseFeatureSet),
+  API_ENTRY(PortStatsGet),
+  API_ENTRY(PortEventNextGet),
+  API_ENTRY(NumQueuesGet),
+  API_ENTRY(QueueStatsGet),
+  API_ENTRY(QueueRateGet),
+};
+#define API_LIST_SIZE (sizeof(apiList)/sizeof(apiList[0]))
+
+/* Parse a single option. */
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+  char *end;
+
+  switch (key)
+  {
+    case 's':                           /* speed */
+      errno = 0;
+      speed = strtod(arg, &end);
+      if ((errno != 0) || (*end != '\0') || (speed < 0))
+      {
+        argp_error(state, "Invalid speed \"%s\"", arg);
+        return EINVAL;
+      }
+      break;
+
+    case 'i':
+      inject = 1;
+      break;
+
+    case 'v':
+      verbose = 1;
+      break;
+
+    case ARGP_KEY_ARG:
+      if (traceFile != NULL)
+      {
+        argp_error(state, "Only one trace file may be given");
+        return EINVAL;
+      }
+      traceFile = arg;
+      break;
+
+    case ARGP_KEY_END:
+      if (traceFile == NULL)
+      {
+        argp_usage(state);
+      }
+      break;
+
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void waitUntilNs(uint64_t when)
+{
+  struct timespec ts;
+
+  ts.tv_sec = when / 1000000000ULL;
+  ts.tv_nsec = when % 1000000000ULL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+  {
+    /* restart */
+  }
+}
+
+/* Reads the header and the API names; map[i] is the apiList entry of
+   trace API i, NULL if this build does not know it */
+static int traceHeaderRead(FILE *fp, apiList_t ***map, uint16_t *numApis)
+{
+  ind_ofdpa_trace_file_hdr_t hdr;
+  char name[128];
+  uint16_t i;
+  uint32_t j, k;
+  int ch;
+
+  if (fread(&hdr, sizeof(hdr), 1, fp) != 1)
+  {
+    printf("Failed to read the trace header.\n");
+    return -1;
+  }
+  if ((hdr.magic != IND_OFDPA_TRACE_MAGIC) || (hdr.version != IND_OFDPA_TRACE_VERSION))
+  {
+    printf("Not an OF-DPA trace, or an unsupported version.\n");
+    return -1;
+  }
+  if ((hdr.flow_entry_size != sizeof(ofdpaFlowEntry_t)) ||
+      (hdr.group_entry_size != sizeof(ofdpaGroupEntry_t)) ||
+      (hdr.bucket_entry_size != sizeof(ofdpaGroupBucketEntry_t)) ||
+      (hdr.meter_entry_size != sizeof(ofdpaMeterEntry_t)) ||
+      (hdr.flow_event_size != sizeof(ofdpaFlowEvent_t)) ||
+      (hdr.port_event_size != sizeof(ofdpaPortEvent_t)))
+  {
+    printf("The trace was recorded with a different OF-DPA API layout.\n");
+    return -1;
+  }
+
+  *numApis = hdr.num_apis;
+  *map = calloc(hdr.num_apis, sizeof(**map));
+  if ((*map == NULL) && (hdr.num_apis != 0))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < hdr.num_apis; i++)
+  {
+    j = 0;
+    while (((ch = fgetc(fp)) != EOF) && (ch != '\0'))
+    {
+      if (j < sizeof(name) - 1)
+      {
+        name[j++] = ch;
+      }
+    }
+    if (ch == EOF)
+    {
+      printf("Truncated API name table.\n");
+      return -1;
+    }
+    name[j] = '\0';
+
+    for (k = 0; k < API_LIST_SIZE; k++)
+    {
+      if (strcmp(apiList[k].name, name) == 0)
+      {
+        (*map)[i] = &apiList[k];
+        break;
+      }
+    }
+    if ((*map)[i] == NULL)
+    {
+      printf("Calls to %s will be skipped.\n", name);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  char client_name[] = "ofdpa trace replay client";
+  struct argp argp =
+    {
+      .options = options,
+      .parser = parse_opt,
+      .args_doc = "TRACE_FILE",
+      .doc = "Replays a libofdpa call trace recorded by ofagent --trace and reports the call latency.",
+    };
+  ind_ofdpa_trace_rec_t rec;
+  static uint8_t data[IND_OFDPA_TRACE_DATA_MAX];
+  apiList_t **map = NULL;
+  apiList_t *api;
+  uint16_t numApis = 0;
+  uint64_t startNs, callNs, elapsedNs, lastTs = 0;
+  uint64_t records = 0, unknown = 0;
+  OFDPA_ERROR_t rc;
+  FILE *fp;
+  uint32_t i;
+  int skip;
+
+  argp_parse(&argp, argc, argv, 0, 0, 0);
+
+  if (inject && (ofdpa_sim_pkt_inject == NULL))
+  {
+    printf("--inject needs libofdpa_sim; packets and port events will be skipped.\n");
+  }
+
+  fp = fopen(traceFile, "rb");
+  if (fp == NULL)
+  {
+    printf("Cannot open %s: %s\n", traceFile, strerror(errno));
+    return 1;
+  }
+  if (traceHeaderRead(fp, &map, &numApis) != 0)
+  {
+    fclose(fp);
+    return 1;
+  }
+
+  rc = ofdpaClientInitialize(client_name);
+  if (rc != OFDPA_E_NONE)
+  {
+    printf("Failed to initialize OF-DPA client. rc = %d\n", rc);
+    fclose(fp);
+    return rc;
+  }
+
+  startNs = nowNs();
+  while (fread(&rec, sizeof(rec), 1, fp) == 1)
+  {
+    if (fread(data, 1, rec.in_len + rec.out_len, fp) != (size_t)(rec.in_len + rec.out_len))
+    {
+      printf("Trace ends in the middle of a record.\n");
+      break;
+    }
+    records++;
+    lastTs = rec.ts_ns;
+
+    api = (rec.api < numApis) ? map[rec.api] : NULL;
+    if (api == NULL)
+    {
+      unknown++;
+      continue;
+    }
+
+    if (speed > 0)
+    {
+      waitUntilNs(startNs + (uint64_t)(rec.ts_ns / speed));
+    }
+
+    skip = 0;
+    callNs = nowNs();
+    rc = api->replayFcn(data, rec.in_len, &data[rec.in_len], rec.out_len, &skip);
+    elapsedNs = nowNs() - callNs;
+
+    if (skip)
+    {
+      api->skipped++;
+      continue;
+    }
+    api->calls++;
+    api->recordedNs += rec.dur_ns;
+    api->replayNs += elapsedNs;
+    if (elapsedNs > api->replayMaxNs)
+    {
+      api->replayMaxNs = elapsedNs;
+    }
+    if (rc != rec.rv)
+    {
+      api->rvDiffs++;
+      if (verbose)
+      {
+        printf("%s at %llu us returned %d, recorded %d\n", api->name,
+               (unsigned long long)(rec.ts_ns / 1000), rc, rec.rv);
+      }
+    }
+  }
+  elapsedNs = nowNs() - startNs;
+  fclose(fp);
+  free(map);
+
+  printf("\nReplayed %llu records spanning %.3f s in %.3f s",
+         (unsigned long long)records, lastTs / 1e9, elapsedNs / 1e9);
+  if (unknown != 0)
+  {
+    printf(", %llu of unknown APIs skipped", (unsigned long long)unknown);
+  }
+  printf("\n\n%-28s %10s %10s %10s %12s %12s %12s\n",
+         "API", "calls", "skipped", "rv_diffs", "rec_avg_us", "avg_us", "max_us");
+  for (i = 0; i < API_LIST_SIZE; i++)
+  {
+    api = &apiList[i];
+    if ((api->calls == 0) && (api->skipped == 0))
+    {
+      continue;
+    }
+    printf("%-28s %10llu %10llu %10llu %12.1f %12.1f %12.1f\n", api->name,
+           (unsigned long long)api->calls, (unsigned long long)api->skipped,
+           (unsigned long long)api->rvDiffs,
+           api->calls ? (double)api->recordedNs / api->calls / 1000.0 : 0.0,
+           api->calls ? (double)api->replayNs / api->calls / 1000.0 : 0.0,
+           (double)api->replayMaxNs / 1000.0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,868 @@
+#!/usr/bin/env python
+############################################################
+# <bsn.cl fy=2013 v=onl>
+#
+#        Copyright 2013, 2014 BigSwitch Networks, Inc.
+#
+# Licensed under the Eclipse Public License, Version 1.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#        http://www.eclipse.org/legal/epl-v10.html
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific
+# language governing permissions and limitations under the
+# License.
+#
+# </bsn.cl>
+############################################################
+#
+# End-to-end ofagent load generator.
+#
+# Stands in for an OpenFlow 1.3 controller on loopback, optionally
+# starting an ofagent linked against libofdpa_sim (modules/ofdpa_sim),
+# and drives a weighted mix of messages at it:
+#
+#   bridging     flow add to the bridging table (50)
+#   routing      flow add to the unicast routing table (30)
+#   acl          flow add to the ACL policy table (60)
+#   group_mod    modify of an L3 unicast group
+#   barrier      barrier request
+#   port_stats   port stats multipart request for all ports
+#   packet_out   packet out on a physical port
+#
+# Each flow type keeps at most --flows entries installed; once full,
+# the oldest entry is deleted before the next add (reported as
+# flow_delete), so long runs measure a steady state instead of a
+# full table.
+#
+# Latency is request to reply for barriers and port stats. Flow mods,
+# group mods and packet outs have no reply, so a barrier is sent after
+# every --batch of them and their latency runs to its reply. With
+# --loopback the simulation turns every packet out into a packet in,
+# and packet_in latency is packet out to packet in.
+#
+# Example, against an ofagent built with libofdpa_sim:
+#
+#   tools/ofagent_bench.py --ofagent ./ofagent --duration 30 \
+#       --mix bridging=40,routing=20,acl=10,group_mod=10,port_stats=10,packet_out=10
+#
+# --sweep runs the bench once per combination of the listed values,
+# restarting ofagent for each, and ends with a summary of flow mod
+# latency (all flow types and deletes together) per point. For
+# example, flow mod latency under packet-in load with and without the
+# OF-DPA I/O thread:
+#
+#   tools/ofagent_bench.py --ofagent ./ofagent --duration 20 \
+#       --mix bridging=50,routing=30,acl=20 \
+#       --sweep pkt_in_pps=0,1000,10000,50000 --sweep io=none,poll
+#
+# --connections opens idle controller connections next to the measured
+# one; they complete the handshake, answer echoes and drop what else
+# they get. ofagent's CPU use over the measured interval is reported
+# when the bench started it. Barrier latency is the main loop's wakeup
+# latency for a controller message, and with --loopback packet_in
+# latency is the wakeup latency of the OF-DPA packet path.
+#
+# The io backends only change how the I/O thread waits on the OF-DPA
+# event and packet sockets. Controller connections stay on the socket
+# manager's select loop whatever the backend, so barrier latency and
+# CPU against the connection count show the cost of that loop, which
+# io does not change; only packet_in latency compares the backends.
+# The numbers come from libofdpa_sim, not a switch. For example, with
+# 1, 16 and 256 connections and each I/O thread backend:
+#
+#   tools/ofagent_bench.py --ofagent ./ofagent --duration 20 --loopback \
+#       --mix barrier=20,packet_out=80 --rate 2000 \
+#       --sweep connections=1,16,256 --sweep io=none,poll,epoll
+#
+############################################################
+from __future__ import print_function
+
+import collections
+import copy
+import errno
+import itertools
+import json
+import math
+import optparse
+import os
+import random
+import select
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+now = getattr(time, "perf_counter", time.time)
+
+OFP_VERSION = 4
+
+OFPT_HELLO = 0
+OFPT_ERROR = 1
+OFPT_ECHO_REQUEST = 2
+OFPT_ECHO_REPLY = 3
+OFPT_FEATURES_REQUEST = 5
+OFPT_FEATURES_REPLY = 6
+OFPT_PACKET_IN = 10
+OFPT_PACKET_OUT = 13
+OFPT_FLOW_MOD = 14
+OFPT_GROUP_MOD = 15
+OFPT_MULTIPART_REQUEST = 18
+OFPT_MULTIPART_REPLY = 19
+OFPT_BARRIER_REQUEST = 20
+OFPT_BARRIER_REPLY = 21
+
+OFPFC_ADD = 0
+OFPFC_DELETE_STRICT = 4
+OFPGC_ADD = 0
+OFPGC_MODIFY = 1
+OFPGT_INDIRECT = 2
+OFPMP_PORT_STATS = 4
+OFPMPF_REPLY_MORE = 1
+
+OFPP_CONTROLLER = 0xfffffffd
+OFPP_ANY = 0xffffffff
+OFPG_ANY = 0xffffffff
+OFP_NO_BUFFER = 0xffffffff
+OFPVID_PRESENT = 0x1000
+
+OFPIT_GOTO_TABLE = 1
+OFPIT_WRITE_ACTIONS = 3
+OFPAT_OUTPUT = 0
+OFPAT_GROUP = 22
+OFPAT_SET_FIELD = 25
+
+OXM_ETH_DST = 3
+OXM_ETH_SRC = 4
+OXM_ETH_TYPE = 5
+OXM_VLAN_VID = 6
+OXM_IP_PROTO = 10
+OXM_IPV4_SRC = 11
+OXM_IPV4_DST = 12
+
+TABLE_UNICAST_ROUTING = 30
+TABLE_BRIDGING = 50
+TABLE_ACL_POLICY = 60
+
+OFDPA_GROUP_L2_INTERFACE = 0
+OFDPA_GROUP_L3_UNICAST = 2
+
+FLOW_TYPES = ("bridging", "routing", "acl")
+MSG_TYPES = FLOW_TYPES + ("group_mod", "barrier", "port_stats", "packet_out")
+DEFAULT_MIX = "bridging=40,routing=20,acl=10,group_mod=10,barrier=5,port_stats=5,packet_out=10"
+IO_BACKENDS = ("none", "poll", "epoll")
+
+# Marks bench packets so loopback packet ins can be told from the
+# synthetic ones the simulation generates
+PKT_MAGIC = b"OFBENCH!"
+
+############################################################
+#
+# OpenFlow 1.3 encoding
+#
+############################################################
+
+def pad8(data):
+    return data + b"\0" * (-len(data) % 8)
+
+def ofp_msg(msg_type, xid, body=b""):
+    return struct.pack("!BBHI", OFP_VERSION, msg_type, 8 + len(body), xid) + body
+
+def oxm(field, value):
+    return struct.pack("!I", (0x8000 << 16) | (field << 9) | len(value)) + value
+
+def oxm_masked(field, value, mask):
+    return struct.pack("!I", (0x8000 << 16) | (field << 9) | 0x100 | (2 * len(value))) + value + mask
+
+def ofp_match(oxms):
+    body = b"".join(oxms)
+    return pad8(struct.pack("!HH", 1, 4 + len(body)) + body)
+
+def act_output(port):
+    return struct.pack("!HHIH6x", OFPAT_OUTPUT, 16, port, 0xffff)
+
+def act_group(group_id):
+    return struct.pack("!HHI", OFPAT_GROUP, 8, group_id)
+
+def act_set_field(field):
+    length = 4 + len(field)
+    return pad8(struct.pack("!HH", OFPAT_SET_FIELD, length + (-length % 8)) + field)
+
+def inst_goto(table_id):
+    return struct.pack("!HHB3x", OFPIT_GOTO_TABLE, 8, table_id)
+
+def inst_write_actions(actions):
+    body = b"".join(actions)
+    return struct.pack("!HH4x", OFPIT_WRITE_ACTIONS, 8 + len(body)) + body
+
+def flow_mod(xid, command, table_id, priority, match, instructions=(), cookie=0):
+    body = struct.pack("!QQBBHHHIIIH2x", cookie, 0, table_id, command, 0, 0,
+                       priority, OFP_NO_BUFFER, OFPP_ANY, OFPG_ANY, 0)
+    return ofp_msg(OFPT_FLOW_MOD, xid, body + match + b"".join(instructions))
+
+def group_mod(xid, command, group_id, actions):
+    acts = b"".join(actions)
+    bucket = struct.pack("!HHII4x", 16 + len(acts), 0, OFPP_ANY, OFPG_ANY) + acts
+    return ofp_msg(OFPT_GROUP_MOD, xid,
+                   struct.pack("!HBxI", command, OFPGT_INDIRECT, group_id) + bucket)
+
+def port_stats_request(xid):
+    return ofp_msg(OFPT_MULTIPART_REQUEST, xid,
+                   struct.pack("!HH4xI4x", OFPMP_PORT_STATS, 0, OFPP_ANY))
+
+def packet_out(xid, port, data):
+    acts = act_output(port)
+    return ofp_msg(OFPT_PACKET_OUT, xid,
+                   struct.pack("!IIH6x", OFP_NO_BUFFER, OFPP_CONTROLLER, len(acts)) + acts + data)
+
+def mac(value):
+    return struct.pack("!HI", value >> 32, value & 0xffffffff)
+
+def l2_interface_group_id(vlan, port):
+    return (OFDPA_GROUP_L2_INTERFACE << 28) | (vlan << 16) | port
+
+def l3_unicast_group_id(index):
+    return (OFDPA_GROUP_L3_UNICAST << 28) | index
+
+############################################################
+#
+# Controller side of the connection
+#
+############################################################
+
+class Connection(object):
+    def __init__(self, sock):
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        sock.setblocking(False)
+        self.sock = sock
+        self.inbuf = b""
+        self.outbuf = b""
+
+    def send(self, msg):
+        self.outbuf += msg
+
+    def poll(self, timeout):
+        """Flush what the socket takes and return the complete messages read"""
+        wlist = [self.sock] if self.outbuf else []
+        readable, writable, _ = select.select([self.sock], wlist, [], timeout)
+        if writable:
+            try:
+                sent = self.sock.send(self.outbuf)
+                self.outbuf = self.outbuf[sent:]
+            except socket.error as e:
+                if e.errno not in (errno.EAGAIN, errno.EWOULDBLOCK):
+                    raise
+        if readable:
+            data = self.sock.recv(1 << 20)
+            if not data:
+                raise EOFError("ofagent closed the connection")
+            self.inbuf += data
+        msgs = []
+        while len(self.inbuf) >= 8:
+            length = struct.unpack_from("!H", self.inbuf, 2)[0]
+            if length < 8:
+                raise ValueError("bad OpenFlow message length %d" % length)
+            if len(self.inbuf) < length:
+                break
+            msgs.append(self.inbuf[:length])
+            self.inbuf = self.inbuf[length:]
+        return msgs
+
+    def flush(self, timeout):
+        end = now() + timeout
+        while self.outbuf and now() < end:
+            for msg in self.poll(0.01):
+                self.answer_echo(msg)
+
+    def answer_echo(self, msg):
+        """Answer echo requests; returns True if msg was one"""
+        if ord(msg[1:2]) != OFPT_ECHO_REQUEST:
+            return False
+        xid = struct.unpack_from("!I", msg, 4)[0]
+        self.send(ofp_msg(OFPT_ECHO_REPLY, xid, msg[8:]))
+        return True
+
+    def wait_for(self, msg_type, xid, timeout):
+        end = now() + timeout
+        while now() < end:
+            for msg in self.poll(0.05):
+                if self.answer_echo(msg):
+                    continue
+                t, x = ord(msg[1:2]), struct.unpack_from("!I", msg, 4)[0]
+                if t == OFPT_ERROR and x == xid:
+                    raise RuntimeError("error %d/%d for xid %d" %
+                                       (struct.unpack_from("!HH", msg, 8) + (xid,)))
+                if t == msg_type and (xid is None or x == xid):
+                    return msg
+        raise RuntimeError("timed out waiting for message type %d" % msg_type)
+
+############################################################
+#
+# Load generation
+#
+############################################################
+
+def percentile(samples, q):
+    if not samples:
+        return 0.0
+    return samples[min(len(samples) - 1, max(0, int(math.ceil(q * len(samples))) - 1))]
+
+def parse_io(value):
+    if value not in IO_BACKENDS:
+        raise ValueError("unknown I/O backend '%s' (one of %s)" % (value, ", ".join(IO_BACKENDS)))
+    return value
+
+# Options --sweep can vary, with their parsers
+SWEEP_KEYS = collections.OrderedDict([
+    ("pkt_in_pps", int),
+    ("io", parse_io),
+    ("rate", float),
+    ("connections", int),
+])
+
+def parse_sweep(specs):
+    """Returns [(key, [values])] for the --sweep options given"""
+    sweep = []
+    for spec in specs:
+        key, _, values = spec.partition("=")
+        key = key.strip().replace("-", "_")
+        if key not in SWEEP_KEYS:
+            raise ValueError("cannot sweep '%s' (one of %s)" % (key, ", ".join(SWEEP_KEYS)))
+        if key in dict(sweep):
+            raise ValueError("'%s' swept twice" % key)
+        sweep.append((key, [SWEEP_KEYS[key](v.strip()) for v in values.split(",") if v.strip()]))
+        if not sweep[-1][1]:
+            raise ValueError("no values to sweep for '%s'" % key)
+    return sweep
+
+def parse_mix(spec):
+    mix = []
+    for item in spec.split(","):
+        name, _, weight = item.partition("=")
+        name = name.strip()
+        if name not in MSG_TYPES:
+            raise ValueError("unknown message type '%s' (one of %s)" % (name, ", ".join(MSG_TYPES)))
+        if int(weight) > 0:
+            mix.append((name, int(weight)))
+    if not mix:
+        raise ValueError("empty mix")
+    return mix
+
+class Stats(object):
+    def __init__(self):
+        self.sent = 0
+        self.errors = 0
+        self.latencies = []
+
+def cpu_seconds(pid):
+    """User plus system CPU time of a process, all threads included"""
+    with open("/proc/%d/stat" % pid) as f:
+        fields = f.read().rpartition(")")[2].split()
+    return (int(fields[11]) + int(fields[12])) / float(os.sysconf("SC_CLK_TCK"))
+
+class Bench(object):
+    def __init__(self, conn, options, idle=(), agent=None):
+        self.conn = conn
+        self.options = options
+        self.idle = list(idle)
+        self.agent = agent
+        self.rng = random.Random(options.seed)
+        self.mix = parse_mix(options.mix)
+        self.total_weight = sum(w for _, w in self.mix)
+        self.xid = 0
+        self.stats = collections.defaultdict(Stats)
+        self.installed = dict((t, collections.deque()) for t in FLOW_TYPES)
+        self.next_key = dict((t, 0) for t in FLOW_TYPES)
+        self.group_mods = 0
+        self.pkt_seq = 0
+        self.pkt_out_times = {}
+        self.pkt_ins = 0
+        # Messages without a reply wait for the next barrier
+        self.unacked = []
+        # xid -> (type, send time, ops completed by the reply)
+        self.pending = {}
+        # xid -> type, for attributing errors
+        self.xid_types = {}
+        self.measure_from = 0.0
+
+    def new_xid(self, msg_type):
+        self.xid = (self.xid + 1) & 0xffffffff or 1
+        self.xid_types[self.xid] = msg_type
+        if len(self.xid_types) > 1000000:
+            self.xid_types.clear()
+        return self.xid
+
+    def outstanding(self):
+        return len(self.unacked) + sum(1 + len(p[2]) for p in self.pending.values())
+
+    def agent_cpu(self):
+        if self.agent is None:
+            return None
+        try:
+            return cpu_seconds(self.agent.pid)
+        except (IOError, OSError, ValueError, IndexError):
+            return None
+
+    def service_idle(self):
+        """Answer echoes on the idle connections and drop what else they get"""
+        if not self.idle:
+            return
+        readable = select.select([c.sock for c in self.idle], [], [], 0)[0]
+        for conn in self.idle:
+            if conn.sock in readable or conn.outbuf:
+                for msg in conn.poll(0):
+                    conn.answer_echo(msg)
+
+    def record(self, msg_type, t_send, t_done):
+        if t_send >= self.measure_from:
+            self.stats[msg_type].latencies.append(t_done - t_send)
+
+    # Setup: the groups the flows and group mods refer to
+
+    def setup(self):
+        o = self.options
+        for port in range(1, o.ports + 1):
+            self.conn.send(group_mod(self.new_xid("setup"), OFPGC_ADD,
+                                     l2_interface_group_id(o.vlan, port),
+                                     [act_output(port)]))
+        for port in range(1, o.ports + 1):
+            self.conn.send(group_mod(self.new_xid("setup"), OFPGC_ADD,
+                                     l3_unicast_group_id(port),
+                                     self.l3_unicast_actions(port, 0)))
+        xid = self.new_xid("setup")
+        self.conn.send(ofp_msg(OFPT_BARRIER_REQUEST, xid))
+        self.conn.wait_for(OFPT_BARRIER_REPLY, xid, 30)
+
+    def l3_unicast_actions(self, port, generation):
+        o = self.options
+        return [act_set_field(oxm(OXM_ETH_SRC, mac(0x020000000000 | port))),
+                act_set_field(oxm(OXM_ETH_DST, mac(0x040000000000 | (generation << 16) | port))),
+                act_set_field(oxm(OXM_VLAN_VID, struct.pack("!H", OFPVID_PRESENT | o.vlan))),
+                act_group(l2_interface_group_id(o.vlan, port))]
+
+    # Message builders for the mix
+
+    def flow_match(self, flow_type, key):
+        o = self.options
+        if flow_type == "bridging":
+            return TABLE_BRIDGING, ofp_match([
+                oxm(OXM_VLAN_VID, struct.pack("!H", OFPVID_PRESENT | o.vlan)),
+                oxm(OXM_ETH_DST, mac(0x060000000000 | key))])
+        if flow_type == "routing":
+            return TABLE_UNICAST_ROUTING, ofp_match([
+                oxm(OXM_ETH_TYPE, struct.pack("!H", 0x0800)),
+                oxm_masked(OXM_IPV4_DST, struct.pack("!I", 0x0a000000 | key),
+                           struct.pack("!I", 0xffffffff))])
+        return TABLE_ACL_POLICY, ofp_match([
+            oxm(OXM_ETH_TYPE, struct.pack("!H", 0x0800)),
+            oxm(OXM_IP_PROTO, b"\x06"),
+            oxm(OXM_IPV4_SRC, struct.pack("!I", 0x0b000000 | key))])
+
+    def flow_instructions(self, flow_type, key):
+        port = 1 + key % self.options.ports
+        if flow_type == "routing":
+            return [inst_write_actions([act_group(l3_unicast_group_id(port))]),
+                    inst_goto(TABLE_ACL_POLICY)]
+        group = act_group(l2_interface_group_id(self.options.vlan, port))
+        if flow_type == "bridging":
+            return [inst_write_actions([group]), inst_goto(TABLE_ACL_POLICY)]
+        return [inst_write_actions([group])]
+
+    def send_flow(self, flow_type, t):
+        installed = self.installed[flow_type]
+        if len(installed) >= self.options.flows:
+            key = installed.popleft()
+            table_id, match = self.flow_match(flow_type, key)
+            self.conn.send(flow_mod(self.new_xid("flow_delete"), OFPFC_DELETE_STRICT,
+                                    table_id, 1000, match))
+            self.stats["flow_delete"].sent += 1
+            self.unacked.append(("flow_delete", t))
+        key = self.next_key[flow_type] = (self.next_key[flow_type] + 1) & 0xffffff
+        table_id, match = self.flow_match(flow_type, key)
+        self.conn.send(flow_mod(self.new_xid(flow_type), OFPFC_ADD, table_id, 1000, match,
+                                self.flow_instructions(flow_type, key), cookie=key))
+        installed.append(key)
+        self.unacked.append((flow_type, t))
+
+    def send_one(self, msg_type, t):
+        if msg_type in FLOW_TYPES:
+            self.send_flow(msg_type, t)
+        elif msg_type == "group_mod":
+            self.group_mods += 1
+            port = 1 + self.group_mods % self.options.ports
+            self.conn.send(group_mod(self.new_xid(msg_type), OFPGC_MODIFY,
+                                     l3_unicast_group_id(port),
+                                     self.l3_unicast_actions(port, self.group_mods & 0xff)))
+            self.unacked.append((msg_type, t))
+        elif msg_type == "packet_out":
+            self.pkt_seq += 1
+            port = 1 + self.pkt_seq % self.options.ports
+            data = mac(0xffffffffffff) + mac(0x020000000000 | port) + b"\x88\xb5" + \
+                PKT_MAGIC + struct.pack("!Q", self.pkt_seq)
+            self.conn.send(packet_out(self.new_xid(msg_type), port, data + b"\0" * (64 - len(data))))
+            if self.options.loopback:
+                self.pkt_out_times[self.pkt_seq] = t
+            self.unacked.append((msg_type, t))
+        elif msg_type == "barrier":
+            self.send_barrier(t)
+            return
+        elif msg_type == "port_stats":
+            xid = self.new_xid(msg_type)
+            self.conn.send(port_stats_request(xid))
+            self.pending[xid] = (msg_type, t, [])
+        self.stats[msg_type].sent += 1
+
+    def send_barrier(self, t):
+        xid = self.new_xid("barrier")
+        self.conn.send(ofp_msg(OFPT_BARRIER_REQUEST, xid))
+        self.pending[xid] = ("barrier", t, self.unacked)
+        self.stats["barrier"].sent += 1
+        self.unacked = []
+
+    # Replies
+
+    def handle(self, msg, t):
+        msg_type = ord(msg[1:2])
+        xid = struct.unpack_from("!I", msg, 4)[0]
+        if self.conn.answer_echo(msg):
+            return
+        if msg_type == OFPT_BARRIER_REPLY or \
+                (msg_type == OFPT_MULTIPART_REPLY and
+                 not struct.unpack_from("!H", msg, 10)[0] & OFPMPF_REPLY_MORE):
+            entry = self.pending.pop(xid, None)
+            if entry is not None:
+                self.record(entry[0], entry[1], t)
+                for op_type, t_send in entry[2]:
+                    self.record(op_type, t_send, t)
+        elif msg_type == OFPT_ERROR:
+            self.stats[self.xid_types.get(xid, "unknown")].errors += 1
+        elif msg_type == OFPT_PACKET_IN:
+            self.pkt_ins += 1
+            pos = msg.find(PKT_MAGIC)
+            if pos >= 0 and len(msg) >= pos + len(PKT_MAGIC) + 8:
+                seq = struct.unpack_from("!Q", msg, pos + len(PKT_MAGIC))[0]
+                t_send = self.pkt_out_times.pop(seq, None)
+                if t_send is not None:
+                    self.record("packet_in", t_send, t)
+
+    def run(self):
+        o = self.options
+        start = now()
+        self.measure_from = start + o.warmup
+        end = self.measure_from + o.duration
+        interval = 1.0 / o.rate if o.rate > 0 else 0.0
+        next_send = start
+        next_idle = start
+        pkt_ins_at_start = None
+        cpu_at_start = None
+
+        while True:
+            t = now()
+            if pkt_ins_at_start is None and t >= self.measure_from:
+                pkt_ins_at_start = self.pkt_ins
+                cpu_at_start = self.agent_cpu()
+                for s in self.stats.values():
+                    s.sent = s.errors = 0
+            if t >= end:
+                break
+            # Send while the window and the rate allow, a bounded burst at a time
+            for _ in range(64):
+                if self.outstanding() >= o.window or t < next_send:
+                    break
+                pick = self.rng.randrange(self.total_weight)
+                for msg_type, weight in self.mix:
+                    pick -= weight
+                    if pick < 0:
+                        break
+                self.send_one(msg_type, t)
+                if len(self.unacked) >= o.batch:
+                    self.send_barrier(t)
+                next_send = max(next_send + interval, t - 1.0) if interval else t
+            for msg in self.conn.poll(0 if self.conn.outbuf else 0.001):
+                self.handle(msg, now())
+            if t >= next_idle:
+                self.service_idle()
+                next_idle = t + 0.01
+
+        cpu = self.agent_cpu()
+        if cpu is not None and cpu_at_start is not None:
+            cpu -= cpu_at_start
+        else:
+            cpu = None
+
+        # Drain what is in flight so its latency is counted
+        if self.unacked:
+            self.send_barrier(now())
+        drain_end = now() + 10
+        while self.pending and now() < drain_end:
+            for msg in self.conn.poll(0.01):
+                self.handle(msg, now())
+            self.service_idle()
+
+        return self.report(end - self.measure_from, self.pkt_ins - (pkt_ins_at_start or 0), cpu)
+
+    def report(self, elapsed, pkt_ins, cpu=None):
+        rows = []
+        flow_mod = sorted(l for t in FLOW_TYPES + ("flow_delete",) if t in self.stats
+                          for l in self.stats[t].latencies)
+        for msg_type in MSG_TYPES + ("flow_delete", "packet_in", "unknown", "setup"):
+            if msg_type not in self.stats:
+                continue
+            s = self.stats[msg_type]
+            lat = sorted(s.latencies)
+            rows.append({
+                "type": msg_type,
+                "sent": s.sent,
+                "completed": len(lat),
+                "errors": s.errors,
+                "rate": len(lat) / elapsed if elapsed > 0 else 0.0,
+                "p50_us": percentile(lat, 0.50) * 1e6,
+                "p99_us": percentile(lat, 0.99) * 1e6,
+                "p999_us": percentile(lat, 0.999) * 1e6,
+            })
+        return {"duration": elapsed,
+                "connections": 1 + len(self.idle),
+                "agent_cpu_pct": 100.0 * cpu / elapsed if cpu is not None and elapsed > 0 else None,
+                "packet_in_rate": pkt_ins / elapsed if elapsed > 0 else 0.0,
+                "flow_mod": {"completed": len(flow_mod),
+                             "rate": len(flow_mod) / elapsed if elapsed > 0 else 0.0,
+                             "p50_us": percentile(flow_mod, 0.50) * 1e6,
+                             "p99_us": percentile(flow_mod, 0.99) * 1e6,
+                             "p999_us": percentile(flow_mod, 0.999) * 1e6},
+                "types": rows}
+
+def print_report(result, out):
+    print("%-12s %10s %10s %8s %12s %10s %10s %10s" %
+          ("type", "sent", "completed", "errors", "msgs/sec", "p50 us", "p99 us", "p999 us"), file=out)
+    for r in result["types"]:
+        print("%-12s %10d %10d %8d %12.1f %10.1f %10.1f %10.1f" %
+              (r["type"], r["sent"], r["completed"], r["errors"], r["rate"],
+               r["p50_us"], r["p99_us"], r["p999_us"]), file=out)
+    print("packet_in   %.1f/sec over %.1f sec" %
+          (result["packet_in_rate"], result["duration"]), file=out)
+    cpu = result["agent_cpu_pct"]
+    print("ofagent     %s CPU, %d connections" %
+          ("%.1f%%" % cpu if cpu is not None else "unknown", result["connections"]), file=out)
+
+def type_row(result, msg_type):
+    for r in result["types"]:
+        if r["type"] == msg_type:
+            return r
+    return {"p50_us": 0.0, "p99_us": 0.0}
+
+def point_name(point):
+    return " ".join("%s=%s" % kv for kv in point.items()) or "-"
+
+def print_sweep(results, out):
+    width = max(len(point_name(r["point"])) for r in results)
+    print("%-*s %5s %6s %11s %9s %9s %9s %9s %9s %9s %10s" %
+          (width, "point", "conns", "cpu %", "flow mods/s", "flow p50", "flow p99",
+           "barr p50", "barr p99", "pkin p50", "pkin p99", "pkt_in/s"), file=out)
+    for r in results:
+        f, b, p = r["flow_mod"], type_row(r, "barrier"), type_row(r, "packet_in")
+        cpu = r["agent_cpu_pct"]
+        print("%-*s %5d %6s %11.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %10.1f" %
+              (width, point_name(r["point"]), r["connections"],
+               "%.1f" % cpu if cpu is not None else "-", f["rate"], f["p50_us"], f["p99_us"],
+               b["p50_us"], b["p99_us"], p["p50_us"], p["p99_us"], r["packet_in_rate"]), file=out)
+    print("latencies in us; barr is barrier, pkin is packet out to packet in (--loopback)",
+          file=out)
+
+############################################################
+#
+# ofagent startup and connection
+#
+############################################################
+
+def start_agent(options, agent_args):
+    env = dict(os.environ)
+    env.setdefault("OFDPA_SIM_PORTS", str(max(32, options.ports)))
+    if options.loopback:
+        env["OFDPA_SIM_PKT_LOOPBACK"] = "1"
+    if options.pkt_in_pps:
+        env["OFDPA_SIM_PKT_IN_PPS"] = str(options.pkt_in_pps)
+    log = open(options.agent_log, "w")
+    argv = [options.ofagent] + agent_args + options.agent_args
+    if options.io != "none":
+        argv.append("--io-thread=%s" % options.io)
+    return subprocess.Popen(argv, env=env, stdout=log, stderr=subprocess.STDOUT)
+
+def free_port(host):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.bind((host, 0))
+    port = sock.getsockname()[1]
+    sock.close()
+    return port
+
+def handshake(conn, timeout):
+    """Returns the features reply"""
+    conn.send(ofp_msg(OFPT_HELLO, 1))
+    conn.wait_for(OFPT_HELLO, None, timeout)
+    conn.send(ofp_msg(OFPT_FEATURES_REQUEST, 2))
+    return conn.wait_for(OFPT_FEATURES_REPLY, 2, timeout)
+
+def connect(options):
+    """Returns (Connection, agent process or None)"""
+    host, port = options.address.rsplit(":", 1)
+    port = int(port)
+    agent = None
+    # Where the idle connections go
+    options.idle_address = options.address
+
+    if options.listen:
+        # ofagent listens (--listen), we connect like a controller would
+        if options.ofagent:
+            agent = start_agent(options, ["--listen=%s:%d" % (host, port)])
+        end = now() + options.connect_timeout
+        while True:
+            try:
+                sock = socket.create_connection((host, port), timeout=1)
+                break
+            except socket.error:
+                if now() >= end or (agent is not None and agent.poll() is not None):
+                    raise
+                time.sleep(0.1)
+    else:
+        # ofagent connects out (--controller), we accept like a controller would
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind((host, port))
+        server.listen(1)
+        port = server.getsockname()[1]
+        if options.ofagent:
+            agent_args = ["--controller=%s:%d" % (host, port)]
+            if options.connections > 1:
+                # The idle connections reach it through a listener
+                options.idle_address = "%s:%d" % (host, free_port(host))
+                agent_args.append("--listen=%s" % options.idle_address)
+            agent = start_agent(options, agent_args)
+        else:
+            print("waiting for ofagent --controller=%s:%d" % (host, port), file=sys.stderr)
+        server.settimeout(options.connect_timeout)
+        sock, _ = server.accept()
+        server.close()
+
+    conn = Connection(sock)
+    reply = handshake(conn, options.connect_timeout)
+    print("connected to datapath %016x" % struct.unpack_from("!Q", reply, 8)[0], file=sys.stderr)
+    return conn, agent
+
+def connect_idle(options):
+    """Opens the connections beyond the first; stops at the first that
+    ofagent does not complete, and returns those that it did"""
+    host, port = options.idle_address.rsplit(":", 1)
+    idle = []
+    for i in range(1, options.connections):
+        sock = None
+        try:
+            sock = socket.create_connection((host, int(port)), timeout=options.connect_timeout)
+            conn = Connection(sock)
+            handshake(conn, options.connect_timeout)
+        except (socket.error, EOFError, RuntimeError) as e:
+            print("connection %d of %d failed: %s" % (i + 1, options.connections, e),
+                  file=sys.stderr)
+            if sock is not None:
+                sock.close()
+            break
+        idle.append(conn)
+    return idle
+
+def main():
+    parser = optparse.OptionParser(usage="%prog [options] [-- ofagent options]")
+    parser.add_option("--ofagent", help="ofagent binary to start; connect to a running one if omitted")
+    parser.add_option("--agent-log", default="/dev/null", help="ofagent output [%default]")
+    parser.add_option("--address", default="127.0.0.1:0",
+                      help="controller address; port 0 picks a free one [%default]")
+    parser.add_option("--listen", action="store_true",
+                      help="start ofagent with --listen and connect to it instead")
+    parser.add_option("--connect-timeout", type="float", default=30.0)
+    parser.add_option("--mix", default=DEFAULT_MIX, help="message weights [%default]")
+    parser.add_option("--duration", type="float", default=10.0, help="seconds measured [%default]")
+    parser.add_option("--warmup", type="float", default=1.0, help="seconds not measured [%default]")
+    parser.add_option("--rate", type="float", default=0.0,
+                      help="messages per second, 0 for as fast as the window allows [%default]")
+    parser.add_option("--window", type="int", default=256,
+                      help="messages in flight [%default]")
+    parser.add_option("--batch", type="int", default=16,
+                      help="messages without reply per barrier [%default]")
+    parser.add_option("--flows", type="int", default=4096,
+                      help="flows kept installed per flow type [%default]")
+    parser.add_option("--ports", type="int", default=8, help="ports used [%default]")
+    parser.add_option("--vlan", type="int", default=10, help="VLAN used [%default]")
+    parser.add_option("--loopback", action="store_true",
+                      help="measure packet out to packet in through the simulation")
+    parser.add_option("--pkt-in-pps", type="int", default=0,
+                      help="synthetic packet ins per second from the simulation [%default]")
+    parser.add_option("--connections", type="int", default=1,
+                      help="controller connections, all but one idle [%default]")
+    parser.add_option("--io", default="none",
+                      help="OF-DPA I/O thread of a started ofagent: %s [%%default]" %
+                      ", ".join(IO_BACKENDS))
+    parser.add_option("--sweep", action="append", default=[], metavar="KEY=V1,V2,...",
+                      help="run once per value, restarting ofagent each time; repeat to "
+                      "sweep every combination. Keys: %s" % ", ".join(SWEEP_KEYS))
+    parser.add_option("--seed", type="int", default=1)
+    parser.add_option("--json", help="also write the results to this file")
+    options, args = parser.parse_args()
+    options.agent_args = args
+
+    try:
+        parse_mix(options.mix)
+        parse_io(options.io)
+        sweep = parse_sweep(options.sweep)
+    except ValueError as e:
+        parser.error(str(e))
+    if sweep and not options.ofagent:
+        parser.error("--sweep restarts ofagent for each point and needs --ofagent")
+    if options.connections < 1:
+        parser.error("--connections must be at least 1")
+    if not (options.ofagent or options.listen) and \
+            (options.connections > 1 or "connections" in dict(sweep)):
+        parser.error("--connections needs --listen or --ofagent")
+    if options.listen and options.address.endswith(":0"):
+        options.address = options.address[:-2] + ":6634"
+
+    results = []
+    for values in itertools.product(*[v for _, v in sweep]):
+        point = collections.OrderedDict(zip([k for k, _ in sweep], values))
+        point_options = copy.copy(options)
+        for key, value in point.items():
+            setattr(point_options, key, value)
+        if sweep:
+            print("== %s" % point_name(point))
+        result = run_point(point_options)
+        if sweep:
+            result["point"] = point
+        print_report(result, sys.stdout)
+        results.append(result)
+
+    if sweep:
+        print()
+        print_sweep(results, sys.stdout)
+    if options.json:
+        with open(options.json, "w") as f:
+            json.dump(results if sweep else results[0], f, indent=2)
+
+def run_point(options):
+    agent = None
+    idle = []
+    try:
+        conn, agent = connect(options)
+        idle = connect_idle(options)
+        bench = Bench(conn, options, idle, agent)
+        bench.setup()
+        return bench.run()
+    finally:
+        for c in idle:
+            c.sock.close()
+        if agent is not None:
+            agent.terminate()
+            agent.wait()
+
+if __name__ == "__main__":
+    main()